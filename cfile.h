@@ -78,6 +78,7 @@ typedef struct _capture_file {
   int                         lnk_t;                /* File link-layer type; could be WTAP_ENCAP_PER_PACKET */
   GArray                     *linktypes;            /* Array of packet link-layer types */
   guint32                     count;                /* Total number of frames */
+  guint32                     tail_backlog;         /* Records written by the capture child but not read yet (see cf_continue_tail) */
   guint64                     packet_comment_count; /* Number of comments in frames (could be >1 per frame... */
   guint32                     displayed_count;      /* Number of displayed frames */
   guint32                     marked_count;         /* Number of marked frames */
@@ -93,6 +94,11 @@ typedef struct _capture_file {
   gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
   gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
   rescan_type                 redissection_queued;  /* Queued redissection type. */
+  gchar                      *dfilter_frames_filter; /* Display filter that can only match dfilter_frames */
+  guint32                    *dfilter_frames;       /* Frames it can match, ascending (see cf_set_dfilter_frames) */
+  guint                       num_dfilter_frames;   /* Number of dfilter_frames */
+  guint32                     dfilter_frames_count; /* Frames in the file when dfilter_frames was set */
+  struct _field_index_t      *field_index;          /* Frames of each value of the fields in prefs.gui_find_index_fields */
   /* search */
   gchar                      *sfilter;              /* Filter, hex value, or string being searched */
   gboolean                    hex;                  /* TRUE if "Hex value" search was last selected */
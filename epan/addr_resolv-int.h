@@ -0,0 +1,59 @@
+/* addr_resolv-int.h
+ * Definitions for the built-in name resolution tables.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __ADDR_RESOLV_INT_H__
+#define __ADDR_RESOLV_INT_H__
+
+#include <glib.h>
+
+/*
+ * The manuf, wka and services files are compiled into these tables by
+ * tools/make-addr-resolv-tables.py. Each table is sorted by its key, so
+ * it can be searched with bsearch(), and later entries in the files have
+ * already replaced earlier ones with the same key.
+ */
+
+/* Manufacturer IDs (manuf entries without a mask), sorted by OUI */
+typedef struct {
+    guint32      oui;           /* Most significant 24 bits of the address */
+    const char  *name;
+    const char  *longname;
+} builtin_manuf_t;
+
+/* Well-known addresses and address ranges, sorted by address */
+typedef struct {
+    guint64      addr;          /* 48-bit address, masked for ranges */
+    const char  *name;
+} builtin_eth_t;
+
+/* Service names, sorted by port */
+typedef struct {
+    guint16      port;
+    const char  *tcp_name;
+    const char  *udp_name;
+    const char  *sctp_name;
+    const char  *dccp_name;
+} builtin_serv_t;
+
+extern const builtin_manuf_t builtin_manuf[];
+extern const guint builtin_manuf_count;
+
+/* Address ranges (entries with a mask) */
+extern const builtin_eth_t builtin_wka[];
+extern const guint builtin_wka_count;
+
+/* Complete 48-bit addresses */
+extern const builtin_eth_t builtin_ethers[];
+extern const guint builtin_ethers_count;
+
+extern const builtin_serv_t builtin_services[];
+extern const guint builtin_services_count;
+
+#endif /* __ADDR_RESOLV_INT_H__ */
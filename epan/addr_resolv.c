@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <wsutil/strtoi.h>
 
@@ -90,6 +91,7 @@
 
 #include <epan/strutil.h>
 #include <epan/to_str-int.h>
+#include <epan/addr_resolv-int.h>
 #include <epan/maxmind_db.h>
 #include <epan/prefs.h>
 #include <epan/uat.h>
@@ -104,6 +106,7 @@
 #define ENAME_VLANS     "vlans"
 #define ENAME_SS7PCS    "ss7pcs"
 #define ENAME_ENTERPRISES "enterprises.tsv"
+#define ENAME_DNS_CACHE "dns_cache"
 
 #define HASHETHSIZE      2048
 #define HASHHOSTSIZE     2048
@@ -216,6 +219,12 @@ struct cb_serv_data {
     port_type    proto;
 };
 
+/*
+ * The contents of the manuf, wka and services files are built in (see
+ * addr_resolv-int.h). These tables hold the entries from the personal
+ * files, which are read when first needed and take precedence, and the
+ * built-in entries that have been looked up so far.
+ */
 // Maps guint -> hashmanuf_t*
 static wmem_map_t *manuf_hashtable = NULL;
 static wmem_map_t *wka_hashtable = NULL;
@@ -224,6 +233,11 @@ static wmem_map_t *eth_hashtable = NULL;
 static wmem_map_t *serv_port_hashtable = NULL;
 static GHashTable *enterprises_hashtable = NULL;
 
+static gboolean ethers_personal_loaded = FALSE;
+static gboolean ethers_builtin_merged = FALSE;
+static gboolean services_personal_loaded = FALSE;
+static gboolean services_builtin_merged = FALSE;
+
 static subnet_length_entry_t subnet_length_entries[SUBNETLENGTHSIZE]; /* Ordered array of entries */
 static gboolean have_subnet_entry = FALSE;
 
@@ -232,6 +246,7 @@ static gboolean new_resolved_objects = FALSE;
 static GPtrArray* extra_hosts_files = NULL;
 
 static hashether_t *add_eth_name(const guint8 *addr, const gchar *name);
+static void dns_cache_record(int family, const void *addr, int status, const char *name);
 static void add_serv_port_cb(const guint32 port, gpointer ptr);
 
 /* http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
@@ -284,6 +299,9 @@ e_addr_resolve gbl_resolv_flags = {
 };
 static guint name_resolve_concurrency = 500;
 static gboolean resolve_synchronously = FALSE;
+static guint name_resolve_timeout = 5000;       /* milliseconds */
+static gboolean use_dns_cache = FALSE;
+static guint dns_cache_lifetime = 86400;        /* seconds */
 
 /*
  *  Global variables (can be changed in GUI sections)
@@ -293,11 +311,10 @@ static gboolean resolve_synchronously = FALSE;
 
 gchar *g_ethers_path    = NULL;     /* global ethers file     */
 gchar *g_pethers_path   = NULL;     /* personal ethers file   */
-gchar *g_wka_path       = NULL;     /* global well-known-addresses file */
-gchar *g_manuf_path     = NULL;     /* global manuf file      */
+gchar *g_pwka_path      = NULL;     /* personal well-known-addresses file */
+gchar *g_pmanuf_path    = NULL;     /* personal manuf file    */
 gchar *g_ipxnets_path   = NULL;     /* global ipxnets file    */
 gchar *g_pipxnets_path  = NULL;     /* personal ipxnets file  */
-gchar *g_services_path  = NULL;     /* global services file   */
 gchar *g_pservices_path = NULL;     /* personal services file */
 gchar *g_pvlan_path     = NULL;     /* personal vlans file    */
 gchar *g_ss7pcs_path    = NULL;     /* personal ss7pcs file   */
@@ -380,11 +397,71 @@ dns_server_copy_cb(void *dst_, const void *src_, size_t len _U_)
     return dst;
 }
 
+/*
+ * c-ares 1.11.0 and later let us give a port for each server, which is
+ * handy for testing and for resolvers that don't listen on port 53.
+ */
+#if ARES_VERSION >= 0x010b00
+#define HAVE_ARES_SET_SERVERS_PORTS
+#endif
+
+/*
+ * Parse a DNS server address, an IPv4 or IPv6 address optionally
+ * followed by a port: "192.0.2.1", "192.0.2.1:5353", "2001:db8::1"
+ * or "[2001:db8::1]:5353". The port is 0 if none was given.
+ */
+static gboolean
+parse_dns_server(const char *str, int *family, ws_in6_addr *addr, guint16 *port)
+{
+    gchar *host;
+    const char *colon, *end;
+    gboolean ok;
+
+    *port = 0;
+    if (str[0] == '[') {
+        end = strchr(str, ']');
+        if (end == NULL)
+            return FALSE;
+        host = g_strndup(str + 1, end - (str + 1));
+        end++;
+        if (*end != '\0' && (*end != ':' || !ws_strtou16(end + 1, NULL, port) || *port == 0)) {
+            g_free(host);
+            return FALSE;
+        }
+    } else {
+        colon = strchr(str, ':');
+        if (colon != NULL && strchr(colon + 1, ':') == NULL) {
+            /* Exactly one colon, so an IPv4 address and a port */
+            if (!ws_strtou16(colon + 1, NULL, port) || *port == 0)
+                return FALSE;
+            host = g_strndup(str, colon - str);
+        } else {
+            host = g_strdup(str);
+        }
+    }
+
+    if (ws_inet_pton6(host, addr)) {
+        *family = AF_INET6;
+        ok = TRUE;
+    } else if (ws_inet_pton4(host, (ws_in4_addr *)(void *)addr)) {
+        *family = AF_INET;
+        ok = TRUE;
+    } else {
+        ok = FALSE;
+    }
+    g_free(host);
+    return ok;
+}
+
 static gboolean
 dnsserver_uat_fld_ip_chk_cb(void* r _U_, const char* ipaddr, guint len _U_, const void* u1 _U_, const void* u2 _U_, char** err)
 {
-    //Check for a valid IPv4 or IPv6 address.
-    if (ipaddr && g_hostname_is_ip_address(ipaddr)) {
+    int family;
+    ws_in6_addr addr;
+    guint16 port;
+
+    //Check for a valid IPv4 or IPv6 address, with an optional port.
+    if (ipaddr && parse_dns_server(ipaddr, &family, &addr, &port)) {
         *err = NULL;
         return TRUE;
     }
@@ -416,6 +493,7 @@ c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he)
         }
 
     }
+    dns_cache_record(sdd->family, &sdd->addr, status, status == ARES_SUCCESS ? he->h_name : NULL);
 
     /*
      * Let our caller know that this is complete.
@@ -433,8 +511,21 @@ wait_for_sync_resolv(gboolean *completed) {
     int nfds;
     fd_set rfds, wfds;
     struct timeval tv;
+    gint64 deadline, remaining;
+
+    deadline = g_get_monotonic_time() + (gint64)name_resolve_timeout * 1000;
 
     while (!*completed) {
+        /*
+         * Don't wait any longer than the user asked us to; give up on
+         * the request, which calls its callback and completes it.
+         */
+        remaining = deadline - g_get_monotonic_time();
+        if (name_resolve_timeout != 0 && remaining <= 0) {
+            ares_cancel(ghba_chan);
+            return;
+        }
+
         /*
          * Not yet resolved; wait for something to show up on the
          * address-to-name C-ARES channel.
@@ -455,6 +546,10 @@ wait_for_sync_resolv(gboolean *completed) {
          */
         tv.tv_sec = 1;
         tv.tv_usec = 0;
+        if (name_resolve_timeout != 0 && remaining < G_USEC_PER_SEC) {
+            tv.tv_sec = 0;
+            tv.tv_usec = (long)remaining;
+        }
 
         FD_ZERO(&rfds);
         FD_ZERO(&wfds);
@@ -520,7 +615,7 @@ sync_lookup_ip6(const ws_in6_addr *addr)
     sdd->family = AF_INET6;
     memcpy(&sdd->addr.ip6, addr, sizeof(sdd->addr.ip6));
     sdd->completed = &completed;
-    ares_gethostbyaddr(ghba_chan, &addr, sizeof(ws_in6_addr), AF_INET6,
+    ares_gethostbyaddr(ghba_chan, addr, sizeof(ws_in6_addr), AF_INET6,
                        c_ares_ghba_sync_cb, sdd);
 
     /*
@@ -546,47 +641,44 @@ c_ares_set_dns_servers(void)
         ares_set_servers(ghba_chan, NULL);
         ares_set_servers(ghbn_chan, NULL);
     } else {
-        struct ares_addr_node* servers = wmem_alloc_array(NULL, struct ares_addr_node, ndnsservers);
-        ws_in4_addr ipv4addr;
-        ws_in6_addr ipv6addr;
-        gboolean invalid_IP_found = FALSE;
-        struct ares_addr_node* server;
+#ifdef HAVE_ARES_SET_SERVERS_PORTS
+        struct ares_addr_port_node* servers = wmem_alloc0_array(NULL, struct ares_addr_port_node, ndnsservers);
+        struct ares_addr_port_node* server = NULL;
+#else
+        struct ares_addr_node* servers = wmem_alloc0_array(NULL, struct ares_addr_node, ndnsservers);
+        struct ares_addr_node* server = NULL;
+#endif
+        ws_in6_addr addr;
+        int family;
+        guint16 port;
         guint i;
-        for (i = 0, server = servers; i < ndnsservers-1; i++, server++) {
-            if (ws_inet_pton6(dnsserverlist_uats[i].ipaddr, &ipv6addr)) {
-                server->family = AF_INET6;
-                memcpy(&server->addr.addr6, &ipv6addr, 16);
-            } else if (ws_inet_pton4(dnsserverlist_uats[i].ipaddr, &ipv4addr)) {
-                server->family = AF_INET;
-                memcpy(&server->addr.addr4, &ipv4addr, 4);
-            } else {
-                //This shouldn't happen, but just in case...
-                invalid_IP_found = TRUE;
-                server->family = 0;
-                memset(&server->addr.addr4, 0, 4);
-                break;
-            }
 
-            server->next = (server+1);
-        }
-        if (!invalid_IP_found) {
-            if (ws_inet_pton6(dnsserverlist_uats[i].ipaddr, &ipv6addr)) {
-                server->family = AF_INET6;
-                memcpy(&server->addr.addr6, &ipv6addr, 16);
-            }
-            else if (ws_inet_pton4(dnsserverlist_uats[i].ipaddr, &ipv4addr)) {
-                server->family = AF_INET;
-                memcpy(&server->addr.addr4, &ipv4addr, 4);
-            } else {
+        for (i = 0; i < ndnsservers; i++) {
+            if (!parse_dns_server(dnsserverlist_uats[i].ipaddr, &family, &addr, &port)) {
                 //This shouldn't happen, but just in case...
-                server->family = 0;
-                memset(&server->addr.addr4, 0, 4);
+                continue;
             }
+            if (server != NULL)
+                server->next = server + 1;
+            server = (server == NULL) ? servers : server + 1;
+            server->family = family;
+            if (family == AF_INET6)
+                memcpy(&server->addr.addr6, &addr, 16);
+            else
+                memcpy(&server->addr.addr4, &addr, 4);
+#ifdef HAVE_ARES_SET_SERVERS_PORTS
+            server->udp_port = port;
+            server->tcp_port = port;
+#endif
         }
-        server->next = NULL;
 
-        ares_set_servers(ghba_chan, servers);
-        ares_set_servers(ghbn_chan, servers);
+#ifdef HAVE_ARES_SET_SERVERS_PORTS
+        ares_set_servers_ports(ghba_chan, server ? servers : NULL);
+        ares_set_servers_ports(ghbn_chan, server ? servers : NULL);
+#else
+        ares_set_servers(ghba_chan, server ? servers : NULL);
+        ares_set_servers(ghbn_chan, server ? servers : NULL);
+#endif
         wmem_free(NULL, servers);
     }
 }
@@ -758,28 +850,100 @@ wmem_utoa(wmem_allocator_t *allocator, guint port)
     return bp;
 }
 
+/*
+ * Read the personal services file the first time a service name is
+ * needed; the global one is built in.
+ */
+static void
+load_personal_services(void)
+{
+    gboolean parse_file = TRUE;
+
+    if (services_personal_loaded)
+        return;
+    services_personal_loaded = TRUE;
+
+    /* Compute the pathname of the personal services file */
+    if (g_pservices_path == NULL) {
+        /* Check profile directory before personal configuration */
+        g_pservices_path = get_persconffile_path(ENAME_SERVICES, TRUE);
+        if (!parse_services_file(g_pservices_path)) {
+            g_free(g_pservices_path);
+            g_pservices_path = get_persconffile_path(ENAME_SERVICES, FALSE);
+        } else {
+            parse_file = FALSE;
+        }
+    }
+    if (parse_file) {
+        parse_services_file(g_pservices_path);
+    }
+}
+
+static int
+builtin_serv_cmp(const void *key, const void *entry)
+{
+    const guint port = *(const guint *)key;
+    const builtin_serv_t *serv = (const builtin_serv_t *)entry;
+
+    return port < serv->port ? -1 : port > serv->port ? 1 : 0;
+}
+
+static const builtin_serv_t *
+builtin_serv_lookup(guint port)
+{
+    return (const builtin_serv_t *)bsearch(&port, builtin_services, builtin_services_count,
+            sizeof(builtin_serv_t), builtin_serv_cmp);
+}
+
 static const gchar *
 _serv_name_lookup(port_type proto, guint port, serv_port_t **value_ret)
 {
     serv_port_t *serv_port_table;
+    const builtin_serv_t *serv;
+    const gchar *name = NULL;
+
+    load_personal_services();
 
     serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(port));
 
     if (value_ret != NULL)
         *value_ret = serv_port_table;
 
-    if (serv_port_table == NULL)
+    if (serv_port_table != NULL) {
+        switch (proto) {
+            case PT_UDP:
+                name = serv_port_table->udp_name;
+                break;
+            case PT_TCP:
+                name = serv_port_table->tcp_name;
+                break;
+            case PT_SCTP:
+                name = serv_port_table->sctp_name;
+                break;
+            case PT_DCCP:
+                name = serv_port_table->dccp_name;
+                break;
+            default:
+                break;
+        }
+        if (name != NULL)
+            return name;
+    }
+
+    /* Not overridden; try the built-in table. */
+    serv = builtin_serv_lookup(port);
+    if (serv == NULL)
         return NULL;
 
     switch (proto) {
         case PT_UDP:
-            return serv_port_table->udp_name;
+            return serv->udp_name;
         case PT_TCP:
-            return serv_port_table->tcp_name;
+            return serv->tcp_name;
         case PT_SCTP:
-            return serv_port_table->sctp_name;
+            return serv->sctp_name;
         case PT_DCCP:
-            return serv_port_table->dccp_name;
+            return serv->dccp_name;
         default:
             break;
     }
@@ -816,38 +980,16 @@ serv_name_lookup(port_type proto, guint port)
 static void
 initialize_services(void)
 {
-    gboolean parse_file = TRUE;
     g_assert(serv_port_hashtable == NULL);
     serv_port_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
-
-    /* Compute the pathname of the services file. */
-    if (g_services_path == NULL) {
-        g_services_path = get_datafile_path(ENAME_SERVICES);
-    }
-    parse_services_file(g_services_path);
-
-    /* Compute the pathname of the personal services file */
-    if (g_pservices_path == NULL) {
-        /* Check profile directory before personal configuration */
-        g_pservices_path = get_persconffile_path(ENAME_SERVICES, TRUE);
-        if (!parse_services_file(g_pservices_path)) {
-            g_free(g_pservices_path);
-            g_pservices_path = get_persconffile_path(ENAME_SERVICES, FALSE);
-        } else {
-            parse_file = FALSE;
-        }
-    }
-    if (parse_file) {
-        parse_services_file(g_pservices_path);
-    }
 }
 
 static void
 service_name_lookup_cleanup(void)
 {
     serv_port_hashtable = NULL;
-    g_free(g_services_path);
-    g_services_path = NULL;
+    services_personal_loaded = FALSE;
+    services_builtin_merged = FALSE;
     g_free(g_pservices_path);
     g_pservices_path = NULL;
 }
@@ -1032,6 +1174,7 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
             }
         }
     }
+    dns_cache_record(caqm->family, &caqm->addr, status, status == ARES_SUCCESS ? he->h_name : NULL);
     wmem_free(wmem_epan_scope(), caqm);
 }
 
@@ -1516,7 +1659,7 @@ get_ethbyaddr(const guint8 *addr)
 } /* get_ethbyaddr */
 
 static hashmanuf_t *
-manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
+manuf_hash_new_entry(const guint8 *addr, const char* name, const char* longname)
 {
     guint manuf_key;
     hashmanuf_t *manuf_value;
@@ -1551,7 +1694,7 @@ manuf_hash_new_entry(const guint8 *addr, char* name, char* longname)
 }
 
 static void
-wka_hash_new_entry(const guint8 *addr, char* name)
+wka_hash_new_entry(const guint8 *addr, const char* name)
 {
     guint8 *wka_key;
 
@@ -1583,6 +1726,109 @@ add_manuf_name(const guint8 *addr, unsigned int mask, gchar *name, gchar *longna
     }
 } /* add_manuf_name */
 
+/*
+ * Read the personal manuf and wka files the first time an Ethernet
+ * address or manufacturer is looked up; the global ones are built in.
+ * Their entries go into the hash tables, which are searched before the
+ * built-in tables.
+ */
+static void
+load_personal_ethers(void)
+{
+    ether_t *eth;
+    guint    mask = 0;
+
+    if (ethers_personal_loaded)
+        return;
+    ethers_personal_loaded = TRUE;
+
+    /* Compute the pathname of the personal manuf file */
+    if (g_pmanuf_path == NULL)
+        g_pmanuf_path = get_persconffile_path(ENAME_MANUF, TRUE);
+
+    /* Read it and initialize the hash table */
+    set_ethent(g_pmanuf_path);
+    while ((eth = get_ethent(&mask, TRUE))) {
+        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
+    }
+    end_ethent();
+
+    /* Compute the pathname of the personal wka file */
+    if (g_pwka_path == NULL)
+        g_pwka_path = get_persconffile_path(ENAME_WKA, TRUE);
+
+    /* Read it and initialize the hash table */
+    set_ethent(g_pwka_path);
+    while ((eth = get_ethent(&mask, TRUE))) {
+        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
+    }
+    end_ethent();
+}
+
+static int
+builtin_manuf_cmp(const void *key, const void *entry)
+{
+    const guint32 oui = *(const guint32 *)key;
+    const builtin_manuf_t *manuf = (const builtin_manuf_t *)entry;
+
+    return oui < manuf->oui ? -1 : oui > manuf->oui ? 1 : 0;
+}
+
+static int
+builtin_eth_cmp(const void *key, const void *entry)
+{
+    const guint64 addr = *(const guint64 *)key;
+    const builtin_eth_t *eth = (const builtin_eth_t *)entry;
+
+    return addr < eth->addr ? -1 : addr > eth->addr ? 1 : 0;
+}
+
+static const builtin_eth_t *
+builtin_eth_lookup(const builtin_eth_t *table, guint count, const guint8 *addr)
+{
+    const guint64 key = pntoh48(addr);
+
+    return (const builtin_eth_t *)bsearch(&key, table, count, sizeof(builtin_eth_t), builtin_eth_cmp);
+}
+
+static void
+builtin_eth_addr(guint8 *addr, guint64 key)
+{
+    phton16(addr, (guint16)(key >> 32));
+    phton32(addr + 2, (guint32)key);
+}
+
+/*
+ * Look up a manufacturer ID, first in the hash table and then in the
+ * built-in table. A built-in entry is copied to the hash table, which
+ * is what the callers hand out.
+ */
+static hashmanuf_t *
+manuf_key_lookup(guint32 manuf_key)
+{
+    hashmanuf_t *manuf_value;
+    const builtin_manuf_t *manuf;
+    guint8 addr[3];
+
+    load_personal_ethers();
+
+    manuf_value = (hashmanuf_t*)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    if (manuf_value != NULL) {
+        return manuf_value;
+    }
+
+    manuf = (const builtin_manuf_t *)bsearch(&manuf_key, builtin_manuf, builtin_manuf_count,
+            sizeof(builtin_manuf_t), builtin_manuf_cmp);
+    if (manuf == NULL) {
+        return NULL;
+    }
+
+    addr[0] = (guint8)(manuf_key >> 16);
+    addr[1] = (guint8)(manuf_key >> 8);
+    addr[2] = (guint8)manuf_key;
+    return manuf_hash_new_entry(addr, manuf->name, manuf->longname);
+}
+
 static hashmanuf_t *
 manuf_name_lookup(const guint8 *addr)
 {
@@ -1601,7 +1847,7 @@ manuf_name_lookup(const guint8 *addr)
 
 
     /* first try to find a "perfect match" */
-    manuf_value = (hashmanuf_t*)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    manuf_value = manuf_key_lookup(manuf_key);
     if (manuf_value != NULL) {
         return manuf_value;
     }
@@ -1613,7 +1859,7 @@ manuf_name_lookup(const guint8 *addr)
      * 0x02 locally administered bit */
     if ((manuf_key & 0x00010000) != 0) {
         manuf_key &= 0x00FEFFFF;
-        manuf_value = (hashmanuf_t*)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+        manuf_value = manuf_key_lookup(manuf_key);
         if (manuf_value != NULL) {
             return manuf_value;
         }
@@ -1624,17 +1870,20 @@ manuf_name_lookup(const guint8 *addr)
 
 } /* manuf_name_lookup */
 
-static gchar *
+static const gchar *
 wka_name_lookup(const guint8 *addr, const unsigned int mask)
 {
     guint8     masked_addr[6];
     guint      num;
     gint       i;
-    gchar     *name;
+    const gchar *name;
+    const builtin_eth_t *wka;
 
     if (wka_hashtable == NULL) {
         return NULL;
     }
+    load_personal_ethers();
+
     /* Get the part of the address covered by the mask. */
     for (i = 0, num = mask; num >= 8; i++, num -= 8)
         masked_addr[i] = addr[i];   /* copy octets entirely covered by the mask */
@@ -1645,7 +1894,12 @@ wka_name_lookup(const guint8 *addr, const unsigned int mask)
     for (; i < 6; i++)
         masked_addr[i] = 0;
 
-    name = (gchar *)wmem_map_lookup(wka_hashtable, masked_addr);
+    name = (const gchar *)wmem_map_lookup(wka_hashtable, masked_addr);
+    if (name == NULL) {
+        wka = builtin_eth_lookup(builtin_wka, builtin_wka_count, masked_addr);
+        if (wka != NULL)
+            name = wka->name;
+    }
 
     return name;
 
@@ -1682,9 +1936,6 @@ eth_addr_cmp(gconstpointer a, gconstpointer b)
 static void
 initialize_ethers(void)
 {
-    ether_t *eth;
-    guint    mask = 0;
-
     /* hash table initialization */
     wka_hashtable   = wmem_map_new(wmem_epan_scope(), eth_addr_hash, eth_addr_cmp);
     manuf_hashtable = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
@@ -1701,27 +1952,7 @@ initialize_ethers(void)
     if (g_pethers_path == NULL)
         g_pethers_path = get_persconffile_path(ENAME_ETHERS, FALSE);
 
-    /* Compute the pathname of the manuf file */
-    if (g_manuf_path == NULL)
-        g_manuf_path = get_datafile_path(ENAME_MANUF);
-
-    /* Read it and initialize the hash table */
-    set_ethent(g_manuf_path);
-    while ((eth = get_ethent(&mask, TRUE))) {
-        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
-    }
-    end_ethent();
-
-    /* Compute the pathname of the wka file */
-    if (g_wka_path == NULL)
-        g_wka_path = get_datafile_path(ENAME_WKA);
-
-    /* Read it and initialize the hash table */
-    set_ethent(g_wka_path);
-    while ((eth = get_ethent(&mask, TRUE))) {
-        add_manuf_name(eth->addr, mask, eth->name, eth->longname);
-    }
-    end_ethent();
+    /* The personal manuf and wka files are read by load_personal_ethers(). */
 
 } /* initialize_ethers */
 
@@ -1732,16 +1963,19 @@ ethers_cleanup(void)
     g_ethers_path = NULL;
     g_free(g_pethers_path);
     g_pethers_path = NULL;
-    g_free(g_manuf_path);
-    g_manuf_path = NULL;
-    g_free(g_wka_path);
-    g_wka_path = NULL;
+    g_free(g_pmanuf_path);
+    g_pmanuf_path = NULL;
+    g_free(g_pwka_path);
+    g_pwka_path = NULL;
+    ethers_personal_loaded = FALSE;
+    ethers_builtin_merged = FALSE;
 }
 
 /* Resolve ethernet address */
 static hashether_t *
 eth_addr_resolve(hashether_t *tp) {
     ether_t      *eth;
+    const builtin_eth_t *builtin;
     hashmanuf_t *manuf_value;
     const guint8 *addr = tp->addr;
 
@@ -1749,9 +1983,14 @@ eth_addr_resolve(hashether_t *tp) {
         g_strlcpy(tp->resolved_name, eth->name, MAXNAMELEN);
         tp->status = HASHETHER_STATUS_RESOLVED_NAME;
         return tp;
+    } else if ((builtin = builtin_eth_lookup(builtin_ethers, builtin_ethers_count, addr)) != NULL) {
+        /* Full addresses from the built-in manuf file come after the ethers files. */
+        g_strlcpy(tp->resolved_name, builtin->name, MAXNAMELEN);
+        tp->status = HASHETHER_STATUS_RESOLVED_NAME;
+        return tp;
     } else {
         guint         mask;
-        gchar        *name;
+        const gchar  *name;
         address       ether_addr;
 
         /* Unknown name.  Try looking for it in the well-known-address
@@ -1872,6 +2111,8 @@ add_eth_name(const guint8 *addr, const gchar *name)
 {
     hashether_t *tp;
 
+    load_personal_ethers();
+
     tp = (hashether_t *)wmem_map_lookup(eth_hashtable, addr);
 
     if (tp == NULL) {
@@ -1892,6 +2133,8 @@ eth_name_lookup(const guint8 *addr, const gboolean resolve)
 {
     hashether_t  *tp;
 
+    load_personal_ethers();
+
     tp = (hashether_t *)wmem_map_lookup(eth_hashtable, addr);
 
     if (tp == NULL) {
@@ -2841,6 +3084,29 @@ addr_resolve_pref_init(module_t *nameres)
             10,
             &name_resolve_concurrency);
 
+    prefs_register_uint_preference(nameres, "name_resolve_timeout",
+            "Maximum wait for name lookups (ms)",
+            "How long to wait for outstanding DNS requests, in milliseconds,"
+            " when names must be known before going on: for each address"
+            " when resolving synchronously, or in total after the first pass"
+            " of a two-pass analysis in TShark. Names that arrive too late are"
+            " shown as addresses. 0 waits as long as the resolver keeps retrying.",
+            10,
+            &name_resolve_timeout);
+
+    prefs_register_bool_preference(nameres, "use_dns_cache",
+            "Cache DNS results between runs",
+            "Remember the names found, and not found, by reverse DNS lookups in"
+            " a \"dns_cache\" file in the personal configuration directory,"
+            " and use them instead of asking again.",
+            &use_dns_cache);
+
+    prefs_register_uint_preference(nameres, "dns_cache_lifetime",
+            "DNS cache lifetime (s)",
+            "How long, in seconds, entries in the DNS cache are used.",
+            10,
+            &dns_cache_lifetime);
+
     prefs_register_bool_preference(nameres, "hosts_file_handling",
             "Only use the profile \"hosts\" file",
             "By default \"hosts\" files will be loaded from multiple sources."
@@ -2866,6 +3132,7 @@ addr_resolve_pref_init(module_t *nameres)
 void addr_resolve_pref_apply(void)
 {
     c_ares_set_dns_servers();
+    maxmind_db_pref_apply();
 }
 
 void
@@ -2879,25 +3146,19 @@ disable_name_resolution(void) {
     gbl_resolv_flags.ss7pc_name                         = FALSE;
 }
 
-gboolean
-host_name_lookup_process(void) {
+/*
+ * Submit queued asynchronous requests, keeping at most
+ * name_resolve_concurrency of them in flight.
+ */
+static void
+process_async_dns_queue(void)
+{
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
-    while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
+    while (head != NULL && async_dns_in_flight < name_resolve_concurrency) {
         caqm = (async_dns_queue_msg_t *)wmem_list_frame_data(head);
         wmem_list_remove_frame(async_dns_queue_head, head);
         if (caqm->family == AF_INET) {
@@ -2912,6 +3173,23 @@ host_name_lookup_process(void) {
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    int nfds;
+    fd_set rfds, wfds;
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    process_async_dns_queue();
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
@@ -2930,6 +3208,104 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+void
+host_name_lookup_prefetch(const address *addr)
+{
+    gboolean synchronous = resolve_synchronously;
+    guint32 ip4;
+    ws_in6_addr ip6;
+
+    /*
+     * With no requests allowed in flight, host_lookup() would resolve
+     * synchronously, which is what prefetching is meant to avoid.
+     */
+    if (!async_dns_initialized || name_resolve_concurrency == 0)
+        return;
+
+    resolve_synchronously = FALSE;
+    switch (addr->type) {
+        case AT_IPv4:
+            memcpy(&ip4, addr->data, sizeof ip4);
+            host_lookup(ip4);
+            break;
+        case AT_IPv6:
+            memcpy(&ip6, addr->data, sizeof ip6);
+            host_lookup6(&ip6);
+            break;
+        default:
+            break;
+    }
+    resolve_synchronously = synchronous;
+}
+
+gboolean
+host_name_lookups_pending(void)
+{
+    if (!async_dns_initialized)
+        return FALSE;
+
+    return async_dns_in_flight > 0 || wmem_list_count(async_dns_queue_head) > 0;
+}
+
+gboolean
+host_name_lookup_wait(void)
+{
+    struct timeval tv, maxtv, *tvp;
+    int nfds;
+    fd_set rfds, wfds;
+    gint64 deadline, remaining;
+    wmem_list_frame_t* head;
+
+    if (!async_dns_initialized)
+        return host_name_lookup_process();
+
+    deadline = g_get_monotonic_time() + (gint64)name_resolve_timeout * 1000;
+
+    for (;;) {
+        process_async_dns_queue();
+        if (async_dns_in_flight == 0)
+            break;
+
+        remaining = deadline - g_get_monotonic_time();
+        if (name_resolve_timeout != 0 && remaining <= 0) {
+            /*
+             * Out of time. Cancelling calls the callbacks of the
+             * requests in flight; throw away the ones never sent.
+             */
+            ares_cancel(ghba_chan);
+            while ((head = wmem_list_head(async_dns_queue_head)) != NULL) {
+                wmem_free(wmem_epan_scope(), wmem_list_frame_data(head));
+                wmem_list_remove_frame(async_dns_queue_head, head);
+            }
+            break;
+        }
+
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds == 0)
+            break;
+
+        /* Wake up for c-ares' retransmissions, or at the deadline */
+        maxtv.tv_sec = 1;
+        maxtv.tv_usec = 0;
+        if (name_resolve_timeout != 0 && remaining < G_USEC_PER_SEC) {
+            maxtv.tv_sec = 0;
+            maxtv.tv_usec = (long)remaining;
+        }
+        tvp = ares_timeout(ghba_chan, &maxtv, &tv);
+        if (select(nfds, &rfds, &wfds, NULL, tvp) == -1) { /* call to select() failed */
+            /* If it's interrupted by a signal, no need to put out a message */
+            if (errno != EINTR)
+                fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
+            break;
+        }
+        ares_process(ghba_chan, &rfds, &wfds);
+    }
+
+    return host_name_lookup_process();
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
@@ -3060,6 +3436,191 @@ add_manually_resolved(void)
     }
 }
 
+/*
+ * Results of reverse DNS lookups, kept between runs in the personal
+ * configuration directory if "use_dns_cache" is set. Failed lookups
+ * are remembered too, so that addresses without names aren't looked
+ * up over and over again. Each line of the file is
+ *
+ *     <time added> <address> <name, or "-" if there was none>
+ *
+ * Entries older than dns_cache_lifetime seconds are dropped.
+ */
+typedef struct {
+    gint64  added;
+    gchar  *name;       /* NULL if the address has no name */
+} dns_cache_entry_t;
+
+static wmem_map_t *dns_cache_table = NULL;
+static gboolean dns_cache_changed = FALSE;
+
+static void
+dns_cache_add(const char *addr_str, const char *name, gint64 added)
+{
+    dns_cache_entry_t *entry;
+
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_table, addr_str);
+    if (entry == NULL) {
+        entry = wmem_new(wmem_epan_scope(), dns_cache_entry_t);
+        wmem_map_insert(dns_cache_table, wmem_strdup(wmem_epan_scope(), addr_str), entry);
+    } else {
+        wmem_free(wmem_epan_scope(), entry->name);
+    }
+    entry->added = added;
+    entry->name = wmem_strdup(wmem_epan_scope(), name);
+}
+
+static void
+dns_cache_record(int family, const void *addr, int status, const char *name)
+{
+    gchar addr_str[WS_INET6_ADDRSTRLEN];
+
+    if (dns_cache_table == NULL)
+        return;
+
+    /*
+     * Only remember answers; a timeout or a cancelled request says
+     * nothing about the address.
+     */
+    if (status == ARES_SUCCESS) {
+        if (name == NULL || name[0] == '\0')
+            return;
+    } else if (status == ARES_ENOTFOUND || status == ARES_ENODATA) {
+        name = NULL;
+    } else {
+        return;
+    }
+
+    switch (family) {
+        case AF_INET:
+            ip_to_str_buf((const guint8 *)addr, addr_str, sizeof addr_str);
+            break;
+        case AF_INET6:
+            ip6_to_str_buf((const ws_in6_addr *)addr, addr_str, sizeof addr_str);
+            break;
+        default:
+            return;
+    }
+    dns_cache_add(addr_str, name, (gint64)time(NULL));
+    dns_cache_changed = TRUE;
+}
+
+static void
+read_dns_cache(void)
+{
+    char *path;
+    FILE *fp;
+    char line[MAX_LINELEN];
+    char *addr_str, *name, *end;
+    gint64 added, now = (gint64)time(NULL);
+    ws_in4_addr ip4;
+    ws_in6_addr ip6;
+    hashipv4_t *tp;
+    hashipv6_t *tp6;
+    ws_in6_addr *addr_key;
+
+    dns_cache_table = wmem_map_new(wmem_epan_scope(), g_str_hash, g_str_equal);
+    dns_cache_changed = FALSE;
+
+    path = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+    fp = ws_fopen(path, "r");
+    g_free(path);
+    if (fp == NULL)
+        return;
+
+    while (fgetline(line, sizeof(line), fp) >= 0) {
+        if (line[0] == '#')
+            continue;
+        added = g_ascii_strtoll(line, &end, 10);
+        if (end == line || now - added > (gint64)dns_cache_lifetime || added > now)
+            continue;
+        if ((addr_str = strtok(end, " \t")) == NULL ||
+            (name = strtok(NULL, " \t")) == NULL)
+            continue;
+        if (strcmp(name, "-") == 0)
+            name = NULL;
+
+        /*
+         * Hosts files, name resolution blocks and manually resolved
+         * addresses take precedence.
+         */
+        if (ws_inet_pton4(addr_str, &ip4)) {
+            if (wmem_map_lookup(ipv4_hash_table, GUINT_TO_POINTER(ip4)) != NULL)
+                continue;
+            if (name != NULL) {
+                add_ipv4_name(ip4, name);
+            } else {
+                tp = new_ipv4(ip4);
+                fill_dummy_ip4(ip4, tp);
+                tp->flags |= TRIED_RESOLVE_ADDRESS;
+                wmem_map_insert(ipv4_hash_table, GUINT_TO_POINTER(ip4), tp);
+            }
+        } else if (ws_inet_pton6(addr_str, &ip6)) {
+            if (wmem_map_lookup(ipv6_hash_table, &ip6) != NULL)
+                continue;
+            if (name != NULL) {
+                add_ipv6_name(&ip6, name);
+            } else {
+                addr_key = wmem_new(wmem_epan_scope(), ws_in6_addr);
+                memcpy(addr_key, &ip6, sizeof(ip6));
+                tp6 = new_ipv6(&ip6);
+                fill_dummy_ip6(tp6);
+                tp6->flags |= TRIED_RESOLVE_ADDRESS;
+                wmem_map_insert(ipv6_hash_table, addr_key, tp6);
+            }
+        } else {
+            continue;
+        }
+        dns_cache_add(addr_str, name, added);
+    }
+    fclose(fp);
+
+    /* Loading the cache shouldn't be reported as newly resolved names */
+    new_resolved_objects = FALSE;
+}
+
+static void
+write_dns_cache_entry(gpointer key, gpointer value, gpointer user_data)
+{
+    const dns_cache_entry_t *entry = (const dns_cache_entry_t *)value;
+
+    fprintf((FILE *)user_data, "%" G_GINT64_FORMAT "\t%s\t%s\n",
+            entry->added, (const char *)key, entry->name ? entry->name : "-");
+}
+
+static void
+write_dns_cache(void)
+{
+    char *pf_dir_path;
+    char *path;
+    FILE *fp;
+
+    if (dns_cache_table == NULL || !dns_cache_changed)
+        return;
+
+    if (create_persconffile_dir(&pf_dir_path) == -1) {
+        g_free(pf_dir_path);
+        return;
+    }
+
+    path = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+    fp = ws_fopen(path, "w");
+    if (fp == NULL) {
+        report_open_failure(path, errno, TRUE);
+        g_free(path);
+        return;
+    }
+    g_free(path);
+
+    fputs("# Reverse DNS lookup cache.\n"
+          "#\n"
+          "# This file is regenerated when names are looked up and the\n"
+          "# \"nameres.use_dns_cache\" preference is enabled.\n", fp);
+    wmem_map_foreach(dns_cache_table, write_dns_cache_entry, fp);
+    fclose(fp);
+    dns_cache_changed = FALSE;
+}
+
 static void
 host_name_lookup_init(void)
 {
@@ -3124,6 +3685,9 @@ host_name_lookup_init(void)
     add_manually_resolved();
 
     ss7pc_name_lookup_init();
+
+    if (use_dns_cache && gbl_resolv_flags.network_name && gbl_resolv_flags.use_external_net_name_resolver)
+        read_dns_cache();
 }
 
 static void
@@ -3134,6 +3698,9 @@ host_name_lookup_cleanup(void)
 
     _host_name_lookup_cleanup();
 
+    write_dns_cache();
+    dns_cache_table = NULL;
+
     ipxnet_hash_table = NULL;
     ipv4_hash_table = NULL;
     ipv6_hash_table = NULL;
@@ -3379,7 +3946,7 @@ get_manuf_name_if_known(const guint8 *addr)
     oct = addr[2];
     manuf_key = manuf_key | oct;
 
-    manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    manuf_value = manuf_key_lookup(manuf_key);
     if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
         return NULL;
     }
@@ -3393,7 +3960,7 @@ uint_get_manuf_name_if_known(const guint manuf_key)
 {
     hashmanuf_t *manuf_value;
 
-    manuf_value = (hashmanuf_t *)wmem_map_lookup(manuf_hashtable, GUINT_TO_POINTER(manuf_key));
+    manuf_value = manuf_key_lookup(manuf_key);
     if ((manuf_value == NULL) || (manuf_value->status == HASHETHER_STATUS_UNRESOLVED)) {
         return NULL;
     }
@@ -3568,27 +4135,100 @@ get_host_ipaddr6(const char *host, ws_in6_addr *addrp)
     return FALSE;
 }
 
+/*
+ * The hash tables normally hold only what has been looked up so far. The
+ * functions handing them out for listing copy in the rest of the built-in
+ * entries first, without replacing those from the personal files.
+ */
+static void
+merge_builtin_ethers(void)
+{
+    guint8 addr[6];
+    guint  i;
+
+    if (ethers_builtin_merged || manuf_hashtable == NULL)
+        return;
+    load_personal_ethers();
+    ethers_builtin_merged = TRUE;
+
+    for (i = 0; i < builtin_manuf_count; i++) {
+        if (!wmem_map_contains(manuf_hashtable, GUINT_TO_POINTER(builtin_manuf[i].oui))) {
+            addr[0] = (guint8)(builtin_manuf[i].oui >> 16);
+            addr[1] = (guint8)(builtin_manuf[i].oui >> 8);
+            addr[2] = (guint8)builtin_manuf[i].oui;
+            manuf_hash_new_entry(addr, builtin_manuf[i].name, builtin_manuf[i].longname);
+        }
+    }
+
+    for (i = 0; i < builtin_wka_count; i++) {
+        builtin_eth_addr(addr, builtin_wka[i].addr);
+        if (!wmem_map_contains(wka_hashtable, addr))
+            wka_hash_new_entry(addr, builtin_wka[i].name);
+    }
+
+    for (i = 0; i < builtin_ethers_count; i++) {
+        builtin_eth_addr(addr, builtin_ethers[i].addr);
+        /* Resolved, so that an ethers file still names it first. */
+        if (!wmem_map_contains(eth_hashtable, addr))
+            eth_hash_new_entry(addr, TRUE);
+    }
+}
+
+static void
+merge_builtin_services(void)
+{
+    const builtin_serv_t *serv;
+    serv_port_t *serv_port_table;
+    guint  i;
+
+    if (services_builtin_merged || serv_port_hashtable == NULL)
+        return;
+    load_personal_services();
+    services_builtin_merged = TRUE;
+
+    for (i = 0; i < builtin_services_count; i++) {
+        serv = &builtin_services[i];
+        serv_port_table = (serv_port_t *)wmem_map_lookup(serv_port_hashtable, GUINT_TO_POINTER(serv->port));
+        if (serv_port_table == NULL) {
+            serv_port_table = wmem_new0(wmem_epan_scope(), serv_port_t);
+            wmem_map_insert(serv_port_hashtable, GUINT_TO_POINTER(serv->port), serv_port_table);
+        }
+        if (serv_port_table->tcp_name == NULL && serv->tcp_name != NULL)
+            serv_port_table->tcp_name = wmem_strdup(wmem_epan_scope(), serv->tcp_name);
+        if (serv_port_table->udp_name == NULL && serv->udp_name != NULL)
+            serv_port_table->udp_name = wmem_strdup(wmem_epan_scope(), serv->udp_name);
+        if (serv_port_table->sctp_name == NULL && serv->sctp_name != NULL)
+            serv_port_table->sctp_name = wmem_strdup(wmem_epan_scope(), serv->sctp_name);
+        if (serv_port_table->dccp_name == NULL && serv->dccp_name != NULL)
+            serv_port_table->dccp_name = wmem_strdup(wmem_epan_scope(), serv->dccp_name);
+    }
+}
+
 wmem_map_t *
 get_manuf_hashtable(void)
 {
+    merge_builtin_ethers();
     return manuf_hashtable;
 }
 
 wmem_map_t *
 get_wka_hashtable(void)
 {
+    merge_builtin_ethers();
     return wka_hashtable;
 }
 
 wmem_map_t *
 get_eth_hashtable(void)
 {
+    merge_builtin_ethers();
     return eth_hashtable;
 }
 
 wmem_map_t *
 get_serv_port_hashtable(void)
 {
+    merge_builtin_services();
     return serv_port_hashtable;
 }
 
@@ -194,6 +194,28 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/** Queue an asynchronous lookup of an IPv4 or IPv6 address, if it hasn't
+ *  been looked up already, even when resolving synchronously. Used to
+ *  look up the addresses of a file in parallel ahead of time; see
+ *  host_name_lookup_wait(). Other address types are ignored.
+ */
+WS_DLL_PUBLIC void host_name_lookup_prefetch(const address *addr);
+
+/** Are there asynchronous lookups queued or in flight? If not, there's
+ *  nothing for host_name_lookup_process() to do for c-ares.
+ */
+WS_DLL_PUBLIC gboolean host_name_lookups_pending(void);
+
+/** Send all queued lookups, as many at a time as the concurrency
+ *  preference allows, and wait until they have completed or the
+ *  "name_resolve_timeout" preference has expired. Lookups still
+ *  outstanding at that point are abandoned.
+ *
+ * @return True if any new objects have been resolved since the previous
+ * call to host_name_lookup_process().
+ */
+WS_DLL_PUBLIC gboolean host_name_lookup_wait(void);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/proto.h>
@@ -23,6 +25,41 @@
 /* REPLACEMENT CHARACTER */
 #define UNREPL 0xFFFD
 
+/*
+ * Returns how many of the octets at ptr, up to length, are ASCII.
+ * Protocol strings are mostly ASCII, so check eight octets at a time.
+ */
+static inline gint
+ascii_run_length(const guint8 *ptr, gint length)
+{
+    guint64 w;
+    gint    i = 0;
+
+    while (i + 8 <= length) {
+        memcpy(&w, ptr + i, sizeof(w));
+        if (w & G_GUINT64_CONSTANT(0x8080808080808080))
+            break;
+        i += 8;
+    }
+    while (i < length && ptr[i] < 0x80)
+        i++;
+    return i;
+}
+
+/*
+ * ASCII is the same in UTF-8, so an all-ASCII string is just copied.
+ */
+static guint8 *
+copy_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
+{
+    guint8 *str;
+
+    str = (guint8 *)wmem_alloc(scope, length + 1);
+    memcpy(str, ptr, length);
+    str[length] = '\0';
+    return str;
+}
+
 /*
  * Wikipedia's "Character encoding" template, giving a pile of character
  * encodings and Wikipedia pages for them:
@@ -66,22 +103,32 @@
 guint8 *
 get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    gint    run;
 
-    str = wmem_strbuf_sized_new(scope, length+1, 0);
+    run = ascii_run_length(ptr, length);
+    if (run == length)
+        return copy_ascii_string(scope, ptr, length);
 
-    while (length > 0) {
-        guint8 ch = *ptr;
+    /* A REPLACEMENT CHARACTER takes three bytes in UTF-8. */
+    str = out = (guint8 *)wmem_alloc(scope, run + 3 * (length - run) + 1);
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else
-            wmem_strbuf_append_unichar(str, UNREPL);
+    while (length > 0) {
+        memcpy(out, ptr, run);
+        out += run;
+        ptr += run;
+        length -= run;
+        if (length == 0)
+            break;
+
+        out += g_unichar_to_utf8(UNREPL, (gchar *)out);
         ptr++;
         length--;
+        run = ascii_run_length(ptr, length);
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -145,29 +192,42 @@ get_iso_646_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, cons
 guint8 *
 get_8859_1_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    gint    run;
 
-    str = wmem_strbuf_sized_new(scope, length+1, 0);
+    run = ascii_run_length(ptr, length);
+    if (run == length)
+        return copy_ascii_string(scope, ptr, length);
+
+    /* Octets 0x80-0xFF take two bytes in UTF-8. */
+    str = out = (guint8 *)wmem_alloc(scope, run + 2 * (length - run) + 1);
 
     while (length > 0) {
-        guint8 ch = *ptr;
+        guint8 ch;
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else {
-            /*
-             * Note: we assume here that the code points
-             * 0x80-0x9F are used for C1 control characters,
-             * and thus have the same value as the corresponding
-             * Unicode code points.
-             */
-            wmem_strbuf_append_unichar(str, ch);
-        }
+        memcpy(out, ptr, run);
+        out += run;
+        ptr += run;
+        length -= run;
+        if (length == 0)
+            break;
+
+        /*
+         * Note: we assume here that the code points
+         * 0x80-0x9F are used for C1 control characters,
+         * and thus have the same value as the corresponding
+         * Unicode code points.
+         */
+        ch = *ptr;
+        *out++ = 0xC0 | (ch >> 6);
+        *out++ = 0x80 | (ch & 0x3F);
         ptr++;
         length--;
+        run = ascii_run_length(ptr, length);
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -645,22 +705,32 @@ const gunichar2 charset_table_cp866[0x80] = {
 guint8 *
 get_unichar2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const gunichar2 table[0x80])
 {
-    wmem_strbuf_t *str;
+    guint8 *str, *out;
+    gint    run;
 
-    str = wmem_strbuf_sized_new(scope, length+1, 0);
+    run = ascii_run_length(ptr, length);
+    if (run == length)
+        return copy_ascii_string(scope, ptr, length);
 
-    while (length > 0) {
-        guint8 ch = *ptr;
+    /* BMP characters take at most three bytes in UTF-8. */
+    str = out = (guint8 *)wmem_alloc(scope, run + 3 * (length - run) + 1);
 
-        if (ch < 0x80)
-            wmem_strbuf_append_c(str, ch);
-        else
-            wmem_strbuf_append_unichar(str, table[ch-0x80]);
+    while (length > 0) {
+        memcpy(out, ptr, run);
+        out += run;
+        ptr += run;
+        length -= run;
+        if (length == 0)
+            break;
+
+        out += g_unichar_to_utf8(table[*ptr-0x80], (gchar *)out);
         ptr++;
         length--;
+        run = ascii_run_length(ptr, length);
     }
+    *out = '\0';
 
-    return (guint8 *) wmem_strbuf_finalize(str);
+    return str;
 }
 
 /*
@@ -684,9 +754,10 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
 {
     gunichar2      uchar;
     gint           i;       /* Byte counter for string */
-    wmem_strbuf_t *strbuf;
+    guint8        *str, *out;
 
-    strbuf = wmem_strbuf_sized_new(scope, length+1, 0);
+    /* Each 2-byte character takes at most three bytes in UTF-8. */
+    str = out = (guint8 *)wmem_alloc(scope, (length / 2) * 3 + 1);
 
     for(i = 0; i + 1 < length; i += 2) {
         if (encoding == ENC_BIG_ENDIAN){
@@ -694,14 +765,18 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
         }else{
             uchar = pletoh16(ptr + i);
         }
-        wmem_strbuf_append_unichar(strbuf, uchar);
+        if (uchar < 0x80)
+            *out++ = (guint8)uchar;
+        else
+            out += g_unichar_to_utf8(uchar, (gchar *)out);
     }
+    *out = '\0';
 
     /*
      * XXX - if i < length, this means we were handed an odd
      * number of bytes, so we're not a valid UCS-2 string.
      */
-    return (guint8 *) wmem_strbuf_finalize(strbuf);
+    return str;
 }
 
 /*
@@ -720,12 +795,16 @@ get_ucs_2_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
 guint8 *
 get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const guint encoding)
 {
-    wmem_strbuf_t *strbuf;
+    guint8        *str, *out;
     gunichar2      uchar2, lead_surrogate;
     gunichar       uchar;
     gint           i;       /* Byte counter for string */
 
-    strbuf = wmem_strbuf_sized_new(scope, length+1, 0);
+    /*
+     * Each 2-byte unit takes at most three bytes in UTF-8 (a surrogate
+     * pair takes four), plus a REPLACEMENT CHARACTER for an odd byte.
+     */
+    str = out = (guint8 *)wmem_alloc(scope, (length / 2) * 3 + 3 + 1);
 
     for(i = 0; i + 1 < length; i += 2) {
         if (encoding == ENC_BIG_ENDIAN)
@@ -746,7 +825,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
                  * Insert a REPLACEMENT CHARACTER to mark the error,
                  * and quit.
                  */
-                wmem_strbuf_append_unichar(strbuf, UNREPL);
+                out += g_unichar_to_utf8(UNREPL, (gchar *)out);
                 break;
             }
             lead_surrogate = uchar2;
@@ -757,7 +836,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
             if (IS_TRAIL_SURROGATE(uchar2)) {
                 /* Trail surrogate. */
                 uchar = SURROGATE_VALUE(lead_surrogate, uchar2);
-                wmem_strbuf_append_unichar(strbuf, uchar);
+                out += g_unichar_to_utf8(uchar, (gchar *)out);
             } else {
                 /*
                  * Not a trail surrogate.
@@ -765,7 +844,7 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
                  * Insert a REPLACEMENT CHARACTER to mark the error,
                  * and continue;
                  */
-                wmem_strbuf_append_unichar(strbuf, UNREPL);
+                out += g_unichar_to_utf8(UNREPL, (gchar *)out);
             }
         } else {
             if (IS_TRAIL_SURROGATE(uchar2)) {
@@ -776,12 +855,15 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
                  * Insert a REPLACEMENT CHARACTER to mark the error,
                  * and continue;
                  */
-                wmem_strbuf_append_unichar(strbuf, UNREPL);
+                out += g_unichar_to_utf8(UNREPL, (gchar *)out);
             } else {
                 /*
                  * Non-surrogate; just append it.
                  */
-                wmem_strbuf_append_unichar(strbuf, uchar2);
+                if (uchar2 < 0x80)
+                    *out++ = (guint8)uchar2;
+                else
+                    out += g_unichar_to_utf8(uchar2, (gchar *)out);
             }
         }
     }
@@ -792,8 +874,9 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, const
      * to mark the error.
      */
     if (i < length)
-        wmem_strbuf_append_unichar(strbuf, UNREPL);
-    return (guint8 *) wmem_strbuf_finalize(strbuf);
+        out += g_unichar_to_utf8(UNREPL, (gchar *)out);
+    *out = '\0';
+    return str;
 }
 
 /*
@@ -0,0 +1,289 @@
+/* charsets_test.c
+ * Character set conversion tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "charsets.h"
+#include "proto.h"
+#include "wmem/wmem.h"
+
+/*
+ * The 8-bit converters copy runs of ASCII eight octets at a time, and the
+ * 16-bit ones store ASCII units directly. So besides the known conversions,
+ * each converter gets one non-ASCII character at every position of strings
+ * up to a few words long, where it ends or interrupts a run.
+ */
+
+#define MAX_CHARS   24
+
+#define UNREPL      0xFFFD
+#define UTF8_UNREPL "\xef\xbf\xbd"
+
+static wmem_allocator_t *test_scope;
+
+/* 0x80 is the euro sign and 0xE9 is CYRILLIC SMALL LETTER SHORT I */
+static gunichar2 test_table[0x80];
+
+typedef enum {
+    CONV_ASCII,
+    CONV_8859_1,
+    CONV_UNICHAR2
+} conv_8bit_e;
+
+typedef struct {
+    const char *in;
+    const char *out;
+} vector_t;
+
+/* Big-endian; each pair of octets is swapped for little-endian */
+typedef struct {
+    const char *in;
+    gint        len;
+    const char *out;
+} vector16_t;
+
+static guint8 *
+convert_8bit(conv_8bit_e conv, const guint8 *ptr, gint length)
+{
+    switch (conv) {
+    case CONV_ASCII:
+        return get_ascii_string(test_scope, ptr, length);
+    case CONV_8859_1:
+        return get_8859_1_string(test_scope, ptr, length);
+    case CONV_UNICHAR2:
+        return get_unichar2_string(test_scope, ptr, length, test_table);
+    }
+    g_assert_not_reached();
+    return NULL;
+}
+
+static void
+check_8bit(conv_8bit_e conv, const vector_t *vectors, guint num_vectors)
+{
+    guint i;
+
+    for (i = 0; i < num_vectors; i++) {
+        guint8 *got = convert_8bit(conv, (const guint8 *)vectors[i].in, (gint)strlen(vectors[i].in));
+
+        g_assert_cmpstr((const char *)got, ==, vectors[i].out);
+        wmem_free(test_scope, got);
+    }
+}
+
+/* Octet 0xE9 at every position of a run of 'a's, which must be copied as is */
+static void
+check_8bit_positions(conv_8bit_e conv, const char *converted)
+{
+    gchar  run[MAX_CHARS + 1];
+    guint8 in[MAX_CHARS];
+    gchar  expected[MAX_CHARS * 3 + 1];
+    guint8 *got;
+    gint   len, pos;
+
+    memset(run, 'a', MAX_CHARS);
+    run[MAX_CHARS] = '\0';
+    memset(in, 'a', sizeof in);
+    for (len = 0; len <= MAX_CHARS; len++) {
+        got = convert_8bit(conv, in, len);
+        g_assert_cmpstr((const char *)got, ==, run + MAX_CHARS - len);
+        wmem_free(test_scope, got);
+
+        for (pos = 0; pos < len; pos++) {
+            in[pos] = 0xE9;
+            g_snprintf(expected, sizeof expected, "%.*s%s%.*s", pos, run, converted, len - pos - 1, run);
+            got = convert_8bit(conv, in, len);
+            g_assert_cmpstr((const char *)got, ==, expected);
+            wmem_free(test_scope, got);
+            in[pos] = 'a';
+        }
+    }
+}
+
+static void
+charsets_test_ascii(void)
+{
+    static const vector_t vectors[] = {
+        { "", "" },
+        { "GET / HTTP/1.1", "GET / HTTP/1.1" },
+        { "caf\xe9", "caf" UTF8_UNREPL },
+        { "\x80\xff", UTF8_UNREPL UTF8_UNREPL },
+    };
+
+    check_8bit(CONV_ASCII, vectors, G_N_ELEMENTS(vectors));
+    check_8bit_positions(CONV_ASCII, UTF8_UNREPL);
+}
+
+static void
+charsets_test_8859_1(void)
+{
+    static const vector_t vectors[] = {
+        { "caf\xe9", "caf\xc3\xa9" },
+        { "\x80", "\xc2\x80" },
+        { "\xa0x\xff", "\xc2\xa0x\xc3\xbf" },
+    };
+
+    check_8bit(CONV_8859_1, vectors, G_N_ELEMENTS(vectors));
+    check_8bit_positions(CONV_8859_1, "\xc3\xa9");
+}
+
+static void
+charsets_test_unichar2(void)
+{
+    static const vector_t vectors[] = {
+        { "\x80" "5", "\xe2\x82\xac" "5" },
+        { "\xe9", "\xd0\xb9" },
+        /* Not in the table */
+        { "\x81", UTF8_UNREPL },
+    };
+
+    check_8bit(CONV_UNICHAR2, vectors, G_N_ELEMENTS(vectors));
+    check_8bit_positions(CONV_UNICHAR2, "\xd0\xb9");
+}
+
+static void
+check_16bit(gboolean utf16, const vector16_t *vectors, guint num_vectors)
+{
+    guint8 in[MAX_CHARS * 2];
+    guint8 *got;
+    guint  i;
+    gint   j;
+
+    for (i = 0; i < num_vectors; i++) {
+        g_assert(vectors[i].len <= (gint)sizeof in);
+
+        memcpy(in, vectors[i].in, vectors[i].len);
+        got = utf16 ? get_utf_16_string(test_scope, in, vectors[i].len, ENC_BIG_ENDIAN)
+                    : get_ucs_2_string(test_scope, in, vectors[i].len, ENC_BIG_ENDIAN);
+        g_assert_cmpstr((const char *)got, ==, vectors[i].out);
+        wmem_free(test_scope, got);
+
+        for (j = 0; j + 1 < vectors[i].len; j += 2) {
+            in[j] = vectors[i].in[j + 1];
+            in[j + 1] = vectors[i].in[j];
+        }
+        got = utf16 ? get_utf_16_string(test_scope, in, vectors[i].len, ENC_LITTLE_ENDIAN)
+                    : get_ucs_2_string(test_scope, in, vectors[i].len, ENC_LITTLE_ENDIAN);
+        g_assert_cmpstr((const char *)got, ==, vectors[i].out);
+        wmem_free(test_scope, got);
+    }
+}
+
+/* U+00E9 at every position of a run of 'a's */
+static void
+check_16bit_positions(gboolean utf16, guint encoding)
+{
+    gchar  run[MAX_CHARS + 1];
+    guint8 in[MAX_CHARS * 2];
+    gchar  expected[MAX_CHARS * 3 + 1];
+    guint8 *got;
+    gint   len, pos, i;
+
+    memset(run, 'a', MAX_CHARS);
+    run[MAX_CHARS] = '\0';
+    for (len = 1; len <= MAX_CHARS; len++) {
+        for (pos = 0; pos < len; pos++) {
+            for (i = 0; i < len; i++) {
+                guint8 c = (i == pos) ? 0xE9 : 'a';
+
+                in[2 * i] = (encoding == ENC_BIG_ENDIAN) ? 0 : c;
+                in[2 * i + 1] = (encoding == ENC_BIG_ENDIAN) ? c : 0;
+            }
+            g_snprintf(expected, sizeof expected, "%.*s\xc3\xa9%.*s", pos, run, len - pos - 1, run);
+            got = utf16 ? get_utf_16_string(test_scope, in, 2 * len, encoding)
+                        : get_ucs_2_string(test_scope, in, 2 * len, encoding);
+            g_assert_cmpstr((const char *)got, ==, expected);
+            wmem_free(test_scope, got);
+        }
+    }
+}
+
+static void
+charsets_test_utf_16(void)
+{
+    static const vector16_t vectors[] = {
+        { "\x00" "A" "\x00" "b", 4, "Ab" },
+        { "\x00\xe9\x20\xac", 4, "\xc3\xa9\xe2\x82\xac" },
+        /* U+1F600 */
+        { "\xd8\x3d\xde\x00", 4, "\xf0\x9f\x98\x80" },
+        /* A trail surrogate on its own */
+        { "\xde\x00\x00" "A", 4, UTF8_UNREPL "A" },
+        /* A lead surrogate takes the unit after it, whatever it is */
+        { "\xd8\x3d\x00" "A" "\x00" "b", 6, UTF8_UNREPL "b" },
+        { "\x00" "A" "\xd8\x3d", 4, "A" UTF8_UNREPL },
+        /* An odd octet at the end */
+        { "\x00" "A" "\x00", 3, "A" UTF8_UNREPL },
+    };
+
+    check_16bit(TRUE, vectors, G_N_ELEMENTS(vectors));
+    check_16bit_positions(TRUE, ENC_BIG_ENDIAN);
+    check_16bit_positions(TRUE, ENC_LITTLE_ENDIAN);
+}
+
+static void
+charsets_test_ucs_2(void)
+{
+    static const vector16_t vectors[] = {
+        { "\x00" "A" "\x00" "b", 4, "Ab" },
+        { "\x00\xe9\x20\xac", 4, "\xc3\xa9\xe2\x82\xac" },
+        /* No surrogate pairs in UCS-2 */
+        { "\xd8\x3d\xde\x00", 4, "\xed\xa0\xbd\xed\xb8\x80" },
+        /* An odd octet at the end is dropped */
+        { "\x00" "A" "\x00", 3, "A" },
+    };
+
+    check_16bit(FALSE, vectors, G_N_ELEMENTS(vectors));
+    check_16bit_positions(FALSE, ENC_BIG_ENDIAN);
+    check_16bit_positions(FALSE, ENC_LITTLE_ENDIAN);
+}
+
+int
+main(int argc, char **argv)
+{
+    int result;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(test_table); i++)
+        test_table[i] = UNREPL;
+    test_table[0x80 - 0x80] = 0x20AC;
+    test_table[0xE9 - 0x80] = 0x0439;
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/charsets/ascii",      charsets_test_ascii);
+    g_test_add_func("/charsets/8859_1",     charsets_test_8859_1);
+    g_test_add_func("/charsets/unichar2",   charsets_test_unichar2);
+    g_test_add_func("/charsets/utf_16",     charsets_test_utf_16);
+    g_test_add_func("/charsets/ucs_2",      charsets_test_ucs_2);
+
+    wmem_init();
+    test_scope = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    result = g_test_run();
+    wmem_destroy_allocator(test_scope);
+    wmem_cleanup();
+
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
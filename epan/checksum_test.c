@@ -0,0 +1,215 @@
+/* checksum_test.c
+ * CRC-32 and Internet checksum tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "tvbuff.h"
+#include "in_cksum.h"
+
+#include <wsutil/crc32.h>
+
+/*
+ * The fast paths take words at a time from wherever the data starts, so
+ * the pattern below is checked at every alignment, with heads and tails
+ * of every length split off and chained back on.
+ */
+
+#define PATTERN_LEN         4096
+#define PATTERN_CRC32       0x5D1C4EE3
+#define PATTERN_CRC32C      0xE1C2F7E8
+#define PATTERN_CKSUM       0x03FC
+#define PATTERN_CKSUM_ODD   0x04E4      /* without the last octet */
+#define SPLIT_MAX           40
+
+#define LONG_LEN            (256 * 1024)
+
+static guint8 *
+make_pattern(guint offset)
+{
+    guint8 *buf = (guint8 *)g_malloc(offset + PATTERN_LEN);
+    guint i;
+
+    for (i = 0; i < PATTERN_LEN; i++)
+        buf[offset + i] = (guint8)(i * 31 + 7);
+    return buf;
+}
+
+static guint32
+crc32c_final(const guint8 *buf, guint len)
+{
+    return crc32c_calculate_no_swap(buf, len, CRC32C_PRELOAD) ^ 0xFFFFFFFF;
+}
+
+static void
+checksum_test_crc32_known(void)
+{
+    static const struct {
+        const char *data;
+        guint       len;
+        guint32     crc32;
+        guint32     crc32c;
+    } vectors[] = {
+        /* The standard check values */
+        { "123456789", 9, 0xCBF43926, 0xE3069283 },
+        /* RFC 3720 B.4 */
+        { "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+          "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00",
+          32, 0x190A55AD, 0x8A9136AA },
+        { "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+          "\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff",
+          32, 0xFF6CAB0B, 0x62A8AB43 },
+        { "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"
+          "\x10\x11\x12\x13\x14\x15\x16\x17\x18\x19\x1a\x1b\x1c\x1d\x1e\x1f",
+          32, 0x91267E8A, 0x46DD794E },
+        { "\x1f\x1e\x1d\x1c\x1b\x1a\x19\x18\x17\x16\x15\x14\x13\x12\x11\x10"
+          "\x0f\x0e\x0d\x0c\x0b\x0a\x09\x08\x07\x06\x05\x04\x03\x02\x01\x00",
+          32, 0x9AB0EF72, 0x113FDB5C },
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(vectors); i++) {
+        const guint8 *data = (const guint8 *)vectors[i].data;
+
+        g_assert_cmphex(crc32_ccitt(data, vectors[i].len), ==, vectors[i].crc32);
+        g_assert_cmphex(crc32c_final(data, vectors[i].len), ==, vectors[i].crc32c);
+        g_assert_cmphex(crc32c_calculate(data, vectors[i].len, CRC32C_SWAP(CRC32C_PRELOAD)), ==,
+                        CRC32C_SWAP(vectors[i].crc32c ^ 0xFFFFFFFF));
+    }
+}
+
+static void
+checksum_test_crc32_alignment(void)
+{
+    guint offset, head, tail;
+
+    for (offset = 0; offset < 16; offset++) {
+        guint8 *buf = make_pattern(offset);
+        const guint8 *p = buf + offset;
+
+        g_assert_cmphex(crc32_ccitt(p, PATTERN_LEN), ==, PATTERN_CRC32);
+        g_assert_cmphex(crc32c_final(p, PATTERN_LEN), ==, PATTERN_CRC32C);
+
+        for (head = 0; head <= SPLIT_MAX; head++) {
+            for (tail = 0; tail <= SPLIT_MAX; tail++) {
+                guint mid = PATTERN_LEN - head - tail;
+                guint32 crc;
+
+                crc = crc32_ccitt_seed(p, head, CRC32_CCITT_SEED);
+                crc = crc32_ccitt_seed(p + head, mid, ~crc);
+                crc = crc32_ccitt_seed(p + head + mid, tail, ~crc);
+                g_assert_cmphex(crc, ==, PATTERN_CRC32);
+
+                crc = crc32c_calculate_no_swap(p, head, CRC32C_PRELOAD);
+                crc = crc32c_calculate_no_swap(p + head, mid, crc);
+                crc = crc32c_calculate_no_swap(p + head + mid, tail, crc);
+                g_assert_cmphex(crc ^ 0xFFFFFFFF, ==, PATTERN_CRC32C);
+            }
+        }
+        g_free(buf);
+    }
+}
+
+static void
+checksum_test_in_cksum_known(void)
+{
+    /* RFC 1071 section 3 */
+    static const guint8 rfc1071[] = { 0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7 };
+    /* An IPv4 header with its checksum, 0xb861, in place */
+    static const guint8 ipv4[] = {
+        0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+        0xb8, 0x61, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7
+    };
+    guint8 hdr[sizeof ipv4];
+    vec_t vec[1];
+
+    SET_CKSUM_VEC_PTR(vec[0], rfc1071, sizeof rfc1071);
+    g_assert_cmphex(g_ntohs(in_cksum(vec, 1)), ==, 0x220d);
+
+    g_assert_cmphex(ip_checksum(ipv4, sizeof ipv4), ==, 0);
+    memcpy(hdr, ipv4, sizeof hdr);
+    hdr[10] = hdr[11] = 0;
+    g_assert_cmphex(g_ntohs(ip_checksum(hdr, sizeof hdr)), ==, 0xb861);
+}
+
+static void
+checksum_test_in_cksum_alignment(void)
+{
+    guint offset, head, tail;
+    vec_t vec[3];
+
+    for (offset = 0; offset < 16; offset++) {
+        guint8 *buf = make_pattern(offset);
+        const guint8 *p = buf + offset;
+
+        g_assert_cmphex(g_ntohs(ip_checksum(p, PATTERN_LEN)), ==, PATTERN_CKSUM);
+        g_assert_cmphex(g_ntohs(ip_checksum(p, PATTERN_LEN - 1)), ==, PATTERN_CKSUM_ODD);
+
+        /* Pieces of odd and even lengths start at odd and even addresses */
+        for (head = 0; head <= SPLIT_MAX; head++) {
+            for (tail = 0; tail <= SPLIT_MAX; tail++) {
+                guint mid = PATTERN_LEN - head - tail;
+
+                SET_CKSUM_VEC_PTR(vec[0], p, head);
+                SET_CKSUM_VEC_PTR(vec[1], p + head, mid);
+                SET_CKSUM_VEC_PTR(vec[2], p + head + mid, tail);
+                g_assert_cmphex(g_ntohs(in_cksum(vec, 3)), ==, PATTERN_CKSUM);
+            }
+        }
+        g_free(buf);
+    }
+}
+
+/* Long enough to overflow a 32-bit running sum of 16-bit words */
+static void
+checksum_test_in_cksum_long(void)
+{
+    guint8 *buf = (guint8 *)g_malloc(LONG_LEN);
+
+    memset(buf, 0xFF, LONG_LEN);
+    g_assert_cmphex(ip_checksum(buf, LONG_LEN), ==, 0);
+
+    /* 0x0101 words, so the byte order doesn't matter */
+    memset(buf, 0x01, LONG_LEN);
+    g_assert_cmphex(ip_checksum(buf, LONG_LEN), ==, 0xFDFD);
+    g_assert_cmphex(ip_checksum(buf + 1, LONG_LEN - 2), ==, 0xFEFE);
+
+    g_free(buf);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/checksum/crc32_known",            checksum_test_crc32_known);
+    g_test_add_func("/checksum/crc32_alignment",        checksum_test_crc32_alignment);
+    g_test_add_func("/checksum/in_cksum_known",         checksum_test_in_cksum_known);
+    g_test_add_func("/checksum/in_cksum_alignment",     checksum_test_in_cksum_alignment);
+    g_test_add_func("/checksum/in_cksum_long",          checksum_test_in_cksum_long);
+
+    return g_test_run();
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
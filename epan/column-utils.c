@@ -426,6 +426,9 @@ col_append_str_uint(column_info *cinfo, const gint col, const gchar *abbrev, gui
 {
   char buf[16];
 
+  if (!CHECK_COL(cinfo, col))
+    return;
+
   guint32_to_str_buf(val, buf, sizeof(buf));
   col_append_lstr(cinfo, col, sep ? sep : "", abbrev, "=", buf, COL_ADD_LSTR_TERMINATOR);
 }
@@ -448,6 +451,10 @@ col_append_ports(column_info *cinfo, const gint col, port_type typ, guint16 src,
 {
   char buf_src[32], buf_dst[32];
 
+  /* Don't bother with the service name lookups if nobody shows the column */
+  if (!CHECK_COL(cinfo, col))
+    return;
+
   col_snprint_port(buf_src, 32, typ, src);
   col_snprint_port(buf_dst, 32, typ, dst);
   col_append_lstr(cinfo, col, buf_src, " " UTF8_RIGHTWARDS_ARROW " ", buf_dst, COL_ADD_LSTR_TERMINATOR);
@@ -11,6 +11,7 @@
 
 #include "config.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "proto.h"
@@ -186,64 +187,353 @@ guint conversation_table_get_num(void)
     return wmem_tree_count(registered_ct_tables);
 }
 
-/** Compute the hash value for two given address/port pairs.
- * (Parameter type is gconstpointer for GHashTable compatibility.)
+/*
+ * Conversations and endpoints are both kept in ch->conv_array, found through
+ * ch->slots: an open addressing (linear probing) table of array indexes plus
+ * one, with 0 for a free slot. The address data of the items are allocated
+ * in ch->addr_scope, so that adding an item only allocates memory when one
+ * of those has to grow.
+ */
+
+typedef struct {
+    guint    (*hash)(gconstpointer item);
+    gboolean (*equal)(gconstpointer item1, gconstpointer item2);
+    guint64  (*frames)(gconstpointer item);
+    void     (*free_addresses)(wmem_allocator_t *scope, gpointer item);
+} ct_item_ops_t;
+
+/*
+ * With ch->max_items set, only that many items are kept, using the Space-Saving
+ * algorithm: a new item replaces the one with the fewest frames, taking those
+ * as its error. Counts start at zero on replacement, so they're exact for
+ * the time the item was kept, and items are ranked by count plus error, which
+ * keeps every item with more frames than the error of the least one.
+ */
+struct _ct_top_items {
+    guint32 *heap;              /* item indexes, lowest rank first */
+    guint32 *pos;               /* heap position of each item */
+    guint64 *error;             /* frames an item may be ranked with but didn't have */
+};
+
+#define CT_MIN_SLOTS 1024
+
+static inline gpointer
+ct_item(conv_hash_t *ch, guint idx)
+{
+    return ch->conv_array->data + (gsize)idx * g_array_get_element_size(ch->conv_array);
+}
+
+/* Returns the slot of the item equal to key, or the free slot it would go in. */
+static guint
+ct_find_slot(conv_hash_t *ch, const ct_item_ops_t *ops, gconstpointer key)
+{
+    guint mask = ch->num_slots - 1;
+    guint slot = ops->hash(key) & mask;
+
+    while (ch->slots[slot] != 0 && !ops->equal(ct_item(ch, ch->slots[slot] - 1), key)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void
+ct_grow_slots(conv_hash_t *ch, const ct_item_ops_t *ops)
+{
+    guint i;
+
+    g_free(ch->slots);
+    ch->num_slots = ch->num_slots ? ch->num_slots * 2 : CT_MIN_SLOTS;
+    ch->slots = g_new0(guint32, ch->num_slots);
+    for (i = 0; i < ch->conv_array->len; i++) {
+        ch->slots[ct_find_slot(ch, ops, ct_item(ch, i))] = i + 1;
+    }
+}
+
+/* Frees a slot, moving back the items that probed past it. */
+static void
+ct_remove_slot(conv_hash_t *ch, const ct_item_ops_t *ops, guint slot)
+{
+    guint mask = ch->num_slots - 1;
+    guint next, home;
+
+    for (next = (slot + 1) & mask; ch->slots[next] != 0; next = (next + 1) & mask) {
+        home = ops->hash(ct_item(ch, ch->slots[next] - 1)) & mask;
+        /* Can the item at next go in the free slot? */
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            ch->slots[slot] = ch->slots[next];
+            slot = next;
+        }
+    }
+    ch->slots[slot] = 0;
+}
+
+static inline guint64
+ct_top_rank(conv_hash_t *ch, const ct_item_ops_t *ops, guint32 idx)
+{
+    return ch->top->error[idx] + ops->frames(ct_item(ch, idx));
+}
+
+static void
+ct_top_swap(struct _ct_top_items *top, guint pos1, guint pos2)
+{
+    guint32 idx = top->heap[pos1];
+
+    top->heap[pos1] = top->heap[pos2];
+    top->heap[pos2] = idx;
+    top->pos[top->heap[pos1]] = pos1;
+    top->pos[top->heap[pos2]] = pos2;
+}
+
+static void
+ct_top_sift_up(conv_hash_t *ch, const ct_item_ops_t *ops, guint pos)
+{
+    while (pos > 0 && ct_top_rank(ch, ops, ch->top->heap[pos]) < ct_top_rank(ch, ops, ch->top->heap[(pos - 1) / 2])) {
+        ct_top_swap(ch->top, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void
+ct_top_sift_down(conv_hash_t *ch, const ct_item_ops_t *ops, guint pos)
+{
+    guint len = ch->conv_array->len;
+
+    for (;;) {
+        guint lowest = pos;
+        guint child = 2 * pos + 1;
+
+        if (child < len && ct_top_rank(ch, ops, ch->top->heap[child]) < ct_top_rank(ch, ops, ch->top->heap[lowest]))
+            lowest = child;
+        child++;
+        if (child < len && ct_top_rank(ch, ops, ch->top->heap[child]) < ct_top_rank(ch, ops, ch->top->heap[lowest]))
+            lowest = child;
+        if (lowest == pos)
+            return;
+        ct_top_swap(ch->top, pos, lowest);
+        pos = lowest;
+    }
+}
+
+/*
+ * Finds the item equal to key. If there's none, returns the index of a new
+ * item for the caller to fill in, after replacing the least one if the table
+ * is full, and sets is_new.
+ */
+static guint
+ct_lookup(conv_hash_t *ch, const ct_item_ops_t *ops, gsize item_size, gconstpointer key, gboolean *is_new)
+{
+    guint slot, idx;
+
+    /* if we don't have any entries at all yet */
+    if (ch->conv_array == NULL) {
+        ch->conv_array = g_array_sized_new(FALSE, FALSE, (guint)item_size, ch->max_items ? MIN(ch->max_items, 10000) : 10000);
+        ch->addr_scope = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+        ct_grow_slots(ch, ops);
+        if (ch->max_items) {
+            ch->top = g_new(struct _ct_top_items, 1);
+            ch->top->heap = g_new(guint32, ch->max_items);
+            ch->top->pos = g_new(guint32, ch->max_items);
+            ch->top->error = g_new(guint64, ch->max_items);
+        }
+    }
+
+    slot = ct_find_slot(ch, ops, key);
+    if (ch->slots[slot] != 0) {
+        *is_new = FALSE;
+        return ch->slots[slot] - 1;
+    }
+    *is_new = TRUE;
+
+    if (ch->max_items && ch->conv_array->len >= ch->max_items) {
+        gpointer least;
+
+        idx = ch->top->heap[0];
+        least = ct_item(ch, idx);
+        ch->top->error[idx] += ops->frames(least);
+        ch->evicted_frames += ops->frames(least);
+        ct_remove_slot(ch, ops, ct_find_slot(ch, ops, least));
+        ops->free_addresses(ch->addr_scope, least);
+        /* Removing may have moved the free slot. */
+        slot = ct_find_slot(ch, ops, key);
+    } else {
+        idx = ch->conv_array->len;
+        g_array_set_size(ch->conv_array, idx + 1);
+        if (ch->top) {
+            ch->top->heap[idx] = idx;
+            ch->top->pos[idx] = idx;
+            ch->top->error[idx] = 0;
+        }
+        /* Keep the table at most half full. */
+        if (2 * ch->conv_array->len > ch->num_slots) {
+            ch->conv_array->len--;
+            ct_grow_slots(ch, ops);
+            ch->conv_array->len++;
+            slot = ct_find_slot(ch, ops, key);
+        }
+    }
+    ch->slots[slot] = idx + 1;
+    return idx;
+}
+
+/* Re-ranks an item after its frame count went up. */
+static inline void
+ct_update_rank(conv_hash_t *ch, const ct_item_ops_t *ops, gconstpointer item)
+{
+    if (ch->top) {
+        guint idx = (guint)(((const gchar *)item - ch->conv_array->data) / g_array_get_element_size(ch->conv_array));
+        /* A new item has no frames yet, so it may also rank too high. */
+        ct_top_sift_up(ch, ops, ch->top->pos[idx]);
+        ct_top_sift_down(ch, ops, ch->top->pos[idx]);
+    }
+}
+
+static void
+ct_reset(conv_hash_t *ch)
+{
+    if (ch->conv_array != NULL) {
+        g_array_free(ch->conv_array, TRUE);
+        wmem_destroy_allocator(ch->addr_scope);
+    }
+    g_free(ch->slots);
+    if (ch->top) {
+        g_free(ch->top->heap);
+        g_free(ch->top->pos);
+        g_free(ch->top->error);
+        g_free(ch->top);
+    }
+
+    ch->conv_array = NULL;
+    ch->addr_scope = NULL;
+    ch->slots = NULL;
+    ch->num_slots = 0;
+    ch->top = NULL;
+    ch->evicted_frames = 0;
+}
+
+/** Compute the hash value for the address/port pairs of a conversation.
  *
- * @param v Conversation Key. MUST point to a conv_key_t struct.
- * @return Computed key hash.
+ * @param v Conversation. MUST point to a conv_item_t struct.
+ * @return Computed hash.
  */
 static guint
 conversation_hash(gconstpointer v)
 {
-    const conv_key_t *key = (const conv_key_t *)v;
+    const conv_item_t *conv = (const conv_item_t *)v;
     guint hash_val;
 
     hash_val = 0;
-    hash_val = add_address_to_hash(hash_val, &key->addr1);
-    hash_val += key->port1;
-    hash_val = add_address_to_hash(hash_val, &key->addr2);
-    hash_val += key->port2;
-    hash_val ^= key->conv_id;
-
+    hash_val = add_address_to_hash(hash_val, &conv->src_address);
+    hash_val += conv->src_port;
+    hash_val = add_address_to_hash(hash_val, &conv->dst_address);
+    hash_val += conv->dst_port;
+    hash_val ^= conv->conv_id;
+
+    /* Mix the bits, as slots are picked by the low ones. */
+    hash_val ^= hash_val >> 16;
+    hash_val *= 0x45d9f3b;
+    hash_val ^= hash_val >> 16;
     return hash_val;
 }
 
-/** Compare two conversation keys for an exact match.
- * (Parameter types are gconstpointer for GHashTable compatibility.)
+/** Compare two conversations for an exact match. Their addresses and
+ * ports are always ordered the same way.
  *
- * @param key1 First conversation. MUST point to a conv_key_t struct.
- * @param key2 Second conversation. MUST point to a conv_key_t struct.
+ * @param v1 First conversation. MUST point to a conv_item_t struct.
+ * @param v2 Second conversation. MUST point to a conv_item_t struct.
  * @return TRUE if conversations are equal, FALSE otherwise.
  */
 static gboolean
-conversation_equal(gconstpointer key1, gconstpointer key2)
-{
-    const conv_key_t *ck1 = (const conv_key_t *)key1;
-    const conv_key_t *ck2 = (const conv_key_t *)key2;
-
-    if (ck1->conv_id == ck2->conv_id)
-    {
-        if (ck1->port1 == ck2->port1 &&
-            ck1->port2 == ck2->port2 &&
-            addresses_equal(&ck1->addr1, &ck2->addr1) &&
-            addresses_equal(&ck1->addr2, &ck2->addr2)) {
-            return TRUE;
-        }
+conversation_equal(gconstpointer v1, gconstpointer v2)
+{
+    const conv_item_t *conv1 = (const conv_item_t *)v1;
+    const conv_item_t *conv2 = (const conv_item_t *)v2;
+
+    return conv1->conv_id == conv2->conv_id &&
+           conv1->src_port == conv2->src_port &&
+           conv1->dst_port == conv2->dst_port &&
+           addresses_equal(&conv1->src_address, &conv2->src_address) &&
+           addresses_equal(&conv1->dst_address, &conv2->dst_address);
+}
 
-        if (ck1->port2 == ck2->port1 &&
-            ck1->port1 == ck2->port2 &&
-            addresses_equal(&ck1->addr2, &ck2->addr1) &&
-            addresses_equal(&ck1->addr1, &ck2->addr2)) {
-            return TRUE;
-        }
-    }
+static guint64
+conversation_frames(gconstpointer v)
+{
+    const conv_item_t *conv = (const conv_item_t *)v;
 
-    /*
-     * The addresses, ports, or conversation IDs don't match.
-     */
-    return FALSE;
+    return conv->rx_frames + conv->tx_frames;
+}
+
+static void
+conversation_free_addresses(wmem_allocator_t *scope, gpointer v)
+{
+    conv_item_t *conv = (conv_item_t *)v;
+
+    free_address_wmem(scope, &conv->src_address);
+    free_address_wmem(scope, &conv->dst_address);
 }
 
+static const ct_item_ops_t conversation_ops = {
+    conversation_hash,
+    conversation_equal,
+    conversation_frames,
+    conversation_free_addresses
+};
+
+/*
+ * Compute the hash value for the address/port of an endpoint.
+ */
+static guint
+host_hash(gconstpointer v)
+{
+    const hostlist_talker_t *host = (const hostlist_talker_t *)v;
+    guint hash_val;
+
+    hash_val = 0;
+    hash_val = add_address_to_hash(hash_val, &host->myaddress);
+    hash_val += host->port;
+
+    hash_val ^= hash_val >> 16;
+    hash_val *= 0x45d9f3b;
+    hash_val ^= hash_val >> 16;
+    return hash_val;
+}
+
+/*
+ * Compare two endpoints for an exact match.
+ */
+static gboolean
+host_match(gconstpointer v, gconstpointer w)
+{
+    const hostlist_talker_t *v1 = (const hostlist_talker_t *)v;
+    const hostlist_talker_t *v2 = (const hostlist_talker_t *)w;
+
+    return v1->port == v2->port &&
+           addresses_equal(&v1->myaddress, &v2->myaddress);
+}
+
+static guint64
+host_frames(gconstpointer v)
+{
+    const hostlist_talker_t *host = (const hostlist_talker_t *)v;
+
+    return host->rx_frames + host->tx_frames;
+}
+
+static void
+host_free_addresses(wmem_allocator_t *scope, gpointer v)
+{
+    hostlist_talker_t *host = (hostlist_talker_t *)v;
+
+    free_address_wmem(scope, &host->myaddress);
+}
+
+static const ct_item_ops_t host_ops = {
+    host_hash,
+    host_match,
+    host_frames,
+    host_free_addresses
+};
+
 void
 reset_conversation_table_data(conv_hash_t *ch)
 {
@@ -251,23 +541,7 @@ reset_conversation_table_data(conv_hash_t *ch)
         return;
     }
 
-    if (ch->conv_array != NULL) {
-        guint i;
-        for(i = 0; i < ch->conv_array->len; i++){
-            conv_item_t *conv = &g_array_index(ch->conv_array, conv_item_t, i);
-            free_address(&conv->src_address);
-            free_address(&conv->dst_address);
-        }
-
-        g_array_free(ch->conv_array, TRUE);
-    }
-
-    if (ch->hashtable != NULL) {
-        g_hash_table_destroy(ch->hashtable);
-    }
-
-    ch->conv_array=NULL;
-    ch->hashtable=NULL;
+    ct_reset(ch);
 }
 
 void reset_hostlist_table_data(conv_hash_t *ch)
@@ -276,22 +550,27 @@ void reset_hostlist_table_data(conv_hash_t *ch)
         return;
     }
 
-    if (ch->conv_array != NULL) {
-        guint i;
-        for(i = 0; i < ch->conv_array->len; i++){
-            hostlist_talker_t *host = &g_array_index(ch->conv_array, hostlist_talker_t, i);
-            free_address(&host->myaddress);
-        }
+    ct_reset(ch);
+}
 
-        g_array_free(ch->conv_array, TRUE);
-    }
+const char *
+conversation_table_parse_max_items(const char *filter, guint *max_items)
+{
+    const char *p;
+    char *end;
+    unsigned long n;
 
-    if (ch->hashtable != NULL) {
-        g_hash_table_destroy(ch->hashtable);
+    *max_items = 0;
+    if (filter == NULL || strncmp(filter, "top:", 4) != 0) {
+        return filter;
     }
-
-    ch->conv_array=NULL;
-    ch->hashtable=NULL;
+    n = strtoul(filter + 4, &end, 10);
+    if (end == filter + 4 || (*end != '\0' && *end != ',') || n == 0 || n > G_MAXINT32) {
+        return filter;
+    }
+    *max_items = (guint)n;
+    p = end;
+    return *p == ',' ? p + 1 : NULL;
 }
 
 char *get_conversation_address(wmem_allocator_t *allocator, address *addr, gboolean resolve_names)
@@ -565,6 +844,52 @@ add_conversation_table_data(conv_hash_t *ch, const address *src, const address *
     add_conversation_table_data_with_conv_id(ch, src, dst, src_port, dst_port, CONV_ID_UNSET, num_frames, num_bytes, ts, abs_ts, ct_info, etype);
 }
 
+/*
+ * Finds the conversation between the already ordered addresses and ports,
+ * creating it with the given start time if it's new.
+ */
+static conv_item_t *
+get_conversation_item(conv_hash_t *ch, const address *addr1, const address *addr2, guint32 port1, guint32 port2,
+        conv_id_t conv_id, nstime_t *ts, nstime_t *abs_ts, ct_dissector_info_t *ct_info, endpoint_type etype)
+{
+    conv_item_t key, *conv_item;
+    gboolean is_new;
+
+    copy_address_shallow(&key.src_address, addr1);
+    copy_address_shallow(&key.dst_address, addr2);
+    key.src_port = port1;
+    key.dst_port = port2;
+    key.conv_id = conv_id;
+    conv_item = (conv_item_t *)ct_item(ch, ct_lookup(ch, &conversation_ops, sizeof(conv_item_t), &key, &is_new));
+
+    /* if this is a new conversation we need to initialize the struct */
+    if (is_new) {
+        copy_address_wmem(ch->addr_scope, &conv_item->src_address, addr1);
+        copy_address_wmem(ch->addr_scope, &conv_item->dst_address, addr2);
+        conv_item->dissector_info = ct_info;
+        conv_item->etype = etype;
+        conv_item->src_port = port1;
+        conv_item->dst_port = port2;
+        conv_item->conv_id = conv_id;
+        conv_item->rx_frames = 0;
+        conv_item->tx_frames = 0;
+        conv_item->rx_bytes = 0;
+        conv_item->tx_bytes = 0;
+
+        if (ts) {
+            memcpy(&conv_item->start_time, ts, sizeof(conv_item->start_time));
+            memcpy(&conv_item->stop_time, ts, sizeof(conv_item->stop_time));
+            memcpy(&conv_item->start_abs_time, abs_ts, sizeof(conv_item->start_abs_time));
+        } else {
+            nstime_set_unset(&conv_item->start_abs_time);
+            nstime_set_unset(&conv_item->start_time);
+            nstime_set_unset(&conv_item->stop_time);
+        }
+    }
+
+    return conv_item;
+}
+
 void
 add_conversation_table_data_with_conv_id(
     conv_hash_t *ch,
@@ -582,8 +907,7 @@ add_conversation_table_data_with_conv_id(
 {
     const address *addr1, *addr2;
     guint32 port1, port2;
-    conv_item_t *conv_item = NULL;
-    unsigned int conversation_idx = 0;
+    conv_item_t *conv_item;
 
     if (src_port > dst_port) {
         addr1 = src;
@@ -607,70 +931,7 @@ add_conversation_table_data_with_conv_id(
         port1 = dst_port;
     }
 
-    /* if we don't have any entries at all yet */
-    if (ch->conv_array == NULL) {
-        ch->conv_array = g_array_sized_new(FALSE, FALSE, sizeof(conv_item_t), 10000);
-
-        ch->hashtable = g_hash_table_new_full(conversation_hash,
-                                              conversation_equal, /* key_equal_func */
-                                              g_free,             /* key_destroy_func */
-                                              NULL);              /* value_destroy_func */
-
-    } else {
-        /* try to find it among the existing known conversations */
-        conv_key_t existing_key;
-        gpointer conversation_idx_hash_val;
-
-        existing_key.addr1 = *addr1;
-        existing_key.addr2 = *addr2;
-        existing_key.port1 = port1;
-        existing_key.port2 = port2;
-        existing_key.conv_id = conv_id;
-        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
-            conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
-        }
-    }
-
-    /* if we still don't know what conversation this is it has to be a new one
-       and we have to allocate it and append it to the end of the list */
-    if (conv_item == NULL) {
-        conv_key_t *new_key;
-        conv_item_t new_conv_item;
-
-        copy_address(&new_conv_item.src_address, addr1);
-        copy_address(&new_conv_item.dst_address, addr2);
-        new_conv_item.dissector_info = ct_info;
-        new_conv_item.etype = etype;
-        new_conv_item.src_port = port1;
-        new_conv_item.dst_port = port2;
-        new_conv_item.conv_id = conv_id;
-        new_conv_item.rx_frames = 0;
-        new_conv_item.tx_frames = 0;
-        new_conv_item.rx_bytes = 0;
-        new_conv_item.tx_bytes = 0;
-
-        if (ts) {
-            memcpy(&new_conv_item.start_time, ts, sizeof(new_conv_item.start_time));
-            memcpy(&new_conv_item.stop_time, ts, sizeof(new_conv_item.stop_time));
-            memcpy(&new_conv_item.start_abs_time, abs_ts, sizeof(new_conv_item.start_abs_time));
-        } else {
-            nstime_set_unset(&new_conv_item.start_abs_time);
-            nstime_set_unset(&new_conv_item.start_time);
-            nstime_set_unset(&new_conv_item.stop_time);
-        }
-        g_array_append_val(ch->conv_array, new_conv_item);
-        conversation_idx = ch->conv_array->len - 1;
-        conv_item = &g_array_index(ch->conv_array, conv_item_t, conversation_idx);
-
-        /* ct->conversations address is not a constant but src/dst_address.data are */
-        new_key = g_new(conv_key_t, 1);
-        set_address(&new_key->addr1, conv_item->src_address.type, conv_item->src_address.len, conv_item->src_address.data);
-        set_address(&new_key->addr2, conv_item->dst_address.type, conv_item->dst_address.len, conv_item->dst_address.data);
-        new_key->port1 = port1;
-        new_key->port2 = port2;
-        new_key->conv_id = conv_id;
-        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
-    }
+    conv_item = get_conversation_item(ch, addr1, addr2, port1, port2, conv_id, ts, abs_ts, ct_info, etype);
 
     /* update the conversation struct */
     if ( (!cmp_address(src, addr1)) && (!cmp_address(dst, addr2)) && (src_port==port1) && (dst_port==port2) ) {
@@ -680,6 +941,7 @@ add_conversation_table_data_with_conv_id(
         conv_item->rx_frames += num_frames;
         conv_item->rx_bytes += num_bytes;
     }
+    ct_update_rank(ch, &conversation_ops, conv_item);
 
     if (ts) {
         if (nstime_cmp(ts, &conv_item->stop_time) > 0) {
@@ -692,95 +954,38 @@ add_conversation_table_data_with_conv_id(
 }
 
 /*
- * Compute the hash value for a given address/port pairs if the match
- * is to be exact.
+ * Finds the endpoint with the given address and port, creating it if it's new.
  */
-static guint
-host_hash(gconstpointer v)
+static hostlist_talker_t *
+get_hostlist_talker(conv_hash_t *ch, const address *addr, guint32 port, hostlist_dissector_info_t *host_info, endpoint_type etype)
 {
-    const host_key_t *key = (const host_key_t *)v;
-    guint hash_val;
-
-    hash_val = 0;
-    hash_val = add_address_to_hash(hash_val, &key->myaddress);
-    hash_val += key->port;
-    return hash_val;
-}
+    hostlist_talker_t key, *talker;
+    gboolean is_new;
 
-/*
- * Compare two host keys for an exact match.
- */
-static gint
-host_match(gconstpointer v, gconstpointer w)
-{
-    const host_key_t *v1 = (const host_key_t *)v;
-    const host_key_t *v2 = (const host_key_t *)w;
+    copy_address_shallow(&key.myaddress, addr);
+    key.port = port;
+    talker = (hostlist_talker_t *)ct_item(ch, ct_lookup(ch, &host_ops, sizeof(hostlist_talker_t), &key, &is_new));
 
-    if (v1->port == v2->port &&
-        addresses_equal(&v1->myaddress, &v2->myaddress)) {
-        return 1;
+    /* if this is a new talker we need to initialize the struct */
+    if (is_new) {
+        copy_address_wmem(ch->addr_scope, &talker->myaddress, addr);
+        talker->dissector_info = host_info;
+        talker->etype = etype;
+        talker->port = port;
+        talker->rx_frames = 0;
+        talker->tx_frames = 0;
+        talker->rx_bytes = 0;
+        talker->tx_bytes = 0;
+        talker->modified = TRUE;
     }
-    /*
-     * The addresses or the ports don't match.
-     */
-    return 0;
+
+    return talker;
 }
 
 void
 add_hostlist_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboolean sender, int num_frames, int num_bytes, hostlist_dissector_info_t *host_info, endpoint_type etype)
 {
-    hostlist_talker_t *talker=NULL;
-    int talker_idx=0;
-
-    /* XXX should be optimized to allocate n extra entries at a time
-       instead of just one */
-    /* if we don't have any entries at all yet */
-    if(ch->conv_array==NULL){
-        ch->conv_array=g_array_sized_new(FALSE, FALSE, sizeof(hostlist_talker_t), 10000);
-        ch->hashtable = g_hash_table_new_full(host_hash,
-                                              host_match, /* key_equal_func */
-                                              g_free,     /* key_destroy_func */
-                                              NULL);      /* value_destroy_func */
-    }
-    else {
-        /* try to find it among the existing known conversations */
-        host_key_t existing_key;
-        gpointer talker_idx_hash_val;
-
-        copy_address_shallow(&existing_key.myaddress, addr);
-        existing_key.port = port;
-
-        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &talker_idx_hash_val)) {
-            talker = &g_array_index(ch->conv_array, hostlist_talker_t, GPOINTER_TO_UINT(talker_idx_hash_val));
-        }
-    }
-
-    /* if we still don't know what talker this is it has to be a new one
-       and we have to allocate it and append it to the end of the list */
-    if(talker==NULL){
-        host_key_t *new_key;
-        hostlist_talker_t host;
-
-        copy_address(&host.myaddress, addr);
-        host.dissector_info = host_info;
-        host.etype=etype;
-        host.port=port;
-        host.rx_frames=0;
-        host.tx_frames=0;
-        host.rx_bytes=0;
-        host.tx_bytes=0;
-        host.modified = TRUE;
-
-        g_array_append_val(ch->conv_array, host);
-        talker_idx= ch->conv_array->len - 1;
-        talker=&g_array_index(ch->conv_array, hostlist_talker_t, talker_idx);
-
-        /* hl->hosts address is not a constant but address.data is */
-        new_key = g_new(host_key_t,1);
-        set_address(&new_key->myaddress, talker->myaddress.type, talker->myaddress.len, talker->myaddress.data);
-        new_key->port = port;
-        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(talker_idx));
-    }
+    hostlist_talker_t *talker = get_hostlist_talker(ch, addr, port, host_info, etype);
 
     /* if this is a new talker we need to initialize the struct */
     talker->modified = TRUE;
@@ -793,6 +998,178 @@ add_hostlist_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboo
         talker->rx_frames+=num_frames;
         talker->rx_bytes+=num_bytes;
     }
+    ct_update_rank(ch, &host_ops, talker);
+}
+
+static void
+put_address(GByteArray *state, const address *addr)
+{
+    tap_merge_put_uint(state, addr->type);
+    tap_merge_put_uint(state, addr->len);
+    tap_merge_put_bytes(state, addr->data, addr->len);
+}
+
+/* The address points into the state */
+static gboolean
+get_address(tap_merge_state_t *state, address *addr)
+{
+    guint32 type, len;
+
+    if (!tap_merge_get_uint(state, &type) || !tap_merge_get_uint(state, &len) ||
+        len > G_MAXINT || len > state->len - state->offset)
+        return FALSE;
+    set_address(addr, (int)type, (int)len, len ? state->data + state->offset : NULL);
+    state->offset += len;
+    return TRUE;
+}
+
+void
+conversation_table_serialize(void *tapdata, GByteArray *state)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    conv_item_t *conv_item;
+    guint i;
+
+    if (ch->conv_array == NULL) {
+        tap_merge_put_uint(state, 0);
+        return;
+    }
+
+    tap_merge_put_uint(state, ch->conv_array->len);
+    for (i = 0; i < ch->conv_array->len; i++) {
+        conv_item = &g_array_index(ch->conv_array, conv_item_t, i);
+        /* Static, so valid in every process forked after registration */
+        tap_merge_put_bytes(state, &conv_item->dissector_info, sizeof(conv_item->dissector_info));
+        put_address(state, &conv_item->src_address);
+        put_address(state, &conv_item->dst_address);
+        tap_merge_put_uint(state, conv_item->etype);
+        tap_merge_put_uint(state, conv_item->src_port);
+        tap_merge_put_uint(state, conv_item->dst_port);
+        tap_merge_put_bytes(state, &conv_item->conv_id, sizeof(conv_item->conv_id));
+        tap_merge_put_bytes(state, &conv_item->rx_frames, sizeof(guint64));
+        tap_merge_put_bytes(state, &conv_item->tx_frames, sizeof(guint64));
+        tap_merge_put_bytes(state, &conv_item->rx_bytes, sizeof(guint64));
+        tap_merge_put_bytes(state, &conv_item->tx_bytes, sizeof(guint64));
+        tap_merge_put_bytes(state, &conv_item->start_time, sizeof(nstime_t));
+        tap_merge_put_bytes(state, &conv_item->stop_time, sizeof(nstime_t));
+        tap_merge_put_bytes(state, &conv_item->start_abs_time, sizeof(nstime_t));
+    }
+}
+
+gboolean
+conversation_table_merge(void *tapdata, tap_merge_state_t *state)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    conv_item_t other, *conv_item;
+    guint32 num_items, etype;
+    guint i;
+
+    if (!tap_merge_get_uint(state, &num_items))
+        return FALSE;
+
+    /* Conversations new to us are added in the order the other table saw them. */
+    for (i = 0; i < num_items; i++) {
+        if (!tap_merge_get_bytes(state, &other.dissector_info, sizeof(other.dissector_info)) ||
+            !get_address(state, &other.src_address) ||
+            !get_address(state, &other.dst_address) ||
+            !tap_merge_get_uint(state, &etype) ||
+            !tap_merge_get_uint(state, &other.src_port) ||
+            !tap_merge_get_uint(state, &other.dst_port) ||
+            !tap_merge_get_bytes(state, &other.conv_id, sizeof(other.conv_id)) ||
+            !tap_merge_get_bytes(state, &other.rx_frames, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.tx_frames, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.rx_bytes, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.tx_bytes, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.start_time, sizeof(nstime_t)) ||
+            !tap_merge_get_bytes(state, &other.stop_time, sizeof(nstime_t)) ||
+            !tap_merge_get_bytes(state, &other.start_abs_time, sizeof(nstime_t)))
+            return FALSE;
+        other.etype = (endpoint_type)etype;
+
+        conv_item = get_conversation_item(ch, &other.src_address, &other.dst_address, other.src_port, other.dst_port,
+                other.conv_id, NULL, NULL, other.dissector_info, other.etype);
+
+        conv_item->rx_frames += other.rx_frames;
+        conv_item->tx_frames += other.tx_frames;
+        conv_item->rx_bytes += other.rx_bytes;
+        conv_item->tx_bytes += other.tx_bytes;
+        ct_update_rank(ch, &conversation_ops, conv_item);
+
+        if (nstime_is_unset(&conv_item->start_time) ||
+            (!nstime_is_unset(&other.start_time) && nstime_cmp(&other.start_time, &conv_item->start_time) < 0)) {
+            conv_item->start_time = other.start_time;
+            conv_item->start_abs_time = other.start_abs_time;
+        }
+        if (nstime_is_unset(&conv_item->stop_time) ||
+            (!nstime_is_unset(&other.stop_time) && nstime_cmp(&other.stop_time, &conv_item->stop_time) > 0)) {
+            conv_item->stop_time = other.stop_time;
+        }
+    }
+
+    return TRUE;
+}
+
+void
+hostlist_table_serialize(void *tapdata, GByteArray *state)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    hostlist_talker_t *talker;
+    guint i;
+
+    if (ch->conv_array == NULL) {
+        tap_merge_put_uint(state, 0);
+        return;
+    }
+
+    tap_merge_put_uint(state, ch->conv_array->len);
+    for (i = 0; i < ch->conv_array->len; i++) {
+        talker = &g_array_index(ch->conv_array, hostlist_talker_t, i);
+        /* Static, so valid in every process forked after registration */
+        tap_merge_put_bytes(state, &talker->dissector_info, sizeof(talker->dissector_info));
+        put_address(state, &talker->myaddress);
+        tap_merge_put_uint(state, talker->etype);
+        tap_merge_put_uint(state, talker->port);
+        tap_merge_put_bytes(state, &talker->rx_frames, sizeof(guint64));
+        tap_merge_put_bytes(state, &talker->tx_frames, sizeof(guint64));
+        tap_merge_put_bytes(state, &talker->rx_bytes, sizeof(guint64));
+        tap_merge_put_bytes(state, &talker->tx_bytes, sizeof(guint64));
+    }
+}
+
+gboolean
+hostlist_table_merge(void *tapdata, tap_merge_state_t *state)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    hostlist_talker_t other, *talker;
+    guint32 num_items, etype;
+    guint i;
+
+    if (!tap_merge_get_uint(state, &num_items))
+        return FALSE;
+
+    /* Endpoints new to us are added in the order the other table saw them. */
+    for (i = 0; i < num_items; i++) {
+        if (!tap_merge_get_bytes(state, &other.dissector_info, sizeof(other.dissector_info)) ||
+            !get_address(state, &other.myaddress) ||
+            !tap_merge_get_uint(state, &etype) ||
+            !tap_merge_get_uint(state, &other.port) ||
+            !tap_merge_get_bytes(state, &other.rx_frames, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.tx_frames, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.rx_bytes, sizeof(guint64)) ||
+            !tap_merge_get_bytes(state, &other.tx_bytes, sizeof(guint64)))
+            return FALSE;
+
+        talker = get_hostlist_talker(ch, &other.myaddress, other.port, other.dissector_info, (endpoint_type)etype);
+
+        talker->modified = TRUE;
+        talker->rx_frames += other.rx_frames;
+        talker->tx_frames += other.tx_frames;
+        talker->rx_bytes += other.rx_bytes;
+        talker->tx_bytes += other.tx_bytes;
+        ct_update_rank(ch, &host_ops, talker);
+    }
+
+    return TRUE;
 }
 
 /*
@@ -48,28 +48,21 @@ typedef enum {
 } conv_direction_e;
 
 /** Conversation hash + value storage
- * Hash table keys are conv_key_t. Hash table values are indexes into conv_array.
+ * There are no separate keys: the slots are looked up by the addresses, ports
+ * and conversation ID of the conv_array values (conv_item_t or
+ * hostlist_talker_t) themselves.
  */
 typedef struct _conversation_hash_t {
-    GHashTable  *hashtable;       /**< conversations hash table */
+    guint32     *slots;           /**< open addressing index of conv_array (index + 1, 0 if free) */
+    guint        num_slots;       /**< number of slots, a power of 2 */
     GArray      *conv_array;      /**< array of conversation values */
+    wmem_allocator_t *addr_scope; /**< addresses of the conv_array values */
+    guint        max_items;       /**< if not 0, keep only the approximate top max_items by frames */
+    struct _ct_top_items *top;    /**< ranking of the values, with max_items */
+    guint64      evicted_frames;  /**< frames of the values dropped to keep max_items */
     void        *user_data;       /**< "GUI" specifics (if necessary) */
 } conv_hash_t;
 
-/** Key for hash lookups */
-typedef struct _conversation_key_t {
-    address     addr1;
-    address     addr2;
-    guint32     port1;
-    guint32     port2;
-    conv_id_t   conv_id;
-} conv_key_t;
-
-typedef struct {
-    address  myaddress;
-    guint32  port;
-} host_key_t;
-
 struct _conversation_item_t;
 typedef const char* (*conv_get_filter_type)(struct _conversation_item_t* item, conv_filter_type_e filter);
 
@@ -216,6 +209,40 @@ WS_DLL_PUBLIC void reset_conversation_table_data(conv_hash_t *ch);
  */
 WS_DLL_PUBLIC void reset_hostlist_table_data(conv_hash_t *ch);
 
+/** Append the conversation table's entries, for set_tap_listener_merge().
+ * @param tapdata the conv_hash_t registered as the tap data
+ * @param state the serialized state
+ */
+WS_DLL_PUBLIC void conversation_table_serialize(void *tapdata, GByteArray *state);
+
+/** Add entries appended by conversation_table_serialize() to the conversation table.
+ * @param tapdata the conv_hash_t registered as the tap data
+ * @param state the serialized state
+ * @return FALSE if the state can't be read
+ */
+WS_DLL_PUBLIC gboolean conversation_table_merge(void *tapdata, tap_merge_state_t *state);
+
+/** Append the hostlist table's entries, for set_tap_listener_merge().
+ * @param tapdata the conv_hash_t registered as the tap data
+ * @param state the serialized state
+ */
+WS_DLL_PUBLIC void hostlist_table_serialize(void *tapdata, GByteArray *state);
+
+/** Add entries appended by hostlist_table_serialize() to the hostlist table.
+ * @param tapdata the conv_hash_t registered as the tap data
+ * @param state the serialized state
+ * @return FALSE if the state can't be read
+ */
+WS_DLL_PUBLIC gboolean hostlist_table_merge(void *tapdata, tap_merge_state_t *state);
+
+/** Parse a leading "top:<n>" from a conversation or endpoint tap argument.
+ *
+ * @param filter the tap argument following the table type, or NULL
+ * @param max_items set to n, or to 0 if there is none
+ * @return the rest of the argument (the display filter), or NULL if there is none
+ */
+WS_DLL_PUBLIC const char *conversation_table_parse_max_items(const char *filter, guint *max_items);
+
 /** Initialize dissector conversation for stats and (possibly) GUI.
  *
  * @param opt_arg filter string to compare with dissector
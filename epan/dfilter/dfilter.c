@@ -435,6 +435,42 @@ dfilter_deprecated_tokens(dfilter_t *df) {
 	return NULL;
 }
 
+gboolean
+dfilter_get_field_equality(const dfilter_t *df, header_field_info **hfinfo, fvalue_t **fvalue)
+{
+	dfvm_insn_t	*read_tree, *if_false, *any_eq, *ret, *put_fvalue;
+	guint32		field_reg, const_reg;
+	fvalue_t	*fv;
+
+	/* READ_TREE, IF_FALSE_GOTO, ANY_EQ and RETURN, with one constant. */
+	if (df->insns == NULL || df->insns->len != 4 || df->consts == NULL || df->consts->len != 1)
+		return FALSE;
+	read_tree = (dfvm_insn_t *)g_ptr_array_index(df->insns, 0);
+	if_false = (dfvm_insn_t *)g_ptr_array_index(df->insns, 1);
+	any_eq = (dfvm_insn_t *)g_ptr_array_index(df->insns, 2);
+	ret = (dfvm_insn_t *)g_ptr_array_index(df->insns, 3);
+	put_fvalue = (dfvm_insn_t *)g_ptr_array_index(df->consts, 0);
+	if (read_tree->op != READ_TREE || if_false->op != IF_FALSE_GOTO ||
+	    any_eq->op != ANY_EQ || ret->op != RETURN || put_fvalue->op != PUT_FVALUE)
+		return FALSE;
+
+	field_reg = read_tree->arg2->value.numeric;
+	const_reg = put_fvalue->arg2->value.numeric;
+	if (!((any_eq->arg1->value.numeric == field_reg && any_eq->arg2->value.numeric == const_reg) ||
+	      (any_eq->arg1->value.numeric == const_reg && any_eq->arg2->value.numeric == field_reg)))
+		return FALSE;
+
+	/* A subnet matches more than one address. */
+	fv = put_fvalue->arg1->value.fvalue;
+	if ((fvalue_type_ftenum(fv) == FT_IPv4 && fv->value.ipv4.nmask != 0xffffffff) ||
+	    (fvalue_type_ftenum(fv) == FT_IPv6 && fv->value.ipv6.prefix != 128))
+		return FALSE;
+
+	*hfinfo = read_tree->arg1->value.hfinfo;
+	*fvalue = fv;
+	return TRUE;
+}
+
 void
 dfilter_dump(dfilter_t *df)
 {
@@ -76,6 +76,15 @@ WS_DLL_PUBLIC
 GPtrArray *
 dfilter_deprecated_tokens(dfilter_t *df);
 
+/* If the dfilter only tests whether a field is equal to a constant
+ * ("field == value"), returns TRUE and sets hfinfo to the (first) field
+ * of that name and fvalue to the constant, which belongs to the dfilter.
+ * An address with a netmask or prefix isn't a single value, so
+ * "ip.addr == 10.0.0.0/8" returns FALSE. */
+WS_DLL_PUBLIC
+gboolean
+dfilter_get_field_equality(const dfilter_t *df, header_field_info **hfinfo, fvalue_t **fvalue);
+
 /* Print bytecode of dfilter to stdout */
 WS_DLL_PUBLIC
 void
@@ -441,14 +441,13 @@ dcm_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_,
            Still, the values will be freed when the export Object window is closed.
            Therefore, strings and buffers must be copied
         */
-        entry = g_new(export_object_entry_t, 1);
+        entry = eo_entry_new();
 
         entry->pkt_num = pinfo->num;
         entry->hostname = eo_info->hostname;
         entry->content_type = eo_info->content_type;
         entry->filename = g_path_get_basename(eo_info->filename);
-        entry->payload_len  = eo_info->payload_len;
-        entry->payload_data = eo_info->payload_data;
+        eo_entry_set_payload(object_list, entry, eo_info->payload_data, eo_info->payload_len);
 
         object_list->add_entry(object_list->gui_data, entry);
 
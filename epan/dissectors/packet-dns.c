@@ -4221,57 +4221,63 @@ static void dns_stats_tree_init(stats_tree* st)
   st_node_service_rrt = stats_tree_create_node(st, st_str_service_rrt, st_node_service_stats, STAT_DT_FLOAT, FALSE);
 }
 
+static const stat_node_key_vals st_key_packet_qr = { dns_qr_vals, "Unknown qr (%d)" };
+static const stat_node_key_vals st_key_packet_qtypes = { dns_types_description_vals, "Unknown packet type (%d)" };
+static const stat_node_key_vals st_key_packet_qclasses = { dns_classes, "Unknown class (%d)" };
+static const stat_node_key_vals st_key_packet_rcodes = { rcode_vals, "Unknown rcode (%d)" };
+static const stat_node_key_vals st_key_packet_opcodes = { opcode_vals, "Unknown opcode (%d)" };
+
 static tap_packet_status dns_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* edt _U_, const void* p)
 {
   const struct DnsTap *pi = (const struct DnsTap *)p;
-  tick_stat_node(st, st_str_packets, 0, FALSE);
-  stats_tree_tick_pivot(st, st_node_packet_qr,
-          val_to_str(pi->packet_qr, dns_qr_vals, "Unknown qr (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_qtypes,
-          val_to_str(pi->packet_qtype, dns_types_description_vals, "Unknown packet type (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_qclasses,
-          val_to_str(pi->packet_qclass, dns_classes, "Unknown class (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_rcodes,
-          val_to_str(pi->packet_rcode, rcode_vals, "Unknown rcode (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_opcodes,
-          val_to_str(pi->packet_opcode, opcode_vals, "Unknown opcode (%d)"));
-  avg_stat_node_add_value_int(st, st_str_packets_avg_size, 0, FALSE,
+  tick_stat_node_by_id(st, st_node_packets);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_qr, pi->packet_qr,
+          stats_tree_key_name_vals, &st_key_packet_qr);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_qtypes, pi->packet_qtype,
+          stats_tree_key_name_vals, &st_key_packet_qtypes);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_qclasses, pi->packet_qclass,
+          stats_tree_key_name_vals, &st_key_packet_qclasses);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_rcodes, pi->packet_rcode,
+          stats_tree_key_name_vals, &st_key_packet_rcodes);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_opcodes, pi->packet_opcode,
+          stats_tree_key_name_vals, &st_key_packet_opcodes);
+  avg_stat_node_add_value_int_by_id(st, st_node_packets_avg_size,
           pi->payload_size);
 
   /* split up stats for queries and responses */
   if (pi->packet_qr == 0) {
-    avg_stat_node_add_value_int(st, st_str_query_qname_len, 0, FALSE, pi->qname_len);
+    avg_stat_node_add_value_int_by_id(st, st_node_query_qname_len, pi->qname_len);
     switch(pi->qname_labels) {
       case 1:
-        tick_stat_node(st, st_str_query_domains_l1, 0, FALSE);
+        tick_stat_node_by_id(st, st_node_query_domains_l1);
         break;
       case 2:
-        tick_stat_node(st, st_str_query_domains_l2, 0, FALSE);
+        tick_stat_node_by_id(st, st_node_query_domains_l2);
         break;
       case 3:
-        tick_stat_node(st, st_str_query_domains_l3, 0, FALSE);
+        tick_stat_node_by_id(st, st_node_query_domains_l3);
         break;
       default:
-        tick_stat_node(st, st_str_query_domains_lmore, 0, FALSE);
+        tick_stat_node_by_id(st, st_node_query_domains_lmore);
         break;
     }
   } else {
-    avg_stat_node_add_value_int(st, st_str_response_nquestions, 0, FALSE, pi->nquestions);
-    avg_stat_node_add_value_int(st, st_str_response_nanswers, 0, FALSE, pi->nanswers);
-    avg_stat_node_add_value_int(st, st_str_response_nauthorities, 0, FALSE, pi->nauthorities);
-    avg_stat_node_add_value_int(st, st_str_response_nadditionals, 0, FALSE, pi->nadditionals);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nquestions, pi->nquestions);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nanswers, pi->nanswers);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nauthorities, pi->nauthorities);
+    avg_stat_node_add_value_int_by_id(st, st_node_response_nadditionals, pi->nadditionals);
     if (pi->unsolicited) {
-      tick_stat_node(st, st_str_service_unsolicited, 0, FALSE);
+      tick_stat_node_by_id(st, st_node_service_unsolicited);
     } else {
-        avg_stat_node_add_value_int(st, st_str_response_nquestions, 0, FALSE, pi->nquestions);
-        avg_stat_node_add_value_int(st, st_str_response_nanswers, 0, FALSE, pi->nanswers);
-        avg_stat_node_add_value_int(st, st_str_response_nauthorities, 0, FALSE, pi->nauthorities);
-        avg_stat_node_add_value_int(st, st_str_response_nadditionals, 0, FALSE, pi->nadditionals);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nquestions, pi->nquestions);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nanswers, pi->nanswers);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nauthorities, pi->nauthorities);
+        avg_stat_node_add_value_int_by_id(st, st_node_response_nadditionals, pi->nadditionals);
         if (pi->unsolicited) {
-          tick_stat_node(st, st_str_service_unsolicited, 0, FALSE);
+          tick_stat_node_by_id(st, st_node_service_unsolicited);
         } else {
           if (pi->retransmission)
-            tick_stat_node(st, st_str_service_retransmission, 0, FALSE);
+            tick_stat_node_by_id(st, st_node_service_retransmission);
           else
             avg_stat_node_add_value_float(st, st_str_service_rrt, 0, FALSE, (gfloat)(pi->rrt.secs + pi->rrt.nsecs/1000000000.0));
         }
@@ -351,14 +351,13 @@ http_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 	if(eo_info) { /* We have data waiting for us */
 		/* These values will be freed when the Export Object window
 		 * is closed. */
-		entry = g_new(export_object_entry_t, 1);
+		entry = eo_entry_new();
 
 		entry->pkt_num = pinfo->num;
 		entry->hostname = g_strdup(eo_info->hostname);
 		entry->content_type = g_strdup(eo_info->content_type);
 		entry->filename = eo_info->filename ? g_path_get_basename(eo_info->filename) : NULL;
-		entry->payload_len = eo_info->payload_len;
-		entry->payload_data = (guint8 *)g_memdup(eo_info->payload_data, eo_info->payload_len);
+		eo_entry_set_payload_copy(object_list, entry, eo_info->payload_data, eo_info->payload_len);
 
 		object_list->add_entry(object_list->gui_data, entry);
 
@@ -591,6 +590,18 @@ http_stats_tree_init(stats_tree* st)
 	st_node_other = stats_tree_create_node(st, st_str_other, st_node_packets, STAT_DT_INT, FALSE);
 }
 
+/* Names the node of a response code under its group */
+static void
+http_status_key_name(gchar *buf, gsize buf_len, guint32 key, const void *data _U_)
+{
+	const gchar *status = try_val_to_str(key, vals_http_status_code);
+
+	if (status)
+		g_snprintf(buf, (gulong) buf_len, "%u %s", key, status);
+	else
+		g_snprintf(buf, (gulong) buf_len, "%u Unknown (%u)", key, key);
+}
+
 /* HTTP/Packet Counter stats packet function */
 static tap_packet_status
 http_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* edt _U_, const void* p)
@@ -598,43 +609,33 @@ http_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* e
 	const http_info_value_t* v = (const http_info_value_t*)p;
 	guint i = v->response_code;
 	int resp_grp;
-	const gchar *resp_str;
-	gchar str[64];
 
-	tick_stat_node(st, st_str_packets, 0, FALSE);
+	tick_stat_node_by_id(st, st_node_packets);
 
 	if (i) {
-		tick_stat_node(st, st_str_responses, st_node_packets, FALSE);
+		tick_stat_node_by_id(st, st_node_responses);
 
 		if ( (i<100)||(i>=600) ) {
 			resp_grp = st_node_resp_broken;
-			resp_str = st_str_resp_broken;
 		} else if (i<200) {
 			resp_grp = st_node_resp_100;
-			resp_str = st_str_resp_100;
 		} else if (i<300) {
 			resp_grp = st_node_resp_200;
-			resp_str = st_str_resp_200;
 		} else if (i<400) {
 			resp_grp = st_node_resp_300;
-			resp_str = st_str_resp_300;
 		} else if (i<500) {
 			resp_grp = st_node_resp_400;
-			resp_str = st_str_resp_400;
 		} else {
 			resp_grp = st_node_resp_500;
-			resp_str = st_str_resp_500;
 		}
 
-		tick_stat_node(st, resp_str, st_node_responses, FALSE);
+		tick_stat_node_by_id(st, resp_grp);
 
-		g_snprintf(str, sizeof(str), "%u %s", i,
-			   val_to_str(i, vals_http_status_code, "Unknown (%d)"));
-		tick_stat_node(st, str, resp_grp, FALSE);
+		tick_stat_node_by_key(st, i, http_status_key_name, NULL, resp_grp, FALSE);
 	} else if (v->request_method) {
 		stats_tree_tick_pivot(st,st_node_requests,v->request_method);
 	} else {
-		tick_stat_node(st, st_str_other, st_node_packets, FALSE);
+		tick_stat_node_by_id(st, st_node_other);
 	}
 
 	return TAP_PACKET_REDRAW;
@@ -162,7 +162,7 @@ imf_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
   if(eo_info) { /* We have data waiting for us */
     /* These values will be freed when the Export Object window
      * is closed. */
-    entry = g_new(export_object_entry_t, 1);
+    entry = eo_entry_new();
 
     gchar *start = g_strrstr_len(eo_info->sender_data, -1, "<");
     gchar *stop = g_strrstr_len(eo_info->sender_data, -1,  ">");
@@ -177,8 +177,7 @@ imf_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
     entry->pkt_num = pinfo->num;
     entry->content_type = g_strdup("EML file");
     entry->filename = g_strdup_printf("%s.eml", eo_info->subject_data);
-    entry->payload_len = eo_info->payload_len;
-    entry->payload_data = (guint8 *)g_memdup(eo_info->payload_data, eo_info->payload_len);
+    eo_entry_set_payload_copy(object_list, entry, (const guint8 *)eo_info->payload_data, eo_info->payload_len);
 
     object_list->add_entry(object_list->gui_data, entry);
 
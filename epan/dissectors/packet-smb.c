@@ -1035,7 +1035,7 @@ typedef struct _free_chunk {
 /* insert_chunk function will recalculate the free_chunk_list, the data_size,
 	the end_of_file, and the data_gathered as appropriate.
 	It will also insert the data chunk that is coming in the right
-	place of the file in memory.
+	place of the file in memory, or of its file in the spill directory.
 	HINTS:
 	file->data_gathered		contains the real data gathered independently from the file length
 	file->file_length		contains the length of the file in memory, i.e.,
@@ -1043,7 +1043,7 @@ typedef struct _free_chunk {
 							file length would be different.
 */
 static void
-insert_chunk(active_file   *file, export_object_entry_t *entry, const smb_eo_t *eo_info)
+insert_chunk(export_object_list_t *object_list, active_file *file, export_object_entry_t *entry, const smb_eo_t *eo_info)
 {
 	gint       nfreechunks      = g_slist_length(file->free_chunk_list);
 	gint       i;
@@ -1130,6 +1130,16 @@ insert_chunk(active_file   *file, export_object_entry_t *entry, const smb_eo_t *
 		}
 	}
 
+	/* With a spill directory, the chunk goes straight to the file */
+	if (!file->is_out_of_memory && eo_entry_write_chunk(object_list, entry, chunk_offset, eo_info->payload_data, chunk_length)) {
+		return;
+	}
+	if (entry->payload_path) {
+		/* Writing failed part way through the file */
+		file->is_out_of_memory = TRUE;
+		return;
+	}
+
 	/* Now, let's insert the data chunk into memory
 	   ...first, we shall be able to allocate the memory */
 	if (!entry->payload_data) {
@@ -1283,9 +1293,9 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 
 	if (active_row == -1) { /* This is a new-tracked file */
 		/* Construct the entry in the list of active files */
-		entry = g_new(export_object_entry_t, 1);
-		entry->payload_data = NULL;
-		entry->payload_len = 0;
+		/* The chunks are written to the spill directory as they
+		   arrive, if there is one, or put together in memory */
+		entry = eo_entry_new();
 		new_file = (active_file *)g_malloc(sizeof(active_file));
 		new_file->tid = incoming_file.tid;
 		new_file->uid = incoming_file.uid;
@@ -1302,7 +1312,7 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 
 		/* Insert the first chunk in the chunk list of this file */
 		if (is_supported_filetype) {
-			insert_chunk(new_file, entry, eo_info);
+			insert_chunk(object_list, new_file, entry, eo_info);
 		}
 
 		if (new_file->is_out_of_memory) {
@@ -1337,7 +1347,7 @@ smb_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
 		current_file->flag_contains = current_file->flag_contains|contains;
 		current_entry = object_list->get_entry(object_list->gui_data, active_row);
 
-		insert_chunk(current_file, current_entry, eo_info);
+		insert_chunk(object_list, current_file, current_entry, eo_info);
 
 		/* Modify the current_entry object_type string */
 		if (current_file->is_out_of_memory) {
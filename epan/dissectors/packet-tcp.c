@@ -6248,6 +6248,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     if (tcpd) {
         item = proto_tree_add_uint(tcp_tree, hf_tcp_stream, tvb, offset, 0, tcpd->stream);
         proto_item_set_generated(item);
+        follow_add_stream_frame(TCP_STREAM, tcpd->stream, pinfo);
 
         /* Copy the stream index into the header as well to make it available
          * to tap listeners.
@@ -207,7 +207,7 @@ tftp_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
   export_object_entry_t *entry;
 
   /* These values will be freed when the Export Object window is closed. */
-  entry = g_new(export_object_entry_t, 1);
+  entry = eo_entry_new();
 
   /* Remember which frame had the last block of the file */
   entry->pkt_num = pinfo->num;
@@ -219,8 +219,7 @@ tftp_eo_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const
   g_free(eo_info->filename);
 
   /* Pass out the contiguous data and length already accumulated. */
-  entry->payload_len = eo_info->payload_len;
-  entry->payload_data = eo_info->payload_data;
+  eo_entry_set_payload(object_list, entry, eo_info->payload_data, eo_info->payload_len);
 
   /* These 2 fields not used */
   entry->hostname = NULL;
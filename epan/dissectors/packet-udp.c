@@ -1177,6 +1177,7 @@ dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint32 ip_proto)
   if (udpd) {
     item = proto_tree_add_uint(udp_tree, &hfi_udp_stream, tvb, offset, 0, udpd->stream);
     proto_item_set_generated(item);
+    follow_add_stream_frame(UDP_STREAM, udpd->stream, pinfo);
 
     /* Copy the stream index into the header as well to make it available
     * to tap listeners.
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <wsutil/ws_printf.h>
 
@@ -34,6 +35,12 @@ static int proto_malformed    = -1;
 static int expert_tap         = -1;
 static int highest_severity   =  0;
 
+/* Number of expert infos of each severity and group, counted as the frames
+ * are first dissected and indexed by the PI_ value shifted out of its mask */
+#define EXPERT_NUM_SEVERITIES ((PI_SEVERITY_MASK >> 20) + 1)
+#define EXPERT_NUM_GROUPS     ((PI_GROUP_MASK >> 24) + 1)
+static guint32 expert_counts[EXPERT_NUM_SEVERITIES][EXPERT_NUM_GROUPS];
+
 static int ett_expert         = -1;
 static int ett_subexpert      = -1;
 
@@ -245,6 +252,7 @@ expert_packet_init(void)
 	}
 
 	highest_severity = 0;
+	memset(expert_counts, 0, sizeof expert_counts);
 
 	proto_malformed = proto_get_id_by_filter_name("_ws.malformed");
 }
@@ -300,6 +308,22 @@ expert_get_highest_severity(void)
 	return highest_severity;
 }
 
+guint32
+expert_get_count(int severity, int group)
+{
+	guint32 count = 0;
+	guint   sev_idx = ((guint)severity & PI_SEVERITY_MASK) >> 20;
+	guint   group_idx;
+
+	if (group != 0) {
+		return expert_counts[sev_idx][((guint)group & PI_GROUP_MASK) >> 24];
+	}
+	for (group_idx = 0; group_idx < EXPERT_NUM_GROUPS; group_idx++) {
+		count += expert_counts[sev_idx][group_idx];
+	}
+	return count;
+}
+
 void
 expert_update_comment_count(guint64 count)
 {
@@ -493,10 +517,14 @@ expert_create_tree(proto_item *pi, int group, int severity, const char *msg)
 }
 
 static void
-expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int severity, int hf_index, gboolean use_vaformat,
+expert_set_info_vformat(packet_info *pinfo, proto_item *pi, expert_field_info *eiinfo, gboolean use_vaformat,
 			const char *format, va_list ap)
 {
 	char           formatted[ITEM_LABEL_LENGTH];
+	const char    *summary;
+	int            group    = eiinfo->group;
+	int            severity = eiinfo->severity;
+	int            hf_index = *eiinfo->hf_info.p_id;
 	int            tap;
 	expert_info_t *ei;
 	proto_tree    *tree;
@@ -515,6 +543,10 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 		highest_severity = severity;
 	}
 
+	if (!PINFO_FD_VISITED(pinfo)) {
+		expert_counts[((guint)severity & PI_SEVERITY_MASK) >> 20][((guint)group & PI_GROUP_MASK) >> 24]++;
+	}
+
 	/* XXX: can we get rid of these checks and make them programming errors instead now? */
 	if (pi != NULL && PITEM_FINFO(pi) != NULL) {
 		expert_set_item_flags(pi, group, severity);
@@ -525,24 +557,36 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 		col_add_str(pinfo->cinfo, COL_EXPERT, val_to_str(severity, expert_severity_vals, "Unknown (%u)"));
 	}
 
-	if (use_vaformat) {
+	/*
+	 * Only format the message if it will be shown, filtered on or tapped
+	 * by a listener that wants it; otherwise the items below are faked
+	 * anyway, and listeners that defer text get the registered summary
+	 * (the exact message is there when the frame is dissected to show it).
+	 */
+	if (!use_vaformat) {
+		summary = format;
+	} else if (proto_field_is_referenced(pi, proto_expert) ||
+		   proto_field_is_referenced(pi, hf_expert_msg) ||
+		   (hf_index != -1 && proto_field_is_referenced(pi, hf_index)) ||
+		   tap_listeners_require_text(expert_tap)) {
 		ws_vsnprintf(formatted, ITEM_LABEL_LENGTH, format, ap);
+		summary = formatted;
 	} else {
-		g_strlcpy(formatted, format, ITEM_LABEL_LENGTH);
+		summary = eiinfo->summary;
 	}
 
-	tree = expert_create_tree(pi, group, severity, formatted);
+	tree = expert_create_tree(pi, group, severity, summary);
 
 	if (hf_index == -1) {
 		/* If no filterable expert info, just add the message */
-		ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, formatted);
+		ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, summary);
 		proto_item_set_generated(ti);
 	} else {
 		/* If filterable expert info, hide the "generic" form of the message,
 		   and generate the formatted filterable expert info */
-		ti = proto_tree_add_none_format(tree, hf_index, NULL, 0, 0, "%s", formatted);
+		ti = proto_tree_add_none_format(tree, hf_index, NULL, 0, 0, "%s", summary);
 		proto_item_set_generated(ti);
-		ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, formatted);
+		ti = proto_tree_add_string(tree, hf_expert_msg, NULL, 0, 0, summary);
 		proto_item_set_hidden(ti);
 	}
 
@@ -565,7 +609,8 @@ expert_set_info_vformat(packet_info *pinfo, proto_item *pi, int group, int sever
 	ei->severity    = severity;
 	ei->hf_index    = hf_index;
 	ei->protocol    = pinfo->current_proto;
-	ei->summary     = wmem_strdup(wmem_packet_scope(), formatted);
+	/* The registered summary outlives the packet, only copy formatted ones */
+	ei->summary     = (summary == formatted) ? wmem_strdup(wmem_packet_scope(), summary) : (gchar *)summary;
 
 	/* if we have a proto_item (not a faked item), set expert attributes to it */
 	if (pi != NULL && PITEM_FINFO(pi) != NULL) {
@@ -591,7 +636,7 @@ expert_add_info_internal(packet_info *pinfo, proto_item *pi, expert_field *expin
 	EXPERT_REGISTRAR_GET_NTH(expindex->ei, eiinfo);
 
 	va_start(unused, expindex);
-	expert_set_info_vformat(pinfo, pi, eiinfo->group, eiinfo->severity, *eiinfo->hf_info.p_id, FALSE, eiinfo->summary, unused);
+	expert_set_info_vformat(pinfo, pi, eiinfo, FALSE, eiinfo->summary, unused);
 	va_end(unused);
 }
 
@@ -611,7 +656,7 @@ expert_add_info_format(packet_info *pinfo, proto_item *pi, expert_field *expinde
 	EXPERT_REGISTRAR_GET_NTH(expindex->ei, eiinfo);
 
 	va_start(ap, format);
-	expert_set_info_vformat(pinfo, pi, eiinfo->group, eiinfo->severity, *eiinfo->hf_info.p_id, TRUE, format, ap);
+	expert_set_info_vformat(pinfo, pi, eiinfo, TRUE, format, ap);
 	va_end(ap);
 }
 
@@ -637,7 +682,7 @@ proto_tree_add_expert_internal(proto_tree *tree, packet_info *pinfo, expert_fiel
 		item_length = captured_length;
 	ti = proto_tree_add_text_internal(tree, tvb, start, item_length, "%s", eiinfo->summary);
 	va_start(unused, length);
-	expert_set_info_vformat(pinfo, ti, eiinfo->group, eiinfo->severity, *eiinfo->hf_info.p_id, FALSE, eiinfo->summary, unused);
+	expert_set_info_vformat(pinfo, ti, eiinfo, FALSE, eiinfo->summary, unused);
 	va_end(unused);
 
 	/* But make sure it throws an exception *after* adding the item */
@@ -678,7 +723,7 @@ proto_tree_add_expert_format(proto_tree *tree, packet_info *pinfo, expert_field
 	va_end(ap);
 
 	va_start(ap, format);
-	expert_set_info_vformat(pinfo, ti, eiinfo->group, eiinfo->severity, *eiinfo->hf_info.p_id, TRUE, format, ap);
+	expert_set_info_vformat(pinfo, ti, eiinfo, TRUE, format, ap);
 	va_end(ap);
 
 	/* But make sure it throws an exception *after* adding the item */
@@ -92,6 +92,15 @@ expert_packet_cleanup(void);
 WS_DLL_PUBLIC int
 expert_get_highest_severity(void);
 
+/** Get the number of expert infos of a severity seen so far, counted as the
+ frames are first dissected (without formatting any message).
+ @param severity The severity (PI_ERROR, PI_WARN, ...)
+ @param group The group (PI_CHECKSUM, PI_SEQUENCE, ...), or 0 for all groups
+ @return The number of expert infos
+ */
+WS_DLL_PUBLIC guint32
+expert_get_count(int severity, int group);
+
 WS_DLL_PUBLIC void
 expert_update_comment_count(guint64 count);
 
@@ -10,12 +10,25 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 
+#include <wsutil/crc32.h>
+#include <wsutil/file_util.h>
+
 #include "proto.h"
 #include "packet_info.h"
 #include "export_object.h"
 
+/* The most passed to ws_write() or crc32c_calculate() at once */
+#define EO_SPILL_CHUNK 0x40000000
+
+struct _eo_spill_t {
+    gchar      *dir;
+    GHashTable *files;                   /* names of the files written to dir */
+    guint       n_chunked;               /* payloads written a chunk at a time so far */
+};
+
 struct register_eo {
     int proto_id;                        /* protocol id (0-indexed) */
     const char* tap_listen_str;          /* string used in register_tap_listener (NULL to use protocol name) */
@@ -146,12 +159,238 @@ eo_ct2ext(const char *content_type)
     return content_type;
 }
 
+eo_spill_t *
+eo_spill_new(const char *parent_dir)
+{
+    eo_spill_t *spill;
+    gchar *dir;
+
+    if (parent_dir == NULL || parent_dir[0] == '\0')
+        parent_dir = g_get_tmp_dir();
+    if (g_mkdir_with_parents(parent_dir, 0755) == -1)
+        return NULL;
+
+    dir = g_build_filename(parent_dir, "wireshark_eo_XXXXXX", NULL);
+    if (g_mkdtemp(dir) == NULL) {
+        g_free(dir);
+        return NULL;
+    }
+
+    spill = g_new(eo_spill_t, 1);
+    spill->dir = dir;
+    spill->files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    spill->n_chunked = 0;
+    return spill;
+}
+
+void
+eo_spill_reset(eo_spill_t *spill)
+{
+    GHashTableIter iter;
+    gpointer name;
+
+    g_hash_table_iter_init(&iter, spill->files);
+    while (g_hash_table_iter_next(&iter, &name, NULL)) {
+        gchar *path = g_build_filename(spill->dir, (const gchar *)name, NULL);
+        ws_unlink(path);
+        g_free(path);
+    }
+    g_hash_table_remove_all(spill->files);
+}
+
+void
+eo_spill_free(eo_spill_t *spill)
+{
+    if (spill == NULL)
+        return;
+
+    eo_spill_reset(spill);
+    ws_remove(spill->dir);
+    g_hash_table_destroy(spill->files);
+    g_free(spill->dir);
+    g_free(spill);
+}
+
+static gboolean
+eo_write_all(int fd, const guint8 *data, gint64 len)
+{
+    while (len != 0) {
+        ssize_t written = ws_write(fd, data, len > EO_SPILL_CHUNK ? EO_SPILL_CHUNK : (int)len);
+        if (written <= 0)
+            return FALSE;
+        data += written;
+        len -= written;
+    }
+    return TRUE;
+}
+
+/* Does a file hold exactly this data? */
+static gboolean
+eo_file_equals(const char *path, const guint8 *data, gint64 len)
+{
+    guint8 buf[16384];
+    gboolean equal = FALSE;
+    int fd;
+
+    fd = ws_open(path, O_RDONLY | O_BINARY, 0000);
+    if (fd == -1)
+        return FALSE;
+
+    for (;;) {
+        ssize_t bytes_read = ws_read(fd, buf, sizeof buf);
+        if (bytes_read < 0 || bytes_read > len || memcmp(buf, data, bytes_read) != 0)
+            break;
+        if (bytes_read == 0) {
+            equal = (len == 0);
+            break;
+        }
+        data += bytes_read;
+        len -= bytes_read;
+    }
+    ws_close(fd);
+    return equal;
+}
+
+/*
+ * Write a payload to a spill directory, unless it's there already, and
+ * return the path of its file. The file is named after the CRC-32C and
+ * length of the payload; as the CRC isn't collision-resistant, a file of
+ * that name is only shared if its contents are the same.
+ */
+static gchar *
+eo_spill_write(eo_spill_t *spill, const guint8 *data, gint64 len)
+{
+    guint32 crc = CRC32C_PRELOAD;
+    gint64 offset;
+    guint dupn;
+
+    for (offset = 0; offset < len; offset += EO_SPILL_CHUNK)
+        crc = crc32c_calculate(data + offset, (int)MIN(len - offset, EO_SPILL_CHUNK), crc);
+
+    for (dupn = 0; ; dupn++) {
+        gchar *name = g_strdup_printf("%08x-%" G_GINT64_MODIFIER "x-%u", crc, len, dupn);
+        gchar *path = g_build_filename(spill->dir, name, NULL);
+
+        if (!g_hash_table_contains(spill->files, name)) {
+            int fd = ws_open(path, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0600);
+            gboolean written = FALSE;
+
+            if (fd != -1) {
+                written = eo_write_all(fd, data, len);
+                if (ws_close(fd) < 0)
+                    written = FALSE;
+                if (!written)
+                    ws_unlink(path);
+            }
+            if (!written) {
+                g_free(name);
+                g_free(path);
+                return NULL;
+            }
+            g_hash_table_add(spill->files, name);
+            return path;
+        }
+
+        g_free(name);
+        if (eo_file_equals(path, data, len))
+            return path;
+        g_free(path);
+    }
+}
+
+export_object_entry_t *
+eo_entry_new(void)
+{
+    return g_new0(export_object_entry_t, 1);
+}
+
+void
+eo_entry_set_payload(export_object_list_t *object_list, export_object_entry_t *entry,
+                     guint8 *data, gint64 len)
+{
+    entry->payload_len = len;
+    entry->payload_data = data;
+    entry->payload_path = NULL;
+
+    if (object_list->spill == NULL || data == NULL)
+        return;
+
+    entry->payload_path = eo_spill_write(object_list->spill, data, len);
+    if (entry->payload_path != NULL) {
+        g_free(entry->payload_data);
+        entry->payload_data = NULL;
+    }
+}
+
+void
+eo_entry_set_payload_copy(export_object_list_t *object_list, export_object_entry_t *entry,
+                          const guint8 *data, gint64 len)
+{
+    entry->payload_len = len;
+    entry->payload_data = NULL;
+    entry->payload_path = NULL;
+
+    if (data == NULL)
+        return;
+
+    if (object_list->spill != NULL)
+        entry->payload_path = eo_spill_write(object_list->spill, data, len);
+    if (entry->payload_path == NULL)
+        entry->payload_data = (guint8 *)g_memdup(data, (guint)len);
+}
+
+/*
+ * Payloads written a chunk at a time get a file of their own, which isn't
+ * named after its contents, as those aren't known until the last chunk.
+ */
+gboolean
+eo_entry_write_chunk(export_object_list_t *object_list, export_object_entry_t *entry,
+                     gint64 offset, const guint8 *data, gint64 len)
+{
+    eo_spill_t *spill = object_list->spill;
+    gboolean written;
+    int fd;
+
+    if (spill == NULL || entry->payload_data != NULL)
+        return FALSE;
+
+    if (entry->payload_path == NULL) {
+        for (;;) {
+            gchar *name = g_strdup_printf("chunked-%u", spill->n_chunked++);
+            gchar *path = g_build_filename(spill->dir, name, NULL);
+
+            fd = ws_open(path, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0600);
+            if (fd != -1) {
+                g_hash_table_add(spill->files, name);
+                entry->payload_path = path;
+                break;
+            }
+            g_free(name);
+            g_free(path);
+            if (errno != EEXIST)
+                return FALSE;
+        }
+    } else {
+        fd = ws_open(entry->payload_path, O_WRONLY | O_BINARY, 0000);
+        if (fd == -1)
+            return FALSE;
+    }
+
+    written = ws_lseek64(fd, offset, SEEK_SET) == offset && eo_write_all(fd, data, len);
+    if (ws_close(fd) < 0)
+        written = FALSE;
+    if (written)
+        entry->payload_len = MAX(entry->payload_len, offset + len);
+    return written;
+}
+
 void eo_free_entry(export_object_entry_t *entry)
 {
     g_free(entry->hostname);
     g_free(entry->content_type);
     g_free(entry->filename);
     g_free(entry->payload_data);
+    g_free(entry->payload_path);
 
     g_free(entry);
 }
@@ -18,6 +18,9 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/** An object found by a tap handler. Entries must be allocated with
+    eo_entry_new(), as eo_free_entry() frees members that a handler
+    might not set. */
 typedef struct _export_object_entry_t {
     guint32 pkt_num;
     gchar *hostname;
@@ -26,13 +29,16 @@ typedef struct _export_object_entry_t {
     /* We need to store a 64 bit integer to hold a file length
       (was guint payload_len;)
 
-      XXX - we store the entire object in the program's address space,
-      so the *real* maximum object size is size_t; if we were to export
-      objects by going through all of the packets containing data from
-      the object, one packet at a time, and write the object incrementally,
-      we could support objects that don't fit into the address space. */
+      XXX - unless it's written to a spill directory (see
+      eo_entry_set_payload()), we store the entire object in the
+      program's address space, so the *real* maximum object size is
+      size_t; if we were to export objects by going through all of the
+      packets containing data from the object, one packet at a time, and
+      write the object incrementally, we could support objects that don't
+      fit into the address space. */
     gint64 payload_len;
     guint8 *payload_data;
+    gchar *payload_path;    /* file holding the payload if payload_data is NULL */
 } export_object_entry_t;
 
 /** Maximum file name size for the file to which we save an object.
@@ -44,10 +50,16 @@ typedef struct _export_object_entry_t {
 typedef void (*export_object_object_list_add_entry_cb)(void* gui_data, struct _export_object_entry_t *entry);
 typedef export_object_entry_t* (*export_object_object_list_get_entry_cb)(void* gui_data, int row);
 
+/** A directory to which the payloads of objects are written as they're
+    found, instead of keeping them in memory. Files are named after a hash
+    of their contents, so identical payloads are only written once. */
+typedef struct _eo_spill_t eo_spill_t;
+
 typedef struct _export_object_list_t {
     export_object_object_list_add_entry_cb add_entry; //GUI specific handler for adding an object entry
     export_object_object_list_get_entry_cb get_entry; //GUI specific handler for retrieving an object entry
     void* gui_data;                                   //GUI specific data (for UI representation)
+    eo_spill_t* spill;                                //Where to write payloads, or NULL to keep them in memory
 } export_object_list_t;
 
 /** Structure for information about a registered exported object */
@@ -128,6 +140,68 @@ WS_DLL_PUBLIC GString *eo_massage_str(const gchar *in_str, gsize maxlen, int dup
  */
 WS_DLL_PUBLIC const char *eo_ct2ext(const char *content_type);
 
+/** Create a spill directory for object payloads.
+ * @param parent_dir the directory in which to create it, or NULL for the
+ *  temporary directory
+ * @return the spill directory, or NULL if it couldn't be created
+ */
+WS_DLL_PUBLIC eo_spill_t *eo_spill_new(const char *parent_dir);
+
+/** Remove the payloads written to a spill directory.
+ * @param spill the spill directory
+ */
+WS_DLL_PUBLIC void eo_spill_reset(eo_spill_t *spill);
+
+/** Remove a spill directory and the payloads written to it.
+ * @param spill the spill directory, or NULL
+ */
+WS_DLL_PUBLIC void eo_spill_free(eo_spill_t *spill);
+
+/** Allocate an entry for an object, with all of its members zeroed.
+ * Tap handlers must use this rather than allocating entries themselves.
+ * @return the entry, to be freed with eo_free_entry()
+ */
+WS_DLL_PUBLIC export_object_entry_t *eo_entry_new(void);
+
+/** Set the payload of an object. Tap handlers use this for objects that
+ * are complete, so that the payload goes to the spill directory of the
+ * object list if it has one; otherwise (or if writing it fails) it's kept
+ * in memory.
+ * @param object_list the object list the entry is added to
+ * @param entry the entry of the object
+ * @param data the payload, allocated with g_malloc(); the entry takes it over
+ * @param len the length of the payload
+ */
+WS_DLL_PUBLIC void eo_entry_set_payload(export_object_list_t *object_list, export_object_entry_t *entry,
+                                        guint8 *data, gint64 len);
+
+/** Like eo_entry_set_payload(), for a payload the tap handler doesn't own.
+ * It's written to the spill directory straight from data, and only copied
+ * if it's kept in memory.
+ * @param object_list the object list the entry is added to
+ * @param entry the entry of the object
+ * @param data the payload
+ * @param len the length of the payload
+ */
+WS_DLL_PUBLIC void eo_entry_set_payload_copy(export_object_list_t *object_list, export_object_entry_t *entry,
+                                             const guint8 *data, gint64 len);
+
+/** Write a chunk of an object's payload at its offset, for objects that
+ * are put together from pieces arriving in any order. The first call
+ * creates a file for the payload in the spill directory of the object list;
+ * payloads written this way aren't shared with identical ones. The payload
+ * length grows to the end of the furthest chunk.
+ * @param object_list the object list the entry is added to
+ * @param entry the entry of the object
+ * @param offset where the chunk goes in the payload
+ * @param data the chunk
+ * @param len the length of the chunk
+ * @return FALSE if the object list has no spill directory, the payload is
+ *  already kept in memory, or writing failed
+ */
+WS_DLL_PUBLIC gboolean eo_entry_write_chunk(export_object_list_t *object_list, export_object_entry_t *entry,
+                                            gint64 offset, const guint8 *data, gint64 len);
+
 /** Free the contents of export_object_entry_t structure
  *
  * @param entry export_object_entry_t structure to be freed
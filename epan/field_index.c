@@ -0,0 +1,295 @@
+/* field_index.c
+ * Index of the frames containing each value of some fields
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/proto.h>
+#include <epan/ftypes/ftypes.h>
+#include "field_index.h"
+
+/*
+ * The frames of a value, as a posting list: the differences between
+ * consecutive frame numbers, 7 bits per byte with the high bit set on all
+ * but the last byte of each one.
+ */
+typedef struct {
+    guint32     last_frame;
+    guint32     num_frames;
+    GByteArray *deltas;
+} frame_list_t;
+
+typedef struct {
+    int         hf_id;      /* the first field of the name */
+    GHashTable *values;     /* dfilter representation of a value -> frame_list_t */
+    gboolean    generated;  /* some frame had a generated value */
+} indexed_field_t;
+
+struct _field_index_t {
+    GArray     *fields;     /* indexed_field_t */
+    GArray     *hf_ids;     /* all fields of the indexed names, to prime with */
+};
+
+/*
+ * The values are keyed by their display filter representation, always in
+ * decimal so that fields of the same name with different bases agree. That
+ * only works for types whose representations are equal if and only if the
+ * values are.
+ *
+ * The frames are only added on the first pass, so the values mustn't change
+ * on later ones. Frame number fields (e.g. tcp.reassembled_in or
+ * dns.response_in) usually refer to frames not dissected yet and are only
+ * added on a later pass, so they're never indexed.
+ */
+static gboolean
+field_index_ftype_ok(ftenum_t ftype)
+{
+    if (ftype == FT_FRAMENUM)
+        return FALSE;
+    return IS_FT_INT(ftype) || IS_FT_UINT(ftype) || IS_FT_STRING(ftype) ||
+           ftype == FT_UINT_STRING || ftype == FT_ETHER ||
+           ftype == FT_IPv4 || ftype == FT_IPv6;
+}
+
+static void
+frame_list_free(gpointer data)
+{
+    frame_list_t *frames = (frame_list_t *)data;
+
+    g_byte_array_free(frames->deltas, TRUE);
+    g_free(frames);
+}
+
+static void
+frame_list_add(frame_list_t *frames, guint32 frame_num)
+{
+    guint8 buf[5];
+    guint32 delta;
+    guint len = 0;
+
+    if (frames->num_frames > 0 && frames->last_frame == frame_num)
+        return;
+
+    delta = frame_num - frames->last_frame;
+    while (delta >= 0x80) {
+        buf[len++] = (guint8)(delta | 0x80);
+        delta >>= 7;
+    }
+    buf[len++] = (guint8)delta;
+    g_byte_array_append(frames->deltas, buf, len);
+
+    frames->last_frame = frame_num;
+    frames->num_frames++;
+}
+
+static guint32 *
+frame_list_get(const frame_list_t *frames)
+{
+    guint32 *frame_nums = g_new(guint32, frames->num_frames);
+    guint32 frame_num = 0;
+    guint i, pos = 0;
+
+    for (i = 0; i < frames->num_frames; i++) {
+        guint32 delta = 0;
+        guint shift = 0;
+
+        do {
+            delta |= (guint32)(frames->deltas->data[pos] & 0x7f) << shift;
+            shift += 7;
+        } while (frames->deltas->data[pos++] & 0x80);
+        frame_num += delta;
+        frame_nums[i] = frame_num;
+    }
+    return frame_nums;
+}
+
+field_index_t *
+field_index_new(const char *fields)
+{
+    field_index_t *fi;
+    gchar **names;
+    guint i, j;
+
+    if (fields == NULL)
+        return NULL;
+
+    fi = g_new(field_index_t, 1);
+    fi->fields = g_array_new(FALSE, FALSE, sizeof(indexed_field_t));
+    fi->hf_ids = g_array_new(FALSE, FALSE, sizeof(int));
+
+    names = g_strsplit_set(fields, " ,", -1);
+    for (i = 0; names[i] != NULL; i++) {
+        header_field_info *hfinfo = proto_registrar_get_byname(names[i]);
+        indexed_field_t field;
+        gboolean dup = FALSE;
+
+        if (hfinfo == NULL || !field_index_ftype_ok(hfinfo->type))
+            continue;
+        while (hfinfo->same_name_prev_id != -1)
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+        for (j = 0; j < fi->fields->len; j++) {
+            if (g_array_index(fi->fields, indexed_field_t, j).hf_id == hfinfo->id)
+                dup = TRUE;
+        }
+        if (dup)
+            continue;
+
+        field.hf_id = hfinfo->id;
+        field.values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, frame_list_free);
+        field.generated = FALSE;
+        g_array_append_val(fi->fields, field);
+        for (; hfinfo != NULL; hfinfo = hfinfo->same_name_next)
+            g_array_append_val(fi->hf_ids, hfinfo->id);
+    }
+    g_strfreev(names);
+
+    if (fi->fields->len == 0) {
+        field_index_free(fi);
+        return NULL;
+    }
+    return fi;
+}
+
+void
+field_index_free(field_index_t *fi)
+{
+    guint i;
+
+    if (fi == NULL)
+        return;
+
+    for (i = 0; i < fi->fields->len; i++)
+        g_hash_table_destroy(g_array_index(fi->fields, indexed_field_t, i).values);
+    g_array_free(fi->fields, TRUE);
+    g_array_free(fi->hf_ids, TRUE);
+    g_free(fi);
+}
+
+void
+field_index_reset(field_index_t *fi)
+{
+    guint i;
+
+    for (i = 0; i < fi->fields->len; i++) {
+        indexed_field_t *field = &g_array_index(fi->fields, indexed_field_t, i);
+
+        g_hash_table_remove_all(field->values);
+        field->generated = FALSE;
+    }
+}
+
+void
+field_index_prime_edt(field_index_t *fi, epan_dissect_t *edt)
+{
+    epan_dissect_prime_with_hfid_array(edt, fi->hf_ids);
+}
+
+void
+field_index_add_frame(field_index_t *fi, epan_dissect_t *edt, guint32 frame_num)
+{
+    guint i, j;
+
+    if (edt->tree == NULL)
+        return;
+
+    for (i = 0; i < fi->fields->len; i++) {
+        indexed_field_t *field = &g_array_index(fi->fields, indexed_field_t, i);
+        header_field_info *hfinfo;
+
+        for (hfinfo = proto_registrar_get_nth(field->hf_id); hfinfo != NULL; hfinfo = hfinfo->same_name_next) {
+            GPtrArray *finfos = proto_get_finfo_ptr_array(edt->tree, hfinfo->id);
+
+            for (j = 0; finfos != NULL && j < finfos->len; j++) {
+                field_info *finfo = (field_info *)g_ptr_array_index(finfos, j);
+                frame_list_t *frames;
+                char *value;
+
+                /*
+                 * Generated values are often derived from other frames, and
+                 * may differ or only be there once those are dissected. That
+                 * rules out stream numbers such as tcp.stream; the frames of
+                 * a stream are listed by follow_get_stream_frames() instead.
+                 */
+                if (FI_GET_FLAG(finfo, FI_GENERATED) && !field->generated) {
+                    field->generated = TRUE;
+                    g_hash_table_remove_all(field->values);
+                }
+                if (field->generated)
+                    break;
+
+                value = fvalue_to_string_repr(NULL, &finfo->value, FTREPR_DFILTER, BASE_DEC);
+                if (value == NULL)
+                    continue;
+                frames = (frame_list_t *)g_hash_table_lookup(field->values, value);
+                if (frames == NULL) {
+                    frames = g_new0(frame_list_t, 1);
+                    frames->deltas = g_byte_array_new();
+                    g_hash_table_insert(field->values, g_strdup(value), frames);
+                }
+                frame_list_add(frames, frame_num);
+                wmem_free(NULL, value);
+            }
+        }
+    }
+}
+
+guint32 *
+field_index_lookup(field_index_t *fi, const dfilter_t *df, guint *num_frames)
+{
+    header_field_info *hfinfo;
+    fvalue_t *fv;
+    indexed_field_t *field;
+    frame_list_t *frames;
+    char *value;
+    guint i;
+
+    *num_frames = 0;
+    if (df == NULL || !dfilter_get_field_equality(df, &hfinfo, &fv))
+        return NULL;
+
+    for (i = 0; i < fi->fields->len; i++) {
+        if (g_array_index(fi->fields, indexed_field_t, i).hf_id == hfinfo->id)
+            break;
+    }
+    if (i == fi->fields->len)
+        return NULL;
+    field = &g_array_index(fi->fields, indexed_field_t, i);
+    if (field->generated)
+        return NULL;
+
+    value = fvalue_to_string_repr(NULL, fv, FTREPR_DFILTER, BASE_DEC);
+    if (value == NULL)
+        return NULL;
+    frames = (frame_list_t *)g_hash_table_lookup(field->values, value);
+    wmem_free(NULL, value);
+
+    if (frames == NULL) {
+        /* No frame has that value. */
+        return g_new(guint32, 1);
+    }
+    *num_frames = frames->num_frames;
+    return frame_list_get(frames);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
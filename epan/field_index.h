@@ -0,0 +1,103 @@
+/* field_index.h
+ * Index of the frames containing each value of some fields
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FIELD_INDEX_H__
+#define __FIELD_INDEX_H__
+
+#include <epan/epan_dissect.h>
+#include <epan/dfilter/dfilter.h>
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @file
+ * An inverted index of the values of some fields (e.g. addresses, ports or
+ * host names): for each value, the frames that contain it. Frames are added
+ * in ascending order as they're first dissected; a display filter that tests
+ * an indexed field for equality with a value can then only match the frames
+ * listed for that value.
+ *
+ * Only values that are the same on every pass can be indexed: frame number
+ * fields are never indexed, and a field that has a generated value in any
+ * frame isn't used, so filters on those fall back to testing every frame.
+ * Stream numbers (e.g. tcp.stream) are generated, so can't be indexed; see
+ * follow_get_stream_frames() for the frames of a stream.
+ */
+
+typedef struct _field_index_t field_index_t;
+
+/** Create an index of the values of some fields.
+ *
+ * @param fields the field names, separated by spaces or commas
+ * @return the index, or NULL if there are no known fields of a type that
+ * can be indexed
+ */
+WS_DLL_PUBLIC field_index_t *field_index_new(const char *fields);
+
+/** Free an index.
+ *
+ * @param fi the index
+ */
+WS_DLL_PUBLIC void field_index_free(field_index_t *fi);
+
+/** Remove all frames from an index, e.g. before the frames are dissected again.
+ *
+ * @param fi the index
+ */
+WS_DLL_PUBLIC void field_index_reset(field_index_t *fi);
+
+/** Prime an epan_dissect_t with the indexed fields, before dissecting a
+ * frame to add.
+ *
+ * @param fi the index
+ * @param edt the epan_dissect_t, which must have a protocol tree
+ */
+WS_DLL_PUBLIC void field_index_prime_edt(field_index_t *fi, epan_dissect_t *edt);
+
+/** Add the values of the indexed fields of a dissected frame. Frames must
+ * be added in ascending order.
+ *
+ * @param fi the index
+ * @param edt the epan_dissect_t of the frame, primed with field_index_prime_edt()
+ * @param frame_num the frame number
+ */
+WS_DLL_PUBLIC void field_index_add_frame(field_index_t *fi, epan_dissect_t *edt, guint32 frame_num);
+
+/** Get the frames a display filter can match, if it tests an indexed field
+ * for equality with a value.
+ *
+ * @param fi the index
+ * @param df the display filter
+ * @param[out] num_frames the number of frames
+ * @return the frames, in ascending order, to be freed with g_free(), or NULL
+ * if the index can't tell (every frame may match)
+ */
+WS_DLL_PUBLIC guint32 *field_index_lookup(field_index_t *fi, const dfilter_t *df, guint *num_frames);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FIELD_INDEX_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,387 @@
+/* field_index_test.c
+ * Field value index tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
+#include <epan/dfilter/dfilter.h>
+#include <epan/field_index.h>
+#include <epan/test_report_message.h>
+#include <wiretap/wtap.h>
+
+/*
+ * The frames have no packet data; each one gets a tcp.port, an ip.addr and
+ * a tcp.stream item made up from its number, so the frames a filter matches
+ * are known without dissecting a capture. As in the TCP dissector, the
+ * tcp.stream item is generated.
+ */
+
+#define NUM_FRAMES  300
+#define PERF_FRAMES 100000
+
+static epan_t *test_session;
+static int hf_tcp_port = -1;
+static int hf_ip_addr = -1;
+static int hf_tcp_stream = -1;
+static const guint8 test_data[4];
+
+static epan_dissect_t *
+test_dissect(guint32 frame_num, field_index_t *fi, dfilter_t *df)
+{
+    epan_dissect_t *edt = epan_dissect_new(test_session, TRUE, FALSE);
+    proto_item *ti;
+
+    edt->tvb = tvb_new_real_data(test_data, sizeof test_data, sizeof test_data);
+    if (fi != NULL)
+        field_index_prime_edt(fi, edt);
+    if (df != NULL)
+        epan_dissect_prime_with_dfilter(edt, df);
+
+    proto_tree_add_uint(edt->tree, hf_tcp_port, edt->tvb, 0, 0,
+                        (frame_num % 3 == 0) ? 80 : 1024 + frame_num % 10);
+    /* Far enough apart that the difference takes more than one byte. */
+    if (frame_num == 1 || frame_num == 200)
+        proto_tree_add_uint(edt->tree, hf_tcp_port, edt->tvb, 0, 0, 443);
+    proto_tree_add_ipv4(edt->tree, hf_ip_addr, edt->tvb, 0, 0, g_htonl(0x0a000000 | (frame_num % 4)));
+    ti = proto_tree_add_uint(edt->tree, hf_tcp_stream, edt->tvb, 0, 0, frame_num % 5);
+    proto_item_set_generated(ti);
+
+    return edt;
+}
+
+static field_index_t *
+test_index_new(const char *fields, guint32 num_frames)
+{
+    field_index_t *fi = field_index_new(fields);
+    guint32 frame_num;
+
+    g_assert(fi != NULL);
+    for (frame_num = 1; frame_num <= num_frames; frame_num++) {
+        epan_dissect_t *edt = test_dissect(frame_num, fi, NULL);
+
+        field_index_add_frame(fi, edt, frame_num);
+        epan_dissect_free(edt);
+    }
+    return fi;
+}
+
+static dfilter_t *
+test_compile(const char *text)
+{
+    dfilter_t *df;
+    gchar *err_msg = NULL;
+
+    if (!dfilter_compile(text, &df, &err_msg))
+        g_error("\"%s\": %s", text, err_msg);
+    return df;
+}
+
+static guint32 *
+test_lookup(field_index_t *fi, const char *text, guint *num_frames)
+{
+    dfilter_t *df = test_compile(text);
+    guint32 *frames = field_index_lookup(fi, df, num_frames);
+
+    dfilter_free(df);
+    return frames;
+}
+
+static void
+field_index_test_equality(void)
+{
+    static const char *rejected[] = {
+        "tcp.port != 80",
+        "tcp.port > 80",
+        "tcp.port",
+        "!(tcp.port == 80)",
+        "tcp.port == 80 or tcp.port == 443",
+        "tcp.port == 80 && ip.addr == 10.0.0.1",
+        "tcp.port in {80 443}",
+        "ip.addr == 10.0.0.0/8",
+    };
+    header_field_info *hfinfo;
+    fvalue_t *fv;
+    dfilter_t *df;
+    guint i;
+
+    df = test_compile("tcp.port == 80");
+    g_assert(dfilter_get_field_equality(df, &hfinfo, &fv));
+    g_assert_cmpint(hfinfo->id, ==, hf_tcp_port);
+    g_assert_cmpuint(fvalue_get_uinteger(fv), ==, 80);
+    dfilter_free(df);
+
+    df = test_compile("80 == tcp.port");
+    g_assert(dfilter_get_field_equality(df, &hfinfo, &fv));
+    g_assert_cmpint(hfinfo->id, ==, hf_tcp_port);
+    dfilter_free(df);
+
+    /* A /32 is a single address. */
+    df = test_compile("ip.addr == 10.0.0.1/32");
+    g_assert(dfilter_get_field_equality(df, &hfinfo, &fv));
+    g_assert_cmpint(hfinfo->id, ==, hf_ip_addr);
+    dfilter_free(df);
+
+    for (i = 0; i < G_N_ELEMENTS(rejected); i++) {
+        df = test_compile(rejected[i]);
+        if (dfilter_get_field_equality(df, &hfinfo, &fv))
+            g_error("\"%s\" was taken as an equality test", rejected[i]);
+        dfilter_free(df);
+    }
+}
+
+static void
+field_index_test_new(void)
+{
+    field_index_t *fi;
+
+    g_assert(field_index_new(NULL) == NULL);
+    g_assert(field_index_new("") == NULL);
+    g_assert(field_index_new("no.such.field") == NULL);
+    /* Frame numbers are only added on later passes. */
+    g_assert(field_index_new("tcp.reassembled_in") == NULL);
+
+    fi = field_index_new("tcp.reassembled_in,tcp.port tcp.port");
+    g_assert(fi != NULL);
+    field_index_free(fi);
+}
+
+static void
+field_index_test_lookup(void)
+{
+    field_index_t *fi = test_index_new("tcp.port ip.addr", NUM_FRAMES);
+    guint32 *frames;
+    guint num_frames, i;
+
+    frames = test_lookup(fi, "tcp.port == 443", &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, 2);
+    g_assert_cmpuint(frames[0], ==, 1);
+    g_assert_cmpuint(frames[1], ==, 200);
+    g_free(frames);
+
+    frames = test_lookup(fi, "tcp.port == 80", &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, NUM_FRAMES / 3);
+    for (i = 0; i < num_frames; i++)
+        g_assert_cmpuint(frames[i], ==, 3 * (i + 1));
+    g_free(frames);
+
+    frames = test_lookup(fi, "ip.addr == 10.0.0.2", &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, NUM_FRAMES / 4);
+    for (i = 0; i < num_frames; i++)
+        g_assert_cmpuint(frames[i], ==, 4 * i + 2);
+    g_free(frames);
+
+    /* No frame has the value: nothing can match. */
+    frames = test_lookup(fi, "tcp.port == 9", &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, 0);
+    g_free(frames);
+
+    /* The index can't tell. */
+    g_assert(test_lookup(fi, "udp.port == 53", &num_frames) == NULL);
+    g_assert(test_lookup(fi, "tcp.port != 80", &num_frames) == NULL);
+    g_assert(test_lookup(fi, "ip.addr == 10.0.0.0/8", &num_frames) == NULL);
+    g_assert(field_index_lookup(fi, NULL, &num_frames) == NULL);
+
+    field_index_reset(fi);
+    frames = test_lookup(fi, "tcp.port == 443", &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, 0);
+    g_free(frames);
+
+    field_index_free(fi);
+}
+
+/*
+ * Generated values such as stream numbers may only be right once other
+ * frames have been dissected, so such a field is never used.
+ */
+static void
+field_index_test_generated(void)
+{
+    field_index_t *fi = test_index_new("tcp.port tcp.stream", NUM_FRAMES);
+    guint32 *frames;
+    guint num_frames;
+
+    g_assert(test_lookup(fi, "tcp.stream == 1", &num_frames) == NULL);
+    frames = test_lookup(fi, "tcp.port == 443", &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, 2);
+    g_free(frames);
+
+    field_index_free(fi);
+}
+
+/* The frames a filter matches, testing every one of them */
+static GArray *
+test_matching_frames(dfilter_t *df, guint32 num_frames)
+{
+    GArray *matched = g_array_new(FALSE, FALSE, sizeof(guint32));
+    guint32 frame_num;
+
+    for (frame_num = 1; frame_num <= num_frames; frame_num++) {
+        epan_dissect_t *edt = test_dissect(frame_num, NULL, df);
+
+        if (dfilter_apply_edt(df, edt))
+            g_array_append_val(matched, frame_num);
+        epan_dissect_free(edt);
+    }
+    return matched;
+}
+
+/*
+ * The frames listed for a filter the index can answer must be exactly the
+ * ones it matches; for the others, it must not answer at all.
+ */
+static void
+field_index_test_matches(void)
+{
+    static const struct {
+        const char *filter;
+        gboolean    answered;
+    } filters[] = {
+        { "tcp.port == 80",                         TRUE },
+        { "tcp.port == 443",                        TRUE },
+        { "ip.addr == 10.0.0.3",                    TRUE },
+        { "tcp.port == 9",                          TRUE },
+        { "tcp.stream == 2",                        FALSE },
+        { "tcp.port != 80",                         FALSE },
+        { "ip.addr == 10.0.0.0/8",                  FALSE },
+        { "tcp.port == 80 && ip.addr == 10.0.0.1",  FALSE },
+    };
+    field_index_t *fi = test_index_new("tcp.port ip.addr tcp.stream", NUM_FRAMES);
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(filters); i++) {
+        dfilter_t *df = test_compile(filters[i].filter);
+        guint32 *frames;
+        guint num_frames;
+
+        frames = field_index_lookup(fi, df, &num_frames);
+        if (!filters[i].answered) {
+            g_assert(frames == NULL);
+        } else {
+            GArray *matched = test_matching_frames(df, NUM_FRAMES);
+
+            g_assert(frames != NULL);
+            if (num_frames != matched->len ||
+                memcmp(frames, matched->data, num_frames * sizeof(guint32)) != 0)
+                g_error("\"%s\": %u frames match, %u listed", filters[i].filter, matched->len, num_frames);
+            g_array_free(matched, TRUE);
+        }
+        g_free(frames);
+        dfilter_free(df);
+    }
+    field_index_free(fi);
+}
+
+/*
+ * How long filtering takes when every frame is tested, and when only the
+ * frames the index lists are.
+ */
+static void
+field_index_test_perf(void)
+{
+    static const char *filters[] = { "ip.addr == 10.0.0.3", "tcp.port == 443" };
+    field_index_t *fi;
+    gdouble elapsed;
+    guint i, j;
+
+    g_test_timer_start();
+    fi = test_index_new("tcp.port ip.addr", PERF_FRAMES);
+    elapsed = g_test_timer_elapsed();
+    g_test_message("indexing %u frames: %.3f s", PERF_FRAMES, elapsed);
+
+    for (i = 0; i < G_N_ELEMENTS(filters); i++) {
+        dfilter_t *df = test_compile(filters[i]);
+        GArray *matched;
+        guint32 *frames;
+        guint num_frames;
+        guint num_matched = 0;
+
+        g_test_timer_start();
+        matched = test_matching_frames(df, PERF_FRAMES);
+        elapsed = g_test_timer_elapsed();
+        g_test_minimized_result(elapsed, "\"%s\", every frame: %.3f s", filters[i], elapsed);
+
+        g_test_timer_start();
+        frames = field_index_lookup(fi, df, &num_frames);
+        g_assert(frames != NULL);
+        for (j = 0; j < num_frames; j++) {
+            epan_dissect_t *edt = test_dissect(frames[j], NULL, df);
+
+            if (dfilter_apply_edt(df, edt))
+                num_matched++;
+            epan_dissect_free(edt);
+        }
+        elapsed = g_test_timer_elapsed();
+        g_test_minimized_result(elapsed, "\"%s\", indexed frames: %.3f s", filters[i], elapsed);
+        g_assert_cmpuint(num_matched, ==, matched->len);
+
+        g_free(frames);
+        g_array_free(matched, TRUE);
+        dfilter_free(df);
+    }
+    field_index_free(fi);
+}
+
+int
+main(int argc, char **argv)
+{
+    static const struct packet_provider_funcs funcs = { NULL, NULL, NULL, NULL };
+    int result;
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/field_index/equality", field_index_test_equality);
+    g_test_add_func("/field_index/new", field_index_test_new);
+    g_test_add_func("/field_index/lookup", field_index_test_lookup);
+    g_test_add_func("/field_index/generated", field_index_test_generated);
+    g_test_add_func("/field_index/matches", field_index_test_matches);
+    if (g_test_perf())
+        g_test_add_func("/field_index/perf", field_index_test_perf);
+
+    test_init_report_message();
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    test_session = epan_new(NULL, &funcs);
+    hf_tcp_port = proto_registrar_get_id_byname("tcp.port");
+    hf_ip_addr = proto_registrar_get_id_byname("ip.addr");
+    hf_tcp_stream = proto_registrar_get_id_byname("tcp.stream");
+
+    result = g_test_run();
+
+    epan_free(test_session);
+    epan_cleanup();
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -119,6 +119,93 @@ gchar* follow_get_stat_tap_string(register_follow_t* follower)
     return g_string_free(cmd_str, FALSE);
 }
 
+/*
+ * The frames of each stream, as a posting list: the differences between
+ * consecutive frame numbers, 7 bits per byte with the high bit set on all
+ * but the last byte of each one. Most of them fit in a byte.
+ */
+typedef struct {
+    guint32      last_frame;
+    guint32      num_frames;
+    wmem_array_t *deltas;
+} stream_frames_t;
+
+static gboolean stream_frames_enabled = FALSE;
+static wmem_map_t *stream_frames[MAX_STREAM];
+
+void follow_set_stream_frames_enabled(gboolean enable)
+{
+    stream_frames_enabled = enable;
+}
+
+void follow_add_stream_frame(stream_type type, guint32 stream, packet_info *pinfo)
+{
+    stream_frames_t *frames;
+    guint8 buf[5];
+    guint32 delta;
+    guint len = 0;
+
+    if (!stream_frames_enabled || PINFO_FD_VISITED(pinfo))
+        return;
+
+    if (stream_frames[type] == NULL)
+        stream_frames[type] = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+
+    frames = (stream_frames_t *)wmem_map_lookup(stream_frames[type], GUINT_TO_POINTER(stream));
+    if (frames == NULL) {
+        frames = wmem_new0(wmem_file_scope(), stream_frames_t);
+        frames->deltas = wmem_array_sized_new(wmem_file_scope(), 1, 16);
+        wmem_map_insert(stream_frames[type], GUINT_TO_POINTER(stream), frames);
+    } else if (frames->last_frame == pinfo->num) {
+        /* e.g. a tunnel carrying the stream twice */
+        return;
+    }
+
+    delta = pinfo->num - frames->last_frame;
+    while (delta >= 0x80) {
+        buf[len++] = (guint8)(delta | 0x80);
+        delta >>= 7;
+    }
+    buf[len++] = (guint8)delta;
+    wmem_array_append(frames->deltas, buf, len);
+
+    frames->last_frame = pinfo->num;
+    frames->num_frames++;
+}
+
+guint32 *follow_get_stream_frames(stream_type type, guint32 stream, guint *num_frames)
+{
+    stream_frames_t *frames;
+    const guint8 *deltas;
+    guint32 *frame_nums;
+    guint32 frame_num = 0;
+    guint i, pos = 0;
+
+    *num_frames = 0;
+    if (stream_frames[type] == NULL)
+        return NULL;
+    frames = (stream_frames_t *)wmem_map_lookup(stream_frames[type], GUINT_TO_POINTER(stream));
+    if (frames == NULL)
+        return NULL;
+
+    deltas = (const guint8 *)wmem_array_get_raw(frames->deltas);
+    frame_nums = g_new(guint32, frames->num_frames);
+    for (i = 0; i < frames->num_frames; i++) {
+        guint32 delta = 0;
+        guint shift = 0;
+
+        do {
+            delta |= (guint32)(deltas[pos] & 0x7f) << shift;
+            shift += 7;
+        } while (deltas[pos++] & 0x80);
+        frame_num += delta;
+        frame_nums[i] = frame_num;
+    }
+
+    *num_frames = frames->num_frames;
+    return frame_nums;
+}
+
 /* here we are going to try and reconstruct the data portion of a TCP
    session. We will try and handle duplicates, TCP fragments, and out
    of order packets in a smart way. */
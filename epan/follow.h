@@ -27,6 +27,7 @@ extern "C" {
 typedef enum {
   TCP_STREAM = 0,
   UDP_STREAM,
+  QUIC_STREAM,
   MAX_STREAM
 } stream_type;
 
@@ -189,6 +190,32 @@ WS_DLL_PUBLIC void follow_iterate_followers(wmem_foreach_func func, gpointer use
  */
 WS_DLL_PUBLIC gchar* follow_get_stat_tap_string(register_follow_t* follower);
 
+/** Enable or disable recording the frames of each stream on the first pass.
+ * Only useful when the frames are kept for a later retap, as by the GUI.
+ *
+ * @param enable TRUE to record the frames
+ */
+WS_DLL_PUBLIC void follow_set_stream_frames_enabled(gboolean enable);
+
+/** Record that the frame being dissected for the first time is part of a stream.
+ *  Called by the dissector that assigns the stream index, e.g. tcp.stream.
+ *
+ * @param type the kind of stream
+ * @param stream the stream index
+ * @param pinfo packet info of the frame
+ */
+WS_DLL_PUBLIC void follow_add_stream_frame(stream_type type, guint32 stream, packet_info *pinfo);
+
+/** Get the frames that are part of a stream, in ascending order.
+ *
+ * @param type the kind of stream
+ * @param stream the stream index
+ * @param[out] num_frames the number of frames
+ * @return the frame numbers, to be freed with g_free(), or NULL if the frames of
+ * the stream weren't recorded
+ */
+WS_DLL_PUBLIC guint32 *follow_get_stream_frames(stream_type type, guint32 stream, guint *num_frames);
+
 /** Clear counters, addresses and ports of follow_info_t
  *
  * @param info [in] follower info
@@ -0,0 +1,260 @@
+/* follow_test.c
+ * Stream frame list tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/follow.h>
+#include <epan/frame_data.h>
+#include <epan/tvbuff.h>
+#include <epan/dfilter/dfilter.h>
+#include <epan/test_report_message.h>
+#include <wiretap/wtap.h>
+#include <wsutil/buffer.h>
+
+/* The frames of the capture file, for the frame timestamps. */
+struct packet_provider_data {
+    GPtrArray *frames;
+};
+
+static const char *capture_path;
+
+static const nstime_t *
+test_get_frame_ts(struct packet_provider_data *prov, guint32 frame_num)
+{
+    if (prov == NULL || frame_num == 0 || frame_num > prov->frames->len)
+        return NULL;
+    return &((frame_data *)g_ptr_array_index(prov->frames, frame_num - 1))->abs_ts;
+}
+
+static const struct packet_provider_funcs test_funcs = { test_get_frame_ts, NULL, NULL, NULL };
+
+static void
+test_add_frame(stream_type type, guint32 stream, guint32 frame_num, gboolean visited)
+{
+    frame_data fd;
+    packet_info pinfo;
+
+    memset(&fd, 0, sizeof fd);
+    memset(&pinfo, 0, sizeof pinfo);
+    fd.num = frame_num;
+    fd.visited = visited;
+    pinfo.fd = &fd;
+    pinfo.num = frame_num;
+    follow_add_stream_frame(type, stream, &pinfo);
+}
+
+static void
+test_check_frames(stream_type type, guint32 stream, const guint32 *expected, guint num_expected)
+{
+    guint32 *frames;
+    guint num_frames, i;
+
+    frames = follow_get_stream_frames(type, stream, &num_frames);
+    g_assert(frames != NULL);
+    g_assert_cmpuint(num_frames, ==, num_expected);
+    for (i = 0; i < num_frames; i++)
+        g_assert_cmpuint(frames[i], ==, expected[i]);
+    g_free(frames);
+}
+
+/*
+ * The gaps between these take from one to five bytes each, the last one with
+ * all the bits of the fifth byte.
+ */
+static void
+follow_test_stream_frames(void)
+{
+    static const guint32 stream0[] = {
+        1, 2, 3, 130, 131, 16515, 16516, 2100000, 300000000, 0xffffffff
+    };
+    static const guint32 stream1[] = { 4, 127, 128, 129 };
+    epan_t *session = epan_new(NULL, &test_funcs);
+    guint num_frames;
+    guint i;
+
+    /* Nothing is recorded unless it's enabled. */
+    test_add_frame(UDP_STREAM, 0, 1, FALSE);
+    g_assert(follow_get_stream_frames(UDP_STREAM, 0, &num_frames) == NULL);
+    g_assert_cmpuint(num_frames, ==, 0);
+
+    follow_set_stream_frames_enabled(TRUE);
+    for (i = 0; i < G_N_ELEMENTS(stream0); i++) {
+        test_add_frame(UDP_STREAM, 0, stream0[i], FALSE);
+        /* e.g. a tunnel carrying the stream twice */
+        test_add_frame(UDP_STREAM, 0, stream0[i], FALSE);
+        if (i < G_N_ELEMENTS(stream1))
+            test_add_frame(UDP_STREAM, 1, stream1[i], FALSE);
+    }
+    /* Only the first pass counts. */
+    test_add_frame(UDP_STREAM, 1, 200, TRUE);
+    follow_set_stream_frames_enabled(FALSE);
+
+    test_check_frames(UDP_STREAM, 0, stream0, G_N_ELEMENTS(stream0));
+    test_check_frames(UDP_STREAM, 1, stream1, G_N_ELEMENTS(stream1));
+    g_assert(follow_get_stream_frames(UDP_STREAM, 2, &num_frames) == NULL);
+    g_assert(follow_get_stream_frames(QUIC_STREAM, 0, &num_frames) == NULL);
+
+    /* The lists belong to the file. */
+    epan_free(session);
+    session = epan_new(NULL, &test_funcs);
+    g_assert(follow_get_stream_frames(UDP_STREAM, 0, &num_frames) == NULL);
+    epan_free(session);
+}
+
+/*
+ * Record the TCP streams on a first pass over the capture file, then, as
+ * a rescan with "tcp.stream eq N" would, test that filter against every
+ * frame. The frames it matches are the ones the follow hint lists.
+ */
+static void
+follow_test_tcp_stream_filter(void)
+{
+    struct packet_provider_data prov;
+    epan_t *session;
+    wtap *wth;
+    wtap_rec rec;
+    Buffer buf;
+    int err;
+    gchar *err_info = NULL;
+    gint64 data_offset;
+    nstime_t elapsed_time;
+    const frame_data *ref = NULL;
+    frame_data *prev_dis = NULL;
+    guint32 cum_bytes = 0;
+    guint32 num_streams = 0;
+    guint32 stream;
+    int hf_tcp_stream;
+    guint i;
+
+    if (capture_path == NULL) {
+        g_test_skip("No capture file given");
+        return;
+    }
+
+    wth = wtap_open_offline(capture_path, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    if (wth == NULL)
+        g_error("%s: %s", capture_path, err_info ? err_info : g_strerror(err));
+
+    prov.frames = g_ptr_array_new();
+    session = epan_new(&prov, &test_funcs);
+    hf_tcp_stream = proto_registrar_get_id_byname("tcp.stream");
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    nstime_set_zero(&elapsed_time);
+
+    follow_set_stream_frames_enabled(TRUE);
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        epan_dissect_t *edt = epan_dissect_new(session, TRUE, FALSE);
+        frame_data *fd = g_new(frame_data, 1);
+        GPtrArray *finfos;
+
+        frame_data_init(fd, prov.frames->len + 1, &rec, data_offset, cum_bytes);
+        g_ptr_array_add(prov.frames, fd);
+        epan_dissect_prime_with_hfid(edt, hf_tcp_stream);
+        frame_data_set_before_dissect(fd, &elapsed_time, &ref, prev_dis);
+        epan_dissect_run(edt, wtap_file_type_subtype(wth), &rec,
+                         tvb_new_real_data(ws_buffer_start_ptr(&buf), rec.rec_header.packet_header.caplen, rec.rec_header.packet_header.len),
+                         fd, NULL);
+        frame_data_set_after_dissect(fd, &cum_bytes);
+        prev_dis = fd;
+
+        finfos = proto_get_finfo_ptr_array(edt->tree, hf_tcp_stream);
+        for (i = 0; finfos != NULL && i < finfos->len; i++) {
+            stream = fvalue_get_uinteger(&((field_info *)g_ptr_array_index(finfos, i))->value);
+            num_streams = MAX(num_streams, stream + 1);
+        }
+        epan_dissect_free(edt);
+    }
+    follow_set_stream_frames_enabled(FALSE);
+    g_assert_cmpint(err, ==, 0);
+    g_assert_cmpuint(num_streams, >, 1);
+
+    for (stream = 0; stream < num_streams; stream++) {
+        GArray *matched = g_array_new(FALSE, FALSE, sizeof(guint32));
+        gchar *filter = g_strdup_printf("tcp.stream eq %u", stream);
+        gchar *err_msg = NULL;
+        dfilter_t *df;
+
+        if (!dfilter_compile(filter, &df, &err_msg))
+            g_error("\"%s\": %s", filter, err_msg);
+        for (i = 0; i < prov.frames->len; i++) {
+            frame_data *fd = (frame_data *)g_ptr_array_index(prov.frames, i);
+            epan_dissect_t *edt = epan_dissect_new(session, TRUE, FALSE);
+
+            if (!wtap_seek_read(wth, fd->file_off, &rec, &buf, &err, &err_info))
+                g_error("%s: %s", capture_path, err_info ? err_info : g_strerror(err));
+            epan_dissect_prime_with_dfilter(edt, df);
+            epan_dissect_run(edt, wtap_file_type_subtype(wth), &rec,
+                             tvb_new_real_data(ws_buffer_start_ptr(&buf), fd->cap_len, fd->pkt_len),
+                             fd, NULL);
+            if (dfilter_apply_edt(df, edt))
+                g_array_append_val(matched, fd->num);
+            epan_dissect_free(edt);
+        }
+        test_check_frames(TCP_STREAM, stream, (const guint32 *)(void *)matched->data, matched->len);
+
+        dfilter_free(df);
+        g_free(filter);
+        g_array_free(matched, TRUE);
+    }
+
+    for (i = 0; i < prov.frames->len; i++) {
+        frame_data_destroy((frame_data *)g_ptr_array_index(prov.frames, i));
+        g_free(g_ptr_array_index(prov.frames, i));
+    }
+    epan_free(session);
+    g_ptr_array_free(prov.frames, TRUE);
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+    wtap_close(wth);
+}
+
+int
+main(int argc, char **argv)
+{
+    int result;
+
+    g_test_init(&argc, &argv, NULL);
+    /* A capture file with more than one TCP stream, if any. */
+    if (argc > 1)
+        capture_path = argv[1];
+
+    g_test_add_func("/follow/stream_frames", follow_test_stream_frames);
+    g_test_add_func("/follow/tcp_stream_filter", follow_test_tcp_stream_filter);
+
+    test_init_report_message();
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+
+    result = g_test_run();
+
+    epan_cleanup();
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
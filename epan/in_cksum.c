@@ -13,8 +13,16 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
+/* SSE2 is part of x86-64, so it can be used without a run time check */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IN_CKSUM_SSE2
+#include <emmintrin.h>
+#endif
+
 #include <epan/tvbuff.h>
 #include <epan/in_cksum.h>
 
@@ -28,6 +36,94 @@
 #define ADDCARRY(x)  {if ((x) > 65535) (x) -= 65535;}
 #define REDUCE {l_util.l = sum; sum = l_util.s[0] + l_util.s[1]; ADDCARRY(sum);}
 
+/*
+ * One's complement sum of an even number of bytes, as 16-bit words in
+ * host byte order, folded to 16 bits.
+ *
+ * Since end-around carries can be added back in at any point, the words
+ * can be summed in any grouping and the carries folded in at the end:
+ * with SSE2 they are widened and added into 32-bit lanes, which are
+ * flushed before they can overflow, and otherwise eight bytes are added
+ * at a time with the carry out of each addition added back in.
+ */
+#ifdef IN_CKSUM_SSE2
+#define CKSUM_FLUSH_BLOCKS	16384	/* 2 * 16384 * 0xffff fits in 32 bits */
+
+static guint32
+in_cksum_words(const guint8 *p, int len)
+{
+	guint64 sum = 0;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i x, y, acc0, acc1, acc2, acc3;
+	guint32 lanes[16];
+	guint16 w16;
+	int blocks, i;
+
+	while (len >= 32) {
+		blocks = len / 32;
+		if (blocks > CKSUM_FLUSH_BLOCKS)
+			blocks = CKSUM_FLUSH_BLOCKS;
+		len -= blocks * 32;
+		acc0 = acc1 = acc2 = acc3 = zero;
+		while (blocks-- > 0) {
+			x = _mm_loadu_si128((const __m128i *)(const void *)p);
+			y = _mm_loadu_si128((const __m128i *)(const void *)(p + 16));
+			acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(x, zero));
+			acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(x, zero));
+			acc2 = _mm_add_epi32(acc2, _mm_unpacklo_epi16(y, zero));
+			acc3 = _mm_add_epi32(acc3, _mm_unpackhi_epi16(y, zero));
+			p += 32;
+		}
+		_mm_storeu_si128((__m128i *)(void *)&lanes[0], acc0);
+		_mm_storeu_si128((__m128i *)(void *)&lanes[4], acc1);
+		_mm_storeu_si128((__m128i *)(void *)&lanes[8], acc2);
+		_mm_storeu_si128((__m128i *)(void *)&lanes[12], acc3);
+		for (i = 0; i < 16; i++)
+			sum += lanes[i];
+	}
+	while (len >= 2) {
+		memcpy(&w16, p, 2);
+		sum += w16;
+		p += 2;
+		len -= 2;
+	}
+
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (guint32)sum;
+}
+#else
+static guint32
+in_cksum_words(const guint8 *p, int len)
+{
+	guint64 sum = 0, w64;
+	guint16 w16;
+
+	while (len >= 8) {
+		memcpy(&w64, p, 8);
+		sum += w64;
+		sum += (sum < w64);	/* end-around carry */
+		p += 8;
+		len -= 8;
+	}
+	while (len >= 2) {
+		memcpy(&w16, p, 2);
+		sum += w16;
+		sum += (sum < w16);
+		p += 2;
+		len -= 2;
+	}
+
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (guint32)sum;
+}
+#endif
+
 int
 in_cksum(const vec_t *vec, int veclen)
 {
@@ -75,29 +171,10 @@ in_cksum(const vec_t *vec, int veclen)
 			mlen--;
 			byte_swapped = 1;
 		}
-		/*
-		 * Unroll the loop to make overhead from
-		 * branches &c small.
-		 */
-		while ((mlen -= 32) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			sum += w[4]; sum += w[5]; sum += w[6]; sum += w[7];
-			sum += w[8]; sum += w[9]; sum += w[10]; sum += w[11];
-			sum += w[12]; sum += w[13]; sum += w[14]; sum += w[15];
-			w += 16;
-		}
-		mlen += 32;
-		while ((mlen -= 8) >= 0) {
-			sum += w[0]; sum += w[1]; sum += w[2]; sum += w[3];
-			w += 4;
-		}
-		mlen += 8;
-		if (mlen == 0 && byte_swapped == 0)
-			continue;
+		sum += in_cksum_words((const guint8 *)w, mlen & ~1);
+		w += mlen / 2;
+		mlen = (mlen & 1) ? -1 : -2;
 		REDUCE;
-		while ((mlen -= 2) >= 0) {
-			sum += *w++;
-		}
 		if (byte_swapped) {
 			REDUCE;
 			sum <<= 8;
@@ -21,8 +21,11 @@ static mmdb_lookup_t mmdb_not_found;
 #ifdef HAVE_MAXMINDDB
 
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
+#include <maxminddb.h>
+
 #include <epan/wmem/wmem.h>
 
 #include <epan/addr_resolv.h>
@@ -152,6 +155,409 @@ static void init_lookup(mmdb_lookup_t *lookup) {
     *lookup = empty_lookup;
 }
 
+/*
+ * In-process lookups.
+ *
+ * The databases are opened here with libmaxminddb, which memory-maps
+ * them, and looked up synchronously, so results are available to the
+ * packet that asked for them. Results are kept in a sharded LRU cache
+ * keyed by address (IPv4 addresses as IPv4-mapped IPv6 addresses), so
+ * captures with very many addresses don't grow it without bound.
+ *
+ * The cache only holds pointers to results, which are interned like
+ * their strings and never freed; a pointer returned by a lookup stays
+ * valid after the address has been evicted.
+ *
+ * If the databases can't be opened here, or in-process lookups are
+ * disabled, we fall back to the mmdbresolve process.
+ */
+#define MMDB_CACHE_SHARDS       16      /* Power of two */
+
+typedef struct _mmdb_cache_entry_t {
+    ws_in6_addr addr;
+    const mmdb_lookup_t *result;
+    struct _mmdb_cache_entry_t *prev;   // More recently used
+    struct _mmdb_cache_entry_t *next;   // Less recently used
+} mmdb_cache_entry_t;
+
+typedef struct {
+    GMutex mtx;
+    GHashTable *entries;                // ws_in6_addr * -> mmdb_cache_entry_t *
+    mmdb_cache_entry_t *mru;
+    mmdb_cache_entry_t *lru;
+    guint count;
+} mmdb_cache_shard_t;
+
+static gboolean mmdb_in_process = TRUE;     // Preference
+static guint mmdb_cache_size = 65536;       // Preference
+static gboolean mmdb_in_process_applied;
+static guint mmdb_cache_size_applied;
+
+// Protects mmdb_dbs and the cache shards' tables. Lookups hold it as
+// readers from the cache lookup until the result is cached, so that
+// mmdb_in_process_stop can't close the databases or free the shards
+// while a lookup is still using them.
+static GRWLock mmdb_in_process_mtx;
+static MMDB_s *mmdb_dbs;
+static guint mmdb_db_count;
+static guint mmdb_cache_shard_size;
+static mmdb_cache_shard_t mmdb_cache[MMDB_CACHE_SHARDS];
+
+// Interned results. Protects mmdb_str_chunk as well.
+static GMutex mmdb_intern_mtx;
+static wmem_map_t *mmdb_result_chunk;
+
+static const char *mmdb_co_iso_key[]     = {"country", "iso_code", NULL};
+static const char *mmdb_co_name_key[]    = {"country", "names", "en", NULL};
+static const char *mmdb_ci_name_key[]    = {"city", "names", "en", NULL};
+static const char *mmdb_asn_o_key[]      = {"autonomous_system_organization", NULL};
+static const char *mmdb_asn_key[]        = {"autonomous_system_number", NULL};
+static const char *mmdb_l_lat_key[]      = {"location", "latitude", NULL};
+static const char *mmdb_l_lon_key[]      = {"location", "longitude", NULL};
+static const char *mmdb_l_accuracy_key[] = {"location", "accuracy_radius", NULL};
+
+static guint mmdb_result_hash(gconstpointer key) {
+    const mmdb_lookup_t *result = (const mmdb_lookup_t *) key;
+
+    // The strings are interned. Leave out the coordinates, which might be DBL_MAX.
+    return g_direct_hash(result->city) ^ g_direct_hash(result->country) ^
+        g_direct_hash(result->as_org) ^ result->as_number;
+}
+
+static gboolean mmdb_result_equal(gconstpointer a, gconstpointer b) {
+    const mmdb_lookup_t *ra = (const mmdb_lookup_t *) a;
+    const mmdb_lookup_t *rb = (const mmdb_lookup_t *) b;
+
+    // The strings are interned.
+    return ra->found == rb->found && ra->country == rb->country &&
+        ra->country_iso == rb->country_iso && ra->city == rb->city &&
+        ra->as_number == rb->as_number && ra->as_org == rb->as_org &&
+        ra->latitude == rb->latitude && ra->longitude == rb->longitude &&
+        ra->accuracy == rb->accuracy;
+}
+
+static gboolean mmdb_entry_is_string(const MMDB_entry_data_s *entry_data) {
+    return entry_data->type == MMDB_DATA_TYPE_UTF8_STRING;
+}
+
+// Returns a string entry's value, interned.
+// Must be called with mmdb_intern_mtx held.
+static const char *mmdb_entry_string(const MMDB_entry_data_s *entry_data) {
+    char *str = g_strndup(entry_data->utf8_string, entry_data->data_size);
+    const char *chunk_str = chunkify_string(str);
+    g_free(str);
+    return chunk_str;
+}
+
+static gboolean mmdb_entry_double(const MMDB_entry_data_s *entry_data, double *val) {
+    switch (entry_data->type) {
+        case MMDB_DATA_TYPE_DOUBLE:
+            *val = entry_data->double_value;
+            return TRUE;
+        case MMDB_DATA_TYPE_FLOAT:
+            *val = entry_data->float_value;
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static gboolean mmdb_entry_uint(const MMDB_entry_data_s *entry_data, guint32 max, guint32 *val) {
+    guint64 uval;
+
+    switch (entry_data->type) {
+        case MMDB_DATA_TYPE_UINT16:
+            uval = entry_data->uint16;
+            break;
+        case MMDB_DATA_TYPE_UINT32:
+            uval = entry_data->uint32;
+            break;
+        case MMDB_DATA_TYPE_UINT64:
+            uval = entry_data->uint64;
+            break;
+        case MMDB_DATA_TYPE_INT32:
+            if (entry_data->int32 < 0) {
+                return FALSE;
+            }
+            uval = (guint64) entry_data->int32;
+            break;
+        default:
+            return FALSE;
+    }
+    if (uval > max) {
+        return FALSE;
+    }
+    *val = (guint32) uval;
+    return TRUE;
+}
+
+#define MMDB_GET_VALUE(keys) \
+    (MMDB_aget_value(&mmdb_result.entry, &entry_data, keys) == MMDB_SUCCESS && entry_data.has_data)
+
+// Look an address up in each database. As with mmdbresolve, values from
+// later databases replace those from earlier ones. libmaxminddb lookups
+// only read the databases, so only the interning is done with
+// mmdb_intern_mtx held.
+static const mmdb_lookup_t *mmdb_lookup_in_process(const ws_in6_addr *addr, gboolean is_ipv4) {
+    struct sockaddr_storage ss;
+    mmdb_lookup_t lookup;
+    const mmdb_lookup_t *result;
+    // The strings found point into the databases until they're interned.
+    MMDB_entry_data_s co_iso_data, co_name_data, ci_name_data, asn_o_data;
+
+    memset(&ss, 0, sizeof(ss));
+    if (is_ipv4) {
+        struct sockaddr_in *sin = (struct sockaddr_in *) &ss;
+        sin->sin_family = AF_INET;
+        memcpy(&sin->sin_addr, addr->bytes + 12, 4);
+    } else {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &ss;
+        sin6->sin6_family = AF_INET6;
+        memcpy(&sin6->sin6_addr, addr->bytes, sizeof(ws_in6_addr));
+    }
+
+    init_lookup(&lookup);
+    co_iso_data.has_data = false;
+    co_name_data.has_data = false;
+    ci_name_data.has_data = false;
+    asn_o_data.has_data = false;
+
+    for (guint i = 0; i < mmdb_db_count; i++) {
+        int mmdb_err;
+        MMDB_lookup_result_s mmdb_result = MMDB_lookup_sockaddr(&mmdb_dbs[i], (const struct sockaddr *) &ss, &mmdb_err);
+        MMDB_entry_data_s entry_data;
+        double dval;
+        guint32 uval;
+
+        if (mmdb_err != MMDB_SUCCESS || !mmdb_result.found_entry) {
+            continue;
+        }
+
+        if (MMDB_GET_VALUE(mmdb_co_iso_key) && mmdb_entry_is_string(&entry_data)) {
+            lookup.found = TRUE;
+            co_iso_data = entry_data;
+        }
+        if (MMDB_GET_VALUE(mmdb_co_name_key) && mmdb_entry_is_string(&entry_data)) {
+            lookup.found = TRUE;
+            co_name_data = entry_data;
+        }
+        if (MMDB_GET_VALUE(mmdb_ci_name_key) && mmdb_entry_is_string(&entry_data)) {
+            lookup.found = TRUE;
+            ci_name_data = entry_data;
+        }
+        if (MMDB_GET_VALUE(mmdb_asn_o_key) && mmdb_entry_is_string(&entry_data)) {
+            lookup.found = TRUE;
+            asn_o_data = entry_data;
+        }
+        if (MMDB_GET_VALUE(mmdb_asn_key) && mmdb_entry_uint(&entry_data, G_MAXUINT32, &uval)) {
+            lookup.found = TRUE;
+            lookup.as_number = uval;
+        }
+        if (MMDB_GET_VALUE(mmdb_l_lat_key) && mmdb_entry_double(&entry_data, &dval)) {
+            lookup.found = TRUE;
+            lookup.latitude = dval;
+        }
+        if (MMDB_GET_VALUE(mmdb_l_lon_key) && mmdb_entry_double(&entry_data, &dval)) {
+            lookup.found = TRUE;
+            lookup.longitude = dval;
+        }
+        if (MMDB_GET_VALUE(mmdb_l_accuracy_key) && mmdb_entry_uint(&entry_data, G_MAXUINT16, &uval)) {
+            lookup.found = TRUE;
+            lookup.accuracy = (guint16) uval;
+        }
+    }
+
+    if (!lookup.found) {
+        return &mmdb_not_found;
+    }
+
+    g_mutex_lock(&mmdb_intern_mtx);
+    if (co_iso_data.has_data) {
+        lookup.country_iso = mmdb_entry_string(&co_iso_data);
+    }
+    if (co_name_data.has_data) {
+        lookup.country = mmdb_entry_string(&co_name_data);
+    }
+    if (ci_name_data.has_data) {
+        lookup.city = mmdb_entry_string(&ci_name_data);
+    }
+    if (asn_o_data.has_data) {
+        lookup.as_org = mmdb_entry_string(&asn_o_data);
+    }
+    result = (const mmdb_lookup_t *) wmem_map_lookup(mmdb_result_chunk, &lookup);
+    if (!result) {
+        mmdb_lookup_t *chunk_result = (mmdb_lookup_t *) wmem_memdup(wmem_epan_scope(), &lookup, sizeof(lookup));
+        wmem_map_insert(mmdb_result_chunk, chunk_result, chunk_result);
+        result = chunk_result;
+    }
+    g_mutex_unlock(&mmdb_intern_mtx);
+
+    return result;
+}
+
+#undef MMDB_GET_VALUE
+
+static void mmdb_cache_unlink(mmdb_cache_shard_t *shard, mmdb_cache_entry_t *entry) {
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        shard->mru = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        shard->lru = entry->prev;
+    }
+}
+
+static void mmdb_cache_push_front(mmdb_cache_shard_t *shard, mmdb_cache_entry_t *entry) {
+    entry->prev = NULL;
+    entry->next = shard->mru;
+    if (shard->mru) {
+        shard->mru->prev = entry;
+    } else {
+        shard->lru = entry;
+    }
+    shard->mru = entry;
+}
+
+// Returns NULL if in-process lookups aren't running.
+static const mmdb_lookup_t *mmdb_cache_lookup(const ws_in6_addr *addr, gboolean is_ipv4) {
+    mmdb_cache_shard_t *shard = &mmdb_cache[ipv6_oat_hash(addr) & (MMDB_CACHE_SHARDS - 1)];
+    mmdb_cache_entry_t *entry;
+    const mmdb_lookup_t *result;
+
+    g_rw_lock_reader_lock(&mmdb_in_process_mtx);
+    if (mmdb_db_count == 0) {
+        g_rw_lock_reader_unlock(&mmdb_in_process_mtx);
+        return NULL;
+    }
+
+    g_mutex_lock(&shard->mtx);
+    entry = (mmdb_cache_entry_t *) g_hash_table_lookup(shard->entries, addr);
+    if (entry) {
+        if (entry != shard->mru) {
+            mmdb_cache_unlink(shard, entry);
+            mmdb_cache_push_front(shard, entry);
+        }
+        result = entry->result;
+        g_mutex_unlock(&shard->mtx);
+        g_rw_lock_reader_unlock(&mmdb_in_process_mtx);
+        return result;
+    }
+    g_mutex_unlock(&shard->mtx);
+
+    result = mmdb_lookup_in_process(addr, is_ipv4);
+
+    g_mutex_lock(&shard->mtx);
+    // Another thread might have looked it up in the meantime.
+    if (!g_hash_table_contains(shard->entries, addr)) {
+        if (shard->count < mmdb_cache_shard_size) {
+            entry = g_new(mmdb_cache_entry_t, 1);
+            shard->count++;
+        } else {
+            // Reuse the least recently used entry.
+            entry = shard->lru;
+            mmdb_cache_unlink(shard, entry);
+            g_hash_table_steal(shard->entries, &entry->addr);
+        }
+        entry->addr = *addr;
+        entry->result = result;
+        mmdb_cache_push_front(shard, entry);
+        g_hash_table_insert(shard->entries, &entry->addr, entry);
+    }
+    g_mutex_unlock(&shard->mtx);
+    g_rw_lock_reader_unlock(&mmdb_in_process_mtx);
+
+    return result;
+}
+
+// Must be called with mmdb_in_process_mtx held as a writer, which waits
+// for lookups in flight and keeps new ones out.
+static void mmdb_in_process_close(void) {
+    for (guint i = 0; i < MMDB_CACHE_SHARDS; i++) {
+        mmdb_cache_shard_t *shard = &mmdb_cache[i];
+
+        if (shard->entries) {
+            g_hash_table_destroy(shard->entries);
+            shard->entries = NULL;
+        }
+        shard->mru = shard->lru = NULL;
+        shard->count = 0;
+    }
+
+    for (guint i = 0; i < mmdb_db_count; i++) {
+        MMDB_close(&mmdb_dbs[i]);
+    }
+    g_free(mmdb_dbs);
+    mmdb_dbs = NULL;
+    mmdb_db_count = 0;
+}
+
+static void mmdb_in_process_stop(void) {
+    g_rw_lock_writer_lock(&mmdb_in_process_mtx);
+    mmdb_in_process_close();
+    g_rw_lock_writer_unlock(&mmdb_in_process_mtx);
+}
+
+/**
+ * Open our databases for in-process lookups.
+ * Returns FALSE if none could be opened.
+ */
+static gboolean mmdb_in_process_start(void) {
+    gboolean started = FALSE;
+
+    g_rw_lock_writer_lock(&mmdb_in_process_mtx);
+    mmdb_in_process_close();
+
+    if (!mmdb_file_arr || mmdb_file_arr->len == 0) {
+        goto done;
+    }
+
+    if (!mmdb_str_chunk) {
+        mmdb_str_chunk = wmem_map_new(wmem_epan_scope(), wmem_str_hash, g_str_equal);
+    }
+
+    if (!mmdb_result_chunk) {
+        mmdb_result_chunk = wmem_map_new(wmem_epan_scope(), mmdb_result_hash, mmdb_result_equal);
+    }
+
+    mmdb_dbs = g_new0(MMDB_s, mmdb_file_arr->len);
+    for (guint i = 0; i < mmdb_file_arr->len; i++) {
+        const char *path = (const char *) g_ptr_array_index(mmdb_file_arr, i);
+        int mmdb_err = MMDB_open(path, MMDB_MODE_MMAP, &mmdb_dbs[mmdb_db_count]);
+        if (mmdb_err == MMDB_SUCCESS) {
+            MMDB_DEBUG("opened %s type %s", path, mmdb_dbs[mmdb_db_count].metadata.database_type);
+            mmdb_db_count++;
+        } else {
+            MMDB_DEBUG("can't open %s: %s", path, MMDB_strerror(mmdb_err));
+        }
+    }
+
+    if (mmdb_db_count == 0) {
+        g_free(mmdb_dbs);
+        mmdb_dbs = NULL;
+        goto done;
+    }
+
+    mmdb_cache_shard_size = MAX(mmdb_cache_size / MMDB_CACHE_SHARDS, 1);
+    for (guint i = 0; i < MMDB_CACHE_SHARDS; i++) {
+        mmdb_cache[i].entries = g_hash_table_new_full(ipv6_oat_hash, ipv6_equal, NULL, g_free);
+    }
+    started = TRUE;
+
+done:
+    g_rw_lock_writer_unlock(&mmdb_in_process_mtx);
+    return started;
+}
+
+static void mmdb_in_process_addr4(const ws_in4_addr *addr, ws_in6_addr *addr6) {
+    static const guint8 v4_mapped_prefix[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+
+    memcpy(addr6->bytes, v4_mapped_prefix, sizeof(v4_mapped_prefix));
+    memcpy(addr6->bytes + 12, addr, 4);
+}
+
 static gboolean mmdbr_pipe_valid(void) {
     g_rw_lock_reader_lock(&mmdbr_pipe_mtx);
     gboolean pipe_valid = ws_pipe_valid(&mmdbr_pipe);
@@ -527,6 +933,7 @@ static void maxmind_db_cleanup(void) {
     guint i;
 
     mmdb_resolve_stop();
+    mmdb_in_process_stop();
 
     /* If we have old data, clear out the whole thing
      * and start again. TODO: Just update the ones that
@@ -563,6 +970,12 @@ static void maxmind_db_post_update_cb(void) {
         }
     }
 
+    mmdb_in_process_applied = mmdb_in_process;
+    mmdb_cache_size_applied = mmdb_cache_size;
+    if (mmdb_in_process && mmdb_in_process_start()) {
+        return;
+    }
+
     mmdb_resolve_start();
 }
 
@@ -599,11 +1012,41 @@ maxmind_db_pref_init(module_t *nameres)
             " Wireshark will look in each directory for files ending"
             " with \".mmdb\".",
             maxmind_db_paths_uat);
+
+    prefs_register_bool_preference(nameres,
+            "maxmind_db_in_process",
+            "Look up MaxMind databases in process",
+            "Read the MaxMind databases directly instead of asking a separate"
+            " mmdbresolve process. Results are then available immediately."
+            " The separate process is still used if the databases can't be"
+            " opened.",
+            &mmdb_in_process);
+
+    prefs_register_uint_preference(nameres,
+            "maxmind_db_cache_size",
+            "MaxMind lookup cache size",
+            "How many addresses to remember the results of MaxMind"
+            " lookups for, when looking up in process.",
+            10,
+            &mmdb_cache_size);
+}
+
+void maxmind_db_pref_apply(void)
+{
+    // Nothing to restart if the database list hasn't been set up yet.
+    if (!mmdb_file_arr) {
+        return;
+    }
+
+    if (mmdb_in_process != mmdb_in_process_applied || mmdb_cache_size != mmdb_cache_size_applied) {
+        maxmind_db_post_update_cb();
+    }
 }
 
 void maxmind_db_pref_cleanup(void)
 {
     mmdb_resolve_stop();
+    mmdb_in_process_stop();
 }
 
 /**
@@ -653,6 +1096,15 @@ gboolean maxmind_db_lookup_process(void)
 
 const mmdb_lookup_t *
 maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
+    ws_in6_addr addr6;
+    const mmdb_lookup_t *cached;
+
+    mmdb_in_process_addr4(addr, &addr6);
+    cached = mmdb_cache_lookup(&addr6, TRUE);
+    if (cached) {
+        return cached;
+    }
+
     mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
 
     if (!result) {
@@ -672,6 +1124,11 @@ maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
 
 const mmdb_lookup_t *
 maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
+    const mmdb_lookup_t *cached = mmdb_cache_lookup(addr, FALSE);
+    if (cached) {
+        return cached;
+    }
+
     mmdb_lookup_t * result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
 
     if (!result) {
@@ -718,6 +1175,9 @@ maxmind_db_get_paths(void) {
 void
 maxmind_db_pref_init(module_t *nameres _U_) {}
 
+void
+maxmind_db_pref_apply(void) {}
+
 void
 maxmind_db_pref_cleanup(void) {}
 
@@ -39,6 +39,11 @@ typedef struct _mmdb_lookup_t {
  */
 WS_DLL_LOCAL void maxmind_db_pref_init(module_t *nameres);
 
+/**
+ * Apply function called when the name resolution preferences change
+ */
+WS_DLL_LOCAL void maxmind_db_pref_apply(void);
+
 /**
  * Cleanup function called from prefs_cleanup
  */
@@ -49,7 +54,8 @@ WS_DLL_LOCAL void maxmind_db_pref_cleanup(void);
  *
  * @param addr IPv4 address to look up
  *
- * @return The database entry if found, else NULL.
+ * @return The database entry if found, else NULL. The entry stays valid
+ * after later lookups.
  */
 WS_DLL_PUBLIC WS_RETNONNULL const mmdb_lookup_t *maxmind_db_lookup_ipv4(const ws_in4_addr *addr);
 
@@ -58,7 +64,8 @@ WS_DLL_PUBLIC WS_RETNONNULL const mmdb_lookup_t *maxmind_db_lookup_ipv4(const ws
  *
  * @param addr IPv6 address to look up
  *
- * @return The database entry if found, else NULL.
+ * @return The database entry if found, else NULL. The entry stays valid
+ * after later lookups.
  */
 WS_DLL_PUBLIC WS_RETNONNULL const mmdb_lookup_t *maxmind_db_lookup_ipv6(const ws_in6_addr *addr);
 
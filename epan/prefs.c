@@ -3260,6 +3260,18 @@ prefs_register_modules(void)
                                    "Wrap to beginning/end of file during search?",
                                    &prefs.gui_find_wrap);
 
+    register_string_like_preference(gui_module, "find_index_fields",
+                                    "Fields to index for finding packets",
+                                    "Fields whose values are indexed when a capture file is read, separated by spaces "
+                                    "(e.g. ip.addr ipv6.addr tcp.port udp.port dns.qry.name http.host "
+                                    "tls.handshake.extensions_server_name). "
+                                    "Finding a packet or applying a display filter that tests one of them for "
+                                    "equality with a value then only has to look at the packets with that value. "
+                                    "Frame number fields and fields with generated values, such as tcp.stream, aren't indexed; "
+                                    "filters on a stream being followed use the frames recorded for Follow Stream instead. "
+                                    "Takes effect for the next capture file read.",
+                                    &prefs.gui_find_index_fields, PREF_STRING, NULL, TRUE);
+
     prefs_register_obsolete_preference(gui_module, "use_pref_save");
 
     prefs_register_bool_preference(gui_module, "geometry.save.position",
@@ -3343,6 +3355,14 @@ prefs_register_modules(void)
                                    10,
                                    &prefs.gui_max_export_objects);
 
+    register_string_like_preference(gui_module, "export_objects_spill_dir",
+                                    "Directory for exported object contents",
+                                    "If set, the contents of the objects found by Export Objects are written to "
+                                    "files in a directory created under this one as they are found, instead of "
+                                    "being kept in memory until they're saved. Identical contents are only "
+                                    "written once.",
+                                    &prefs.gui_export_objects_spill_dir, PREF_DIRNAME, NULL, TRUE);
+
 
     /* User Interface : Layout */
     gui_layout_module = prefs_register_subtree(gui_module, "Layout", "Layout", gui_layout_callback);
@@ -4111,6 +4131,8 @@ pre_init_prefs(void)
     prefs.gui_ask_unsaved            = TRUE;
     prefs.gui_autocomplete_filter    = TRUE;
     prefs.gui_find_wrap              = TRUE;
+    g_free(prefs.gui_find_index_fields);
+    prefs.gui_find_index_fields      = g_strdup("");
     prefs.gui_update_enabled         = TRUE;
     prefs.gui_update_channel         = UPDATE_CHANNEL_STABLE;
     prefs.gui_update_interval        = 60*60*24; /* Seconds */
@@ -4138,6 +4160,8 @@ pre_init_prefs(void)
     prefs.gui_qt_show_selected_packet = FALSE;
     prefs.gui_qt_show_file_load_time = FALSE;
     prefs.gui_max_export_objects     = 1000;
+    g_free(prefs.gui_export_objects_spill_dir);
+    prefs.gui_export_objects_spill_dir = g_strdup("");
 
     if (prefs.col_list) {
         free_col_info(prefs.col_list);
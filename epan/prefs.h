@@ -167,11 +167,13 @@ typedef struct _e_prefs {
   gboolean     gui_ask_unsaved;
   gboolean     gui_autocomplete_filter;
   gboolean     gui_find_wrap;
+  gchar       *gui_find_index_fields;
   gchar       *gui_window_title;
   gchar       *gui_prepend_window_title;
   gchar       *gui_start_title;
   version_info_e gui_version_placement;
   guint        gui_max_export_objects;
+  gchar       *gui_export_objects_spill_dir;
   layout_type_e gui_layout_type;
   layout_pane_content_e gui_layout_content_1;
   layout_pane_content_e gui_layout_content_2;
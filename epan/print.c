@@ -70,6 +70,45 @@ typedef struct {
     epan_dissect_t  *edt;
 } write_field_data_t;
 
+/* Value types of the columns written by write_columnar_proto_tree() */
+typedef enum {
+    COLUMNAR_STRING,    /* dictionary-encoded text */
+    COLUMNAR_UINT,
+    COLUMNAR_INT,
+    COLUMNAR_BOOL,
+    COLUMNAR_DOUBLE,
+    COLUMNAR_TIME,      /* nanoseconds since the epoch */
+    COLUMNAR_DURATION   /* nanoseconds */
+} columnar_type_e;
+
+typedef union {
+    guint64 u;          /* COLUMNAR_UINT, COLUMNAR_BOOL, dictionary index */
+    gint64  i;          /* COLUMNAR_INT, COLUMNAR_TIME, COLUMNAR_DURATION */
+    gdouble d;          /* COLUMNAR_DOUBLE */
+} columnar_value_t;
+
+typedef struct {
+    columnar_type_e  type;
+    int              bits;          /* 32 or 64 for integer types */
+    GArray          *offsets;       /* guint32, start of each row in values */
+    GArray          *values;        /* columnar_value_t */
+    guint            row_count;     /* values added for the current packet */
+    GHashTable      *dict;          /* string -> index + 1, kept across batches */
+    GPtrArray       *dict_new;      /* strings first seen in the current batch */
+} columnar_column_t;
+
+/* Rows buffered before a record batch is written */
+#define COLUMNAR_BATCH_ROWS 4096
+
+/* Version of the schema item at the start of the stream */
+#define COLUMNAR_VERSION 1
+
+typedef struct _columnar_output {
+    json_dumper         dumper;
+    columnar_column_t  *columns;
+    guint32             rows;
+} columnar_output_t;
+
 struct _output_fields {
     gboolean      print_bom;
     gboolean      print_header;
@@ -81,6 +120,7 @@ struct _output_fields {
     GPtrArray   **field_values;
     gchar         quote;
     gboolean      includes_col_fields;
+    columnar_output_t *columnar;
 };
 
 static gchar *get_field_hex_value(GSList *src_list, field_info *fi);
@@ -121,6 +161,8 @@ static void print_pdml_geninfo(epan_dissect_t *edt, FILE *fh);
 static void write_ek_summary(column_info *cinfo, write_json_data *pdata);
 
 static void proto_tree_get_node_field_values(proto_node *node, gpointer data);
+static void output_fields_prepare_indicies(output_fields_t *fields);
+static void columnar_output_free(output_fields_t *fields);
 
 /* Cache the protocols and field handles that the print functionality needs
    This helps break explicit dependency on the dissectors. */
@@ -2027,6 +2069,8 @@ void output_fields_free(output_fields_t* fields)
             g_free(fields->field_values);
         }
 
+        columnar_output_free(fields);
+
         for (i = 0; i < fields->fields->len; ++i) {
             gchar* field = (gchar *)g_ptr_array_index(fields->fields,i);
             g_free(field);
@@ -2339,6 +2383,26 @@ static void proto_tree_get_node_field_values(proto_node *node, gpointer data)
     }
 }
 
+static void output_fields_prepare_indicies(output_fields_t *fields)
+{
+    gsize i;
+
+    if (NULL == fields->field_indicies) {
+        /* Prepare a lookup table from string abbreviation for field to its index. */
+        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
+
+        i = 0;
+        while (i < fields->fields->len) {
+            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
+            /* Store field indicies +1 so that zero is not a valid value,
+             * and can be distinguished from NULL as a pointer.
+             */
+            ++i;
+            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
+        }
+    }
+}
+
 static void write_specified_fields(fields_format format, output_fields_t *fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh, json_dumper *dumper)
 {
     gsize     i;
@@ -2361,20 +2425,7 @@ static void write_specified_fields(fields_format format, output_fields_t *fields
     data.fields = fields;
     data.edt = edt;
 
-    if (NULL == fields->field_indicies) {
-        /* Prepare a lookup table from string abbreviation for field to its index. */
-        fields->field_indicies = g_hash_table_new(g_str_hash, g_str_equal);
-
-        i = 0;
-        while (i < fields->fields->len) {
-            gchar *field = (gchar *)g_ptr_array_index(fields->fields, i);
-            /* Store field indicies +1 so that zero is not a valid value,
-             * and can be distinguished from NULL as a pointer.
-             */
-            ++i;
-            g_hash_table_insert(fields->field_indicies, field, GUINT_TO_POINTER(i));
-        }
-    }
+    output_fields_prepare_indicies(fields);
 
     /* Array buffer to store values for this packet              */
     /*  Allocate an array for the 'GPtrarray *' the first time   */
@@ -2527,6 +2578,479 @@ void write_fields_finale(output_fields_t* fields _U_ , FILE *fh _U_)
     /* Nothing to do */
 }
 
+/*
+ * Columnar output ("tshark -T columnar").
+ *
+ * Each field given with -e becomes a typed column, and rows are written in
+ * record batches of COLUMNAR_BATCH_ROWS packets as a stream of CBOR items
+ * (see JSON_DUMPER_FLAGS_CBOR), so consumers can load whole columns without
+ * parsing text. The stream starts with a schema item:
+ *
+ *   {"version": 1, "fields": [{"name": "ip.src", "type": "uint32", "ftype": "FT_IPv4"}, ...]}
+ *
+ * followed by one item per batch:
+ *
+ *   {"rows": N, "columns": [{"offsets": [...], "dictionary": [...], "values": [...]}, ...]}
+ *
+ * The values of row r are values[offsets[r]] up to values[offsets[r + 1]],
+ * so fields that occur several times in a packet form list columns and
+ * missing fields are empty lists. String columns hold indexes into a
+ * dictionary which is built up over the whole stream; every batch carries
+ * only the strings first seen in that batch. IPv4 addresses are written as
+ * 32-bit integers, absolute times as nanoseconds since the epoch and
+ * relative times as nanoseconds.
+ */
+static columnar_type_e
+columnar_type_for_ftype(ftenum_t type, int *bits)
+{
+    *bits = 32;
+    switch (type) {
+    case FT_CHAR:
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_FRAMENUM:
+    case FT_IPv4:
+        return COLUMNAR_UINT;
+
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+    case FT_EUI64:
+        *bits = 64;
+        return COLUMNAR_UINT;
+
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return COLUMNAR_INT;
+
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        *bits = 64;
+        return COLUMNAR_INT;
+
+    case FT_BOOLEAN:
+        return COLUMNAR_BOOL;
+
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return COLUMNAR_DOUBLE;
+
+    case FT_ABSOLUTE_TIME:
+        return COLUMNAR_TIME;
+
+    case FT_RELATIVE_TIME:
+        return COLUMNAR_DURATION;
+
+    default:
+        return COLUMNAR_STRING;
+    }
+}
+
+static const char *
+columnar_type_name(const columnar_column_t *column)
+{
+    switch (column->type) {
+    case COLUMNAR_UINT:
+        return column->bits == 64 ? "uint64" : "uint32";
+    case COLUMNAR_INT:
+        return column->bits == 64 ? "int64" : "int32";
+    case COLUMNAR_BOOL:
+        return "bool";
+    case COLUMNAR_DOUBLE:
+        return "double";
+    case COLUMNAR_TIME:
+        return "timestamp_ns";
+    case COLUMNAR_DURATION:
+        return "duration_ns";
+    default:
+        return "string";
+    }
+}
+
+/*
+ * Fields with the same name may be registered with different types; the
+ * column gets a type that holds all of them, or becomes a string column.
+ */
+static void
+columnar_column_init(columnar_column_t *column, const gchar *field)
+{
+    header_field_info *hfinfo = NULL;
+
+    column->type = COLUMNAR_STRING;
+    column->bits = 32;
+
+    if (strncmp(field, COLUMN_FIELD_FILTER, strlen(COLUMN_FIELD_FILTER)) != 0)
+        hfinfo = proto_registrar_get_byname(field);
+
+    if (hfinfo) {
+        while (hfinfo->same_name_prev_id != -1)
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+
+        column->type = columnar_type_for_ftype(hfinfo->type, &column->bits);
+        for (hfinfo = hfinfo->same_name_next; hfinfo; hfinfo = hfinfo->same_name_next) {
+            int bits;
+
+            if (columnar_type_for_ftype(hfinfo->type, &bits) != column->type) {
+                column->type = COLUMNAR_STRING;
+                column->bits = 32;
+                break;
+            }
+            column->bits = MAX(column->bits, bits);
+        }
+    }
+
+    column->offsets = g_array_sized_new(FALSE, FALSE, sizeof(guint32), COLUMNAR_BATCH_ROWS + 1);
+    column->values = g_array_sized_new(FALSE, FALSE, sizeof(columnar_value_t), COLUMNAR_BATCH_ROWS);
+    if (column->type == COLUMNAR_STRING) {
+        column->dict = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        column->dict_new = g_ptr_array_new();
+    }
+}
+
+/*
+ * Adds a value for the current packet, honouring the "occurrence" option.
+ * Returns the slot to fill in, or NULL if the value is not wanted.
+ */
+static columnar_value_t *
+columnar_column_add(output_fields_t *fields, columnar_column_t *column)
+{
+    columnar_value_t empty = { 0 };
+
+    if (column->row_count > 0) {
+        switch (fields->occurrence) {
+        case 'f':
+            return NULL;
+        case 'l':
+            return &g_array_index(column->values, columnar_value_t, column->values->len - 1);
+        default:
+            break;
+        }
+    }
+
+    column->row_count++;
+    g_array_append_val(column->values, empty);
+    return &g_array_index(column->values, columnar_value_t, column->values->len - 1);
+}
+
+static void
+columnar_column_add_string(output_fields_t *fields, columnar_column_t *column, gchar *str)
+{
+    columnar_value_t *value;
+    gpointer index;
+
+    value = columnar_column_add(fields, column);
+    if (!value || !str) {
+        g_free(str);
+        return;
+    }
+
+    /* Dictionary indexes are stored +1 to tell them from a missing entry. */
+    index = g_hash_table_lookup(column->dict, str);
+    if (index) {
+        g_free(str);
+    } else {
+        index = GUINT_TO_POINTER(g_hash_table_size(column->dict) + 1);
+        g_hash_table_insert(column->dict, str, index);
+        g_ptr_array_add(column->dict_new, str);
+    }
+    value->u = GPOINTER_TO_UINT(index) - 1;
+}
+
+static void
+columnar_column_add_field(output_fields_t *fields, columnar_column_t *column, field_info *fi, epan_dissect_t *edt)
+{
+    columnar_value_t *value;
+    const nstime_t *ts;
+
+    if (column->type == COLUMNAR_STRING) {
+        columnar_column_add_string(fields, column, get_node_field_value(fi, edt));
+        return;
+    }
+
+    value = columnar_column_add(fields, column);
+    if (!value)
+        return;
+
+    switch (fi->hfinfo->type) {
+    case FT_IPv4:
+        /* Stored in network byte order. */
+        value->u = g_ntohl(fvalue_get_uinteger(&fi->value));
+        break;
+
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+    case FT_EUI64:
+    case FT_BOOLEAN:
+        value->u = fvalue_get_uinteger64(&fi->value);
+        break;
+
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        value->i = fvalue_get_sinteger(&fi->value);
+        break;
+
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        value->i = fvalue_get_sinteger64(&fi->value);
+        break;
+
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        value->d = fvalue_get_floating(&fi->value);
+        break;
+
+    case FT_ABSOLUTE_TIME:
+    case FT_RELATIVE_TIME:
+        ts = (const nstime_t *)fvalue_get(&fi->value);
+        value->i = (gint64)ts->secs * G_GINT64_CONSTANT(1000000000) + ts->nsecs;
+        break;
+
+    default:
+        value->u = fvalue_get_uinteger(&fi->value);
+        break;
+    }
+}
+
+static void proto_tree_get_node_columnar_values(proto_node *node, gpointer data)
+{
+    write_field_data_t *call_data;
+    field_info *fi;
+    gpointer    field_index;
+
+    call_data = (write_field_data_t *)data;
+    fi = PNODE_FINFO(node);
+
+    /* dissection with an invisible proto tree? */
+    g_assert(fi);
+
+    field_index = g_hash_table_lookup(call_data->fields->field_indicies, fi->hfinfo->abbrev);
+    if (NULL != field_index) {
+        columnar_column_add_field(call_data->fields,
+                                  &call_data->fields->columnar->columns[GPOINTER_TO_UINT(field_index) - 1],
+                                  fi, call_data->edt);
+    }
+
+    /* Recurse here. */
+    if (node->first_child != NULL) {
+        proto_tree_children_foreach(node, proto_tree_get_node_columnar_values,
+                                    call_data);
+    }
+}
+
+static void
+columnar_write_batch(output_fields_t *fields)
+{
+    columnar_output_t *out = fields->columnar;
+    json_dumper *dumper = &out->dumper;
+    gsize i;
+    guint j;
+
+    if (out->rows == 0)
+        return;
+
+    json_dumper_begin_object(dumper);
+    json_dumper_set_member_name(dumper, "rows");
+    json_dumper_value_anyf(dumper, "%u", out->rows);
+    json_dumper_set_member_name(dumper, "columns");
+    json_dumper_begin_array(dumper);
+    for (i = 0; i < fields->fields->len; i++) {
+        columnar_column_t *column = &out->columns[i];
+
+        json_dumper_begin_object(dumper);
+
+        json_dumper_set_member_name(dumper, "offsets");
+        json_dumper_begin_array(dumper);
+        for (j = 0; j < column->offsets->len; j++) {
+            json_dumper_value_anyf(dumper, "%u", g_array_index(column->offsets, guint32, j));
+        }
+        json_dumper_value_anyf(dumper, "%u", column->values->len);
+        json_dumper_end_array(dumper);
+
+        if (column->type == COLUMNAR_STRING) {
+            json_dumper_set_member_name(dumper, "dictionary");
+            json_dumper_begin_array(dumper);
+            for (j = 0; j < column->dict_new->len; j++) {
+                json_dumper_value_string(dumper, (const char *)g_ptr_array_index(column->dict_new, j));
+            }
+            json_dumper_end_array(dumper);
+            g_ptr_array_set_size(column->dict_new, 0);
+        }
+
+        json_dumper_set_member_name(dumper, "values");
+        json_dumper_begin_array(dumper);
+        for (j = 0; j < column->values->len; j++) {
+            const columnar_value_t *value = &g_array_index(column->values, columnar_value_t, j);
+
+            switch (column->type) {
+            case COLUMNAR_INT:
+            case COLUMNAR_TIME:
+            case COLUMNAR_DURATION:
+                json_dumper_value_anyf(dumper, "%" G_GINT64_FORMAT, value->i);
+                break;
+            case COLUMNAR_BOOL:
+                json_dumper_value_anyf(dumper, "%s", value->u ? "true" : "false");
+                break;
+            case COLUMNAR_DOUBLE:
+                json_dumper_value_double(dumper, value->d);
+                break;
+            default:
+                json_dumper_value_anyf(dumper, "%" G_GUINT64_FORMAT, value->u);
+                break;
+            }
+        }
+        json_dumper_end_array(dumper);
+
+        json_dumper_end_object(dumper);
+
+        g_array_set_size(column->offsets, 0);
+        g_array_set_size(column->values, 0);
+    }
+    json_dumper_end_array(dumper);
+    json_dumper_end_object(dumper);
+    json_dumper_finish(dumper);
+
+    out->rows = 0;
+}
+
+static void
+columnar_output_free(output_fields_t *fields)
+{
+    columnar_output_t *out = fields->columnar;
+    gsize i;
+
+    if (NULL == out)
+        return;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        g_array_free(out->columns[i].offsets, TRUE);
+        g_array_free(out->columns[i].values, TRUE);
+        if (out->columns[i].dict) {
+            g_ptr_array_free(out->columns[i].dict_new, TRUE);
+            g_hash_table_destroy(out->columns[i].dict);
+        }
+    }
+    g_free(out->columns);
+    g_free(out);
+    fields->columnar = NULL;
+}
+
+void write_columnar_preamble(output_fields_t* fields, FILE *fh)
+{
+    columnar_output_t *out;
+    json_dumper *dumper;
+    gsize i;
+
+    g_assert(fields);
+    g_assert(fh);
+    g_assert(fields->fields);
+
+    columnar_output_free(fields);
+    output_fields_prepare_indicies(fields);
+
+    out = g_new0(columnar_output_t, 1);
+    out->dumper.output_file = fh;
+    out->dumper.flags = JSON_DUMPER_FLAGS_CBOR;
+    out->columns = g_new0(columnar_column_t, fields->fields->len);
+    fields->columnar = out;
+
+    dumper = &out->dumper;
+    json_dumper_begin_object(dumper);
+    json_dumper_set_member_name(dumper, "version");
+    json_dumper_value_anyf(dumper, "%d", COLUMNAR_VERSION);
+    json_dumper_set_member_name(dumper, "fields");
+    json_dumper_begin_array(dumper);
+    for (i = 0; i < fields->fields->len; i++) {
+        const gchar *field = (const gchar *)g_ptr_array_index(fields->fields, i);
+        header_field_info *hfinfo = proto_registrar_get_byname(field);
+
+        columnar_column_init(&out->columns[i], field);
+
+        json_dumper_begin_object(dumper);
+        json_dumper_set_member_name(dumper, "name");
+        json_dumper_value_string(dumper, field);
+        json_dumper_set_member_name(dumper, "type");
+        json_dumper_value_string(dumper, columnar_type_name(&out->columns[i]));
+        if (hfinfo) {
+            json_dumper_set_member_name(dumper, "ftype");
+            json_dumper_value_string(dumper, ftype_name(hfinfo->type));
+        }
+        json_dumper_end_object(dumper);
+    }
+    json_dumper_end_array(dumper);
+    json_dumper_end_object(dumper);
+    json_dumper_finish(dumper);
+}
+
+void write_columnar_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh _U_)
+{
+    columnar_output_t *out;
+    write_field_data_t data;
+    gpointer field_index;
+    gchar *col_name;
+    gint col;
+    gsize i;
+
+    g_assert(fields);
+    g_assert(fields->columnar);
+    g_assert(edt);
+
+    out = fields->columnar;
+    for (i = 0; i < fields->fields->len; i++) {
+        columnar_column_t *column = &out->columns[i];
+
+        g_array_append_val(column->offsets, column->values->len);
+        column->row_count = 0;
+    }
+
+    data.fields = fields;
+    data.edt = edt;
+    proto_tree_children_foreach(edt->tree, proto_tree_get_node_columnar_values,
+                                &data);
+
+    /* Add columns to fields */
+    if (fields->includes_col_fields) {
+        for (col = 0; col < cinfo->num_cols; col++) {
+            if (!get_column_visible(col))
+                continue;
+            /* Prepend COLUMN_FIELD_FILTER as the field name */
+            col_name = g_strdup_printf("%s%s", COLUMN_FIELD_FILTER, cinfo->columns[col].col_title);
+            field_index = g_hash_table_lookup(fields->field_indicies, col_name);
+            g_free(col_name);
+
+            if (NULL != field_index) {
+                columnar_column_add_string(fields, &out->columns[GPOINTER_TO_UINT(field_index) - 1],
+                                           g_strdup(cinfo->columns[col].col_data));
+            }
+        }
+    }
+
+    if (++out->rows == COLUMNAR_BATCH_ROWS)
+        columnar_write_batch(fields);
+}
+
+void write_columnar_finale(output_fields_t* fields, FILE *fh _U_)
+{
+    g_assert(fields);
+
+    if (fields->columnar) {
+        columnar_write_batch(fields);
+        columnar_output_free(fields);
+    }
+}
+
 /* Returns an g_malloced string */
 gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt)
 {
@@ -2664,6 +3188,7 @@ output_fields_t* output_fields_new(void)
     fields->field_values        = NULL;
     fields->quote               ='\0';
     fields->includes_col_fields = FALSE;
+    fields->columnar            = NULL;
     return fields;
 }
 
@@ -125,6 +125,14 @@ WS_DLL_PUBLIC void write_fields_preamble(output_fields_t* fields, FILE *fh);
 WS_DLL_PUBLIC void write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
 WS_DLL_PUBLIC void write_fields_finale(output_fields_t* fields, FILE *fh);
 
+/*
+ * Typed, column-oriented output of the fields selected with
+ * output_fields_add(): a CBOR schema item followed by CBOR record batches.
+ */
+WS_DLL_PUBLIC void write_columnar_preamble(output_fields_t* fields, FILE *fh);
+WS_DLL_PUBLIC void write_columnar_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_info *cinfo, FILE *fh);
+WS_DLL_PUBLIC void write_columnar_finale(output_fields_t* fields, FILE *fh);
+
 WS_DLL_PUBLIC gchar* get_node_field_value(field_info* fi, epan_dissect_t* edt);
 
 extern void print_cache_field_handles(void);
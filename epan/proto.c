@@ -92,6 +92,18 @@ struct ptvcursor {
 #define CHECK_FOR_NULL_TREE(tree) \
 	CHECK_FOR_NULL_TREE_AND_FREE(tree, ((void)0))
 
+/*
+ * There is no separate "columns only" mode: without a tree (e.g. TShark
+ * printing only the columns) CHECK_FOR_NULL_TREE() returns at once, and
+ * with a tree built only for filters, colouring rules or custom columns
+ * TRY_TO_FAKE_THIS_ITEM() returns before anything is formatted for an
+ * item nobody refers to. Column text can't be deferred any further from
+ * here or from column-utils.c, as dissectors build the strings they pass
+ * to col_*() and proto_item_append_text() themselves; avoiding that work
+ * takes checks in the dissectors (a NULL or invisible tree, or a column
+ * that isn't shown). tools/dissect_columns_bench.py times the cases.
+ */
+
 /** See inlined comments.
  @param tree the tree to append this item to
  @param hfindex field index
@@ -410,6 +422,15 @@ static gpa_hfinfo_t gpa_hfinfo;
 static GHashTable *gpa_name_map = NULL;
 static header_field_info *same_name_hfinfo;
 
+/*
+ * Fields are entered in gpa_name_map when something first needs to find
+ * a field by name (a display filter, a custom column, a field list),
+ * not when they're registered; many short-lived tshark runs never
+ * need it. Fields with IDs below this have been entered.
+ */
+static guint32 gpa_name_map_len;
+static void gpa_name_map_sync(void);
+
 /* Hash table protocol aliases. const char * -> const char * */
 static GHashTable *gpa_protocol_aliases = NULL;
 
@@ -498,6 +519,7 @@ proto_init(GSList *register_all_plugin_protocols_list,
 	gpa_hfinfo.allocated_len = 0;
 	gpa_hfinfo.hfi           = NULL;
 	gpa_name_map             = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, save_same_name_hfinfo);
+	gpa_name_map_len         = 0;
 	gpa_protocol_aliases     = g_hash_table_new(g_str_hash, g_str_equal);
 	deregistered_fields      = g_ptr_array_new();
 	deregistered_data        = g_ptr_array_new();
@@ -953,6 +975,7 @@ proto_registrar_get_byname(const char *field_name)
 		return last_hfinfo;
 	}
 
+	gpa_name_map_sync();
 	hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
 
 	if (hfinfo) {
@@ -972,6 +995,7 @@ proto_registrar_get_byname(const char *field_name)
 		return NULL;
 	}
 
+	gpa_name_map_sync();
 	hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
 
 	if (hfinfo) {
@@ -7211,6 +7235,8 @@ proto_deregister_protocol(const char *short_name)
 	if (protocol == NULL)
 		return FALSE;
 
+	gpa_name_map_sync();
+
 	g_hash_table_remove(proto_names, protocol->name);
 	g_hash_table_remove(proto_short_names, (gpointer)short_name);
 	g_hash_table_remove(proto_filter_names, (gpointer)protocol->filter_name);
@@ -7308,6 +7334,9 @@ proto_get_first_protocol_field(const int proto_id, void **cookie)
 	if ((protocol == NULL) || (protocol->fields == NULL) || (protocol->fields->len == 0))
 		return NULL;
 
+	/* Callers look at same_name_prev_id to skip duplicate names. */
+	gpa_name_map_sync();
+
 	*cookie = GUINT_TO_POINTER(0 + 1);
 	return (header_field_info *)g_ptr_array_index(protocol->fields, 0);
 }
@@ -7723,6 +7752,8 @@ proto_deregister_field (const int parent, gint hf_id)
 		return;
 	}
 
+	gpa_name_map_sync();
+
 	for (i = 0; i < proto->fields->len; i++) {
 		hfi = (header_field_info *)g_ptr_array_index(proto->fields, i);
 		if (hfi->id == hf_id) {
@@ -8550,6 +8581,18 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 	gpa_hfinfo.len++;
 	hfinfo->id = gpa_hfinfo.len - 1;
 
+#ifdef ENABLE_CHECK_FILTER
+	/* Check names and report incompatible duplicates right away. */
+	gpa_name_map_sync();
+#endif
+
+	return hfinfo->id;
+}
+
+/* Enter a field in gpa_name_map. */
+static void
+proto_register_field_name(header_field_info *hfinfo)
+{
 	/* if we have real names, enter this field in the name tree */
 	if ((hfinfo->name[0] != 0) && (hfinfo->abbrev[0] != 0 )) {
 
@@ -8611,8 +8654,20 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 #endif
 		}
 	}
+}
 
-	return hfinfo->id;
+/* Enter every field registered since the last call in gpa_name_map,
+ * in registration order, so that fields sharing a name are chained
+ * the same way they would have been at registration. */
+static void
+gpa_name_map_sync(void)
+{
+	while (gpa_name_map_len < gpa_hfinfo.len) {
+		header_field_info *hfinfo = gpa_hfinfo.hfi[gpa_name_map_len++];
+
+		if (hfinfo)
+			proto_register_field_name(hfinfo);
+	}
 }
 
 void
@@ -10612,6 +10667,8 @@ proto_registrar_dump_fieldcount(void)
 	guint32			same_name_count = 0;
 	guint32			protocol_count = 0;
 
+	gpa_name_map_sync();
+
 	for (i = 0; i < gpa_hfinfo.len; i++) {
 		if (gpa_hfinfo.hfi[i] == NULL) {
 			deregistered_count++;
@@ -10767,6 +10824,8 @@ proto_registrar_dump_elastic(const gchar* filter)
 	json_dumper_set_member_name(&dumper, "properties");
 	json_dumper_begin_object(&dumper); // 6.properties
 
+	gpa_name_map_sync();
+
 	for (i = 0; i < gpa_hfinfo.len; i++) {
 		if (gpa_hfinfo.hfi[i] == NULL)
 			continue; /* This is a deregistered protocol or header field */
@@ -10883,6 +10942,8 @@ proto_registrar_dump_fields(void)
 	const char	  *blurb;
 	char		   width[5];
 
+	gpa_name_map_sync();
+
 	len = gpa_hfinfo.len;
 	for (i = 0; i < len ; i++) {
 		if (gpa_hfinfo.hfi[i] == NULL)
@@ -11291,7 +11352,7 @@ proto_construct_match_selected_string(field_info *finfo, epan_dissect_t *edt)
 static gboolean
 proto_item_add_bitmask_tree(proto_item *item, tvbuff_t *tvb, const int offset,
 			    const int len, const gint ett, const int **fields,
-			    const int flags, gboolean first,
+			    int flags, gboolean first,
 			    gboolean use_parent_tree,
 			    proto_tree* tree, guint64 value)
 {
@@ -11315,6 +11376,12 @@ proto_item_add_bitmask_tree(proto_item *item, tvbuff_t *tvb, const int offset,
 	if (use_parent_tree == FALSE)
 		tree = proto_item_add_subtree(item, ett);
 
+	/* The summary appended to the header item is only ever shown in a
+	 * visible tree; skip all the value_string lookups and number
+	 * formatting when nobody is going to look at it. */
+	if (!item || !PTREE_DATA(item)->visible)
+		flags |= BMT_NO_APPEND;
+
 	while (*fields) {
 		guint64 present_bits;
 		PROTO_REGISTRAR_GET_NTH(**fields,hf);
@@ -11951,30 +12018,17 @@ _proto_tree_add_bits_ret_val(proto_tree *tree, const int hfindex, tvbuff_t *tvb,
 	CHECK_FOR_NULL_TREE(tree);
 	TRY_TO_FAKE_THIS_ITEM(tree, hfindex, hf_field);
 
-	bf_str = decode_bits_in_field(bit_offset, no_of_bits, value);
-
 	switch (hf_field->type) {
 	case FT_BOOLEAN:
-		/* Boolean field */
-		tfstring = &tfs_true_false;
-		if (hf_field->strings)
-			tfstring = (const true_false_string *)hf_field->strings;
-		return proto_tree_add_boolean_format(tree, hfindex, tvb, offset, length, (guint32)value,
-			"%s = %s: %s",
-			bf_str, hf_field->name, tfs_get_string(!!value, tfstring));
+		pi = proto_tree_add_boolean(tree, hfindex, tvb, offset, length, (guint32)value);
 		break;
 
 	case FT_CHAR:
-		pi = proto_tree_add_uint(tree, hfindex, tvb, offset, length, (guint32)value);
-		fill_label_char(PITEM_FINFO(pi), lbl_str);
-		break;
-
 	case FT_UINT8:
 	case FT_UINT16:
 	case FT_UINT24:
 	case FT_UINT32:
 		pi = proto_tree_add_uint(tree, hfindex, tvb, offset, length, (guint32)value);
-		fill_label_number(PITEM_FINFO(pi), lbl_str, FALSE);
 		break;
 
 	case FT_INT8:
@@ -11982,7 +12036,6 @@ _proto_tree_add_bits_ret_val(proto_tree *tree, const int hfindex, tvbuff_t *tvb,
 	case FT_INT24:
 	case FT_INT32:
 		pi = proto_tree_add_int(tree, hfindex, tvb, offset, length, (gint32)value);
-		fill_label_number(PITEM_FINFO(pi), lbl_str, TRUE);
 		break;
 
 	case FT_UINT40:
@@ -11990,7 +12043,6 @@ _proto_tree_add_bits_ret_val(proto_tree *tree, const int hfindex, tvbuff_t *tvb,
 	case FT_UINT56:
 	case FT_UINT64:
 		pi = proto_tree_add_uint64(tree, hfindex, tvb, offset, length, value);
-		fill_label_number64(PITEM_FINFO(pi), lbl_str, FALSE);
 		break;
 
 	case FT_INT40:
@@ -11998,7 +12050,6 @@ _proto_tree_add_bits_ret_val(proto_tree *tree, const int hfindex, tvbuff_t *tvb,
 	case FT_INT56:
 	case FT_INT64:
 		pi = proto_tree_add_int64(tree, hfindex, tvb, offset, length, (gint64)value);
-		fill_label_number64(PITEM_FINFO(pi), lbl_str, TRUE);
 		break;
 
 	default:
@@ -12007,6 +12058,52 @@ _proto_tree_add_bits_ret_val(proto_tree *tree, const int hfindex, tvbuff_t *tvb,
 		break;
 	}
 
+	/* The field value is all a filter or column needs; only build the
+	 * "..10 10.. = Name: value" label for a visible tree. */
+	TRY_TO_FAKE_THIS_REPR(pi);
+
+	bf_str = decode_bits_in_field(bit_offset, no_of_bits, value);
+
+	switch (hf_field->type) {
+	case FT_BOOLEAN:
+		/* Boolean field */
+		tfstring = &tfs_true_false;
+		if (hf_field->strings)
+			tfstring = (const true_false_string *)hf_field->strings;
+		proto_item_set_text(pi, "%s = %s: %s",
+			bf_str, hf_field->name, tfs_get_string(!!value, tfstring));
+		return pi;
+
+	case FT_CHAR:
+		fill_label_char(PITEM_FINFO(pi), lbl_str);
+		break;
+
+	case FT_UINT8:
+	case FT_UINT16:
+	case FT_UINT24:
+	case FT_UINT32:
+		fill_label_number(PITEM_FINFO(pi), lbl_str, FALSE);
+		break;
+
+	case FT_INT8:
+	case FT_INT16:
+	case FT_INT24:
+	case FT_INT32:
+		fill_label_number(PITEM_FINFO(pi), lbl_str, TRUE);
+		break;
+
+	case FT_UINT40:
+	case FT_UINT48:
+	case FT_UINT56:
+	case FT_UINT64:
+		fill_label_number64(PITEM_FINFO(pi), lbl_str, FALSE);
+		break;
+
+	default:
+		fill_label_number64(PITEM_FINFO(pi), lbl_str, TRUE);
+		break;
+	}
+
 	proto_item_set_text(pi, "%s = %s", bf_str, lbl_str);
 	return pi;
 }
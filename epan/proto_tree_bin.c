@@ -0,0 +1,644 @@
+/* proto_tree_bin.c
+ * Compact binary serialization of dissected protocol trees
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <epan/packet.h>
+#include <epan/epan_dissect.h>
+#include <epan/proto_tree_bin.h>
+#include <ftypes/ftypes-int.h>
+
+/* The longest varint a 64-bit value can take */
+#define PTB_VARINT_MAX      10
+
+struct _proto_tree_bin_writer {
+    FILE       *fh;
+    GHashTable *field_ids;      /* hfinfo id -> stream field id + 1 */
+    guint32     n_fields;
+    GByteArray *fields;         /* Field records for the current packet */
+    GByteArray *nodes;          /* Nodes of the current packet */
+    guint32     node_count;
+};
+
+struct _proto_tree_bin_reader {
+    const guint8   *data;
+    const guint8   *end;
+    const guint8   *pos;
+    gboolean        failed;
+    GArray         *fields;     /* proto_tree_bin_field_t, indexed by id */
+    GHashTable     *by_abbrev;  /* abbrev -> id + 1 of the first field with it */
+    GArray         *nodes;      /* proto_tree_bin_node_t of the current packet */
+    GArray         *open;       /* ptb_open_node_t, parents whose children have not all been read yet */
+};
+
+typedef struct {
+    guint32         node;
+    guint32         remaining;  /* children still to be read */
+} ptb_open_node_t;
+
+/*
+ * Writer
+ */
+
+static void
+ptb_put_varint(GByteArray *buf, guint64 value)
+{
+    guint8 tmp[PTB_VARINT_MAX];
+    guint len = 0;
+
+    while (value >= 0x80) {
+        tmp[len++] = (guint8)(value | 0x80);
+        value >>= 7;
+    }
+    tmp[len++] = (guint8)value;
+    g_byte_array_append(buf, tmp, len);
+}
+
+static void
+ptb_put_zigzag(GByteArray *buf, gint64 value)
+{
+    ptb_put_varint(buf, ((guint64)value << 1) ^ (guint64)(value >> 63));
+}
+
+static void
+ptb_put_data(GByteArray *buf, const guint8 *data, gsize len)
+{
+    ptb_put_varint(buf, len);
+    if (len)
+        g_byte_array_append(buf, data, (guint)len);
+}
+
+static void
+ptb_put_string(GByteArray *buf, const char *str)
+{
+    ptb_put_data(buf, (const guint8 *)str, str ? strlen(str) : 0);
+}
+
+static proto_tree_bin_kind_e
+ptb_kind_for_ftype(ftenum_t ftype)
+{
+    switch (ftype) {
+    case FT_NONE:
+    case FT_PROTOCOL:
+        return PTB_KIND_NONE;
+
+    case FT_BOOLEAN:
+    case FT_IPv4:
+    case FT_IPXNET:
+    case FT_EUI64:
+        return PTB_KIND_UINT;
+
+    case FT_FLOAT:
+    case FT_DOUBLE:
+        return PTB_KIND_DOUBLE;
+
+    case FT_BYTES:
+    case FT_UINT_BYTES:
+    case FT_AX25:
+    case FT_VINES:
+    case FT_ETHER:
+    case FT_OID:
+    case FT_REL_OID:
+    case FT_SYSTEM_ID:
+    case FT_FCWWN:
+    case FT_IPv6:
+        return PTB_KIND_BYTES;
+
+    case FT_UINT_STRING:
+        return PTB_KIND_STRING;
+
+    default:
+        break;
+    }
+
+    if (IS_FT_UINT(ftype))
+        return PTB_KIND_UINT;
+    if (IS_FT_INT(ftype))
+        return PTB_KIND_INT;
+    if (IS_FT_TIME(ftype))
+        return PTB_KIND_TIME;
+
+    /* Strings, and everything without a better representation */
+    return PTB_KIND_STRING;
+}
+
+static proto_tree_bin_kind_e
+ptb_kind_for_field(const header_field_info *hfinfo)
+{
+    /* Text-only items have no value, keep their label instead. */
+    if (hfinfo->id == hf_text_only)
+        return PTB_KIND_STRING;
+    return ptb_kind_for_ftype(hfinfo->type);
+}
+
+static guint32
+ptb_field_id(proto_tree_bin_writer_t *writer, const header_field_info *hfinfo)
+{
+    guint32 id = GPOINTER_TO_UINT(g_hash_table_lookup(writer->field_ids, GINT_TO_POINTER(hfinfo->id)));
+
+    if (id)
+        return id - 1;
+
+    id = writer->n_fields++;
+    g_hash_table_insert(writer->field_ids, GINT_TO_POINTER(hfinfo->id), GUINT_TO_POINTER(id + 1));
+
+    ptb_put_varint(writer->fields, PTB_RECORD_FIELD);
+    ptb_put_varint(writer->fields, id);
+    ptb_put_varint(writer->fields, hfinfo->type);
+    ptb_put_varint(writer->fields, ptb_kind_for_field(hfinfo));
+    ptb_put_string(writer->fields, hfinfo->abbrev);
+    return id;
+}
+
+static void
+ptb_put_value(GByteArray *buf, field_info *fi)
+{
+    header_field_info *hfinfo = fi->hfinfo;
+    fvalue_t *fv = &fi->value;
+    const nstime_t *ts;
+    char *str;
+
+    switch (ptb_kind_for_field(hfinfo)) {
+    case PTB_KIND_NONE:
+        break;
+
+    case PTB_KIND_UINT:
+        if (hfinfo->type == FT_IPv4)
+            ptb_put_varint(buf, g_ntohl(fvalue_get_uinteger(fv)));
+        else if (IS_FT_UINT64(hfinfo->type) || hfinfo->type == FT_EUI64 || hfinfo->type == FT_BOOLEAN)
+            ptb_put_varint(buf, fvalue_get_uinteger64(fv));
+        else
+            ptb_put_varint(buf, fvalue_get_uinteger(fv));
+        break;
+
+    case PTB_KIND_INT:
+        if (IS_FT_INT64(hfinfo->type))
+            ptb_put_zigzag(buf, fvalue_get_sinteger64(fv));
+        else
+            ptb_put_zigzag(buf, fvalue_get_sinteger(fv));
+        break;
+
+    case PTB_KIND_DOUBLE:
+    {
+        union {
+            gdouble d;
+            guint64 u;
+        } bits;
+        guint64 le;
+
+        bits.d = fvalue_get_floating(fv);
+        le = GUINT64_TO_LE(bits.u);
+        g_byte_array_append(buf, (const guint8 *)&le, 8);
+        break;
+    }
+
+    case PTB_KIND_TIME:
+        ts = (const nstime_t *)fvalue_get(fv);
+        ptb_put_zigzag(buf, ts->secs);
+        ptb_put_varint(buf, (guint32)ts->nsecs);
+        break;
+
+    case PTB_KIND_BYTES:
+        if (hfinfo->type == FT_IPv6)
+            ptb_put_data(buf, (const guint8 *)fvalue_get(fv), FT_IPv6_LEN);
+        else
+            ptb_put_data(buf, (const guint8 *)fvalue_get(fv), fvalue_length(fv));
+        break;
+
+    case PTB_KIND_STRING:
+        if (hfinfo->id == hf_text_only) {
+            if (fi->rep) {
+                ptb_put_string(buf, fi->rep->representation);
+            } else {
+                gchar label_str[ITEM_LABEL_LENGTH];
+
+                label_str[0] = '\0';
+                proto_item_fill_label(fi, label_str);
+                ptb_put_string(buf, label_str);
+            }
+        } else if (IS_FT_STRING(hfinfo->type) || hfinfo->type == FT_UINT_STRING) {
+            ptb_put_string(buf, (const char *)fvalue_get(fv));
+        } else {
+            str = fvalue_to_string_repr(NULL, fv, FTREPR_DISPLAY, hfinfo->display);
+            ptb_put_string(buf, str);
+            wmem_free(NULL, str);
+        }
+        break;
+    }
+}
+
+static void
+ptb_put_node(proto_tree_bin_writer_t *writer, proto_node *node)
+{
+    field_info *fi = PNODE_FINFO(node);
+    proto_node *child;
+    guint32 n_children = 0;
+    guint32 id;
+
+    if (!fi)
+        return;
+
+    for (child = node->first_child; child; child = child->next) {
+        if (PNODE_FINFO(child))
+            n_children++;
+    }
+
+    id = ptb_field_id(writer, fi->hfinfo);
+    ptb_put_varint(writer->nodes, id);
+    ptb_put_varint(writer->nodes, n_children);
+    ptb_put_varint(writer->nodes, (guint32)MAX(fi->start, 0));
+    ptb_put_varint(writer->nodes, (guint32)MAX(fi->length, 0));
+    ptb_put_value(writer->nodes, fi);
+    writer->node_count++;
+
+    for (child = node->first_child; child; child = child->next)
+        ptb_put_node(writer, child);
+}
+
+proto_tree_bin_writer_t *
+proto_tree_bin_writer_new(FILE *fh)
+{
+    proto_tree_bin_writer_t *writer = g_new0(proto_tree_bin_writer_t, 1);
+    const guint8 version = PTB_VERSION;
+
+    writer->fh = fh;
+    writer->field_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+    writer->fields = g_byte_array_new();
+    writer->nodes = g_byte_array_new();
+
+    fwrite(PTB_MAGIC, 1, PTB_MAGIC_LEN, fh);
+    fwrite(&version, 1, 1, fh);
+    return writer;
+}
+
+gboolean
+proto_tree_bin_write_packet(proto_tree_bin_writer_t *writer, epan_dissect_t *edt)
+{
+    GByteArray *header;
+    proto_node *node;
+    gboolean ok;
+
+    g_byte_array_set_size(writer->fields, 0);
+    g_byte_array_set_size(writer->nodes, 0);
+    writer->node_count = 0;
+
+    if (edt->tree) {
+        for (node = edt->tree->first_child; node; node = node->next)
+            ptb_put_node(writer, node);
+    }
+
+    header = g_byte_array_sized_new(1 + 2 * PTB_VARINT_MAX);
+    ptb_put_varint(header, PTB_RECORD_PACKET);
+    ptb_put_varint(header, edt->pi.num);
+    ptb_put_varint(header, writer->node_count);
+
+    /* Definitions of fields first seen in this packet go before it. */
+    ok = fwrite(writer->fields->data, 1, writer->fields->len, writer->fh) == writer->fields->len &&
+         fwrite(header->data, 1, header->len, writer->fh) == header->len &&
+         fwrite(writer->nodes->data, 1, writer->nodes->len, writer->fh) == writer->nodes->len;
+
+    g_byte_array_free(header, TRUE);
+    return ok && !ferror(writer->fh);
+}
+
+void
+proto_tree_bin_writer_free(proto_tree_bin_writer_t *writer)
+{
+    if (!writer)
+        return;
+
+    g_hash_table_destroy(writer->field_ids);
+    g_byte_array_free(writer->fields, TRUE);
+    g_byte_array_free(writer->nodes, TRUE);
+    g_free(writer);
+}
+
+/*
+ * Reader
+ */
+
+static gboolean
+ptb_get_varint(proto_tree_bin_reader_t *reader, guint64 *value)
+{
+    guint64 result = 0;
+    guint shift;
+
+    for (shift = 0; shift < 7 * PTB_VARINT_MAX; shift += 7) {
+        guint8 b;
+
+        if (reader->pos >= reader->end)
+            break;
+        b = *reader->pos++;
+        result |= (guint64)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *value = result;
+            return TRUE;
+        }
+    }
+
+    reader->failed = TRUE;
+    return FALSE;
+}
+
+static gboolean
+ptb_get_uint32(proto_tree_bin_reader_t *reader, guint32 *value)
+{
+    guint64 v;
+
+    if (!ptb_get_varint(reader, &v))
+        return FALSE;
+    if (v > G_MAXUINT32) {
+        reader->failed = TRUE;
+        return FALSE;
+    }
+    *value = (guint32)v;
+    return TRUE;
+}
+
+static gboolean
+ptb_get_zigzag(proto_tree_bin_reader_t *reader, gint64 *value)
+{
+    guint64 v;
+
+    if (!ptb_get_varint(reader, &v))
+        return FALSE;
+    *value = (gint64)(v >> 1) ^ -(gint64)(v & 1);
+    return TRUE;
+}
+
+static gboolean
+ptb_get_data(proto_tree_bin_reader_t *reader, const guint8 **data, guint32 *len)
+{
+    if (!ptb_get_uint32(reader, len))
+        return FALSE;
+    if (*len > (gsize)(reader->end - reader->pos)) {
+        reader->failed = TRUE;
+        return FALSE;
+    }
+    *data = reader->pos;
+    reader->pos += *len;
+    return TRUE;
+}
+
+static gboolean
+ptb_read_field(proto_tree_bin_reader_t *reader)
+{
+    proto_tree_bin_field_t field;
+    const guint8 *abbrev;
+    guint32 kind, abbrev_len, first;
+
+    if (!ptb_get_uint32(reader, &field.id) ||
+        !ptb_get_uint32(reader, &field.ftype) ||
+        !ptb_get_uint32(reader, &kind) ||
+        !ptb_get_data(reader, &abbrev, &abbrev_len))
+        return FALSE;
+
+    /* Ids are handed out in order, anything else is not a stream we wrote. */
+    if (field.id != reader->fields->len || kind > PTB_KIND_STRING) {
+        reader->failed = TRUE;
+        return FALSE;
+    }
+    field.kind = (proto_tree_bin_kind_e)kind;
+    field.abbrev = g_strndup((const gchar *)abbrev, abbrev_len);
+
+    /* Fields sharing an abbreviation all refer to the first one. */
+    first = GPOINTER_TO_UINT(g_hash_table_lookup(reader->by_abbrev, field.abbrev));
+    if (first) {
+        field.first_id = first - 1;
+    } else {
+        field.first_id = field.id;
+        g_hash_table_insert(reader->by_abbrev, (gpointer)field.abbrev, GUINT_TO_POINTER(field.id + 1));
+    }
+    g_array_append_val(reader->fields, field);
+    return TRUE;
+}
+
+static gboolean
+ptb_read_value(proto_tree_bin_reader_t *reader, proto_tree_bin_kind_e kind, proto_tree_bin_node_t *node)
+{
+    guint64 u;
+    gint64 i;
+
+    switch (kind) {
+    case PTB_KIND_NONE:
+        return TRUE;
+
+    case PTB_KIND_UINT:
+        return ptb_get_varint(reader, &node->value.uinteger);
+
+    case PTB_KIND_INT:
+        return ptb_get_zigzag(reader, &node->value.sinteger);
+
+    case PTB_KIND_DOUBLE:
+    {
+        union {
+            gdouble d;
+            guint64 u;
+        } bits;
+
+        if (reader->end - reader->pos < 8) {
+            reader->failed = TRUE;
+            return FALSE;
+        }
+        memcpy(&bits.u, reader->pos, 8);
+        bits.u = GUINT64_FROM_LE(bits.u);
+        node->value.floating = bits.d;
+        reader->pos += 8;
+        return TRUE;
+    }
+
+    case PTB_KIND_TIME:
+        if (!ptb_get_zigzag(reader, &i) || !ptb_get_varint(reader, &u))
+            return FALSE;
+        node->value.time.secs = (time_t)i;
+        node->value.time.nsecs = (int)u;
+        return TRUE;
+
+    case PTB_KIND_BYTES:
+    case PTB_KIND_STRING:
+        return ptb_get_data(reader, &node->data, &node->data_len);
+    }
+
+    return FALSE;
+}
+
+proto_tree_bin_reader_t *
+proto_tree_bin_reader_new(const guint8 *data, gsize len)
+{
+    proto_tree_bin_reader_t *reader;
+
+    if (len < PTB_MAGIC_LEN + 1 ||
+        memcmp(data, PTB_MAGIC, PTB_MAGIC_LEN) != 0 ||
+        data[PTB_MAGIC_LEN] != PTB_VERSION)
+        return NULL;
+
+    reader = g_new0(proto_tree_bin_reader_t, 1);
+    reader->data = data;
+    reader->end = data + len;
+    reader->pos = data + PTB_MAGIC_LEN + 1;
+    reader->fields = g_array_new(FALSE, FALSE, sizeof(proto_tree_bin_field_t));
+    reader->by_abbrev = g_hash_table_new(g_str_hash, g_str_equal);
+    reader->nodes = g_array_new(FALSE, TRUE, sizeof(proto_tree_bin_node_t));
+    reader->open = g_array_new(FALSE, FALSE, sizeof(ptb_open_node_t));
+    return reader;
+}
+
+gboolean
+proto_tree_bin_reader_next(proto_tree_bin_reader_t *reader, proto_tree_bin_packet_t *packet)
+{
+    GArray *open = reader->open;
+    guint32 record, n;
+
+    while (!reader->failed && reader->pos < reader->end) {
+        if (!ptb_get_uint32(reader, &record))
+            break;
+
+        if (record == PTB_RECORD_FIELD) {
+            if (!ptb_read_field(reader))
+                break;
+            continue;
+        }
+
+        if (record != PTB_RECORD_PACKET) {
+            reader->failed = TRUE;
+            break;
+        }
+
+        if (!ptb_get_uint32(reader, &packet->frame_num) ||
+            !ptb_get_uint32(reader, &packet->node_count))
+            break;
+
+        /* Every node takes at least four bytes. */
+        if (packet->node_count > (gsize)(reader->end - reader->pos) / 4) {
+            reader->failed = TRUE;
+            break;
+        }
+        g_array_set_size(reader->nodes, packet->node_count);
+        g_array_set_size(open, 0);
+
+        for (n = 0; n < packet->node_count; n++) {
+            proto_tree_bin_node_t *node = &g_array_index(reader->nodes, proto_tree_bin_node_t, n);
+            guint32 n_children;
+
+            memset(node, 0, sizeof(*node));
+            if (!ptb_get_uint32(reader, &node->field) ||
+                !ptb_get_uint32(reader, &n_children) ||
+                !ptb_get_uint32(reader, &node->start) ||
+                !ptb_get_uint32(reader, &node->length))
+                return FALSE;
+
+            if (node->field >= reader->fields->len) {
+                reader->failed = TRUE;
+                return FALSE;
+            }
+            if (!ptb_read_value(reader, g_array_index(reader->fields, proto_tree_bin_field_t, node->field).kind, node))
+                return FALSE;
+
+            while (open->len && g_array_index(open, ptb_open_node_t, open->len - 1).remaining == 0)
+                g_array_set_size(open, open->len - 1);
+            if (open->len) {
+                ptb_open_node_t *parent = &g_array_index(open, ptb_open_node_t, open->len - 1);
+
+                node->parent = parent->node;
+                parent->remaining--;
+            } else {
+                node->parent = PTB_NO_PARENT;
+            }
+
+            if (n_children) {
+                ptb_open_node_t child;
+
+                /* The stack is no deeper than the packet has nodes. */
+                child.node = n;
+                child.remaining = n_children;
+                g_array_append_val(open, child);
+            }
+        }
+
+        packet->nodes = (proto_tree_bin_node_t *)(void *)reader->nodes->data;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+gboolean
+proto_tree_bin_reader_failed(const proto_tree_bin_reader_t *reader)
+{
+    return reader->failed;
+}
+
+const proto_tree_bin_field_t *
+proto_tree_bin_reader_get_field(const proto_tree_bin_reader_t *reader, guint32 id)
+{
+    if (id >= reader->fields->len)
+        return NULL;
+    return &g_array_index(reader->fields, proto_tree_bin_field_t, id);
+}
+
+const proto_tree_bin_field_t *
+proto_tree_bin_reader_find_field(const proto_tree_bin_reader_t *reader, const char *abbrev)
+{
+    guint32 id = GPOINTER_TO_UINT(g_hash_table_lookup(reader->by_abbrev, abbrev));
+
+    if (!id)
+        return NULL;
+    return &g_array_index(reader->fields, proto_tree_bin_field_t, id - 1);
+}
+
+gint
+proto_tree_bin_packet_find(const proto_tree_bin_reader_t *reader, const proto_tree_bin_packet_t *packet, guint32 field, guint32 from)
+{
+    const proto_tree_bin_field_t *fields = (const proto_tree_bin_field_t *)(void *)reader->fields->data;
+    guint32 first, n;
+
+    if (field >= reader->fields->len)
+        return -1;
+    first = fields[field].first_id;
+
+    /* Nodes only refer to fields defined before them, as proto_tree_bin_reader_next() checks. */
+    for (n = from; n < packet->node_count; n++) {
+        if (fields[packet->nodes[n].field].first_id == first)
+            return (gint)n;
+    }
+    return -1;
+}
+
+void
+proto_tree_bin_reader_free(proto_tree_bin_reader_t *reader)
+{
+    guint i;
+
+    if (!reader)
+        return;
+
+    for (i = 0; i < reader->fields->len; i++)
+        g_free((gchar *)g_array_index(reader->fields, proto_tree_bin_field_t, i).abbrev);
+    g_array_free(reader->fields, TRUE);
+    g_hash_table_destroy(reader->by_abbrev);
+    g_array_free(reader->nodes, TRUE);
+    g_array_free(reader->open, TRUE);
+    g_free(reader);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,165 @@
+/* proto_tree_bin.h
+ * Compact binary serialization of dissected protocol trees
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __PROTO_TREE_BIN_H__
+#define __PROTO_TREE_BIN_H__
+
+#include <stdio.h>
+
+#include <epan/epan.h>
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @file
+ * A stream of dissected packets that can be post-processed without running
+ * the dissectors again, and without parsing PDML or JSON.
+ *
+ * The stream starts with the magic "WSPT" and a version byte, followed by
+ * records. All integers are unsigned LEB128 varints, signed integers are
+ * zigzag encoded first, and strings are a varint length followed by UTF-8
+ * bytes. Each record starts with its varint type:
+ *
+ * - PTB_RECORD_FIELD: id, ftenum, value kind, abbreviation.
+ *   Describes a field the first time it is used, before the packet that
+ *   uses it. Ids are small numbers local to the stream.
+ * - PTB_RECORD_PACKET: frame number, node count, then the nodes in
+ *   depth-first order. Each node is the field id, the number of children,
+ *   the offset and length in its data source, and a value of the kind
+ *   given by its field record.
+ *
+ * Value kinds are encoded as:
+ * - PTB_KIND_NONE: nothing
+ * - PTB_KIND_UINT: varint
+ * - PTB_KIND_INT: zigzag varint
+ * - PTB_KIND_DOUBLE: 8 bytes, little-endian IEEE 754
+ * - PTB_KIND_TIME: zigzag varint seconds, varint nanoseconds
+ * - PTB_KIND_BYTES, PTB_KIND_STRING: varint length and data
+ *
+ * IPv4 addresses are unsigned integers in host order. Types without a
+ * natural binary form (GUIDs, for example) are stored as their display
+ * string, as are the labels of text-only items.
+ */
+
+#define PTB_MAGIC           "WSPT"
+#define PTB_MAGIC_LEN       4
+#define PTB_VERSION         1
+
+#define PTB_RECORD_FIELD    1
+#define PTB_RECORD_PACKET   2
+
+typedef enum {
+    PTB_KIND_NONE = 0,
+    PTB_KIND_UINT,
+    PTB_KIND_INT,
+    PTB_KIND_DOUBLE,
+    PTB_KIND_TIME,
+    PTB_KIND_BYTES,
+    PTB_KIND_STRING
+} proto_tree_bin_kind_e;
+
+/* No parent: the node is at the top level of the packet */
+#define PTB_NO_PARENT       G_MAXUINT32
+
+typedef struct _proto_tree_bin_writer proto_tree_bin_writer_t;
+typedef struct _proto_tree_bin_reader proto_tree_bin_reader_t;
+
+typedef struct {
+    guint32                 id;
+    guint32                 ftype;      /**< ftenum_t of the field */
+    proto_tree_bin_kind_e   kind;
+    const gchar            *abbrev;
+    guint32                 first_id;   /**< Id of the first field with the same abbreviation */
+} proto_tree_bin_field_t;
+
+typedef struct {
+    guint32         field;      /**< Field id */
+    guint32         parent;     /**< Node index of the parent, or PTB_NO_PARENT */
+    guint32         start;
+    guint32         length;
+    union {
+        guint64     uinteger;
+        gint64      sinteger;
+        gdouble     floating;
+        nstime_t    time;
+    } value;
+    const guint8   *data;       /**< PTB_KIND_BYTES and PTB_KIND_STRING, not NUL terminated */
+    guint32         data_len;
+} proto_tree_bin_node_t;
+
+typedef struct {
+    guint32                 frame_num;
+    guint32                 node_count;
+    proto_tree_bin_node_t  *nodes;
+} proto_tree_bin_packet_t;
+
+/** Start a stream, writing its header to fh. */
+WS_DLL_PUBLIC proto_tree_bin_writer_t *proto_tree_bin_writer_new(FILE *fh);
+
+/** Append the protocol tree of a dissected packet to the stream. */
+WS_DLL_PUBLIC gboolean proto_tree_bin_write_packet(proto_tree_bin_writer_t *writer, epan_dissect_t *edt);
+
+WS_DLL_PUBLIC void proto_tree_bin_writer_free(proto_tree_bin_writer_t *writer);
+
+/**
+ * Read a stream from memory. The data must stay around as long as the
+ * reader and the nodes returned by it are used. Returns NULL if the data
+ * does not start with a supported header.
+ */
+WS_DLL_PUBLIC proto_tree_bin_reader_t *proto_tree_bin_reader_new(const guint8 *data, gsize len);
+
+/**
+ * Read the next packet. The nodes are valid until the next call. Returns
+ * FALSE at the end of the stream or if it is corrupt, see
+ * proto_tree_bin_reader_failed().
+ */
+WS_DLL_PUBLIC gboolean proto_tree_bin_reader_next(proto_tree_bin_reader_t *reader, proto_tree_bin_packet_t *packet);
+
+/** TRUE if reading stopped because the stream is corrupt or truncated. */
+WS_DLL_PUBLIC gboolean proto_tree_bin_reader_failed(const proto_tree_bin_reader_t *reader);
+
+/** Returns the field with the given id, or NULL if it was not defined (yet). */
+WS_DLL_PUBLIC const proto_tree_bin_field_t *proto_tree_bin_reader_get_field(const proto_tree_bin_reader_t *reader, guint32 id);
+
+/**
+ * Returns the field with the given abbreviation, or NULL if no packet read so
+ * far used it. Several fields can share an abbreviation (e.g. registered by
+ * different dissectors); this is the first one defined.
+ */
+WS_DLL_PUBLIC const proto_tree_bin_field_t *proto_tree_bin_reader_find_field(const proto_tree_bin_reader_t *reader, const char *abbrev);
+
+/**
+ * Returns the index of the first node at or after "from" for the given field
+ * or any other field with the same abbreviation, or -1 if there is none.
+ */
+WS_DLL_PUBLIC gint proto_tree_bin_packet_find(const proto_tree_bin_reader_t *reader, const proto_tree_bin_packet_t *packet, guint32 field, guint32 from);
+
+WS_DLL_PUBLIC void proto_tree_bin_reader_free(proto_tree_bin_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __PROTO_TREE_BIN_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,388 @@
+/* proto_tree_bin_test.c
+ * Binary protocol tree reader tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+
+#include <epan/ftypes/ftypes.h>
+#include <epan/proto_tree_bin.h>
+
+/*
+ * The streams are put together by hand from the description in
+ * proto_tree_bin.h, so that corrupt ones can be made as well.
+ */
+
+static void
+put_varint(GByteArray *buf, guint64 value)
+{
+    guint8 b;
+
+    while (value >= 0x80) {
+        b = (guint8)(value | 0x80);
+        g_byte_array_append(buf, &b, 1);
+        value >>= 7;
+    }
+    b = (guint8)value;
+    g_byte_array_append(buf, &b, 1);
+}
+
+static void
+put_string(GByteArray *buf, const char *str)
+{
+    put_varint(buf, strlen(str));
+    g_byte_array_append(buf, (const guint8 *)str, (guint)strlen(str));
+}
+
+static GByteArray *
+stream_new(void)
+{
+    GByteArray *buf = g_byte_array_new();
+    const guint8 version = PTB_VERSION;
+
+    g_byte_array_append(buf, (const guint8 *)PTB_MAGIC, PTB_MAGIC_LEN);
+    g_byte_array_append(buf, &version, 1);
+    return buf;
+}
+
+static void
+put_field(GByteArray *buf, guint32 id, ftenum_t ftype, proto_tree_bin_kind_e kind, const char *abbrev)
+{
+    put_varint(buf, PTB_RECORD_FIELD);
+    put_varint(buf, id);
+    put_varint(buf, ftype);
+    put_varint(buf, kind);
+    put_string(buf, abbrev);
+}
+
+static void
+put_packet(GByteArray *buf, guint32 frame_num, guint32 node_count)
+{
+    put_varint(buf, PTB_RECORD_PACKET);
+    put_varint(buf, frame_num);
+    put_varint(buf, node_count);
+}
+
+static void
+put_node(GByteArray *buf, guint32 field, guint32 n_children, guint32 start, guint32 length)
+{
+    put_varint(buf, field);
+    put_varint(buf, n_children);
+    put_varint(buf, start);
+    put_varint(buf, length);
+}
+
+static void
+ptb_test_header(void)
+{
+    static const guint8 bad_magic[] = { 'W', 'S', 'P', 'X', PTB_VERSION };
+    static const guint8 bad_version[] = { 'W', 'S', 'P', 'T', PTB_VERSION + 1 };
+    GByteArray *buf = stream_new();
+    proto_tree_bin_reader_t *reader;
+    proto_tree_bin_packet_t packet;
+
+    g_assert(proto_tree_bin_reader_new(bad_magic, sizeof bad_magic) == NULL);
+    g_assert(proto_tree_bin_reader_new(bad_version, sizeof bad_version) == NULL);
+    g_assert(proto_tree_bin_reader_new(buf->data, buf->len - 1) == NULL);
+
+    /* A stream without packets is fine. */
+    reader = proto_tree_bin_reader_new(buf->data, buf->len);
+    g_assert(reader != NULL);
+    g_assert(!proto_tree_bin_reader_next(reader, &packet));
+    g_assert(!proto_tree_bin_reader_failed(reader));
+    proto_tree_bin_reader_free(reader);
+
+    g_byte_array_free(buf, TRUE);
+}
+
+static void
+ptb_test_packets(void)
+{
+    static const guint8 ipv6[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+    GByteArray *buf = stream_new();
+    proto_tree_bin_reader_t *reader;
+    proto_tree_bin_packet_t packet;
+    const proto_tree_bin_field_t *field;
+    guint64 le;
+    union {
+        gdouble d;
+        guint64 u;
+    } bits;
+
+    /*
+     * ip
+     *   ip.src
+     *   ipv6.dst
+     * udp
+     *   test.int
+     */
+    put_field(buf, 0, FT_PROTOCOL, PTB_KIND_NONE, "ip");
+    put_field(buf, 1, FT_IPv4, PTB_KIND_UINT, "ip.src");
+    put_field(buf, 2, FT_IPv6, PTB_KIND_BYTES, "ipv6.dst");
+    put_field(buf, 3, FT_PROTOCOL, PTB_KIND_NONE, "udp");
+    put_field(buf, 4, FT_INT32, PTB_KIND_INT, "test.int");
+    put_packet(buf, 1, 5);
+    put_node(buf, 0, 2, 14, 20);
+    put_node(buf, 1, 0, 26, 4);
+    put_varint(buf, 0xc0a80001);
+    put_node(buf, 2, 0, 30, 16);
+    put_varint(buf, sizeof ipv6);
+    g_byte_array_append(buf, ipv6, sizeof ipv6);
+    put_node(buf, 3, 1, 34, 8);
+    put_node(buf, 4, 0, 34, 2);
+    put_varint(buf, 2 * 1000 - 1);                 /* -1000, zigzag */
+
+    /* Fields first used by the second packet are defined just before it. */
+    put_field(buf, 5, FT_DOUBLE, PTB_KIND_DOUBLE, "test.double");
+    put_field(buf, 6, FT_ABSOLUTE_TIME, PTB_KIND_TIME, "frame.time");
+    put_field(buf, 7, FT_STRING, PTB_KIND_STRING, "test.string");
+    put_packet(buf, 2, 4);
+    put_node(buf, 6, 0, 0, 0);
+    put_varint(buf, 2 * 1600000000);
+    put_varint(buf, 999999999);
+    put_node(buf, 3, 2, 0, 8);
+    put_node(buf, 5, 0, 0, 8);
+    bits.d = -0.5;
+    le = GUINT64_TO_LE(bits.u);
+    g_byte_array_append(buf, (const guint8 *)&le, 8);
+    put_node(buf, 7, 0, 8, 5);
+    put_string(buf, "hello");
+
+    reader = proto_tree_bin_reader_new(buf->data, buf->len);
+    g_assert(reader != NULL);
+
+    g_assert(proto_tree_bin_reader_next(reader, &packet));
+    g_assert_cmpuint(packet.frame_num, ==, 1);
+    g_assert_cmpuint(packet.node_count, ==, 5);
+    g_assert_cmpuint(packet.nodes[0].parent, ==, PTB_NO_PARENT);
+    g_assert_cmpuint(packet.nodes[0].start, ==, 14);
+    g_assert_cmpuint(packet.nodes[0].length, ==, 20);
+    g_assert_cmpuint(packet.nodes[1].parent, ==, 0);
+    g_assert_cmpuint(packet.nodes[1].value.uinteger, ==, 0xc0a80001);
+    g_assert_cmpuint(packet.nodes[2].parent, ==, 0);
+    g_assert_cmpuint(packet.nodes[2].data_len, ==, sizeof ipv6);
+    g_assert(memcmp(packet.nodes[2].data, ipv6, sizeof ipv6) == 0);
+    g_assert_cmpuint(packet.nodes[3].parent, ==, PTB_NO_PARENT);
+    g_assert_cmpuint(packet.nodes[4].parent, ==, 3);
+    g_assert_cmpint(packet.nodes[4].value.sinteger, ==, -1000);
+
+    /* Only the fields defined so far are known. */
+    field = proto_tree_bin_reader_find_field(reader, "ip.src");
+    g_assert(field != NULL);
+    g_assert_cmpuint(field->id, ==, 1);
+    g_assert_cmpuint(field->ftype, ==, FT_IPv4);
+    g_assert_cmpint(field->kind, ==, PTB_KIND_UINT);
+    g_assert(proto_tree_bin_reader_get_field(reader, 4) != NULL);
+    g_assert(proto_tree_bin_reader_get_field(reader, 5) == NULL);
+    g_assert(proto_tree_bin_reader_find_field(reader, "test.string") == NULL);
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, 3, 0), ==, 3);
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, 3, 4), ==, -1);
+
+    g_assert(proto_tree_bin_reader_next(reader, &packet));
+    g_assert_cmpuint(packet.frame_num, ==, 2);
+    g_assert_cmpuint(packet.node_count, ==, 4);
+    g_assert_cmpuint(packet.nodes[0].parent, ==, PTB_NO_PARENT);
+    g_assert_cmpint(packet.nodes[0].value.time.secs, ==, 1600000000);
+    g_assert_cmpint(packet.nodes[0].value.time.nsecs, ==, 999999999);
+    g_assert_cmpuint(packet.nodes[2].parent, ==, 1);
+    g_assert(packet.nodes[2].value.floating == -0.5);
+    g_assert_cmpuint(packet.nodes[3].parent, ==, 1);
+    g_assert_cmpuint(packet.nodes[3].data_len, ==, 5);
+    g_assert(memcmp(packet.nodes[3].data, "hello", 5) == 0);
+    field = proto_tree_bin_reader_find_field(reader, "test.string");
+    g_assert(field != NULL);
+    g_assert_cmpint(field->kind, ==, PTB_KIND_STRING);
+
+    g_assert(!proto_tree_bin_reader_next(reader, &packet));
+    g_assert(!proto_tree_bin_reader_failed(reader));
+    proto_tree_bin_reader_free(reader);
+
+    g_byte_array_free(buf, TRUE);
+}
+
+/* Different dissectors can register fields with the same abbreviation. */
+static void
+ptb_test_same_abbrev(void)
+{
+    GByteArray *buf = stream_new();
+    proto_tree_bin_reader_t *reader;
+    proto_tree_bin_packet_t packet;
+    const proto_tree_bin_field_t *field;
+
+    put_field(buf, 0, FT_UINT16, PTB_KIND_UINT, "test.port");
+    put_field(buf, 1, FT_PROTOCOL, PTB_KIND_NONE, "test");
+    put_field(buf, 2, FT_UINT32, PTB_KIND_UINT, "test.port");
+    put_packet(buf, 1, 3);
+    put_node(buf, 2, 0, 0, 4);
+    put_varint(buf, 70000);
+    put_node(buf, 1, 0, 4, 0);
+    put_node(buf, 0, 0, 4, 2);
+    put_varint(buf, 80);
+
+    reader = proto_tree_bin_reader_new(buf->data, buf->len);
+    g_assert(proto_tree_bin_reader_next(reader, &packet));
+
+    field = proto_tree_bin_reader_find_field(reader, "test.port");
+    g_assert(field != NULL);
+    g_assert_cmpuint(field->id, ==, 0);
+    g_assert_cmpuint(proto_tree_bin_reader_get_field(reader, 2)->first_id, ==, 0);
+
+    /* Either id finds the nodes of both. */
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, field->id, 0), ==, 0);
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, field->id, 1), ==, 2);
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, 2, 1), ==, 2);
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, 1, 0), ==, 1);
+    g_assert_cmpint(proto_tree_bin_packet_find(reader, &packet, 3, 0), ==, -1);
+
+    g_assert(!proto_tree_bin_reader_next(reader, &packet));
+    g_assert(!proto_tree_bin_reader_failed(reader));
+    proto_tree_bin_reader_free(reader);
+
+    g_byte_array_free(buf, TRUE);
+}
+
+/* Deeper than any fixed stack: every node is the only child of the previous one. */
+static void
+ptb_test_deep(void)
+{
+    const guint32 depth = 100000;
+    GByteArray *buf = stream_new();
+    proto_tree_bin_reader_t *reader;
+    proto_tree_bin_packet_t packet;
+    guint32 n;
+
+    put_field(buf, 0, FT_NONE, PTB_KIND_NONE, "test.none");
+    put_packet(buf, 1, depth + 1);
+    for (n = 0; n < depth; n++)
+        put_node(buf, 0, 1, n, 1);
+    put_node(buf, 0, 0, n, 1);
+    /* Nesting starts over for the next packet. */
+    put_packet(buf, 2, 2);
+    put_node(buf, 0, 0, 0, 1);
+    put_node(buf, 0, 0, 1, 1);
+
+    reader = proto_tree_bin_reader_new(buf->data, buf->len);
+    g_assert(proto_tree_bin_reader_next(reader, &packet));
+    g_assert_cmpuint(packet.node_count, ==, depth + 1);
+    g_assert_cmpuint(packet.nodes[0].parent, ==, PTB_NO_PARENT);
+    for (n = 1; n <= depth; n++)
+        g_assert_cmpuint(packet.nodes[n].parent, ==, n - 1);
+
+    g_assert(proto_tree_bin_reader_next(reader, &packet));
+    g_assert_cmpuint(packet.nodes[0].parent, ==, PTB_NO_PARENT);
+    g_assert_cmpuint(packet.nodes[1].parent, ==, PTB_NO_PARENT);
+    g_assert(!proto_tree_bin_reader_failed(reader));
+    proto_tree_bin_reader_free(reader);
+
+    g_byte_array_free(buf, TRUE);
+}
+
+static void
+check_corrupt(GByteArray *buf)
+{
+    proto_tree_bin_reader_t *reader = proto_tree_bin_reader_new(buf->data, buf->len);
+    proto_tree_bin_packet_t packet;
+
+    g_assert(reader != NULL);
+    while (proto_tree_bin_reader_next(reader, &packet))
+        ;
+    g_assert(proto_tree_bin_reader_failed(reader));
+    proto_tree_bin_reader_free(reader);
+    g_byte_array_free(buf, TRUE);
+}
+
+static void
+ptb_test_corrupt(void)
+{
+    GByteArray *buf;
+
+    /* Unknown record type */
+    buf = stream_new();
+    put_varint(buf, 3);
+    check_corrupt(buf);
+
+    /* Field ids out of order */
+    buf = stream_new();
+    put_field(buf, 1, FT_NONE, PTB_KIND_NONE, "test.none");
+    check_corrupt(buf);
+
+    /* Unknown value kind */
+    buf = stream_new();
+    put_field(buf, 0, FT_NONE, (proto_tree_bin_kind_e)(PTB_KIND_STRING + 1), "test.none");
+    check_corrupt(buf);
+
+    /* Node of an undefined field */
+    buf = stream_new();
+    put_field(buf, 0, FT_NONE, PTB_KIND_NONE, "test.none");
+    put_packet(buf, 1, 1);
+    put_node(buf, 1, 0, 0, 0);
+    check_corrupt(buf);
+
+    /* More nodes than there is data for */
+    buf = stream_new();
+    put_field(buf, 0, FT_NONE, PTB_KIND_NONE, "test.none");
+    put_packet(buf, 1, 1000);
+    put_node(buf, 0, 0, 0, 0);
+    check_corrupt(buf);
+
+    /* Varint that doesn't fit in 32 bits */
+    buf = stream_new();
+    put_packet(buf, 1, 0);
+    g_byte_array_set_size(buf, buf->len - 2);
+    put_varint(buf, G_GUINT64_CONSTANT(1) << 32);
+    put_varint(buf, 0);
+    check_corrupt(buf);
+
+    /* String running past the end */
+    buf = stream_new();
+    put_field(buf, 0, FT_STRING, PTB_KIND_STRING, "test.string");
+    put_packet(buf, 1, 1);
+    put_node(buf, 0, 0, 0, 0);
+    put_varint(buf, 100);
+    g_byte_array_append(buf, (const guint8 *)"abcd", 4);
+    check_corrupt(buf);
+
+    /* Truncated in the middle of a varint */
+    buf = stream_new();
+    put_field(buf, 0, FT_UINT32, PTB_KIND_UINT, "test.uint");
+    put_packet(buf, 1, 1);
+    put_node(buf, 0, 0, 0, 0);
+    put_varint(buf, G_MAXUINT32);
+    g_byte_array_set_size(buf, buf->len - 1);
+    check_corrupt(buf);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/proto_tree_bin/header", ptb_test_header);
+    g_test_add_func("/proto_tree_bin/packets", ptb_test_packets);
+    g_test_add_func("/proto_tree_bin/same_abbrev", ptb_test_same_abbrev);
+    g_test_add_func("/proto_tree_bin/deep", ptb_test_deep);
+    g_test_add_func("/proto_tree_bin/corrupt", ptb_test_corrupt);
+
+    return g_test_run();
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
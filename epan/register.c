@@ -11,6 +11,8 @@
 #include "register-int.h"
 #include "ws_attributes.h"
 
+#include <stdlib.h>
+
 #include <glib.h>
 #include "epan/dissectors/dissectors.h"
 
@@ -22,19 +24,41 @@ static GAsyncQueue *register_cb_done_q;
 
 #define CB_WAIT_TIME (150 * 1000) // microseconds
 
+// Startup profiling. Microseconds spent in each routine, indexed the
+// same as dissector_reg_proto and dissector_reg_handoff.
+static gboolean profile_registration;
+static gint64 *proto_reg_usecs;
+static gint64 *handoff_reg_usecs;
+
 static void set_cb_name(const char *proto) {
     g_mutex_lock(&cur_cb_name_mtx);
     cur_cb_name = proto;
     g_mutex_unlock(&cur_cb_name_mtx);
 }
 
+static void
+call_routines(const dissector_reg_t *routines, gulong count, gint64 *usecs)
+{
+    for (gulong i = 0; i < count; i++) {
+        set_cb_name(routines[i].cb_name);
+        if (usecs) {
+            gint64 start = g_get_monotonic_time();
+            routines[i].cb_func();
+            usecs[i] = g_get_monotonic_time() - start;
+        } else {
+            routines[i].cb_func();
+        }
+    }
+}
+
 static void *
 register_all_protocols_worker(void *arg _U_)
 {
-    for (gulong i = 0; i < dissector_reg_proto_count; i++) {
-        set_cb_name(dissector_reg_proto[i].cb_name);
-        dissector_reg_proto[i].cb_func();
+    if (profile_registration) {
+        g_free(proto_reg_usecs);
+        proto_reg_usecs = g_new0(gint64, dissector_reg_proto_count);
     }
+    call_routines(dissector_reg_proto, dissector_reg_proto_count, proto_reg_usecs);
 
     g_async_queue_push(register_cb_done_q, GINT_TO_POINTER(TRUE));
     return NULL;
@@ -67,10 +91,11 @@ register_all_protocols(register_cb cb, gpointer cb_data)
 static void *
 register_all_protocol_handoffs_worker(void *arg _U_)
 {
-    for (gulong i = 0; i < dissector_reg_handoff_count; i++) {
-        set_cb_name(dissector_reg_handoff[i].cb_name);
-        dissector_reg_handoff[i].cb_func();
+    if (profile_registration) {
+        g_free(handoff_reg_usecs);
+        handoff_reg_usecs = g_new0(gint64, dissector_reg_handoff_count);
     }
+    call_routines(dissector_reg_handoff, dissector_reg_handoff_count, handoff_reg_usecs);
 
     g_async_queue_push(register_cb_done_q, GINT_TO_POINTER(TRUE));
     return NULL;
@@ -106,6 +131,67 @@ gulong register_count(void)
     return dissector_reg_proto_count + dissector_reg_handoff_count;
 }
 
+void register_set_profiling(gboolean enable)
+{
+    profile_registration = enable;
+}
+
+typedef struct {
+    const char *name;
+    gint64 usecs;
+} routine_time_t;
+
+static int
+routine_time_cmp(const void *a, const void *b)
+{
+    const routine_time_t *ra = (const routine_time_t *)a;
+    const routine_time_t *rb = (const routine_time_t *)b;
+
+    if (ra->usecs != rb->usecs) {
+        return ra->usecs > rb->usecs ? -1 : 1;
+    }
+    return g_strcmp0(ra->name, rb->name);
+}
+
+static gint64
+add_routine_times(routine_time_t *times, gulong *n_times, const dissector_reg_t *routines, gulong count, const gint64 *usecs)
+{
+    gint64 total = 0;
+
+    for (gulong i = 0; usecs && i < count; i++) {
+        times[*n_times].name = routines[i].cb_name;
+        times[*n_times].usecs = usecs[i];
+        (*n_times)++;
+        total += usecs[i];
+    }
+    return total;
+}
+
+void register_write_profile(FILE *fp, guint max_routines)
+{
+    routine_time_t *times;
+    gulong n_times = 0;
+    gint64 proto_total, handoff_total;
+
+    if (!proto_reg_usecs && !handoff_reg_usecs) {
+        return;
+    }
+
+    times = g_new(routine_time_t, dissector_reg_proto_count + dissector_reg_handoff_count);
+    proto_total = add_routine_times(times, &n_times, dissector_reg_proto, dissector_reg_proto_count, proto_reg_usecs);
+    handoff_total = add_routine_times(times, &n_times, dissector_reg_handoff, dissector_reg_handoff_count, handoff_reg_usecs);
+    qsort(times, n_times, sizeof(routine_time_t), routine_time_cmp);
+
+    fprintf(fp, "%10.3f ms  protocol registration (%lu routines)\n",
+            proto_total / 1000.0, dissector_reg_proto_count);
+    fprintf(fp, "%10.3f ms  handoff registration (%lu routines)\n",
+            handoff_total / 1000.0, dissector_reg_handoff_count);
+    for (gulong i = 0; i < n_times && i < max_routines; i++) {
+        fprintf(fp, "%10.3f ms    %s\n", times[i].usecs / 1000.0, times[i].name);
+    }
+    g_free(times);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
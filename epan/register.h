@@ -11,8 +11,16 @@
 #ifndef __REGISTER_H__
 #define __REGISTER_H__
 
+#include <stdio.h>
+
 #include <glib.h>
 
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 typedef enum {
     RA_NONE,              /* For initialization */
     RA_DISSECTORS,        /* Initializing dissectors */
@@ -32,6 +40,25 @@ typedef enum {
 
 typedef void (*register_cb)(register_action_e action, const char *message, gpointer client_data);
 
+/** Time each built-in protocol registration and handoff routine.
+ * Must be called before epan_init().
+ *
+ * @param enable TRUE to record timings.
+ */
+WS_DLL_PUBLIC void register_set_profiling(gboolean enable);
+
+/** Write the time spent registering protocols and handoffs, followed by
+ * the slowest routines, to a file.
+ *
+ * @param fp File to write to.
+ * @param max_routines Maximum number of routines to list.
+ */
+WS_DLL_PUBLIC void register_write_profile(FILE *fp, guint max_routines);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
 #endif /* __REGISTER_H__ */
 
 /*
@@ -103,6 +103,67 @@ void reset_rtd_table(rtd_stat_table* table)
         memset(table->time_stats[i].rtd, 0, sizeof(timestat_t)*table->time_stats[i].num_timestat);
 }
 
+void rtd_table_serialize(void *tapdata, GByteArray *state)
+{
+    rtd_stat_table *table = &((rtd_data_t *)tapdata)->stat_table;
+    rtd_timestat *ts;
+    guint i;
+
+    tap_merge_put_uint(state, table->num_rtds);
+    for (i = 0; i < table->num_rtds; i++)
+    {
+        ts = &table->time_stats[i];
+        tap_merge_put_uint(state, ts->num_timestat);
+        tap_merge_put_bytes(state, ts->rtd, sizeof(timestat_t)*ts->num_timestat);
+        tap_merge_put_uint(state, ts->open_req_num);
+        tap_merge_put_uint(state, ts->disc_rsp_num);
+        tap_merge_put_uint(state, ts->req_dup_num);
+        tap_merge_put_uint(state, ts->rsp_dup_num);
+    }
+}
+
+gboolean rtd_table_merge(void *tapdata, tap_merge_state_t *state)
+{
+    rtd_stat_table *table = &((rtd_data_t *)tapdata)->stat_table;
+    rtd_timestat *ts;
+    timestat_t stats;
+    guint32 num, value;
+    guint i, j;
+
+    if (!tap_merge_get_uint(state, &num) || num != table->num_rtds)
+        return FALSE;
+
+    for (i = 0; i < table->num_rtds; i++)
+    {
+        ts = &table->time_stats[i];
+        if (!tap_merge_get_uint(state, &num) || num != ts->num_timestat)
+            return FALSE;
+        for (j = 0; j < ts->num_timestat; j++)
+        {
+            if (!tap_merge_get_bytes(state, &stats, sizeof(stats)))
+                return FALSE;
+            time_stat_merge(&ts->rtd[j], &stats);
+        }
+
+        /* A response to a request still open here took one away from
+           the other's count, so the sum is still right. */
+        if (!tap_merge_get_uint(state, &value))
+            return FALSE;
+        ts->open_req_num += value;
+        if (!tap_merge_get_uint(state, &value))
+            return FALSE;
+        ts->disc_rsp_num += value;
+        if (!tap_merge_get_uint(state, &value))
+            return FALSE;
+        ts->req_dup_num += value;
+        if (!tap_merge_get_uint(state, &value))
+            return FALSE;
+        ts->rsp_dup_num += value;
+    }
+
+    return TRUE;
+}
+
 register_rtd_t* get_rtd_table_by_name(const char* name)
 {
     return (register_rtd_t*)wmem_tree_lookup_string(registered_rtd_tables, name, 0);
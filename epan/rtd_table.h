@@ -118,6 +118,21 @@ WS_DLL_PUBLIC void free_rtd_table(rtd_stat_table* table);
  */
 WS_DLL_PUBLIC void reset_rtd_table(rtd_stat_table* table);
 
+/** Append the table data in the RTD, for set_tap_listener_merge().
+ *
+ * @param tapdata rtd_data_t holding the RTD table
+ * @param state serialized state
+ */
+WS_DLL_PUBLIC void rtd_table_serialize(void *tapdata, GByteArray *state);
+
+/** Add table data appended by rtd_table_serialize() to the RTD.
+ *
+ * @param tapdata rtd_data_t holding the RTD table
+ * @param state serialized state
+ * @return FALSE if the state doesn't match the table
+ */
+WS_DLL_PUBLIC gboolean rtd_table_merge(void *tapdata, tap_merge_state_t *state);
+
 /** Interator to walk RTD tables and execute func
  * Used for initialization
  *
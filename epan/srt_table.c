@@ -118,6 +118,63 @@ void reset_srt_table(GArray* srt_array)
     }
 }
 
+void srt_table_serialize(void *tapdata, GByteArray *state)
+{
+    srt_data_t *data = (srt_data_t *)tapdata;
+    guint i;
+    int j;
+    srt_stat_table *srt_table;
+
+    tap_merge_put_uint(state, data->srt_array->len);
+    for (i = 0; i < data->srt_array->len; i++)
+    {
+        srt_table = g_array_index(data->srt_array, srt_stat_table*, i);
+
+        tap_merge_put_uint(state, srt_table->num_procs);
+        for (j = 0; j < srt_table->num_procs; j++)
+        {
+            tap_merge_put_string(state, srt_table->procedures[j].procedure);
+            tap_merge_put_bytes(state, &srt_table->procedures[j].stats, sizeof(timestat_t));
+        }
+    }
+}
+
+gboolean srt_table_merge(void *tapdata, tap_merge_state_t *state)
+{
+    srt_data_t *data = (srt_data_t *)tapdata;
+    guint32 num_tables, num_procs;
+    guint i;
+    int j;
+    srt_stat_table *srt_table;
+    const char *procedure;
+    timestat_t stats;
+
+    if (!tap_merge_get_uint(state, &num_tables) || num_tables != data->srt_array->len)
+        return FALSE;
+
+    for (i = 0; i < num_tables; i++)
+    {
+        srt_table = g_array_index(data->srt_array, srt_stat_table*, i);
+
+        if (!tap_merge_get_uint(state, &num_procs) || num_procs > G_MAXINT)
+            return FALSE;
+        for (j = 0; j < (int)num_procs; j++)
+        {
+            if (!tap_merge_get_string(state, &procedure) ||
+                !tap_merge_get_bytes(state, &stats, sizeof(stats)))
+                return FALSE;
+
+            /* Procedures discovered by the other table */
+            if (j >= srt_table->num_procs || (srt_table->procedures[j].procedure == NULL && procedure != NULL))
+                init_srt_table_row(srt_table, j, procedure);
+
+            time_stat_merge(&srt_table->procedures[j].stats, &stats);
+        }
+    }
+
+    return TRUE;
+}
+
 static wmem_tree_t *registered_srt_tables = NULL;
 
 register_srt_t* get_srt_table_by_name(const char* name)
@@ -135,6 +135,21 @@ WS_DLL_PUBLIC void free_srt_table(register_srt_t *srt, GArray* srt_array);
  */
 WS_DLL_PUBLIC void reset_srt_table(GArray* srt_array);
 
+/** Append the state of ALL tables in the srt, for set_tap_listener_merge().
+ *
+ * @param tapdata srt_data_t holding the SRT table array
+ * @param state serialized state
+ */
+WS_DLL_PUBLIC void srt_table_serialize(void *tapdata, GByteArray *state);
+
+/** Add state appended by srt_table_serialize() to ALL tables in the srt.
+ *
+ * @param tapdata srt_data_t holding the SRT table array
+ * @param state serialized state
+ * @return FALSE if the state doesn't match the tables
+ */
+WS_DLL_PUBLIC gboolean srt_table_merge(void *tapdata, tap_merge_state_t *state);
+
 /** Interator to walk srt tables and execute func
  * Used for initialization
  *
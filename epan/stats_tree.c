@@ -106,6 +106,7 @@ free_stat_node(stat_node *node)
     }
 
     if (node->hash) g_hash_table_destroy(node->hash);
+    if (node->key_hash) g_hash_table_destroy(node->key_hash);
 
     while (node->bh) {
         bucket = node->bh;
@@ -131,6 +132,7 @@ stats_tree_free(stats_tree *st)
     g_hash_table_destroy(st->names);
     g_ptr_array_free(st->parents,TRUE);
     g_free(st->display_name);
+    if (st->root.key_hash) g_hash_table_destroy(st->root.key_hash);
 
     for (child = st->root.children; child; child = next ) {
         /* child->next will be gone after free_stat_node, so cache it here */
@@ -148,6 +150,24 @@ stats_tree_free(stats_tree *st)
 }
 
 
+/* Sets flags of a node, noting it for merge_stat_node() */
+static void
+set_stat_node_flags(stat_node *node, gint flags)
+{
+    node->st_flags |= flags;
+    node->st_flags_set |= flags;
+    node->st_flags_cleared &= ~flags;
+}
+
+/* Clears flags of a node, noting it for merge_stat_node() */
+static void
+clear_stat_node_flags(stat_node *node, gint flags)
+{
+    node->st_flags &= ~flags;
+    node->st_flags_cleared |= flags;
+    node->st_flags_set &= ~flags;
+}
+
 /* reset a node to its original state */
 static void
 reset_stat_node(stat_node *node)
@@ -170,6 +190,9 @@ reset_stat_node(stat_node *node)
         break;
     }
     node->st_flags = 0;
+    node->st_flags_set = 0;
+    node->st_flags_cleared = 0;
+    node->counter_set = FALSE;
 
     while (node->bh) {
         bucket = node->bh;
@@ -230,6 +253,9 @@ stats_tree_reinit(void *p)
         break;
     }
     st->root.st_flags = 0;
+    st->root.st_flags_set = 0;
+    st->root.st_flags_cleared = 0;
+    st->root.counter_set = FALSE;
 
     st->root.bh = (burst_bucket*)g_malloc0(sizeof(burst_bucket));
     st->root.bt = st->root.bh;
@@ -239,6 +265,7 @@ stats_tree_reinit(void *p)
 
     /* No more stat_nodes left in tree - clean out hash, array */
     g_hash_table_remove_all(st->names);
+    if (st->root.key_hash) g_hash_table_remove_all(st->root.key_hash);
     if (st->parents->len>1) {
         g_ptr_array_remove_range(st->parents, 1, st->parents->len-1);
     }
@@ -553,6 +580,166 @@ stats_tree_create_node_by_pname(stats_tree *st, const gchar *name,
     return stats_tree_create_node(st,name,stats_tree_parent_id_by_name(st,parent_name),datatype,with_children);
 }
 
+/* Appends a node's values, as merged by merge_stat_node() */
+static void
+serialize_stat_node(const stat_node *node, GByteArray *state)
+{
+    const stat_node *child;
+    guint32 num_children = 0;
+
+    tap_merge_put_uint(state, (guint32)node->counter);
+    tap_merge_put_uint(state, node->counter_set);
+    tap_merge_put_bytes(state, &node->total, sizeof(node->total));
+    tap_merge_put_bytes(state, &node->minvalue, sizeof(node->minvalue));
+    tap_merge_put_bytes(state, &node->maxvalue, sizeof(node->maxvalue));
+    tap_merge_put_uint(state, (guint32)node->st_flags_set);
+    tap_merge_put_uint(state, (guint32)node->st_flags_cleared);
+
+    for (child = node->children; child; child = child->next)
+        num_children++;
+    tap_merge_put_uint(state, num_children);
+
+    for (child = node->children; child; child = child->next) {
+        tap_merge_put_string(state, child->name);
+        tap_merge_put_uint(state, child->datatype);
+        tap_merge_put_uint(state, child->hash != NULL);
+        tap_merge_put_uint(state, child->id >= 0);
+        tap_merge_put_uint(state, child->rng != NULL);
+        if (child->rng) {
+            tap_merge_put_uint(state, (guint32)child->rng->floor);
+            tap_merge_put_uint(state, (guint32)child->rng->ceil);
+        }
+        serialize_stat_node(child, state);
+    }
+}
+
+extern void
+stats_tree_serialize(void *p, GByteArray *state)
+{
+    stats_tree *st = (stats_tree *)p;
+
+    tap_merge_put_bytes(state, &st->start, sizeof(st->start));
+    tap_merge_put_bytes(state, &st->now, sizeof(st->now));
+    serialize_stat_node(&st->root, state);
+}
+
+/*
+ * Adds the values serialize_stat_node() appended for a node to the node,
+ * and merges its children. Children we don't have are created after
+ * ours, in the order the other tree created them.
+ */
+static gboolean
+merge_stat_node(stat_node *node, tap_merge_state_t *state)
+{
+    stats_tree *st = node->st;
+    stat_node *child;
+    guint32 datatype, counter, counter_set, flags_set, flags_cleared, num_children;
+    guint32 with_hash, as_parent, with_rng, floor, ceil;
+    const gchar *name;
+    stat_node other;
+    guint32 i;
+
+    if (!tap_merge_get_uint(state, &counter) ||
+        !tap_merge_get_uint(state, &counter_set) ||
+        !tap_merge_get_bytes(state, &other.total, sizeof(other.total)) ||
+        !tap_merge_get_bytes(state, &other.minvalue, sizeof(other.minvalue)) ||
+        !tap_merge_get_bytes(state, &other.maxvalue, sizeof(other.maxvalue)) ||
+        !tap_merge_get_uint(state, &flags_set) ||
+        !tap_merge_get_uint(state, &flags_cleared) ||
+        !tap_merge_get_uint(state, &num_children))
+        return FALSE;
+
+    /* A counter the other tree set holds what it was set to plus what came after */
+    if (counter_set) {
+        node->counter = (gint)counter;
+        node->counter_set = TRUE;
+    } else {
+        node->counter += (gint)counter;
+    }
+    switch (node->datatype)
+    {
+    case STAT_DT_INT:
+        node->total.int_total += other.total.int_total;
+        if (node->minvalue.int_min > other.minvalue.int_min)
+            node->minvalue.int_min = other.minvalue.int_min;
+        if (node->maxvalue.int_max < other.maxvalue.int_max)
+            node->maxvalue.int_max = other.maxvalue.int_max;
+        break;
+    case STAT_DT_FLOAT:
+        node->total.float_total += other.total.float_total;
+        if (node->minvalue.float_min > other.minvalue.float_min)
+            node->minvalue.float_min = other.minvalue.float_min;
+        if (node->maxvalue.float_max < other.maxvalue.float_max)
+            node->maxvalue.float_max = other.maxvalue.float_max;
+        break;
+    }
+    clear_stat_node_flags(node, (gint)flags_cleared);
+    set_stat_node_flags(node, (gint)flags_set);
+
+    for (i = 0; i < num_children; i++) {
+        if (!tap_merge_get_string(state, &name) || name == NULL ||
+            !tap_merge_get_uint(state, &datatype) ||
+            !tap_merge_get_uint(state, &with_hash) ||
+            !tap_merge_get_uint(state, &as_parent) ||
+            !tap_merge_get_uint(state, &with_rng))
+            return FALSE;
+        if (with_rng &&
+            (!tap_merge_get_uint(state, &floor) || !tap_merge_get_uint(state, &ceil)))
+            return FALSE;
+
+        if (node->hash) {
+            child = (stat_node *)g_hash_table_lookup(node->hash, name);
+        } else {
+            for (child = node->children; child; child = child->next) {
+                if (strcmp(child->name, name) == 0)
+                    break;
+            }
+        }
+
+        if (child && child->datatype != (stat_node_datatype)datatype)
+            return FALSE;
+
+        if (child == NULL) {
+            /* Only nodes that are parents have IDs to add children by */
+            if (node->id < 0)
+                return FALSE;
+            child = new_stat_node(st, name, node->id, (stat_node_datatype)datatype,
+                                  with_hash ? TRUE : FALSE, as_parent ? TRUE : FALSE);
+            if (with_rng) {
+                child->rng = g_new(range_pair_t, 1);
+                child->rng->floor = (gint)floor;
+                child->rng->ceil = (gint)ceil;
+            }
+        }
+
+        if (!merge_stat_node(child, state))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+extern gboolean
+stats_tree_merge(void *p, tap_merge_state_t *state)
+{
+    stats_tree *st = (stats_tree *)p;
+    double start, now;
+
+    if (!tap_merge_get_bytes(state, &start, sizeof(start)) ||
+        !tap_merge_get_bytes(state, &now, sizeof(now)))
+        return FALSE;
+
+    /* The other tree's packets all came after ours */
+    if (start >= 0.0) {
+        if (st->start < 0.0)
+            st->start = start;
+        st->now = now;
+        st->elapsed = st->now - st->start;
+    }
+
+    return merge_stat_node(&st->root, state);
+}
+
 /* Internal function to update the burst calculation data - add entry to bucket */
 static void
 update_burst_calc(stat_node *node, gint value)
@@ -640,32 +827,10 @@ update_burst_calc(stat_node *node, gint value)
     }
 }
 
-/*
- * Increases by delta the counter of the node whose name is given
- * if the node does not exist yet it's created (with counter=1)
- * using parent_name as parent node.
- * with_hash=TRUE to indicate that the created node will have a parent
- */
-int
-stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
-              int parent_id, gboolean with_hash, gint value)
+/* Applies a manip_node_mode operation to an integer node */
+static void
+manip_stat_node_int(stat_node *node, manip_node_mode mode, gint value)
 {
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
-
-    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
-
-    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
-
     switch (mode) {
         case MN_INCREASE:
             node->counter += value;
@@ -673,6 +838,7 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
             break;
         case MN_SET:
             node->counter = value;
+            node->counter_set = TRUE;
             break;
         case MN_AVERAGE:
             node->counter++;
@@ -686,15 +852,44 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
             if (node->maxvalue.int_max < value) {
                 node->maxvalue.int_max = value;
             }
-            node->st_flags |= ST_FLG_AVERAGE;
+            set_stat_node_flags(node, ST_FLG_AVERAGE);
             break;
         case MN_SET_FLAGS:
-            node->st_flags |= value;
+            set_stat_node_flags(node, value);
             break;
         case MN_CLEAR_FLAGS:
-            node->st_flags &= ~value;
+            clear_stat_node_flags(node, value);
             break;
     }
+}
+
+/*
+ * Increases by delta the counter of the node whose name is given
+ * if the node does not exist yet it's created (with counter=1)
+ * using parent_name as parent node.
+ * with_hash=TRUE to indicate that the created node will have a parent
+ */
+int
+stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
+              int parent_id, gboolean with_hash, gint value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+
+    manip_stat_node_int(node, mode, value);
 
     if (node)
         return node->id;
@@ -702,6 +897,90 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
         return -1;
 }
 
+int
+stats_tree_manip_node_by_id(manip_node_mode mode, stats_tree *st, int node_id, gint value)
+{
+    stat_node *node;
+
+    g_assert( node_id >= 0 && node_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,node_id);
+
+    manip_stat_node_int(node, mode, value);
+
+    return node->id;
+}
+
+/* Size of the buffer in which key_name callbacks build a node's name */
+#define STAT_NODE_KEY_NAME_LEN 256
+
+void
+stats_tree_key_name_vals(gchar *buf, gsize buf_len, guint32 key, const void *key_vals)
+{
+    const stat_node_key_vals *kv = (const stat_node_key_vals *)key_vals;
+    const gchar *name = try_val_to_str(key, kv->vals);
+
+    if (name)
+        g_strlcpy(buf, name, buf_len);
+    else
+        g_snprintf(buf, (gulong) buf_len, kv->unknown_fmt, key);
+}
+
+/*
+ * Finds the child of parent_id identified by key, creating it if needed.
+ * A node created by name before it was first looked up by key is reused.
+ */
+static stat_node*
+get_stat_node_by_key(stats_tree *st, guint32 key, stat_node_key_name_cb key_name,
+              const void *key_name_data, int parent_id, gboolean with_hash)
+{
+    stat_node *node;
+    stat_node *parent;
+    gchar name[STAT_NODE_KEY_NAME_LEN];
+
+    g_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    if (parent->key_hash) {
+        node = (stat_node *)g_hash_table_lookup(parent->key_hash,GUINT_TO_POINTER(key));
+        if (node)
+            return node;
+    } else {
+        parent->key_hash = g_hash_table_new(g_direct_hash,g_direct_equal);
+    }
+
+    if (key_name)
+        key_name(name, sizeof(name), key, key_name_data);
+    else
+        g_snprintf(name, sizeof(name), "%u", key);
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+
+    g_hash_table_insert(parent->key_hash,GUINT_TO_POINTER(key),node);
+
+    return node;
+}
+
+int
+stats_tree_manip_node_by_key(manip_node_mode mode, stats_tree *st, guint32 key,
+              stat_node_key_name_cb key_name, const void *key_name_data,
+              int parent_id, gboolean with_hash, gint value)
+{
+    stat_node *node = get_stat_node_by_key(st,key,key_name,key_name_data,parent_id,with_hash);
+
+    manip_stat_node_int(node, mode, value);
+
+    return node->id;
+}
+
 /*
 * Increases by delta the counter of the node whose name is given
 * if the node does not exist yet it's created (with counter=1)
@@ -742,7 +1021,7 @@ stats_tree_manip_node_float(manip_node_mode mode, stats_tree *st, const char *na
         if (node->maxvalue.float_max < value) {
             node->maxvalue.float_max = value;
         }
-        node->st_flags |= ST_FLG_AVERAGE;
+        set_stat_node_flags(node, ST_FLG_AVERAGE);
         break;
     default:
         //only average is currently supported
@@ -909,31 +1188,13 @@ stats_tree_range_node_with_pname(stats_tree *st, const gchar *name,
 }
 
 
-extern int
-stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
-              int value_in_range)
+/* Updates a range node and the sub node to whose range the value belongs */
+static void
+tick_range_node(stat_node *node, int value_in_range)
 {
-
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
     stat_node *child = NULL;
     gint stat_floor, stat_ceil;
 
-    if (parent_id >= 0 && parent_id < (int) st->parents->len) {
-        parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-    } else {
-        g_assert_not_reached();
-    }
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
-
-    if ( node == NULL )
-        g_assert_not_reached();
-
     /* update stats for container node. counter should already be ticked so we only update total and min/max */
     node->total.int_total += value_in_range;
     if (node->minvalue.int_min > value_in_range) {
@@ -942,7 +1203,7 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
     if (node->maxvalue.int_max < value_in_range) {
         node->maxvalue.int_max = value_in_range;
     }
-    node->st_flags |= ST_FLG_AVERAGE;
+    set_stat_node_flags(node, ST_FLG_AVERAGE);
 
     for ( child = node->children; child; child = child->next) {
         stat_floor =  child->rng->floor;
@@ -957,11 +1218,51 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
             if (child->maxvalue.int_max < value_in_range) {
                 child->maxvalue.int_max = value_in_range;
             }
-            child->st_flags |= ST_FLG_AVERAGE;
+            set_stat_node_flags(child, ST_FLG_AVERAGE);
             update_burst_calc(child, 1);
-            return node->id;
+            return;
         }
     }
+}
+
+extern int
+stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
+              int value_in_range)
+{
+
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    if (parent_id >= 0 && parent_id < (int) st->parents->len) {
+        parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+    } else {
+        g_assert_not_reached();
+    }
+
+    if( parent->hash ) {
+        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
+    } else {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    }
+
+    if ( node == NULL )
+        g_assert_not_reached();
+
+    tick_range_node(node, value_in_range);
+
+    return node->id;
+}
+
+extern int
+stats_tree_tick_range_by_id(stats_tree *st, int range_id, int value_in_range)
+{
+    stat_node *node;
+
+    g_assert( range_id >= 0 && range_id < (int) st->parents->len );
+
+    node = (stat_node *)g_ptr_array_index(st->parents,range_id);
+
+    tick_range_node(node, value_in_range);
 
     return node->id;
 }
@@ -1004,6 +1305,22 @@ stats_tree_tick_pivot(stats_tree *st, int pivot_id, const gchar *pivot_value)
     return pivot_id;
 }
 
+extern int
+stats_tree_tick_pivot_by_key(stats_tree *st, int pivot_id, guint32 key,
+              stat_node_key_name_cb key_name, const void *key_name_data)
+{
+    stat_node *parent;
+
+    g_assert( pivot_id >= 0 && pivot_id < (int) st->parents->len );
+    parent = (stat_node *)g_ptr_array_index(st->parents,pivot_id);
+
+    parent->counter++;
+    update_burst_calc(parent, 1);
+    stats_tree_manip_node_by_key( MN_INCREASE, st, key, key_name, key_name_data, pivot_id, FALSE, 1);
+
+    return pivot_id;
+}
+
 extern gchar*
 stats_tree_get_displayname (gchar* fullname)
 {
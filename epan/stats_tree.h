@@ -16,6 +16,7 @@
 #include <epan/packet_info.h>
 #include <epan/tap.h>
 #include <epan/stat_groups.h>
+#include <epan/value_string.h>
 #include "ws_symbol_export.h"
 
 #ifdef __cplusplus
@@ -177,6 +178,33 @@ WS_DLL_PUBLIC int stats_tree_tick_pivot(stats_tree *st,
                                         int pivot_id,
                                         const gchar *pivot_value);
 
+/*
+ * Fills in buf with the name of the node identified by key under its
+ * parent. Only called when the node is created.
+ */
+typedef void (*stat_node_key_name_cb)(gchar *buf, gsize buf_len, guint32 key, const void *data);
+
+/* data for stats_tree_key_name_vals() */
+typedef struct _stat_node_key_vals {
+    const value_string *vals;
+    const gchar *unknown_fmt;   /* for keys not in vals, as in val_to_str() */
+} stat_node_key_vals;
+
+/* stat_node_key_name_cb naming keys as val_to_str() would, data is a stat_node_key_vals */
+WS_DLL_PUBLIC void stats_tree_key_name_vals(gchar *buf, gsize buf_len, guint32 key, const void *key_vals);
+
+/* increases by one the range node with the given id and the sub node to whose range the value belongs */
+WS_DLL_PUBLIC int stats_tree_tick_range_by_id(stats_tree *st,
+                                              int range_id,
+                                              int value_in_range);
+
+/* ticks the pivot and its child identified by key, see stats_tree_manip_node_by_key() */
+WS_DLL_PUBLIC int stats_tree_tick_pivot_by_key(stats_tree *st,
+                                               int pivot_id,
+                                               guint32 key,
+                                               stat_node_key_name_cb key_name,
+                                               const void *key_name_data);
+
 extern void stats_tree_cleanup(void);
 
 
@@ -245,6 +273,50 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
 #define stat_node_clear_flags(st,name,parent_id,with_children,flags)    \
     (stats_tree_manip_node_int(MN_CLEAR_FLAGS,(st),(name),(parent_id),(with_children),flags))
 
+/*
+ * manipulates the value of the node with the given id, as returned when
+ * it was created, without looking it up by name
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_by_id(manip_node_mode mode,
+                                        stats_tree *st,
+                                        int node_id,
+                                        gint value);
+
+#define increase_stat_node_by_id(st,node_id,value)                      \
+    (stats_tree_manip_node_by_id(MN_INCREASE,(st),(node_id),(value)))
+
+#define tick_stat_node_by_id(st,node_id)                                \
+    (stats_tree_manip_node_by_id(MN_INCREASE,(st),(node_id),1))
+
+#define avg_stat_node_add_value_int_by_id(st,node_id,value)             \
+    (stats_tree_manip_node_by_id(MN_AVERAGE,(st),(node_id),(value)))
+
+/*
+ * manipulates the value of the child of parent_id identified by an integer
+ * key, such as a protocol number or a port, rather than by name. The name
+ * of the node is only built, by key_name (or as the key in decimal if
+ * key_name is NULL), when the node is created, so unlike with the name
+ * based functions nothing has to be formatted or hashed as a string for
+ * every packet.
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_by_key(manip_node_mode mode,
+                                        stats_tree *st,
+                                        guint32 key,
+                                        stat_node_key_name_cb key_name,
+                                        const void *key_name_data,
+                                        int parent_id,
+                                        gboolean with_children,
+                                        gint value);
+
+#define increase_stat_node_by_key(st,key,key_name,key_name_data,parent_id,with_children,value) \
+    (stats_tree_manip_node_by_key(MN_INCREASE,(st),(key),(key_name),(key_name_data),(parent_id),(with_children),(value)))
+
+#define tick_stat_node_by_key(st,key,key_name,key_name_data,parent_id,with_children) \
+    (stats_tree_manip_node_by_key(MN_INCREASE,(st),(key),(key_name),(key_name_data),(parent_id),(with_children),1))
+
+#define avg_stat_node_add_value_int_by_key(st,key,key_name,key_name_data,parent_id,with_children,value) \
+    (stats_tree_manip_node_by_key(MN_AVERAGE,(st),(key),(key_name),(key_name_data),(parent_id),(with_children),(value)))
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
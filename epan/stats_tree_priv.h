@@ -75,6 +75,12 @@ struct _stat_node {
 
 	gint			st_flags;
 
+	/** what was done since the last reset that a merge must redo rather than add:
+	 *  the flags set and cleared, and whether the counter was set */
+	gint			st_flags_set;
+	gint			st_flags_cleared;
+	gboolean		counter_set;
+
 	/** fields for burst rate calculation */
 	gint			bcount;
 	burst_bucket	*bh, *bt;
@@ -84,6 +90,9 @@ struct _stat_node {
 	/** children nodes by name */
 	GHashTable		*hash;
 
+	/** children nodes by integer key, see stats_tree_manip_node_by_key() */
+	GHashTable		*key_hash;
+
 	/** the owner of this node */
 	stats_tree		*st;
 
@@ -189,6 +198,10 @@ WS_DLL_PUBLIC void stats_tree_reinit(void *p_st);
 /* callback for destoy */
 WS_DLL_PUBLIC void stats_tree_free(stats_tree *st);
 
+/** callbacks for set_tap_listener_merge() */
+WS_DLL_PUBLIC void stats_tree_serialize(void *p_st, GByteArray *state);
+WS_DLL_PUBLIC gboolean stats_tree_merge(void *p_st, tap_merge_state_t *state);
+
 /** given an optarg splits the abbr part
    and returns a newly allocated buffer containing it */
 WS_DLL_PUBLIC gchar *stats_tree_get_abbr(const gchar *optarg);
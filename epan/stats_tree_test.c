@@ -0,0 +1,344 @@
+/* stats_tree_test.c
+ * Stats tree node lookup and merge tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include "stats_tree_priv.h"
+
+/*
+ * A test tree has a plain node, a range node and a pivot, set up as
+ * a stats_tree plugin does in its init callback, and checks what the ID
+ * and key based functions do to them. The by key functions exist to save
+ * building a name per packet, so -m perf also times a tree shaped like the
+ * "dests" tree of the stats_tree plugin (destination, port type, port)
+ * ticked both ways.
+ */
+
+#define PERF_TICKS      2000000
+#define PERF_HOSTS      1000
+#define PERF_PORTS      64
+
+static const value_string test_vals[] = {
+    { 1, "one" },
+    { 2, "two" },
+    { 0, NULL }
+};
+
+static const stat_node_key_vals test_key_vals = { test_vals, "Unknown value (%u)" };
+
+static int test_node_top = -1;
+static int test_node_range = -1;
+static int test_node_pivot = -1;
+
+static void
+test_tree_init(stats_tree *st)
+{
+    test_node_top = stats_tree_create_node(st, "Top", 0, STAT_DT_INT, TRUE);
+    test_node_range = stats_tree_create_range_node(st, "Range", 0, "-9", "10-99", "100-", NULL);
+    test_node_pivot = stats_tree_create_pivot(st, "Pivot", 0);
+}
+
+static tap_packet_status
+test_tree_packet(stats_tree *st _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *p _U_)
+{
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+static stats_tree *
+test_tree_new(void)
+{
+    stats_tree *st = stats_tree_new(stats_tree_get_cfg_by_abbr("st_test"), NULL, NULL);
+
+    st->cfg->init(st);
+    return st;
+}
+
+static stat_node *
+find_child(const stat_node *parent, const char *name)
+{
+    stat_node *child;
+
+    for (child = parent->children; child; child = child->next) {
+        if (strcmp(child->name, name) == 0)
+            return child;
+    }
+    return NULL;
+}
+
+static guint
+count_children(const stat_node *parent)
+{
+    stat_node *child;
+    guint n = 0;
+
+    for (child = parent->children; child; child = child->next)
+        n++;
+    return n;
+}
+
+static stat_node *
+get_node(stats_tree *st, int id)
+{
+    return (stat_node *)g_ptr_array_index(st->parents, id);
+}
+
+/* Ticks packets from to to, some of them adding nodes */
+static void
+tick_packets(stats_tree *st, guint from, guint to)
+{
+    guint i;
+    int id;
+
+    for (i = from; i < to; i++) {
+        tick_stat_node_by_id(st, test_node_top);
+        id = tick_stat_node_by_key(st, i / 10, NULL, NULL, test_node_top, TRUE);
+        avg_stat_node_add_value_int_by_key(st, i % 3, NULL, NULL, id, FALSE, (gint)i);
+        tick_stat_node_by_id(st, test_node_range);
+        stats_tree_tick_range_by_id(st, test_node_range, (int)i);
+        stats_tree_tick_pivot_by_key(st, test_node_pivot, i % 4, NULL, NULL);
+    }
+}
+
+static void
+assert_same_nodes(const stat_node *a, const stat_node *b)
+{
+    g_assert_cmpstr(a->name, ==, b->name);
+    g_assert_cmpint(a->counter, ==, b->counter);
+    g_assert_cmpint(a->total.int_total, ==, b->total.int_total);
+    g_assert_cmpint(a->minvalue.int_min, ==, b->minvalue.int_min);
+    g_assert_cmpint(a->maxvalue.int_max, ==, b->maxvalue.int_max);
+    g_assert_cmpint(a->st_flags, ==, b->st_flags);
+
+    for (a = a->children, b = b->children; a && b; a = a->next, b = b->next)
+        assert_same_nodes(a, b);
+    g_assert_null(a);
+    g_assert_null(b);
+}
+
+/* Tests */
+
+static void
+stats_tree_test_by_id(void)
+{
+    stats_tree *st = test_tree_new();
+
+    tick_stat_node(st, "Top", 0, FALSE);
+    tick_stat_node_by_id(st, test_node_top);
+    increase_stat_node_by_id(st, test_node_top, 3);
+    g_assert_cmpint(get_node(st, test_node_top)->counter, ==, 5);
+
+    avg_stat_node_add_value_int_by_id(st, test_node_top, 7);
+    avg_stat_node_add_value_int_by_id(st, test_node_top, -2);
+    g_assert_cmpint(get_node(st, test_node_top)->counter, ==, 7);
+    g_assert_cmpint(get_node(st, test_node_top)->total.int_total, ==, 5);
+    g_assert_cmpint(get_node(st, test_node_top)->minvalue.int_min, ==, -2);
+    g_assert_cmpint(get_node(st, test_node_top)->maxvalue.int_max, ==, 7);
+
+    stats_tree_free(st);
+}
+
+static void
+stats_tree_test_by_key(void)
+{
+    stats_tree *st = test_tree_new();
+    stat_node *top;
+    stat_node *node;
+    int id;
+
+    top = get_node(st, test_node_top);
+
+    /* Decimal names by default */
+    tick_stat_node_by_key(st, 80, NULL, NULL, test_node_top, FALSE);
+    tick_stat_node_by_key(st, 80, NULL, NULL, test_node_top, FALSE);
+    node = find_child(top, "80");
+    g_assert_nonnull(node);
+    g_assert_cmpint(node->counter, ==, 2);
+
+    /* The same node as by name, whichever came first */
+    tick_stat_node(st, "80", test_node_top, FALSE);
+    g_assert_cmpint(node->counter, ==, 3);
+    tick_stat_node(st, "443", test_node_top, FALSE);
+    increase_stat_node_by_key(st, 443, NULL, NULL, test_node_top, FALSE, 4);
+    g_assert_cmpint(find_child(top, "443")->counter, ==, 5);
+    g_assert_cmpuint(count_children(top), ==, 2);
+
+    /* Named from a value_string */
+    tick_stat_node_by_key(st, 2, stats_tree_key_name_vals, &test_key_vals, test_node_top, FALSE);
+    tick_stat_node_by_key(st, 3, stats_tree_key_name_vals, &test_key_vals, test_node_top, FALSE);
+    g_assert_nonnull(find_child(top, "two"));
+    g_assert_nonnull(find_child(top, "Unknown value (3)"));
+
+    /* Nodes with children can be parents */
+    id = tick_stat_node_by_key(st, 6, NULL, NULL, test_node_top, TRUE);
+    g_assert_cmpint(id, >, 0);
+    tick_stat_node_by_key(st, 53, NULL, NULL, id, FALSE);
+    g_assert_cmpint(find_child(get_node(st, id), "53")->counter, ==, 1);
+
+    /* Keys under the root are gone after a reinit */
+    tick_stat_node_by_key(st, 9, NULL, NULL, 0, FALSE);
+    g_assert_nonnull(find_child(&st->root, "9"));
+    stats_tree_reinit(st);
+    g_assert_null(find_child(&st->root, "9"));
+    tick_stat_node_by_key(st, 9, NULL, NULL, 0, FALSE);
+    g_assert_cmpint(find_child(&st->root, "9")->counter, ==, 1);
+
+    stats_tree_free(st);
+}
+
+static void
+stats_tree_test_range_pivot(void)
+{
+    stats_tree *st = test_tree_new();
+    stat_node *range;
+    stat_node *pivot;
+
+    range = get_node(st, test_node_range);
+    stats_tree_tick_range_by_id(st, test_node_range, 5);
+    stats_tree_tick_range_by_id(st, test_node_range, 50);
+    stats_tree_tick_range(st, "Range", 0, 51);
+    stats_tree_tick_range_by_id(st, test_node_range, 5000);
+    g_assert_cmpint(find_child(range, "-9")->counter, ==, 1);
+    g_assert_cmpint(find_child(range, "10-99")->counter, ==, 2);
+    g_assert_cmpint(find_child(range, "100-")->counter, ==, 1);
+    g_assert_cmpint(range->maxvalue.int_max, ==, 5000);
+
+    pivot = get_node(st, test_node_pivot);
+    stats_tree_tick_pivot_by_key(st, test_node_pivot, 1, stats_tree_key_name_vals, &test_key_vals);
+    stats_tree_tick_pivot(st, test_node_pivot, "one");
+    stats_tree_tick_pivot_by_key(st, test_node_pivot, 7, NULL, NULL);
+    g_assert_cmpint(pivot->counter, ==, 3);
+    g_assert_cmpint(find_child(pivot, "one")->counter, ==, 2);
+    g_assert_cmpint(find_child(pivot, "7")->counter, ==, 1);
+    g_assert_cmpuint(count_children(pivot), ==, 2);
+
+    stats_tree_free(st);
+}
+
+static void
+stats_tree_test_merge(void)
+{
+    stats_tree *all = test_tree_new();
+    stats_tree *first = test_tree_new();
+    stats_tree *second = test_tree_new();
+    GByteArray *state = g_byte_array_new();
+    tap_merge_state_t merge_state;
+
+    tick_packets(all, 0, 100);
+    tick_packets(first, 0, 45);
+    tick_packets(second, 45, 100);
+
+    stats_tree_serialize(second, state);
+    merge_state.data = state->data;
+    merge_state.len = state->len;
+    merge_state.offset = 0;
+    g_assert_true(stats_tree_merge(first, &merge_state));
+    g_assert_cmpuint(merge_state.offset, ==, merge_state.len);
+
+    /* Including the order of the nodes added by the merge */
+    assert_same_nodes(&all->root, &first->root);
+
+    /* The merged nodes can still be found by key */
+    tick_stat_node_by_key(first, 9, NULL, NULL, test_node_top, TRUE);
+    g_assert_cmpint(find_child(get_node(first, test_node_top), "9")->counter, ==, 11);
+    g_assert_cmpuint(count_children(get_node(first, test_node_top)), ==, 10);
+
+    /* Truncated state is rejected */
+    merge_state.len = state->len / 2;
+    merge_state.offset = 0;
+    g_assert_false(stats_tree_merge(second, &merge_state));
+
+    g_byte_array_free(state, TRUE);
+    stats_tree_free(all);
+    stats_tree_free(first);
+    stats_tree_free(second);
+}
+
+static void
+stats_tree_test_perf(void)
+{
+    stats_tree *st;
+    gchar    str[64];
+    gdouble  elapsed;
+    guint32  host, port;
+    int      host_node, proto_node;
+    guint    i;
+
+    /* As the name based callers do it, building the names for every packet */
+    st = test_tree_new();
+    g_test_timer_start();
+    for (i = 0; i < PERF_TICKS; i++) {
+        host = 0x0A000000 + (i * 7919) % PERF_HOSTS;
+        port = (i * 31) % PERF_PORTS;
+        tick_stat_node(st, "Top", 0, FALSE);
+        g_snprintf(str, sizeof(str), "%u.%u.%u.%u", host >> 24, (host >> 16) & 0xFF,
+                   (host >> 8) & 0xFF, host & 0xFF);
+        host_node = tick_stat_node(st, str, test_node_top, TRUE);
+        proto_node = tick_stat_node(st, "UDP", host_node, TRUE);
+        g_snprintf(str, sizeof(str), "%u", port);
+        tick_stat_node(st, str, proto_node, TRUE);
+    }
+    elapsed = g_test_timer_elapsed();
+    g_test_message("by name %12.0f packets/s", PERF_TICKS / elapsed);
+    g_test_minimized_result(elapsed, "by name: %.3f s", elapsed);
+    stats_tree_free(st);
+
+    st = test_tree_new();
+    g_test_timer_start();
+    for (i = 0; i < PERF_TICKS; i++) {
+        host = 0x0A000000 + (i * 7919) % PERF_HOSTS;
+        port = (i * 31) % PERF_PORTS;
+        tick_stat_node_by_id(st, test_node_top);
+        host_node = tick_stat_node_by_key(st, host, NULL, NULL, test_node_top, TRUE);
+        proto_node = tick_stat_node_by_key(st, 17, NULL, NULL, host_node, TRUE);
+        tick_stat_node_by_key(st, port, NULL, NULL, proto_node, TRUE);
+    }
+    elapsed = g_test_timer_elapsed();
+    g_test_message("by key  %12.0f packets/s", PERF_TICKS / elapsed);
+    g_test_minimized_result(elapsed, "by key: %.3f s", elapsed);
+    stats_tree_free(st);
+}
+
+int
+main(int argc, char **argv)
+{
+    int result;
+
+    g_test_init(&argc, &argv, NULL);
+
+    stats_tree_register("frame", "st_test", "Test", 0, test_tree_packet, test_tree_init, NULL);
+
+    g_test_add_func("/stats_tree/by_id",        stats_tree_test_by_id);
+    g_test_add_func("/stats_tree/by_key",       stats_tree_test_by_key);
+    g_test_add_func("/stats_tree/range_pivot",  stats_tree_test_range_pivot);
+    g_test_add_func("/stats_tree/merge",        stats_tree_test_merge);
+    if (g_test_perf())
+        g_test_add_func("/stats_tree/perf",     stats_tree_test_perf);
+
+    result = g_test_run();
+
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
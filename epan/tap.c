@@ -25,6 +25,7 @@
 #include <epan/packet_info.h>
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
+#include <wsutil/pint.h>
 
 static gboolean tapping_is_active=FALSE;
 
@@ -89,6 +90,8 @@ typedef struct _tap_listener_t {
 	tap_packet_cb packet;
 	tap_draw_cb draw;
 	tap_finish_cb finish;
+	tap_serialize_cb serialize;
+	tap_merge_cb merge;
 } tap_listener_t;
 
 static tap_listener_t *tap_listener_queue=NULL;
@@ -669,6 +672,170 @@ remove_tap_listener(void *tapdata)
 	free_tap_listener(tl);
 }
 
+static tap_listener_t *
+find_tap_listener(void *tapdata)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata)
+			return tl;
+	}
+	return NULL;
+}
+
+/* this function makes a tap listener mergeable
+ */
+void
+set_tap_listener_merge(void *tapdata, tap_serialize_cb serialize, tap_merge_cb merge)
+{
+	tap_listener_t *tl=find_tap_listener(tapdata);
+
+	if(!tl) {
+		g_warning("set_tap_listener_merge(): no listener found with that tap data");
+		return;
+	}
+	tl->serialize=serialize;
+	tl->merge=merge;
+}
+
+/*
+ * Return TRUE if there are tap listeners and all of them, apart from
+ * dissector helpers, are mergeable, FALSE otherwise.
+ */
+gboolean
+tap_listeners_mergeable(void)
+{
+	tap_listener_t *tl;
+	gboolean have_listeners=FALSE;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		/* Helpers only matter to their dissector, in each process */
+		if(tl->flags & TL_IS_DISSECTOR_HELPER)
+			continue;
+		if(!tl->serialize || !tl->merge)
+			return FALSE;
+		have_listeners=TRUE;
+	}
+	return have_listeners;
+}
+
+/*
+ * The state of each mergeable listener, in queue order, is whether it
+ * failed and the length of its own state, followed by that state.
+ */
+void
+tap_listeners_serialize(GByteArray *state)
+{
+	tap_listener_t *tl;
+	guint start;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if((tl->flags & TL_IS_DISSECTOR_HELPER) || !tl->serialize)
+			continue;
+		tap_merge_put_uint(state, tl->failed);
+		start=state->len;
+		tap_merge_put_uint(state, 0);
+		tl->serialize(tl->tapdata, state);
+		/* Fill in the length now that we know it */
+		phton32(state->data + start, state->len - start - 4);
+	}
+}
+
+gboolean
+tap_listeners_merge(const guint8 *data, gsize len)
+{
+	tap_merge_state_t all = { data, len, 0 };
+	tap_merge_state_t state;
+	tap_listener_t *tl;
+	guint32 failed, tl_len;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if((tl->flags & TL_IS_DISSECTOR_HELPER) || !tl->serialize)
+			continue;
+		if(!tap_merge_get_uint(&all, &failed) ||
+		   !tap_merge_get_uint(&all, &tl_len) ||
+		   tl_len > all.len - all.offset)
+			return FALSE;
+		state.data=all.data + all.offset;
+		state.len=tl_len;
+		state.offset=0;
+		all.offset+=tl_len;
+		if(!tl->merge(tl->tapdata, &state) || state.offset != state.len)
+			return FALSE;
+		if(failed)
+			tl->failed=TRUE;
+		tl->needs_redraw=TRUE;
+	}
+	return all.offset == all.len;
+}
+
+void
+tap_merge_put_bytes(GByteArray *state, const void *data, gsize len)
+{
+	g_byte_array_append(state, (const guint8 *)data, (guint)len);
+}
+
+void
+tap_merge_put_uint(GByteArray *state, guint32 value)
+{
+	guint8 buf[4];
+
+	phton32(buf, value);
+	g_byte_array_append(state, buf, 4);
+}
+
+void
+tap_merge_put_string(GByteArray *state, const char *str)
+{
+	if(!str){
+		tap_merge_put_uint(state, G_MAXUINT32);
+		return;
+	}
+	tap_merge_put_uint(state, (guint32)strlen(str));
+	/* Including the terminator, so it can be read in place */
+	g_byte_array_append(state, (const guint8 *)str, (guint)strlen(str) + 1);
+}
+
+gboolean
+tap_merge_get_bytes(tap_merge_state_t *state, void *data, gsize len)
+{
+	if(len > state->len - state->offset)
+		return FALSE;
+	memcpy(data, state->data + state->offset, len);
+	state->offset+=len;
+	return TRUE;
+}
+
+gboolean
+tap_merge_get_uint(tap_merge_state_t *state, guint32 *value)
+{
+	if(state->len - state->offset < 4)
+		return FALSE;
+	*value=pntoh32(state->data + state->offset);
+	state->offset+=4;
+	return TRUE;
+}
+
+gboolean
+tap_merge_get_string(tap_merge_state_t *state, const char **str)
+{
+	guint32 len;
+
+	if(!tap_merge_get_uint(state, &len))
+		return FALSE;
+	if(len == G_MAXUINT32){
+		*str=NULL;
+		return TRUE;
+	}
+	if((gsize)len >= state->len - state->offset ||
+	   state->data[state->offset + len] != '\0')
+		return FALSE;
+	*str=(const char *)state->data + state->offset;
+	state->offset+=(gsize)len + 1;
+	return TRUE;
+}
+
 /*
  * Return TRUE if we have one or more tap listeners that require dissection,
  * FALSE otherwise.
@@ -705,6 +872,22 @@ have_tap_listener(int tap_id)
 	return FALSE;
 }
 
+/* Returns TRUE if a tap listener for the specified tap id wants text for each tapped packet. */
+gboolean
+tap_listeners_require_text(int tap_id)
+{
+	tap_listener_t *tap_queue = tap_listener_queue;
+
+	while(tap_queue) {
+		if(tap_queue->tap_id == tap_id && !(tap_queue->flags & TL_DEFERS_TEXT))
+			return TRUE;
+
+		tap_queue = tap_queue->next;
+	}
+
+	return FALSE;
+}
+
 /*
  * Return TRUE if we have any tap listeners with filters, FALSE otherwise.
  */
@@ -36,6 +36,18 @@ typedef tap_packet_status (*tap_packet_cb)(void *tapdata, packet_info *pinfo, ep
 typedef void (*tap_draw_cb)(void *tapdata);
 typedef void (*tap_finish_cb)(void *tapdata);
 
+/**
+ * Serialized tap listener state being read back by a tap_merge_cb.
+ */
+typedef struct _tap_merge_state_t {
+	const guint8 *data;	/**< serialized state */
+	gsize len;		/**< length of the state */
+	gsize offset;		/**< how much of it has been read */
+} tap_merge_state_t;
+
+typedef void (*tap_serialize_cb)(void *tapdata, GByteArray *state);
+typedef gboolean (*tap_merge_cb)(void *tapdata, tap_merge_state_t *state);
+
 /**
  * Flags to indicate what a tap listener's packet routine requires.
  */
@@ -46,6 +58,9 @@ typedef void (*tap_finish_cb)(void *tapdata);
 /** Flags to indicate what the tap listener does */
 #define TL_IS_DISSECTOR_HELPER	0x00000008	    /**< tap helps a dissector do work
 						                         ** but does not, itself, require dissection */
+#define TL_DEFERS_TEXT		0x00000010	    /**< tap doesn't need text formatted for each
+						                         ** tapped packet (e.g. expert info messages),
+						                         ** only what's available without formatting */
 
 #ifdef HAVE_PLUGINS
 typedef struct {
@@ -232,6 +247,58 @@ WS_DLL_PUBLIC void tap_listeners_dfilter_recompile(void);
 /** this function removes a tap listener */
 WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
 
+/** This function makes a tap listener mergeable: the state it has built
+ * from one set of packets can be added to the state another instance of it
+ * has built from another set.
+ *
+ * This lets the packets be split between processes forked after the tap
+ * listeners were registered (see tap_listeners_serialize()). The state
+ * only has to be understood by the same build of the program, so it may
+ * hold pointers to data that is static or was allocated before the fork.
+ *
+ * @param tapdata    the instance identifier passed to register_tap_listener().
+ * @param tap_serialize void (*serialize)(void *tapdata, GByteArray *state)
+ *                   Appends the listener's state to the array.
+ * @param tap_merge  gboolean (*merge)(void *tapdata, tap_merge_state_t *state)
+ *                   Reads back the state appended by serialize, adding it to
+ *                   the listener's own. The state read back always comes from
+ *                   packets following all the ones already seen, so a merge
+ *                   must leave the listener as if it had seen those packets
+ *                   itself, e.g. by appending entries seen for the first time
+ *                   in the order they were seen. Returns FALSE if the state
+ *                   can't be read.
+ */
+WS_DLL_PUBLIC void set_tap_listener_merge(void *tapdata, tap_serialize_cb tap_serialize,
+    tap_merge_cb tap_merge);
+
+/**
+ * Return TRUE if there are tap listeners and all of them, apart from
+ * dissector helpers, are mergeable, FALSE otherwise.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_mergeable(void);
+
+/** Appends the state of all the mergeable tap listeners to the array. */
+WS_DLL_PUBLIC void tap_listeners_serialize(GByteArray *state);
+
+/**
+ * Merges state appended by tap_listeners_serialize() in another process
+ * into the tap listeners, which must have been registered in the same
+ * order. Returns FALSE if the state can't be read.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_merge(const guint8 *data, gsize len);
+
+/** Helpers for tap_serialize_cb and tap_merge_cb. The "get" functions
+ * return FALSE if the state is too short.
+ */
+WS_DLL_PUBLIC void tap_merge_put_bytes(GByteArray *state, const void *data, gsize len);
+WS_DLL_PUBLIC void tap_merge_put_uint(GByteArray *state, guint32 value);
+/** Strings may be NULL. */
+WS_DLL_PUBLIC void tap_merge_put_string(GByteArray *state, const char *str);
+WS_DLL_PUBLIC gboolean tap_merge_get_bytes(tap_merge_state_t *state, void *data, gsize len);
+WS_DLL_PUBLIC gboolean tap_merge_get_uint(tap_merge_state_t *state, guint32 *value);
+/** The string is in the state; it must be copied to be kept. */
+WS_DLL_PUBLIC gboolean tap_merge_get_string(tap_merge_state_t *state, const char **str);
+
 /**
  * Return TRUE if we have one or more tap listeners that require dissection,
  * FALSE otherwise.
@@ -241,6 +308,11 @@ WS_DLL_PUBLIC gboolean tap_listeners_require_dissection(void);
 /** Returns TRUE there is an active tap listener for the specified tap id. */
 WS_DLL_PUBLIC gboolean have_tap_listener(int tap_id);
 
+/** Returns TRUE if there is an active tap listener for the specified tap id
+ * that needs the text formatted for each tapped packet, i.e. that wasn't
+ * registered with TL_DEFERS_TEXT. */
+WS_DLL_PUBLIC gboolean tap_listeners_require_text(int tap_id);
+
 /** Return TRUE if we have any tap listeners with filters, FALSE otherwise. */
 WS_DLL_PUBLIC gboolean have_filtering_tap_listeners(void);
 
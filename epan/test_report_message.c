@@ -0,0 +1,58 @@
+/* test_report_message.c
+ * Report message routines for the test programs
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <glib.h>
+
+#include <wsutil/report_message.h>
+
+#include "test_report_message.h"
+
+static void
+test_failure_message(const char *msg_format, va_list ap)
+{
+    vfprintf(stderr, msg_format, ap);
+    fprintf(stderr, "\n");
+}
+
+static void
+test_open_failure_message(const char *filename, int err, gboolean for_writing _U_)
+{
+    fprintf(stderr, "%s: %s\n", filename, g_strerror(err));
+}
+
+static void
+test_read_failure_message(const char *filename, int err)
+{
+    fprintf(stderr, "%s: %s\n", filename, g_strerror(err));
+}
+
+void
+test_init_report_message(void)
+{
+    init_report_message(test_failure_message, test_failure_message,
+                        test_open_failure_message, test_read_failure_message,
+                        test_read_failure_message);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
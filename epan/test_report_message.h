@@ -0,0 +1,29 @@
+/* test_report_message.h
+ * Report message routines for the test programs
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __TEST_REPORT_MESSAGE_H__
+#define __TEST_REPORT_MESSAGE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * Register routines that print failures and warnings to the standard
+ * error, as test programs that call epan_init() must before doing so.
+ * The programs are built with test_report_message.c.
+ */
+void test_init_report_message(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TEST_REPORT_MESSAGE_H__ */
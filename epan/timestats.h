@@ -39,6 +39,9 @@ WS_DLL_PUBLIC void time_stat_init(timestat_t *stats);
 /* Update a timestat_t struct with a new sample */
 WS_DLL_PUBLIC void time_stat_update(timestat_t *stats, const nstime_t *delta, packet_info *pinfo);
 
+/* Add the samples summarized by another timestat_t, all of which came later */
+WS_DLL_PUBLIC void time_stat_merge(timestat_t *stats, const timestat_t *other);
+
 WS_DLL_PUBLIC gdouble get_average(const nstime_t *sum, guint32 num);
 
 #ifdef __cplusplus
@@ -18,9 +18,107 @@
 #include "tvbuff.h"
 #include "exceptions.h"
 #include "wsutil/pint.h"
+#include "wsutil/ws_mempbrk.h"
 
 gboolean failed = FALSE;
 
+/* Reference for the tvb search functions: the offset of the first of the
+ * needle bytes in data[offset, end), or -1 */
+static gint
+ref_find(const guint8 *data, guint offset, guint end, const guint8 *needles, guint n_needles)
+{
+	guint i, j;
+
+	for (i = offset; i < end; i++) {
+		for (j = 0; j < n_needles; j++) {
+			if (data[i] == needles[j])
+				return (gint)i;
+		}
+	}
+	return -1;
+}
+
+static gint
+ref_find_guint16(const guint8 *data, guint offset, guint end, guint16 needle)
+{
+	guint i;
+
+	for (i = offset; i + 1 < end; i++) {
+		if (data[i] == (needle >> 8) && data[i + 1] == (needle & 0xff))
+			return (gint)i;
+	}
+	return -1;
+}
+
+/* Checks tvb_find_guint8(), tvb_find_guint16() and
+ * tvb_ws_mempbrk_pattern_guint8() from every offset, for needles that
+ * occur in the data and one that doesn't.
+ * Returns TRUE if all tests succeeed, FALSE if any test fails */
+static gboolean
+test_searches(tvbuff_t *tvb, const gchar* name, const guint8* data, guint length)
+{
+	ws_mempbrk_pattern pattern;
+	guint8		needles[2];
+	guint16		needle16;
+	guint		offset, maxlength, k;
+	gint		found, expected;
+	guchar		found_needle;
+
+	for (offset = 0; offset <= length; offset++) {
+		for (k = 0; k <= length; k++) {
+			/* The last round looks for a byte that's not there. */
+			needles[0] = k < length ? data[k] : 0xff;
+			needles[1] = k + 1 < length ? data[k + 1] : 0xfe;
+			needle16 = (needles[0] << 8) | needles[1];
+
+			for (maxlength = 0; maxlength <= length - offset + 1; maxlength++) {
+				/* The last round searches to the end with -1. */
+				gint max = maxlength == length - offset + 1 ? -1 : (gint)maxlength;
+				guint end = max == -1 ? length : MIN(offset + maxlength, length);
+
+				found = tvb_find_guint8(tvb, offset, max, needles[0]);
+				expected = ref_find(data, offset, end, needles, 1);
+				if (found != expected) {
+					printf("13: Failed TVB=%s Offset=%u Maxlength=%d Needle=%02x "
+							"tvb_find_guint8 %d != expected %d\n",
+							name, offset, max, needles[0], found, expected);
+					failed = TRUE;
+					return FALSE;
+				}
+
+				found = tvb_find_guint16(tvb, offset, max, needle16);
+				expected = ref_find_guint16(data, offset, end, needle16);
+				if (found != expected) {
+					printf("14: Failed TVB=%s Offset=%u Maxlength=%d Needle=%04x "
+							"tvb_find_guint16 %d != expected %d\n",
+							name, offset, max, needle16, found, expected);
+					failed = TRUE;
+					return FALSE;
+				}
+
+				/* The needles can't be NUL in a pattern. */
+				if (needles[0] && needles[1]) {
+					const gchar needle_str[3] = { (gchar)needles[1], (gchar)needles[0], '\0' };
+
+					memset(&pattern, 0, sizeof(pattern));
+					ws_mempbrk_compile(&pattern, needle_str);
+					found = tvb_ws_mempbrk_pattern_guint8(tvb, offset, max, &pattern, &found_needle);
+					expected = ref_find(data, offset, end, needles, 2);
+					if (found != expected || (found != -1 && found_needle != data[found])) {
+						printf("15: Failed TVB=%s Offset=%u Maxlength=%d "
+								"tvb_ws_mempbrk_pattern_guint8 %d != expected %d\n",
+								name, offset, max, found, expected);
+						failed = TRUE;
+						return FALSE;
+					}
+				}
+			}
+		}
+	}
+
+	return TRUE;
+}
+
 /* Tests a tvbuff against the expected pattern/length.
  * Returns TRUE if all tests succeeed, FALSE if any test fails */
 static gboolean
@@ -239,6 +337,10 @@ test(tvbuff_t *tvb, const gchar* name,
 		}
 	}
 
+	/* Searches, before anything flattens a composite tvb */
+	if (!test_searches(tvb, name, expected_data, length))
+		return FALSE;
+
 	/* Sweep across data in various sized increments checking
 	 * tvb_memdup() */
 	for (incr = 1; incr < length; incr++) {
@@ -295,10 +397,10 @@ run_tests(void)
 	guint		subset_length[6];
 	guint		subset_reported_length[6];
 	guint8		temp;
-	guint8		*comp[6];
-	tvbuff_t	*tvb_comp[6];
-	guint		comp_length[6];
-	guint		comp_reported_length[6];
+	guint8		*comp[7];
+	tvbuff_t	*tvb_comp[7];
+	guint		comp_length[7];
+	guint		comp_reported_length[7];
 	int		len;
 
 	tvb_parent = tvb_new_real_data("", 0, 0);
@@ -466,6 +568,19 @@ run_tests(void)
 	tvb_composite_append(tvb_comp[5], tvb_comp[3]);
 	tvb_composite_finalize(tvb_comp[5]);
 
+	/* One-byte subsets, exercising the member lookup */
+	printf("Making Composite 6\n");
+	tvb_comp[6]		= tvb_new_composite();
+	comp_length[6]		= large_length[0];
+	comp_reported_length[6]	= large_reported_length[0];
+	comp[6]			= large[0];
+	for (i = 0; i < (int)large_length[0] - 1; i++) {
+		tvb_composite_append(tvb_comp[6], tvb_new_subset_length_caplen(tvb_large[0], i, 1, 1));
+	}
+	/* The last byte carries the missing reported length. */
+	tvb_composite_append(tvb_comp[6], tvb_new_subset_length_caplen(tvb_large[0], i, 1, 2));
+	tvb_composite_finalize(tvb_comp[6]);
+
 	/* Test the "composite" tvbuff objects. */
 	test(tvb_comp[0], "Composite 0", comp[0], comp_length[0], comp_reported_length[0]);
 	test(tvb_comp[1], "Composite 1", comp[1], comp_length[1], comp_reported_length[1]);
@@ -473,6 +588,7 @@ run_tests(void)
 	test(tvb_comp[3], "Composite 3", comp[3], comp_length[3], comp_reported_length[3]);
 	test(tvb_comp[4], "Composite 4", comp[4], comp_length[4], comp_reported_length[4]);
 	test(tvb_comp[5], "Composite 5", comp[5], comp_length[5], comp_reported_length[5]);
+	test(tvb_comp[6], "Composite 6", comp[6], comp_length[6], comp_reported_length[6]);
 
 	/* free memory. */
 	/* Don't free: comp[0] */
@@ -481,20 +597,161 @@ run_tests(void)
 	g_free(comp[3]);
 	g_free(comp[4]);
 	g_free(comp[5]);
+	/* Don't free: comp[6] */
 
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+#define BENCH_LINE_LEN	72
+#define BENCH_DATA_LEN	(64 * 1024)
+#define BENCH_MEMBERS	16
+#define BENCH_ROUNDS	200
+#define BENCH_SEGMENTS	4096	/* Composite members, as from a reassembled stream */
+
+static void
+bench_report(const char *what, const char *name, gint64 start, guint64 bytes)
+{
+	gint64 elapsed = g_get_monotonic_time() - start;
+
+	printf("%-18s %-10s %8.3f ms %8.1f MB/s\n", what, name, elapsed / 1000.0,
+			elapsed ? (double)bytes / elapsed : 0.0);
+}
+
+/* Finds a member the way composite tvbs did before their members were
+ * indexed: by walking the member list on every access. Kept as the
+ * reference the indexed lookup is timed against. */
+static guint8
+bench_linear_get_guint8(GSList *members, const guint *end_offsets, guint abs_offset)
+{
+	guint		i, num_members;
+	tvbuff_t	*member_tvb;
+
+	num_members = g_slist_length(members);
+	for (i = 0; i < num_members; i++) {
+		if (abs_offset <= end_offsets[i])
+			break;
+	}
+	member_tvb = (tvbuff_t *)g_slist_nth_data(members, i);
+	return tvb_get_guint8(member_tvb, (gint)(abs_offset - (i ? end_offsets[i - 1] + 1 : 0)));
+}
+
+/* Times the search functions over text lines, in a real tvb and in a
+ * composite of BENCH_MEMBERS pieces of it, and field access in a
+ * composite of BENCH_SEGMENTS pieces, against the linear member lookup. */
+static void
+run_benchmarks(void)
+{
+	tvbuff_t	*tvb_parent, *tvbs[2], *member_tvb;
+	const char	*names[2] = { "real", "composite" };
+	GSList		*linear_members = NULL;
+	guint		linear_end_offsets[BENCH_SEGMENTS];
+	guint8		*data;
+	guint		i, t, round;
+	gint		offset, next_offset;
+	gint64		start;
+	volatile gint	sink = 0;
+
+	data = (guint8 *)g_malloc(BENCH_DATA_LEN);
+	for (i = 0; i < BENCH_DATA_LEN; i++)
+		data[i] = 'a' + (i % 26);
+	for (i = BENCH_LINE_LEN; i < BENCH_DATA_LEN; i += BENCH_LINE_LEN) {
+		data[i - 2] = '\r';
+		data[i - 1] = '\n';
+	}
+	data[BENCH_DATA_LEN - 1] = '\0';
+
+	tvb_parent = tvb_new_real_data(data, BENCH_DATA_LEN, BENCH_DATA_LEN);
+	tvbs[0] = tvb_parent;
+	tvbs[1] = tvb_new_composite();
+	for (i = 0; i < BENCH_MEMBERS; i++) {
+		tvb_composite_append(tvbs[1], tvb_new_subset_length(tvb_parent,
+				i * (BENCH_DATA_LEN / BENCH_MEMBERS), BENCH_DATA_LEN / BENCH_MEMBERS));
+	}
+	tvb_composite_finalize(tvbs[1]);
+
+	for (t = 0; t < G_N_ELEMENTS(tvbs); t++) {
+		start = g_get_monotonic_time();
+		for (round = 0; round < BENCH_ROUNDS; round++)
+			sink += tvb_find_guint8(tvbs[t], 0, -1, '\0');
+		bench_report("tvb_find_guint8", names[t], start, (guint64)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+		start = g_get_monotonic_time();
+		for (round = 0; round < BENCH_ROUNDS; round++)
+			sink += tvb_find_guint16(tvbs[t], 0, -1, 0x7a00);
+		bench_report("tvb_find_guint16", names[t], start, (guint64)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+		start = g_get_monotonic_time();
+		for (round = 0; round < BENCH_ROUNDS; round++) {
+			for (offset = 0; offset < BENCH_DATA_LEN; offset = next_offset)
+				sink += tvb_find_line_end(tvbs[t], offset, -1, &next_offset, FALSE);
+		}
+		bench_report("tvb_find_line_end", names[t], start, (guint64)BENCH_ROUNDS * BENCH_DATA_LEN);
+	}
+
+	/* Field access in a composite with many small members */
+	tvbs[1] = tvb_new_composite();
+	for (i = 0; i < BENCH_SEGMENTS; i++) {
+		member_tvb = tvb_new_subset_length(tvb_parent,
+				i * (BENCH_DATA_LEN / BENCH_SEGMENTS), BENCH_DATA_LEN / BENCH_SEGMENTS);
+		tvb_composite_append(tvbs[1], member_tvb);
+		linear_members = g_slist_prepend(linear_members, member_tvb);
+		linear_end_offsets[i] = (i + 1) * (BENCH_DATA_LEN / BENCH_SEGMENTS) - 1;
+	}
+	tvb_composite_finalize(tvbs[1]);
+	linear_members = g_slist_reverse(linear_members);
+
+	/* The linear lookup is too slow for more than one round. */
+	start = g_get_monotonic_time();
+	for (offset = 0; offset < BENCH_DATA_LEN; offset++)
+		sink += bench_linear_get_guint8(linear_members, linear_end_offsets, (guint)offset);
+	bench_report("sequential guint8", "linear", start, BENCH_DATA_LEN);
+
+	start = g_get_monotonic_time();
+	for (i = 0; i < BENCH_DATA_LEN; i++)
+		sink += bench_linear_get_guint8(linear_members, linear_end_offsets, (i * 7919) % BENCH_DATA_LEN);
+	bench_report("scattered guint8", "linear", start, BENCH_DATA_LEN);
+
+	start = g_get_monotonic_time();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		for (offset = 0; offset < BENCH_DATA_LEN; offset++)
+			sink += tvb_get_guint8(tvbs[1], offset);
+	}
+	bench_report("sequential guint8", "segments", start, (guint64)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+	start = g_get_monotonic_time();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		/* Large strides, so that every access goes to another member */
+		for (i = 0; i < BENCH_DATA_LEN; i++)
+			sink += tvb_get_guint8(tvbs[1], (gint)((i * 7919) % BENCH_DATA_LEN));
+	}
+	bench_report("scattered guint8", "segments", start, (guint64)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+	start = g_get_monotonic_time();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		guint8 *copy = (guint8 *)tvb_memdup(NULL, tvbs[1], 0, -1);
+		sink += copy[0];
+		wmem_free(NULL, copy);
+	}
+	bench_report("memdup", "segments", start, (guint64)BENCH_ROUNDS * BENCH_DATA_LEN);
+
+	g_slist_free(linear_members);
+	tvb_free_chain(tvb_parent);
+	g_free(data);
+}
+
 /* Note: valgrind can be used to check for tvbuff memory leaks */
 int
-main(void)
+main(int argc, char **argv)
 {
 	/* For valgrind: See GLib documentation: "Running GLib Applications" */
 	g_setenv("G_DEBUG", "gc-friendly", 1);
 	g_setenv("G_SLICE", "always-malloc", 1);
 
 	except_init();
-	run_tests();
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+		run_benchmarks();
+	else
+		run_tests();
 	except_deinit();
 	exit(failed?1:0);
 }
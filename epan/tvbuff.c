@@ -2129,7 +2129,7 @@ tvb_find_guint8(tvbuff_t *tvb, const gint offset, const gint maxlength, const gu
 	if (tvb->ops->tvb_find_guint8)
 		return tvb->ops->tvb_find_guint8(tvb, abs_offset, limit, needle);
 
-	return tvb_find_guint8_generic(tvb, offset, limit, needle);
+	return tvb_find_guint8_generic(tvb, abs_offset, limit, needle);
 }
 
 /* Same as tvb_find_guint8() with 16bit needle. */
@@ -2139,37 +2139,49 @@ tvb_find_guint16(tvbuff_t *tvb, const gint offset, const gint maxlength,
 {
 	const guint8 needle1 = ((needle & 0xFF00) >> 8);
 	const guint8 needle2 = ((needle & 0x00FF) >> 0);
-	gint searched_bytes = 0;
-	gint pos = offset;
-
-	do {
-		gint offset1 =
-			tvb_find_guint8(tvb, pos, maxlength - searched_bytes, needle1);
-		gint offset2 = -1;
+	guint	      abs_offset = 0;
+	guint	      limit = 0;
+	guint	      end;
+	gint	      pos;
+	int           exception;
 
-		if (offset1 == -1) {
-			return -1;
-		}
+	DISSECTOR_ASSERT(tvb && tvb->initialized);
 
-		searched_bytes = offset - pos + 1;
+	exception = compute_offset_and_remaining(tvb, offset, &abs_offset, &limit);
+	if (exception)
+		THROW(exception);
 
-		if ((maxlength != -1) && (searched_bytes >= maxlength)) {
-			return -1;
-		}
+	/* Only search to end of tvbuff, w/o throwing exception. */
+	if (maxlength >= 0 && limit > (guint) maxlength)
+		limit = (guint) maxlength;
 
-		offset2 = tvb_find_guint8(tvb, offset1 + 1, 1, needle2);
+	/* Both bytes of the needle have to be within the limit. */
+	if (limit < 2)
+		return -1;
 
-		searched_bytes += 1;
+	/* If we have real data, check the byte after each match in place. */
+	if (tvb->real_data) {
+		const guint8 *ptr = tvb->real_data + abs_offset;
+		const guint8 *last = ptr + limit - 1;
 
-		if (offset2 != -1) {
-			if ((maxlength != -1) && (searched_bytes > maxlength)) {
+		for (; ptr < last; ptr++) {
+			ptr = (const guint8 *)memchr(ptr, needle1, last - ptr);
+			if (ptr == NULL)
 				return -1;
-			}
-			return offset1;
+			if (ptr[1] == needle2)
+				return (gint) (ptr - tvb->real_data);
 		}
+		return -1;
+	}
 
-		pos = offset1 + 1;
-	} while (searched_bytes < maxlength);
+	end = abs_offset + limit - 1;
+	for (pos = abs_offset; (guint) pos < end; pos++) {
+		pos = tvb_find_guint8(tvb, pos, end - pos, needle1);
+		if (pos == -1)
+			return -1;
+		if (tvb_get_guint8(tvb, pos + 1) == needle2)
+			return pos;
+	}
 
 	return -1;
 }
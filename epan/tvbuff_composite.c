@@ -16,14 +16,19 @@
 #include "proto.h"	/* XXX - only used for DISSECTOR_ASSERT, probably a new header file? */
 
 typedef struct {
-	GSList		*tvbs;
+	GQueue		tvbs;
 
-	/* Used for quick testing to see if this
-	 * is the tvbuff that a COMPOSITE is
-	 * interested in. */
+	/* Filled in by tvb_composite_finalize(): the members in order, and
+	 * the range of offsets each of them covers, for binary search. */
+	tvbuff_t	**members;
+	guint		num_members;
 	guint		*start_offsets;
 	guint		*end_offsets;
 
+	/* The member the last lookup ended up in; access tends to be
+	 * sequential. */
+	guint		last_member;
+
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -38,8 +43,9 @@ composite_free(tvbuff_t *tvb)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	g_slist_free(composite->tvbs);
+	g_queue_clear(&composite->tvbs);
 
+	g_free(composite->members);
 	g_free(composite->start_offsets);
 	g_free(composite->end_offsets);
 	if (tvb->real_data) {
@@ -56,37 +62,64 @@ composite_offset(const tvbuff_t *tvb _U_, const guint counter)
 	return counter;
 }
 
+/* Returns the index of the member that holds abs_offset, or num_members
+ * if abs_offset is the end of the composite. */
+static guint
+composite_find_member(tvb_comp_t *composite, guint abs_offset)
+{
+	guint i = composite->last_member;
+	guint lo, hi, mid;
+
+	/* Same member as last time, or the next one? */
+	if (abs_offset >= composite->start_offsets[i]) {
+		if (abs_offset <= composite->end_offsets[i])
+			return i;
+		if (i + 1 < composite->num_members && abs_offset <= composite->end_offsets[i + 1]) {
+			composite->last_member = i + 1;
+			return i + 1;
+		}
+	}
+
+	/* Find the first member that ends at or after abs_offset. */
+	lo = 0;
+	hi = composite->num_members;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (composite->end_offsets[mid] < abs_offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < composite->num_members)
+		composite->last_member = lo;
+	return lo;
+}
+
 static const guint8*
 composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	guint	    i, num_members;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset;
-	GSList	   *slist;
+	guint	    i;
+	void	   *real_data;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
 	/* Maybe the range specified by offset/length
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
-		return "";
+		return (const guint8 *)"";
 	}
 
+	member_tvb = composite->members[i];
 	member_offset = abs_offset - composite->start_offsets[i];
 
 	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
@@ -96,15 +129,14 @@ composite_get_ptr(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 		DISSECTOR_ASSERT(!tvb->real_data);
 		return tvb_get_ptr(member_tvb, member_offset, abs_length);
 	}
-	else {
-		/* Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
-		void *real_data = g_malloc(tvb->length);
-		tvb_memcpy(tvb, real_data, 0, tvb->length);
-		tvb->real_data = (const guint8 *)real_data;
-		return tvb->real_data + abs_offset;
-	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	/* Only now that a range spans members, flatten the whole
+	 * composite; later accesses then use real_data directly.
+	 * Use a temporary variable as tvb_memcpy is also checking tvb->real_data pointer */
+	real_data = g_malloc(tvb->length);
+	tvb_memcpy(tvb, real_data, 0, tvb->length);
+	tvb->real_data = (const guint8 *)real_data;
+	return tvb->real_data + abs_offset;
 }
 
 static void *
@@ -113,63 +145,86 @@ composite_memcpy(tvbuff_t *tvb, void* _target, guint abs_offset, guint abs_lengt
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	guint8 *target = (guint8 *) _target;
 
-	guint	    i, num_members;
 	tvb_comp_t *composite;
-	tvbuff_t   *member_tvb = NULL;
+	tvbuff_t   *member_tvb;
 	guint	    member_offset, member_length;
-	GSList	   *slist;
+	guint	    i;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
-	/* Maybe the range specified by offset/length
-	 * is contiguous inside one of the member tvbuffs */
-	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
-
-	for (i = 0; i < num_members; i++) {
-		if (abs_offset <= composite->end_offsets[i]) {
-			slist = g_slist_nth(composite->tvbs, i);
-			member_tvb = (tvbuff_t *)slist->data;
-			break;
-		}
-	}
+	composite = &composite_tvb->composite;
+	i = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (!member_tvb) {
+	if (i == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
-	member_offset = abs_offset - composite->start_offsets[i];
-
-	if (tvb_bytes_exist(member_tvb, member_offset, abs_length)) {
-		DISSECTOR_ASSERT(!tvb->real_data);
-		return tvb_memcpy(member_tvb, target, member_offset, abs_length);
-	}
-	else {
-		/* The requested data is non-contiguous inside
-		 * the member tvb. We have to memcpy() the part that's in the member tvb,
-		 * then iterate across the other member tvb's, copying their portions
-		 * until we have copied all data.
-		 */
+	/* Copy the part that's in this member, then carry on with the
+	 * following members until we have copied all data. */
+	while (abs_length > 0) {
+		DISSECTOR_ASSERT(i < composite->num_members);
+		member_tvb = composite->members[i];
+		member_offset = abs_offset - composite->start_offsets[i];
 		member_length = tvb_captured_length_remaining(member_tvb, member_offset);
 
 		/* composite_memcpy() can't handle a member_length of zero. */
 		DISSECTOR_ASSERT(member_length > 0);
 
+		if (member_length > abs_length)
+			member_length = abs_length;
+
 		tvb_memcpy(member_tvb, target, member_offset, member_length);
+		target		+= member_length;
 		abs_offset	+= member_length;
 		abs_length	-= member_length;
+		i++;
+	}
 
-		/* Recurse */
-		if (abs_length > 0) {
-			composite_memcpy(tvb, target + member_length, abs_offset, abs_length);
-		}
+	return _target;
+}
 
-		return target;
+/* Search the members one after the other instead of flattening the
+ * composite into one buffer, which would copy all of it. */
+static gint
+composite_find_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, guint8 needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    end_offset = abs_offset + limit;
+	guint	    member_limit, i;
+	gint	    result;
+
+	for (i = composite_find_member(composite, abs_offset); i < composite->num_members && abs_offset < end_offset; i++) {
+		member_limit = MIN(end_offset, composite->end_offsets[i] + 1) - abs_offset;
+		result = tvb_find_guint8(composite->members[i], abs_offset - composite->start_offsets[i], member_limit, needle);
+		if (result != -1)
+			return result + composite->start_offsets[i];
+		abs_offset += member_limit;
+	}
+
+	return -1;
+}
+
+static gint
+composite_pbrk_guint8(tvbuff_t *tvb, guint abs_offset, guint limit, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
+	tvb_comp_t *composite = &composite_tvb->composite;
+	guint	    end_offset = abs_offset + limit;
+	guint	    member_limit, i;
+	gint	    result;
+
+	for (i = composite_find_member(composite, abs_offset); i < composite->num_members && abs_offset < end_offset; i++) {
+		member_limit = MIN(end_offset, composite->end_offsets[i] + 1) - abs_offset;
+		result = tvb_ws_mempbrk_pattern_guint8(composite->members[i], abs_offset - composite->start_offsets[i], member_limit, pattern, found_needle);
+		if (result != -1)
+			return result + composite->start_offsets[i];
+		abs_offset += member_limit;
 	}
 
-	DISSECTOR_ASSERT_NOT_REACHED();
+	return -1;
 }
 
 static const struct tvb_ops tvb_composite_ops = {
@@ -179,8 +234,8 @@ static const struct tvb_ops tvb_composite_ops = {
 	composite_offset,     /* offset */
 	composite_get_ptr,    /* get_ptr */
 	composite_memcpy,     /* memcpy */
-	NULL,                 /* find_guint8 XXX */
-	NULL,                 /* pbrk_guint8 XXX */
+	composite_find_guint8, /* find_guint8 */
+	composite_pbrk_guint8, /* pbrk_guint8 */
 	NULL,                 /* clone */
 };
 
@@ -199,9 +254,12 @@ tvb_new_composite(void)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	composite->tvbs		 = NULL;
+	g_queue_init(&composite->tvbs);
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
 	composite->start_offsets = NULL;
 	composite->end_offsets	 = NULL;
+	composite->last_member	 = 0;
 
 	return tvb;
 }
@@ -221,7 +279,7 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	DISSECTOR_ASSERT(member->length);
 
 	composite       = &composite_tvb->composite;
-	composite->tvbs = g_slist_append(composite->tvbs, member);
+	g_queue_push_tail(&composite->tvbs, member);
 }
 
 void
@@ -239,18 +297,18 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	DISSECTOR_ASSERT(member->length);
 
 	composite       = &composite_tvb->composite;
-	composite->tvbs = g_slist_prepend(composite->tvbs, member);
+	g_queue_push_head(&composite->tvbs, member);
 }
 
 void
 tvb_composite_finalize(tvbuff_t *tvb)
 {
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
-	GSList	   *slist;
+	GList	   *list;
 	guint	    num_members;
 	tvbuff_t   *member_tvb;
 	tvb_comp_t *composite;
-	int	    i = 0;
+	guint	    i = 0;
 
 	DISSECTOR_ASSERT(tvb && !tvb->initialized);
 	DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops);
@@ -259,7 +317,7 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	DISSECTOR_ASSERT(tvb->contained_length == 0);
 
 	composite   = &composite_tvb->composite;
-	num_members = g_slist_length(composite->tvbs);
+	num_members = g_queue_get_length(&composite->tvbs);
 
 	/* Dissectors should not create composite TVBs if they're not going to
 	 * put at least one TVB in them.
@@ -267,12 +325,15 @@ tvb_composite_finalize(tvbuff_t *tvb)
 	 */
 	DISSECTOR_ASSERT(num_members);
 
+	composite->members = g_new(tvbuff_t *, num_members);
+	composite->num_members = num_members;
 	composite->start_offsets = g_new(guint, num_members);
 	composite->end_offsets = g_new(guint, num_members);
 
-	for (slist = composite->tvbs; slist != NULL; slist = slist->next) {
-		DISSECTOR_ASSERT((guint) i < num_members);
-		member_tvb = (tvbuff_t *)slist->data;
+	for (list = composite->tvbs.head; list != NULL; list = list->next) {
+		DISSECTOR_ASSERT(i < num_members);
+		member_tvb = (tvbuff_t *)list->data;
+		composite->members[i] = member_tvb;
 		composite->start_offsets[i] = tvb->length;
 		tvb->length += member_tvb->length;
 		tvb->reported_length += member_tvb->reported_length;
@@ -281,9 +342,10 @@ tvb_composite_finalize(tvbuff_t *tvb)
 		i++;
 	}
 
-	DISSECTOR_ASSERT(composite->tvbs);
+	/* The array is all we need from now on. */
+	g_queue_clear(&composite->tvbs);
 
-	tvb_add_to_chain((tvbuff_t *)composite->tvbs->data, tvb); /* chain composite tvb to first member */
+	tvb_add_to_chain(composite->members[0], tvb); /* chain composite tvb to first member */
 	tvb->initialized = TRUE;
 	tvb->ds_tvb = tvb;
 }
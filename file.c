@@ -27,6 +27,7 @@
 
 #include <epan/exceptions.h>
 #include <epan/epan.h>
+#include <epan/field_index.h>
 #include <epan/column.h>
 #include <epan/packet.h>
 #include <epan/column-utils.h>
@@ -105,6 +106,8 @@ static match_result match_time_reference(capture_file *cf, frame_data *fdata,
     wtap_rec *, Buffer *, void *criterion);
 static gboolean find_packet(capture_file *cf, ws_match_function match_function,
     void *criterion, search_direction dir);
+static gboolean find_packet_in_frames(capture_file *cf, ws_match_function match_function,
+    void *criterion, search_direction dir, const guint32 *frames, guint num_frames);
 
 static void cf_rename_failure_alert_box(const char *filename, int err);
 static void ref_time_packets(capture_file *cf);
@@ -115,6 +118,10 @@ static void ref_time_packets(capture_file *cf);
 /* Show the progress bar after this many seconds. */
 #define PROGBAR_SHOW_DELAY 0.5
 
+/* Microseconds cf_continue_tail() may spend reading new records before
+   returning to the UI. */
+#define TAIL_TIME_SLICE (100 * 1000)
+
 /*
  * We could probably use g_signal_...() instead of the callbacks below but that
  * would require linking our CLI programs to libgobject and creating an object
@@ -264,6 +271,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
 
   cf->provider.wth = wth;
   cf->f_datalen = 0;
+  cf->tail_backlog = 0;
 
   /* Set the file name because we need it to set the follow stream filter.
      XXX - is that still true?  We need it for other reasons, though,
@@ -305,6 +313,9 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
    */
   cf->epan = ws_epan_new(cf);
 
+  /* Index the values of some fields as the frames are read, if asked to. */
+  cf->field_index = field_index_new(prefs.gui_find_index_fields);
+
   packet_list_queue_draw();
   cf_callback_invoke(cf_cb_file_opened, cf);
 
@@ -388,6 +399,9 @@ cf_close(capture_file *cf)
 
   dfilter_free(cf->rfcode);
   cf->rfcode = NULL;
+  cf_set_dfilter_frames(cf, NULL, NULL, 0);
+  field_index_free(cf->field_index);
+  cf->field_index = NULL;
   if (cf->provider.frames != NULL) {
     free_frame_data_sequence(cf->provider.frames);
     cf->provider.frames = NULL;
@@ -529,11 +543,14 @@ cf_read(capture_file *cf, gboolean reloading)
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're indexing field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_index != NULL);
 
   reset_tap_listeners();
 
@@ -747,6 +764,7 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
   gboolean          create_proto_tree;
   guint             tap_flags;
   gboolean          compiled;
+  gint64            slice_end;
 
   /* Compile the current display filter.
    * We assume this will not fail since cf->dfilter is only set in
@@ -769,14 +787,28 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're indexing field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_index != NULL);
 
   *err = 0;
 
+  /* Also read whatever was left over by the previous call. */
+  to_read += cf->tail_backlog;
+  cf->tail_backlog = 0;
+
+  /*
+   * Don't block the UI for longer than TAIL_TIME_SLICE; at high packet
+   * rates the records which didn't fit are left in cf->tail_backlog for
+   * the next call, so the packet list and status bar keep updating.
+   */
+  slice_end = g_get_monotonic_time() + TAIL_TIME_SLICE;
+
   /* Don't freeze/thaw the list when doing live capture */
   /*packet_list_freeze();*/
 
@@ -792,6 +824,10 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
     cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cf->cinfo : NULL;
 
     while (to_read != 0) {
+      if (g_get_monotonic_time() > slice_end) {
+        cf->tail_backlog = to_read;
+        break;
+      }
       wtap_cleareof(cf->provider.wth);
       if (!wtap_read(cf->provider.wth, rec, buf, err, &err_info,
                      &data_offset)) {
@@ -913,11 +949,14 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
    *    one of the tap listeners requires a protocol tree;
    *
    *    a postdissector wants field values or protocols on
-   *    the first pass.
+   *    the first pass;
+   *
+   *    we're indexing field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
-     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+     (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+     cf->field_index != NULL);
 
   if (cf->provider.wth == NULL) {
     cf_close(cf);
@@ -929,6 +968,9 @@ cf_finish_tail(capture_file *cf, wtap_rec *rec, Buffer *buf, int *err)
 
   epan_dissect_init(&edt, cf->epan, create_proto_tree, FALSE);
 
+  /* Everything left is read below. */
+  cf->tail_backlog = 0;
+
   while ((wtap_read(cf->provider.wth, rec, buf, err, &err_info, &data_offset))) {
     if (cf->state == FILE_READ_ABORTED) {
       /* Well, the user decided to abort the read.  Break out of the
@@ -1141,6 +1183,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
     epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
     wtap_rec *rec, Buffer *buf, gboolean add_to_packet_list)
 {
+  gboolean first_pass;
+
   frame_data_set_before_dissect(fdata, &cf->elapsed_time,
                                 &cf->provider.ref, cf->provider.prev_dis);
   cf->provider.prev_cap = fdata;
@@ -1158,10 +1202,13 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
   }
 #endif
 
-  if (!fdata->visited) {
+  first_pass = !fdata->visited;
+  if (first_pass) {
     /* This is the first pass, so prime the epan_dissect_t with the
-       hfids postdissectors want on the first pass. */
+       hfids postdissectors want on the first pass, and those we index. */
     prime_epan_dissect_with_postdissector_wanted_hfids(edt);
+    if (cf->field_index != NULL)
+      field_index_prime_edt(cf->field_index, edt);
   }
 
   /* Dissect the frame. */
@@ -1169,6 +1216,9 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
                              frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
                              fdata, cinfo);
 
+  if (first_pass && cf->field_index != NULL)
+    field_index_add_frame(cf->field_index, edt, fdata->num);
+
   /* If we don't have a display filter, set "passed_dfilter" to 1. */
   if (dfcode != NULL) {
     fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
@@ -1618,6 +1668,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   gboolean    compiled;
   guint32     frames_count;
   gboolean    queued_rescan_type = RESCAN_NONE;
+  guint32    *dfilter_frames = NULL;
+  guint       num_dfilter_frames = 0, next_dfilter_frame = 0;
+  guint32     dfilter_frames_count = 0;
+  gboolean    skip_frame;
 
   /* Rescan in progress, clear pending actions. */
   cf->redissection_queued = RESCAN_NONE;
@@ -1651,14 +1705,36 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
    *    one of the tap listeners requires a protocol tree;
    *
    *    we're redissecting and a postdissector wants field
-   *    values or protocols on the first pass.
+   *    values or protocols on the first pass, or we're indexing
+   *    field values.
    */
   create_proto_tree =
     (dfcode != NULL || have_filtering_tap_listeners() ||
      (tap_flags & TL_REQUIRES_PROTO_TREE) ||
-     (redissect && postdissectors_want_hfids()));
+     (redissect && (postdissectors_want_hfids() || cf->field_index != NULL)));
 
   reset_tap_listeners();
+
+  /* If we were told which frames the display filter can match, and nothing
+     else needs to see the other frames, skip those. */
+  if (cf->dfilter_frames != NULL) {
+    if (!redissect && cf->dfilter != NULL &&
+        strcmp(cf->dfilter, cf->dfilter_frames_filter) == 0 &&
+        !tap_listeners_require_dissection()) {
+      dfilter_frames = cf->dfilter_frames;
+      num_dfilter_frames = cf->num_dfilter_frames;
+      dfilter_frames_count = cf->dfilter_frames_count;
+      cf->dfilter_frames = NULL;
+    }
+    cf_set_dfilter_frames(cf, NULL, NULL, 0);
+  }
+  /* Or if the display filter tests an indexed field for equality. */
+  if (dfilter_frames == NULL && cf->field_index != NULL && !redissect &&
+      !tap_listeners_require_dissection()) {
+    dfilter_frames = field_index_lookup(cf->field_index, dfcode, &num_dfilter_frames);
+    dfilter_frames_count = cf->count;
+  }
+
   /* Which frame, if any, is the currently selected frame?
      XXX - should the selected frame or the focus frame be the "current"
      frame, that frame being the one from which "Find Frame" searches
@@ -1693,6 +1769,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     cf->epan = ws_epan_new(cf);
     cf->cinfo.epan = cf->epan;
 
+    /* The frames are all dissected again, so index them again. */
+    if (cf->field_index != NULL)
+      field_index_reset(cf->field_index);
+
     /* A new Lua tap listener may be registered in lua_prime_all_fields()
        called via epan_new() / init_dissection() when reloading Lua plugins. */
     if (!create_proto_tree && have_filtering_tap_listeners()) {
@@ -1830,7 +1910,15 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     /* Frame dependencies from the previous dissection/filtering are no longer valid. */
     fdata->dependent_of_displayed = 0;
 
-    if (!cf_read_record(cf, fdata, &rec, &buf))
+    skip_frame = FALSE;
+    if (dfilter_frames != NULL && framenum <= dfilter_frames_count &&
+        fdata->visited && !fdata->ref_time) {
+      while (next_dfilter_frame < num_dfilter_frames && dfilter_frames[next_dfilter_frame] < framenum)
+        next_dfilter_frame++;
+      skip_frame = (next_dfilter_frame == num_dfilter_frames || dfilter_frames[next_dfilter_frame] != framenum);
+    }
+
+    if (!skip_frame && !cf_read_record(cf, fdata, &rec, &buf))
       break; /* error reading the frame */
 
     /* If the previous frame is displayed, and we haven't yet seen the
@@ -1841,9 +1929,17 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
       preceding_frame = prev_frame;
     }
 
-    add_packet_to_packet_list(fdata, cf, &edt, dfcode,
-                                    cinfo, &rec, &buf,
-                                    add_to_packet_list);
+    if (skip_frame) {
+      /* The display filter can't match it. */
+      frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                                    &cf->provider.ref, cf->provider.prev_dis);
+      cf->provider.prev_cap = fdata;
+      fdata->passed_dfilter = 0;
+    } else {
+      add_packet_to_packet_list(fdata, cf, &edt, dfcode,
+                                      cinfo, &rec, &buf,
+                                      add_to_packet_list);
+    }
 
     /* If this frame is displayed, and this is the first frame we've
        seen displayed after the selected frame, remember this frame -
@@ -1868,6 +1964,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
   epan_dissect_cleanup(&edt);
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
+  g_free(dfilter_frames);
 
   /* We are done redissecting the packet list. */
   cf->redissecting = FALSE;
@@ -2287,6 +2384,68 @@ cf_retap_packets(capture_file *cf)
   return CF_READ_OK;
 }
 
+cf_read_status_t
+cf_retap_frames(capture_file *cf, const guint32 *frames, guint num_frames)
+{
+  retap_callback_args_t callback_args;
+  gboolean              create_proto_tree;
+  guint                 tap_flags;
+  frame_data           *fdata;
+  wtap_rec              rec;
+  Buffer                buf;
+  cf_read_status_t      status = CF_READ_OK;
+  guint                 i;
+
+  /* Presumably the user closed the capture file. */
+  if (cf == NULL) {
+    return CF_READ_ABORTED;
+  }
+
+  cf_callback_invoke(cf_cb_file_retap_started, cf);
+
+  /* As in cf_retap_packets(). */
+  tap_flags = union_of_tap_listener_flags();
+  callback_args.cinfo = (tap_flags & TL_REQUIRES_COLUMNS) ? &cf->cinfo : NULL;
+  create_proto_tree =
+    (have_filtering_tap_listeners() || (tap_flags & TL_REQUIRES_PROTO_TREE));
+
+  reset_tap_listeners();
+
+  epan_dissect_init(&callback_args.edt, cf->epan, create_proto_tree, FALSE);
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+
+  for (i = 0; i < num_frames; i++) {
+    fdata = frame_data_sequence_find(cf->provider.frames, frames[i]);
+    if (fdata == NULL)
+      continue;
+    if (!cf_read_record(cf, fdata, &rec, &buf)) {
+      status = CF_READ_ERROR;
+      break;
+    }
+    retap_packet(cf, fdata, &rec, &buf, &callback_args);
+  }
+
+  wtap_rec_cleanup(&rec);
+  ws_buffer_free(&buf);
+  epan_dissect_cleanup(&callback_args.edt);
+
+  cf_callback_invoke(cf_cb_file_retap_finished, cf);
+
+  return status;
+}
+
+void
+cf_set_dfilter_frames(capture_file *cf, const gchar *dftext, guint32 *frames, guint num_frames)
+{
+  g_free(cf->dfilter_frames_filter);
+  g_free(cf->dfilter_frames);
+  cf->dfilter_frames_filter = g_strdup(dftext);
+  cf->dfilter_frames = frames;
+  cf->num_dfilter_frames = num_frames;
+  cf->dfilter_frames_count = cf->count;
+}
+
 typedef struct {
   print_args_t *print_args;
   gboolean      print_header_line;
@@ -3488,6 +3647,18 @@ gboolean
 cf_find_packet_dfilter(capture_file *cf, dfilter_t *sfcode,
                        search_direction dir)
 {
+  guint32  *frames;
+  guint     num_frames;
+  gboolean  result;
+
+  /* If the filter tests an indexed field, only look at the frames that
+     have the value. */
+  if (cf->field_index != NULL &&
+      (frames = field_index_lookup(cf->field_index, sfcode, &num_frames)) != NULL) {
+    result = find_packet_in_frames(cf, match_dfilter, sfcode, dir, frames, num_frames);
+    g_free(frames);
+    return result;
+  }
   return find_packet(cf, match_dfilter, sfcode, dir);
 }
 
@@ -3512,7 +3683,7 @@ cf_find_packet_dfilter_string(capture_file *cf, const char *filter,
      */
     return FALSE;
   }
-  result = find_packet(cf, match_dfilter, sfcode, dir);
+  result = cf_find_packet_dfilter(cf, sfcode, dir);
   dfilter_free(sfcode);
   return result;
 }
@@ -3567,6 +3738,31 @@ match_time_reference(capture_file *cf _U_, frame_data *fdata, wtap_rec *rec _U_,
   return fdata->ref_time ? MR_MATCHED : MR_NOTMATCHED;
 }
 
+/* Select the row of a frame found by a search. */
+static gboolean
+select_found_packet(capture_file *cf, frame_data *new_fd)
+{
+  gboolean found_row;
+
+  /* We found a frame that's displayed and that matches.
+     Try to find and select the packet summary list row for that frame. */
+  cf->search_in_progress = TRUE;
+  found_row = packet_list_select_row_from_data(new_fd);
+  cf->search_in_progress = FALSE;
+  cf->search_pos = 0; /* Reset the position */
+  cf->search_len = 0; /* Reset length */
+  if (!found_row) {
+    /* We didn't find a row corresponding to this frame.
+       This means that the frame isn't being displayed currently,
+       so we can't select it. */
+    simple_message_box(ESD_TYPE_INFO, NULL,
+                       "The capture file is probably not fully dissected.",
+                       "End of capture exceeded.");
+    return FALSE; /* The search succeeded but we didn't find the row */
+  }
+  return TRUE; /* The search succeeded and we found the row */
+}
+
 static gboolean
 find_packet(capture_file *cf, ws_match_function match_function,
             void *criterion, search_direction dir)
@@ -3713,33 +3909,105 @@ find_packet(capture_file *cf, ws_match_function match_function,
     destroy_progress_dlg(progbar);
   g_timer_destroy(prog_timer);
 
-  if (new_fd != NULL) {
-    /* We found a frame that's displayed and that matches.
-       Try to find and select the packet summary list row for that frame. */
-    gboolean found_row;
-
-    cf->search_in_progress = TRUE;
-    found_row = packet_list_select_row_from_data(new_fd);
-    cf->search_in_progress = FALSE;
-    cf->search_pos = 0; /* Reset the position */
-    cf->search_len = 0; /* Reset length */
-    if (!found_row) {
-      /* We didn't find a row corresponding to this frame.
-         This means that the frame isn't being displayed currently,
-         so we can't select it. */
-      simple_message_box(ESD_TYPE_INFO, NULL,
-                         "The capture file is probably not fully dissected.",
-                         "End of capture exceeded.");
-      succeeded = FALSE; /* The search succeeded but we didn't find the row */
-    } else
-      succeeded = TRUE; /* The search succeeded and we found the row */
-  } else
+  if (new_fd != NULL)
+    succeeded = select_found_packet(cf, new_fd);
+  else
     succeeded = FALSE;   /* The search failed */
   wtap_rec_cleanup(&rec);
   ws_buffer_free(&buf);
   return succeeded;
 }
 
+/*
+ * Like find_packet(), but only looking at the given frames, in ascending
+ * order, as no other frame can match.
+ */
+static gboolean
+find_packet_in_frames(capture_file *cf, ws_match_function match_function,
+                      void *criterion, search_direction dir,
+                      const guint32 *frames, guint num_frames)
+{
+  guint32      start_framenum;
+  guint        start_idx, idx, count;
+  frame_data  *fdata;
+  frame_data  *new_fd = NULL;
+  wtap_rec     rec;
+  Buffer       buf;
+  match_result result;
+  gboolean     succeeded;
+
+  if (num_frames == 0)
+    return FALSE;
+
+  wtap_rec_init(&rec);
+  ws_buffer_init(&buf, 1514);
+
+  start_framenum = cf->current_frame != NULL ? cf->current_frame->num : 0;
+
+  /* Find the first candidate after the current frame, or the last one
+     before it. */
+  for (start_idx = 0; start_idx < num_frames && frames[start_idx] <= start_framenum; start_idx++)
+    ;
+  if (dir == SD_BACKWARD && start_idx > 0 && frames[start_idx - 1] == start_framenum)
+    start_idx--;
+  /* Going backward, idx is one past the frame to look at next. */
+  idx = start_idx;
+
+  for (count = 0; count < num_frames; count++) {
+    guint32 framenum;
+
+    if (dir == SD_BACKWARD) {
+      if (idx == 0) {
+        if (!prefs.gui_find_wrap) {
+          statusbar_push_temporary_msg("Search reached the beginning.");
+          break;
+        }
+        statusbar_push_temporary_msg("Search reached the beginning. Continuing at end.");
+        idx = num_frames;
+      }
+      framenum = frames[--idx];
+    } else {
+      if (idx == num_frames) {
+        if (!prefs.gui_find_wrap) {
+          statusbar_push_temporary_msg("Search reached the end.");
+          break;
+        }
+        statusbar_push_temporary_msg("Search reached the end. Continuing at beginning.");
+        idx = 0;
+      }
+      framenum = frames[idx++];
+    }
+    if (framenum == start_framenum) {
+      /* Back to the frame we started from. */
+      break;
+    }
+
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+
+    /* Is this packet in the display? */
+    if (fdata && fdata->passed_dfilter) {
+      /* Yes.  Does it match the search criterion? */
+      result = (*match_function)(cf, fdata, &rec, &buf, criterion);
+      if (result == MR_ERROR) {
+        /* Error; our caller has reported the error. */
+        new_fd = NULL;
+        break;
+      } else if (result == MR_MATCHED) {
+        new_fd = fdata;
+        break;
+      }
+    }
+  }
+
+  if (new_fd != NULL)
+    succeeded = select_found_packet(cf, new_fd);
+  else
+    succeeded = FALSE;
+  wtap_rec_cleanup(&rec);
+  ws_buffer_free(&buf);
+  return succeeded;
+}
+
 gboolean
 cf_goto_frame(capture_file *cf, guint fnumber)
 {
@@ -413,6 +413,29 @@ void cf_redissect_packets(capture_file *cf);
  */
 cf_read_status_t cf_retap_packets(capture_file *cf);
 
+/**
+ * Rescan the given packets and just run taps - don't reconstruct the display.
+ *
+ * @param cf the capture file
+ * @param frames the frame numbers, in ascending order
+ * @param num_frames the number of frames
+ * @return one of cf_read_status_t
+ */
+cf_read_status_t cf_retap_frames(capture_file *cf, const guint32 *frames, guint num_frames);
+
+/**
+ * Tell the next rescan of the packet list that a display filter can only
+ * match some of the frames, so that the others needn't be read and
+ * dissected. It's used if the display filter of that rescan is the given
+ * one and no tap listeners need to see all frames.
+ *
+ * @param cf the capture file
+ * @param dftext the display filter
+ * @param frames the frames it can match, in ascending order; freed with g_free() by cf
+ * @param num_frames the number of frames
+ */
+void cf_set_dfilter_frames(capture_file *cf, const gchar *dftext, guint32 *frames, guint num_frames);
+
 /**
  * Adjust timestamp precision if auto is selected.
  *
@@ -16,6 +16,7 @@
 #include <epan/prefs.h>
 #include <epan/uat-int.h>
 #include <epan/to_str.h>
+#include <wsutil/pint.h>
 
 #include "pinfo_stats_tree.h"
 
@@ -93,6 +94,29 @@ static void uat_plen_record_post_update_cb(void) {
 UAT_RANGE_CB_DEF(uat_plen_records, packet_range, uat_plen_record_t)
 
 /* ip host stats_tree -- basic test */
+/* Names nodes keyed by an IPv4 address in host byte order */
+static void ipv4_key_name(gchar *buf, gsize buf_len, guint32 key, const void *data _U_) {
+	address addr;
+	guint32 ipv4 = g_htonl(key);
+
+	set_address(&addr, AT_IPv4, 4, &ipv4);
+	address_to_str_buf(&addr, buf, (int)buf_len);
+}
+
+static void port_type_key_name(gchar *buf, gsize buf_len, guint32 key, const void *data _U_) {
+	g_strlcpy(buf, port_type_to_str((port_type)key), buf_len);
+}
+
+/*
+ * Ticks the child of parent_id for an address. IPv4 addresses are looked
+ * up by key, so that they needn't be formatted for every packet.
+ */
+static int tick_address_node(stats_tree *st, packet_info *pinfo, const address *addr, int parent_id, gboolean with_children) {
+	if (addr->type == AT_IPv4)
+		return tick_stat_node_by_key(st, pntoh32(addr->data), ipv4_key_name, NULL, parent_id, with_children);
+	return tick_stat_node(st, address_to_str(pinfo->pool, addr), parent_id, with_children);
+}
+
 static int st_node_ipv4 = -1;
 static int st_node_ipv6 = -1;
 static const gchar *st_str_ipv4 = "IPv4 Statistics/All Addresses";
@@ -106,19 +130,19 @@ static void ipv6_hosts_stats_tree_init(stats_tree *st) {
 	st_node_ipv6 = stats_tree_create_node(st, st_str_ipv6, 0, STAT_DT_INT, TRUE);
 }
 
-static tap_packet_status ip_hosts_stats_tree_packet(stats_tree *st, packet_info *pinfo, int st_node, const gchar *st_str) {
-	tick_stat_node(st, st_str, 0, FALSE);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_src), st_node, FALSE);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_dst), st_node, FALSE);
+static tap_packet_status ip_hosts_stats_tree_packet(stats_tree *st, packet_info *pinfo, int st_node) {
+	tick_stat_node_by_id(st, st_node);
+	tick_address_node(st, pinfo, &pinfo->net_src, st_node, FALSE);
+	tick_address_node(st, pinfo, &pinfo->net_dst, st_node, FALSE);
 	return TAP_PACKET_REDRAW;
 }
 
 static tap_packet_status ipv4_hosts_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	return ip_hosts_stats_tree_packet(st, pinfo, st_node_ipv4, st_str_ipv4);
+	return ip_hosts_stats_tree_packet(st, pinfo, st_node_ipv4);
 }
 
 static tap_packet_status ipv6_hosts_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	return ip_hosts_stats_tree_packet(st, pinfo, st_node_ipv6, st_str_ipv6);
+	return ip_hosts_stats_tree_packet(st, pinfo, st_node_ipv6);
 }
 
 /* ip host stats_tree -- separate source and dest, test stats_tree flags */
@@ -157,24 +181,22 @@ static void ipv6_srcdst_stats_tree_init(stats_tree *st) {
 static tap_packet_status ip_srcdst_stats_tree_packet(stats_tree *st,
 						     packet_info *pinfo,
 				                     int st_node_src,
-				                     const gchar *st_str_src,
-						     int st_node_dst,
-						     const gchar *st_str_dst) {
+						     int st_node_dst) {
 	/* update source branch */
-	tick_stat_node(st, st_str_src, 0, FALSE);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_src), st_node_src, FALSE);
+	tick_stat_node_by_id(st, st_node_src);
+	tick_address_node(st, pinfo, &pinfo->net_src, st_node_src, FALSE);
 	/* update destination branch */
-	tick_stat_node(st, st_str_dst, 0, FALSE);
-	tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_dst), st_node_dst, FALSE);
+	tick_stat_node_by_id(st, st_node_dst);
+	tick_address_node(st, pinfo, &pinfo->net_dst, st_node_dst, FALSE);
 	return TAP_PACKET_REDRAW;
 }
 
 static tap_packet_status ipv4_srcdst_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	return ip_srcdst_stats_tree_packet(st, pinfo, st_node_ipv4_src, st_str_ipv4_src, st_node_ipv4_dst, st_str_ipv4_dst);
+	return ip_srcdst_stats_tree_packet(st, pinfo, st_node_ipv4_src, st_node_ipv4_dst);
 }
 
 static tap_packet_status ipv6_srcdst_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	return ip_srcdst_stats_tree_packet(st, pinfo, st_node_ipv6_src, st_str_ipv6_src, st_node_ipv6_dst, st_str_ipv6_dst);
+	return ip_srcdst_stats_tree_packet(st, pinfo, st_node_ipv6_src, st_node_ipv6_dst);
 }
 
 /* packet type stats_tree -- test pivot node */
@@ -192,12 +214,12 @@ static void ipv6_ptype_stats_tree_init(stats_tree *st) {
 }
 
 static tap_packet_status ipv4_ptype_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	stats_tree_tick_pivot(st, st_node_ipv4_ptype, port_type_to_str(pinfo->ptype));
+	stats_tree_tick_pivot_by_key(st, st_node_ipv4_ptype, pinfo->ptype, port_type_key_name, NULL);
 	return TAP_PACKET_REDRAW;
 }
 
 static tap_packet_status ipv6_ptype_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	stats_tree_tick_pivot(st, st_node_ipv6_ptype, port_type_to_str(pinfo->ptype));
+	stats_tree_tick_pivot_by_key(st, st_node_ipv6_ptype, pinfo->ptype, port_type_key_name, NULL);
 	return TAP_PACKET_REDRAW;
 }
 
@@ -220,25 +242,23 @@ static void ipv6_dsts_stats_tree_init(stats_tree *st) {
 	st_node_ipv6_dsts = stats_tree_create_node(st, st_str_ipv6_dsts, 0, STAT_DT_INT, TRUE);
 }
 
-static tap_packet_status dsts_stats_tree_packet(stats_tree *st, packet_info *pinfo, int st_node, const gchar *st_str) {
-	static gchar str[128];
+static tap_packet_status dsts_stats_tree_packet(stats_tree *st, packet_info *pinfo, int st_node) {
 	int ip_dst_node;
 	int protocol_node;
 
-	tick_stat_node(st, st_str, 0, FALSE);
-	ip_dst_node = tick_stat_node(st, address_to_str(pinfo->pool, &pinfo->net_dst), st_node, TRUE);
-	protocol_node = tick_stat_node(st, port_type_to_str(pinfo->ptype), ip_dst_node, TRUE);
-	g_snprintf(str, sizeof(str) - 1, "%u", pinfo->destport);
-	tick_stat_node(st, str, protocol_node, TRUE);
+	tick_stat_node_by_id(st, st_node);
+	ip_dst_node = tick_address_node(st, pinfo, &pinfo->net_dst, st_node, TRUE);
+	protocol_node = tick_stat_node_by_key(st, pinfo->ptype, port_type_key_name, NULL, ip_dst_node, TRUE);
+	tick_stat_node_by_key(st, pinfo->destport, NULL, NULL, protocol_node, TRUE);
 	return TAP_PACKET_REDRAW;
 }
 
 static tap_packet_status ipv4_dsts_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	return dsts_stats_tree_packet(st, pinfo, st_node_ipv4_dsts, st_str_ipv4_dsts);
+	return dsts_stats_tree_packet(st, pinfo, st_node_ipv4_dsts);
 }
 
 static tap_packet_status ipv6_dsts_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	return dsts_stats_tree_packet(st, pinfo, st_node_ipv6_dsts, st_str_ipv6_dsts);
+	return dsts_stats_tree_packet(st, pinfo, st_node_ipv6_dsts);
 }
 
 /* packet length stats_tree -- test range node */
@@ -263,9 +283,9 @@ static void plen_stats_tree_init(stats_tree *st) {
 }
 
 static tap_packet_status plen_stats_tree_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_, const void *p _U_) {
-	tick_stat_node(st, st_str_plen, 0, FALSE);
+	tick_stat_node_by_id(st, st_node_plen);
 
-	stats_tree_tick_range(st, st_str_plen, 0, pinfo->fd->pkt_len);
+	stats_tree_tick_range_by_id(st, st_node_plen, pinfo->fd->pkt_len);
 
 	return TAP_PACKET_REDRAW;
 }
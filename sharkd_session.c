@@ -76,12 +76,72 @@
 struct sharkd_filter_item
 {
 	guint8 *filtered; /* can be NULL if all frames are matching for given filter. */
+
+	/* Cursor for paging: frame numbers of matching frames in ascending order, see sharkd_session_filter_rows(). */
+	guint32 *rows;
+	guint32 rows_count;
+	gboolean rows_built;
 };
 
 static GHashTable *filter_table = NULL;
 
+/*
+ * Cache of column rows generated for "frames" request, so scrolling back and forth
+ * (or several clients of web backend asking for the same page) doesn't need to
+ * re-read and re-dissect frames.
+ *
+ * Column values depend on frame number, time reference and previous displayed frame
+ * (delta columns), and on the column set. Everything else (preferences, comments, capture file)
+ * is handled by flushing whole cache when it changes.
+ */
+#define SHARKD_ROW_CACHE_MAX_ENTRIES 100000
+
+struct sharkd_row_cache_key
+{
+	guint32 framenum;
+	guint32 ref_frame;
+	guint32 prev_dis_num;
+	const char *columns; /* interned column specification, "" for default column set */
+};
+
+struct sharkd_row_cache_entry
+{
+	struct sharkd_row_cache_key key;
+	GList lru_link;  /* link in row_cache_lru, most recently used at head */
+	char **cols;     /* NULL-terminated array of column strings */
+};
+
+static GHashTable *row_cache = NULL;
+static GQueue row_cache_lru = G_QUEUE_INIT;
+static guint64 row_cache_hits = 0;
+static guint64 row_cache_misses = 0;
+
+/*
+ * Per-request statistics, reported by "stats" request.
+ *
+ * hist[0] counts requests which took less than 1 microsecond,
+ * hist[i] counts requests which took [2^(i-1), 2^i) microseconds.
+ */
+#define SHARKD_STATS_HIST_BUCKETS 32
+
+struct sharkd_req_stats
+{
+	guint64 count;
+	guint64 total_us;
+	guint64 max_us;
+	guint64 hist[SHARKD_STATS_HIST_BUCKETS];
+};
+
+static GHashTable *req_stats_table = NULL;
+
 static json_dumper dumper = {0};
 
+/* Output encoding flag (JSON_DUMPER_FLAGS_CBOR or 0) to be used starting with next reply, see "setformat". */
+static int dumper_format_flags = 0;
+
+/* In CBOR encoding replies are terminated by undefined simple value, instead of empty line. */
+#define SHARKD_CBOR_REPLY_END 0xf7
+
 static const char *
 json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *attr)
 {
@@ -186,10 +246,11 @@ sharkd_session_filter_free(gpointer data)
 	struct sharkd_filter_item *l = (struct sharkd_filter_item *) data;
 
 	g_free(l->filtered);
+	g_free(l->rows);
 	g_free(l);
 }
 
-static const struct sharkd_filter_item *
+static struct sharkd_filter_item *
 sharkd_session_filter_data(const char *filter)
 {
 	struct sharkd_filter_item *l;
@@ -204,7 +265,7 @@ sharkd_session_filter_data(const char *filter)
 		if (ret == -1)
 			return NULL;
 
-		l = (struct sharkd_filter_item *) g_malloc(sizeof(struct sharkd_filter_item));
+		l = (struct sharkd_filter_item *) g_malloc0(sizeof(struct sharkd_filter_item));
 		l->filtered = filtered;
 
 		g_hash_table_insert(filter_table, g_strdup(filter), l);
@@ -213,6 +274,165 @@ sharkd_session_filter_data(const char *filter)
 	return l;
 }
 
+/*
+ * Returns frame numbers of frames matching filter (in ascending order), so requests for given page
+ * can start directly at requested row, instead of walking (and counting) bitmap from the first frame.
+ *
+ * Returns NULL if filter is matching all frames.
+ */
+static const guint32 *
+sharkd_session_filter_rows(struct sharkd_filter_item *l, guint32 *rows_count)
+{
+	guint32 framenum;
+	guint32 n;
+
+	if (!l->filtered)
+		return NULL;
+
+	if (!l->rows_built)
+	{
+		n = 0;
+		for (framenum = 1; framenum <= cfile.count; framenum++)
+		{
+			if (l->filtered[framenum / 8] & (1 << (framenum % 8)))
+				n++;
+		}
+
+		l->rows = g_new(guint32, n);
+		l->rows_count = n;
+
+		n = 0;
+		for (framenum = 1; framenum <= cfile.count; framenum++)
+		{
+			if (l->filtered[framenum / 8] & (1 << (framenum % 8)))
+				l->rows[n++] = framenum;
+		}
+
+		l->rows_built = TRUE;
+	}
+
+	*rows_count = l->rows_count;
+	return l->rows;
+}
+
+static guint
+sharkd_row_cache_key_hash(gconstpointer k)
+{
+	const struct sharkd_row_cache_key *key = (const struct sharkd_row_cache_key *) k;
+	guint h;
+
+	h = key->framenum;
+	h = (h * 31) + key->ref_frame;
+	h = (h * 31) + key->prev_dis_num;
+	h = (h * 31) + g_direct_hash(key->columns);
+
+	return h;
+}
+
+static gboolean
+sharkd_row_cache_key_equal(gconstpointer a, gconstpointer b)
+{
+	const struct sharkd_row_cache_key *key_a = (const struct sharkd_row_cache_key *) a;
+	const struct sharkd_row_cache_key *key_b = (const struct sharkd_row_cache_key *) b;
+
+	/* columns are interned, pointer comparison is enough */
+	return key_a->framenum == key_b->framenum &&
+	       key_a->ref_frame == key_b->ref_frame &&
+	       key_a->prev_dis_num == key_b->prev_dis_num &&
+	       key_a->columns == key_b->columns;
+}
+
+static void
+sharkd_row_cache_entry_free(gpointer data)
+{
+	struct sharkd_row_cache_entry *entry = (struct sharkd_row_cache_entry *) data;
+
+	g_strfreev(entry->cols);
+	g_free(entry);
+}
+
+static void
+sharkd_row_cache_flush(void)
+{
+	/* entries are owned by hash table, LRU list only links them */
+	g_hash_table_remove_all(row_cache);
+	g_queue_init(&row_cache_lru);
+}
+
+static const char * const *
+sharkd_row_cache_lookup(const struct sharkd_row_cache_key *key)
+{
+	struct sharkd_row_cache_entry *entry;
+
+	entry = (struct sharkd_row_cache_entry *) g_hash_table_lookup(row_cache, key);
+	if (!entry)
+	{
+		row_cache_misses++;
+		return NULL;
+	}
+
+	row_cache_hits++;
+
+	/* move to front */
+	g_queue_unlink(&row_cache_lru, &entry->lru_link);
+	g_queue_push_head_link(&row_cache_lru, &entry->lru_link);
+
+	return (const char * const *) entry->cols;
+}
+
+static const char * const *
+sharkd_row_cache_insert(const struct sharkd_row_cache_key *key, const column_info *cinfo)
+{
+	struct sharkd_row_cache_entry *entry;
+	int col;
+
+	if (g_hash_table_size(row_cache) >= SHARKD_ROW_CACHE_MAX_ENTRIES)
+	{
+		GList *oldest = g_queue_peek_tail_link(&row_cache_lru);
+
+		g_queue_unlink(&row_cache_lru, oldest);
+		g_hash_table_remove(row_cache, &((struct sharkd_row_cache_entry *) oldest->data)->key);
+	}
+
+	entry = g_new0(struct sharkd_row_cache_entry, 1);
+	entry->key = *key;
+	entry->lru_link.data = entry;
+
+	entry->cols = g_new(char *, cinfo->num_cols + 1);
+	for (col = 0; col < cinfo->num_cols; ++col)
+		entry->cols[col] = g_strdup(cinfo->columns[col].col_data);
+	entry->cols[cinfo->num_cols] = NULL;
+
+	g_hash_table_insert(row_cache, &entry->key, entry);
+	g_queue_push_head_link(&row_cache_lru, &entry->lru_link);
+
+	return (const char * const *) entry->cols;
+}
+
+static void
+sharkd_req_stats_update(const char *req, gint64 elapsed_us)
+{
+	struct sharkd_req_stats *stats;
+	guint64 us = (elapsed_us > 0) ? (guint64) elapsed_us : 0;
+	int bucket = 0;
+
+	stats = (struct sharkd_req_stats *) g_hash_table_lookup(req_stats_table, req);
+	if (!stats)
+	{
+		stats = g_new0(struct sharkd_req_stats, 1);
+		g_hash_table_insert(req_stats_table, g_strdup(req), stats);
+	}
+
+	while (us >> bucket && bucket < SHARKD_STATS_HIST_BUCKETS - 1)
+		bucket++;
+
+	stats->count++;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+	stats->hist[bucket]++;
+}
+
 static gboolean
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -546,6 +766,9 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 	fprintf(stderr, "load: filename=%s\n", tok_file);
 
+	sharkd_row_cache_flush();
+	g_hash_table_remove_all(filter_table);
+
 	if (sharkd_cf_open(tok_file, WTAP_TYPE_AUTO, FALSE, &err) != CF_OK)
 	{
 		sharkd_json_simple_reply(err, NULL);
@@ -774,6 +997,10 @@ sharkd_session_create_columns(column_info *cinfo, const char *buf, const jsmntok
  *   (o) limit=N  - show only N frames
  *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
  *
+ * Column rows are kept in LRU cache (see sharkd_row_cache_lookup()), so repeated requests don't need re-dissection.
+ * Result of filter is kept as an ordered list of matching frames, so cost of request with skip and limit
+ * is proportional to limit, not to skip.
+ *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
  *   (m) num - frame number
@@ -792,20 +1019,42 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 	const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
 	const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
 
-	const guint8 *filter_data = NULL;
+	const guint32 *filter_rows = NULL;
+	guint32 filter_rows_count = 0;
+	const char * const *row;
 
 	int col;
 
 	guint32 framenum, prev_dis_num = 0;
 	guint32 current_ref_frame = 0, next_ref_frame = G_MAXUINT32;
+	guint32 row_idx;
 	guint32 skip;
 	guint32 limit;
 
 	column_info *cinfo = &cfile.cinfo;
 	column_info user_cinfo;
+	struct sharkd_row_cache_key row_key;
+
+	row_key.columns = g_intern_static_string("");
 
 	if (tok_column)
 	{
+		GString *columns_spec = g_string_new(NULL);
+		const char *tok_spec;
+		char tok_spec_name[64];
+
+		/* needs to be build before sharkd_session_create_columns() which modifies tokens */
+		for (col = 0; col < 32; col++)
+		{
+			ws_snprintf(tok_spec_name, sizeof(tok_spec_name), "column%d", col);
+			tok_spec = json_find_attr(buf, tokens, count, tok_spec_name);
+			if (tok_spec == NULL)
+				break;
+			g_string_append_printf(columns_spec, "%s\n", tok_spec);
+		}
+		row_key.columns = g_intern_string(columns_spec->str);
+		g_string_free(columns_spec, TRUE);
+
 		memset(&user_cinfo, 0, sizeof(user_cinfo));
 		cinfo = sharkd_session_create_columns(&user_cinfo, buf, tokens, count);
 		if (!cinfo)
@@ -814,12 +1063,12 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 
 	if (tok_filter)
 	{
-		const struct sharkd_filter_item *filter_item;
+		struct sharkd_filter_item *filter_item;
 
 		filter_item = sharkd_session_filter_data(tok_filter);
 		if (!filter_item)
 			return;
-		filter_data = filter_item->filtered;
+		filter_rows = sharkd_session_filter_rows(filter_item, &filter_rows_count);
 	}
 
 	skip = 0;
@@ -842,22 +1091,36 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 			return;
 	}
 
+	/* start directly at requested row, time references (refs) before it are consumed by first displayed frame */
+	if (skip)
+	{
+		if (filter_rows)
+			prev_dis_num = (skip <= filter_rows_count) ? filter_rows[skip - 1] : 0;
+		else
+			prev_dis_num = (skip <= cfile.count) ? skip : 0;
+	}
+
 	sharkd_json_array_open(NULL);
-	for (framenum = 1; framenum <= cfile.count; framenum++)
+	for (row_idx = skip; ; row_idx++)
 	{
 		frame_data *fdata;
-		guint32 ref_frame = (framenum != 1) ? 1 : 0;
+		guint32 ref_frame;
 
-		if (filter_data && !(filter_data[framenum / 8] & (1 << (framenum % 8))))
-			continue;
-
-		if (skip)
+		if (filter_rows)
 		{
-			skip--;
-			prev_dis_num = framenum;
-			continue;
+			if (row_idx >= filter_rows_count)
+				break;
+			framenum = filter_rows[row_idx];
+		}
+		else
+		{
+			if (row_idx >= cfile.count)
+				break;
+			framenum = row_idx + 1;
 		}
 
+		ref_frame = (framenum != 1) ? 1 : 0;
+
 		if (tok_refs)
 		{
 			if (framenum >= next_ref_frame)
@@ -890,16 +1153,27 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
 		}
 
 		fdata = sharkd_get_frame(framenum);
-		sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL));
+
+		row_key.framenum = framenum;
+		row_key.ref_frame = ref_frame;
+		row_key.prev_dis_num = prev_dis_num;
+
+		row = sharkd_row_cache_lookup(&row_key);
+		if (!row)
+		{
+			if (sharkd_dissect_columns(fdata, ref_frame, prev_dis_num, cinfo, (fdata->color_filter == NULL)) == 0)
+				row = sharkd_row_cache_insert(&row_key, cinfo);
+		}
 
 		json_dumper_begin_object(&dumper);
 
 		sharkd_json_array_open("c");
 		for (col = 0; col < cinfo->num_cols; ++col)
 		{
-			const col_item_t *col_item = &cinfo->columns[col];
-
-			sharkd_json_value_string(NULL, col_item->col_data);
+			if (row)
+				sharkd_json_value_string(NULL, row[col]);
+			else
+				sharkd_json_value_string(NULL, cinfo->columns[col].col_data);
 		}
 		sharkd_json_array_close();
 
@@ -3586,6 +3860,7 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
 		return;
 
 	ret = sharkd_set_user_comment(fdata, tok_comment);
+	sharkd_row_cache_flush();
 
 	sharkd_json_simple_reply(ret, NULL);
 }
@@ -3618,6 +3893,7 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
 	ws_snprintf(pref, sizeof(pref), "%s:%s", tok_name, tok_value);
 
 	ret = prefs_set_pref(pref, &errmsg);
+	sharkd_row_cache_flush();
 
 	sharkd_json_simple_reply(ret, errmsg);
 	g_free(errmsg);
@@ -4136,6 +4412,110 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
 	}
 }
 
+/**
+ * sharkd_session_process_setformat()
+ *
+ * Process setformat request
+ *
+ * Input:
+ *   (m) format - encoding of replies: "json" (default) or "cbor"
+ *
+ * Output object with attributes:
+ *   (m) err   - error code: 0 succeed
+ *
+ * Reply to this request is still written using previous encoding, new one is used starting with next reply.
+ *
+ * With "cbor" each reply is a sequence of CBOR (RFC 7049) data items with the same structure
+ * as JSON reply, terminated by the undefined (0xf7) simple value instead of empty line.
+ * Objects and arrays are encoded with indefinite length, so large results (frames, tap, iograph)
+ * can be decoded incrementally while they are still being written. Base64 data is sent as raw bytes.
+ * Requests are always JSON.
+ */
+static void
+sharkd_session_process_setformat(char *buf, const jsmntok_t *tokens, int count)
+{
+	const char *tok_format = json_find_attr(buf, tokens, count, "format");
+
+	if (!tok_format)
+		return;
+
+	if (!strcmp(tok_format, "json"))
+		dumper_format_flags = 0;
+	else if (!strcmp(tok_format, "cbor"))
+		dumper_format_flags = JSON_DUMPER_FLAGS_CBOR;
+	else
+	{
+		sharkd_json_simple_reply(1, "unknown format");
+		return;
+	}
+
+	sharkd_json_simple_reply(0, NULL);
+}
+
+/**
+ * sharkd_session_process_stats()
+ *
+ * Process stats request
+ *
+ * Output object with attributes:
+ *   (m) reqs  - array of handled requests, with attributes:
+ *                  'req'   - request name
+ *                  'count' - number of requests processed
+ *                  'total' - total processing time in microseconds
+ *                  'max'   - maximum processing time in microseconds
+ *                  'hist'  - latency histogram, i-th element counts requests which took less than 2^i microseconds
+ *                            (and not less than 2^(i-1)), trailing zeros are omitted
+ *   (m) cache - frames row cache statistics, with attributes:
+ *                  'entries' - number of cached rows
+ *                  'max'     - maximum number of cached rows
+ *                  'hits'    - number of rows returned from cache
+ *                  'misses'  - number of rows which needed to be dissected
+ */
+static void
+sharkd_session_process_stats(void)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	json_dumper_begin_object(&dumper);
+
+	sharkd_json_array_open("reqs");
+	g_hash_table_iter_init(&iter, req_stats_table);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const struct sharkd_req_stats *stats = (const struct sharkd_req_stats *) value;
+		int i, last;
+
+		json_dumper_begin_object(&dumper);
+		sharkd_json_value_string("req", (const char *) key);
+		sharkd_json_value_anyf("count", "%" G_GUINT64_FORMAT, stats->count);
+		sharkd_json_value_anyf("total", "%" G_GUINT64_FORMAT, stats->total_us);
+		sharkd_json_value_anyf("max", "%" G_GUINT64_FORMAT, stats->max_us);
+
+		for (last = SHARKD_STATS_HIST_BUCKETS - 1; last > 0 && stats->hist[last] == 0; last--)
+			;
+
+		sharkd_json_array_open("hist");
+		for (i = 0; i <= last; i++)
+			sharkd_json_value_anyf(NULL, "%" G_GUINT64_FORMAT, stats->hist[i]);
+		sharkd_json_array_close();
+
+		json_dumper_end_object(&dumper);
+	}
+	sharkd_json_array_close();
+
+	json_dumper_set_member_name(&dumper, "cache");
+	json_dumper_begin_object(&dumper);
+	sharkd_json_value_anyf("entries", "%u", g_hash_table_size(row_cache));
+	sharkd_json_value_anyf("max", "%u", SHARKD_ROW_CACHE_MAX_ENTRIES);
+	sharkd_json_value_anyf("hits", "%" G_GUINT64_FORMAT, row_cache_hits);
+	sharkd_json_value_anyf("misses", "%" G_GUINT64_FORMAT, row_cache_misses);
+	json_dumper_end_object(&dumper);
+
+	json_dumper_end_object(&dumper);
+	json_dumper_finish(&dumper);
+}
+
 static void
 sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 {
@@ -4185,6 +4565,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 
 	{
 		const char *tok_req = json_find_attr(buf, tokens, count, "req");
+		gboolean known_req = TRUE;
+		gint64 start_time;
 
 		if (!tok_req)
 		{
@@ -4192,6 +4574,8 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			return;
 		}
 
+		start_time = g_get_monotonic_time();
+
 		if (!strcmp(tok_req, "load"))
 			sharkd_session_process_load(buf, tokens, count);
 		else if (!strcmp(tok_req, "status"))
@@ -4224,13 +4608,27 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 			sharkd_session_process_dumpconf(buf, tokens, count);
 		else if (!strcmp(tok_req, "download"))
 			sharkd_session_process_download(buf, tokens, count);
+		else if (!strcmp(tok_req, "stats"))
+			sharkd_session_process_stats();
+		else if (!strcmp(tok_req, "setformat"))
+			sharkd_session_process_setformat(buf, tokens, count);
 		else if (!strcmp(tok_req, "bye"))
 			exit(0);
 		else
+		{
 			fprintf(stderr, "::: req = %s\n", tok_req);
+			known_req = FALSE;
+		}
+
+		if (known_req)
+			sharkd_req_stats_update(tok_req, g_get_monotonic_time() - start_time);
 
 		/* reply for every command are 0+ lines of JSON reply (outputed above), finished by empty new line */
 		json_dumper_finish(&dumper);
+		if (dumper.flags & JSON_DUMPER_FLAGS_CBOR)
+			fputc(SHARKD_CBOR_REPLY_END, stdout);
+
+		dumper.flags = (dumper.flags & ~JSON_DUMPER_FLAGS_CBOR) | dumper_format_flags;
 
 		/*
 		 * We do an explicit fflush after every line, because
@@ -4262,6 +4660,8 @@ sharkd_session_main(void)
 	dumper.output_file = stdout;
 
 	filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+	row_cache = g_hash_table_new_full(sharkd_row_cache_key_hash, sharkd_row_cache_key_equal, NULL, sharkd_row_cache_entry_free);
+	req_stats_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
 
 #ifdef HAVE_MAXMINDDB
 	/* mmdbresolve was stopped before fork(), force starting it */
@@ -4304,6 +4704,9 @@ sharkd_session_main(void)
 	}
 
 	g_hash_table_destroy(filter_table);
+	sharkd_row_cache_flush();
+	g_hash_table_destroy(row_cache);
+	g_hash_table_destroy(req_stats_table);
 	g_free(tokens);
 
 	return 0;
@@ -9,10 +9,15 @@
 #
 '''Command line option tests'''
 
+import array
+import base64
 import json
 import sys
 import os.path
+import socket
 import subprocess
+import tempfile
+import time
 import subprocesstest
 import fixtures
 import shutil
@@ -87,6 +92,27 @@ class case_basic_clopts(subprocesstest.SubprocessTestCase):
                        expected_return=self.exit_error)
 
 
+def run_zygote_job(socket_path, args):
+    '''Run a job in a tshark --zygote. Returns its exit status, output and errors.'''
+    with tempfile.TemporaryFile() as out_f, tempfile.TemporaryFile() as err_f, \
+            open(os.devnull, 'rb') as in_f, \
+            socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(socket_path)
+        request = b''.join(arg.encode('utf-8') + b'\0' for arg in args)
+        job_fds = array.array('i', (in_f.fileno(), out_f.fileno(), err_f.fileno()))
+        sock.sendmsg((request,), ((socket.SOL_SOCKET, socket.SCM_RIGHTS, job_fds),))
+        sock.shutdown(socket.SHUT_WR)
+        reply = b''
+        while True:
+            data = sock.recv(64)
+            if not data:
+                break
+            reply += data
+        out_f.seek(0)
+        err_f.seek(0)
+        return int(reply), out_f.read().decode('utf-8'), err_f.read().decode('utf-8')
+
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_tshark_options(subprocesstest.SubprocessTestCase):
@@ -111,6 +137,177 @@ class case_tshark_options(subprocesstest.SubprocessTestCase):
             process = self.runProcess((cmd_tshark, '-' + char_arg))
             self.assertIn(process.returncode, valid_returns)
 
+    def test_tshark_startup_profile(self, cmd_tshark, capture_file):
+        '''--startup-profile reports startup phases and registration routines'''
+        self.assertRun((cmd_tshark, '--startup-profile',
+                        '-r', capture_file('http.pcap'), '-Y', 'http.request.method == "HEAD"'))
+        self.assertTrue(self.grepOutput('HEAD.*/v4/iuident.cab'))
+        self.assertTrue(self.grepOutput(r'ms  epan_init$'))
+        self.assertTrue(self.grepOutput(r'ms  protocol registration \(\d+ routines\)'))
+        self.assertTrue(self.grepOutput(r'ms    proto_(register|reg_handoff)_'))
+
+    def test_tshark_zygote(self, cmd_tshark, capture_file, test_env):
+        '''--zygote runs jobs in processes forked from an initialized tshark'''
+        if sys.platform == 'win32':
+            self.skipTest('--zygote needs UNIX-domain sockets')
+        socket_dir = tempfile.mkdtemp()
+        socket_path = os.path.join(socket_dir, 'zygote.sock')
+        zygote = subprocess.Popen((cmd_tshark, '--zygote', 'unix:' + socket_path),
+                                  stdin=subprocess.DEVNULL, env=test_env)
+        try:
+            deadline = time.monotonic() + 60
+            while not os.path.exists(socket_path):
+                self.assertIsNone(zygote.poll(), 'the zygote exited')
+                self.assertLess(time.monotonic(), deadline, 'the zygote never listened')
+                time.sleep(0.05)
+
+            self.assertEqual(os.stat(socket_path).st_mode & 0o077, 0)
+
+            job_args = ('-r', capture_file('http.pcap'), '-Y', 'http.request.method == "HEAD"')
+            direct = self.assertRun((cmd_tshark,) + job_args, env=test_env)
+            status, out, err = run_zygote_job(socket_path, job_args)
+            self.assertEqual(status, 0, err)
+            self.assertIn('/v4/iuident.cab', out)
+            self.assertEqual(out, direct.stdout_str)
+
+            status, out, err = run_zygote_job(socket_path, ('-C', 'Default', '-r', capture_file('http.pcap')))
+            self.assertEqual(status, self.exit_command_line)
+            self.assertIn("-C can't be used in a zygote job", err)
+        finally:
+            zygote.kill()
+            zygote.wait()
+            shutil.rmtree(socket_dir, ignore_errors=True)
+
+    def test_tshark_zygote_options(self, cmd_tshark, test_env):
+        '''the zygote refuses options that only its jobs can use'''
+        if sys.platform == 'win32':
+            self.skipTest('--zygote needs UNIX-domain sockets')
+        socket_dir = tempfile.mkdtemp()
+        socket_path = os.path.join(socket_dir, 'zygote.sock')
+        try:
+            for zygote_args in (('-V',), ('-x', '-O', 'http'), ('-o', 'tcp.desegment_tcp_streams:FALSE'),
+                                ('-d', 'tcp.port==8888,http'), ('--enable-protocol', 'http'), ('port', '80')):
+                process = self.assertRun((cmd_tshark, '--zygote', 'unix:' + socket_path) + zygote_args,
+                                         env=test_env, expected_return=self.exit_command_line)
+                self.assertIn('with --zygote', process.stderr_str)
+                self.assertFalse(os.path.exists(socket_path))
+        finally:
+            shutil.rmtree(socket_dir, ignore_errors=True)
+
+    def test_tshark_zygote_print_options(self, cmd_tshark, capture_file, test_env):
+        '''zygote jobs get their own print options, not an earlier job's'''
+        if sys.platform == 'win32':
+            self.skipTest('--zygote needs UNIX-domain sockets')
+        socket_dir = tempfile.mkdtemp()
+        socket_path = os.path.join(socket_dir, 'zygote.sock')
+        zygote = subprocess.Popen((cmd_tshark, '--zygote', 'unix:' + socket_path),
+                                  stdin=subprocess.DEVNULL, env=test_env)
+        try:
+            deadline = time.monotonic() + 60
+            while not os.path.exists(socket_path):
+                self.assertIsNone(zygote.poll(), 'the zygote exited')
+                self.assertLess(time.monotonic(), deadline, 'the zygote never listened')
+                time.sleep(0.05)
+
+            read_args = ('-r', capture_file('http.pcap'), '-c', '4')
+            for print_args in ((), ('-V',), ('-x',), ('-O', 'tcp'), ('-P', '-V', '-x'), ()):
+                job_args = read_args + print_args
+                direct = self.assertRun((cmd_tshark,) + job_args, env=test_env)
+                status, out, err = run_zygote_job(socket_path, job_args)
+                self.assertEqual(status, 0, err)
+                self.assertEqual(out, direct.stdout_str, 'options {}'.format(print_args))
+        finally:
+            zygote.kill()
+            zygote.wait()
+            shutil.rmtree(socket_dir, ignore_errors=True)
+
+    def test_tshark_tap_workers(self, cmd_tshark, capture_file, test_env):
+        '''--tap-workers gives the same statistics as a single process'''
+        if sys.platform == 'win32':
+            self.skipTest('--tap-workers needs fork()')
+        for capture in ('http-ooo.pcap', 'dns+icmp.pcapng.gz'):
+            tap_args = ('-r', capture_file(capture), '-2', '-q',
+                        '-o', 'statistics.st_enable_burstinfo:FALSE',
+                        '-z', 'io,stat,1,COUNT(frame.len)frame.len,SUM(frame.len)frame.len,MAX(frame.len)frame.len',
+                        '-z', 'conv,ip', '-z', 'endpoints,udp', '-z', 'expert',
+                        '-z', 'dns,tree', '-z', 'plen,tree', '-z', 'smb,srt')
+            serial = self.assertRun((cmd_tshark,) + tap_args, env=test_env)
+            workers = self.assertRun((cmd_tshark, '--tap-workers', '4') + tap_args, env=test_env)
+            self.assertEqual(workers.stdout_str, serial.stdout_str)
+            # Burst rates and AVG and MIN columns can't be merged; the pass stays serial.
+            for tap in ('plen,tree', 'io,stat,1,AVG(frame.len)frame.len,MIN(frame.len)frame.len'):
+                tap_args = ('-r', capture_file(capture), '-2', '-q', '-z', tap)
+                serial = self.assertRun((cmd_tshark,) + tap_args, env=test_env)
+                workers = self.assertRun((cmd_tshark, '--tap-workers', '4') + tap_args, env=test_env)
+                self.assertEqual(workers.stdout_str, serial.stdout_str)
+        self.assertRun((cmd_tshark, '--tap-workers', '4', '-r', capture_file('http-ooo.pcap')),
+                       env=test_env, expected_return=self.exit_command_line)
+
+    def test_tshark_conv_top(self, cmd_tshark, capture_file, test_env):
+        '''top:<n> conversation and endpoint tables'''
+        for table in ('conv,udp', 'endpoints,ip'):
+            tap_args = ('-r', capture_file('dns+icmp.pcapng.gz'), '-q', '-z')
+            full = self.assertRun((cmd_tshark,) + tap_args + (table,), env=test_env)
+            # With room for all of them, the table is exact.
+            top = self.assertRun((cmd_tshark,) + tap_args + (table + ',top:1000',), env=test_env)
+            top_lines = [line for line in top.stdout_str.splitlines() if not line.startswith('Top 1000 ')]
+            self.assertEqual(top_lines, full.stdout_str.splitlines())
+            top = self.assertRun((cmd_tshark,) + tap_args + (table + ',top:1',), env=test_env)
+            self.assertIn('frames of dropped', top.stdout_str)
+
+    def sharkd_export_objects(self, cmd_sharkd, capture_path, env):
+        '''Returns the payloads sharkd keeps in memory for "eo:http".'''
+        def run_session(requests):
+            proc = self.startProcess((cmd_sharkd, '-'), stdin=subprocess.PIPE, env=env)
+            proc.stdin.write('\n'.join(json.dumps(r) for r in requests).encode('utf8'))
+            self.assertWaitProcess(proc)
+            return [json.loads(line) for line in proc.stdout_str.splitlines() if line.strip()]
+
+        load = {'req': 'load', 'file': capture_path}
+        tokens = []
+        for reply in run_session((load, {'req': 'tap', 'tap0': 'eo:http'})):
+            for tap in reply.get('taps', ()):
+                tokens += [obj['_download'] for obj in tap['objects']]
+        self.assertTrue(tokens)
+        downloads = [{'req': 'download', 'token': token} for token in tokens]
+        return [base64.b64decode(reply['data'])
+                for reply in run_session([load] + downloads) if 'data' in reply]
+
+    def test_tshark_export_objects(self, cmd_tshark, cmd_text2pcap, program, capture_file, test_env):
+        '''--export-objects writes the same objects as an in-memory export'''
+        # Three requests whose bodies are hello, hello, world: the first two
+        # share a spill file, which must still be written out twice.
+        hexdump = self.filename_from_id('eo_dedup.txt')
+        dedup_pcap = self.filename_from_id('eo_dedup.pcap')
+        with open(hexdump, 'w') as f:
+            for path, body in (('a', 'hello'), ('b', 'hello'), ('c', 'world')):
+                for direction, payload in (
+                        ('O', 'GET /%s HTTP/1.1\r\nHost: example.com\r\n\r\n' % path),
+                        ('I', 'HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s' % (len(body), body))):
+                    data = payload.encode('ascii')
+                    f.write(direction + '\n')
+                    for offset in range(0, len(data), 16):
+                        f.write('%06x %s\n' % (offset, ' '.join('%02x' % b for b in data[offset:offset + 16])))
+        self.assertRun((cmd_text2pcap, '-D', '-T', '1234,80', hexdump, dedup_pcap), env=test_env)
+
+        for capture_path in (capture_file('http-ooo.pcap'), dedup_pcap):
+            export_dir = tempfile.mkdtemp()
+            try:
+                self.assertRun((cmd_tshark, '-r', capture_path, '-q',
+                                '--export-objects', 'http,' + export_dir), env=test_env)
+                exported = os.listdir(export_dir)
+                self.assertFalse([name for name in exported if name.startswith('wireshark_eo_')])
+                contents = {}
+                for name in exported:
+                    with open(os.path.join(export_dir, name), 'rb') as f:
+                        contents[name] = f.read()
+            finally:
+                shutil.rmtree(export_dir)
+            self.assertEqual(sorted(contents.values()),
+                             sorted(self.sharkd_export_objects(program('sharkd'), capture_path, test_env)))
+            if capture_path == dedup_pcap:
+                self.assertEqual(contents, {'a': b'hello', 'b': b'hello', 'c': b'world'})
+
 
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
@@ -255,6 +452,14 @@ class case_tshark_z_expert(subprocesstest.SubprocessTestCase):
         self.assertTrue(self.grepOutput('Notes'))
         self.assertTrue(self.grepOutput('Comments'))
 
+    def test_tshark_z_expert_brief(self, cmd_tshark, capture_file):
+        self.assertRun((cmd_tshark, '-q', '-z', 'expert,warn,brief,tcp',
+            '-r', capture_file('http-ooo.pcap')))
+        self.assertTrue(self.grepOutput('Errors'))
+        self.assertTrue(self.grepOutput('Warns'))
+        self.assertFalse(self.grepOutput('Chats'))
+        self.assertTrue(self.grepOutput(r'This frame is a \(suspected\) out-of-order segment'))
+
     def test_tshark_z_expert_invalid_filter(self, cmd_tshark, capture_file):
         invalid_filter = '__invalid_protocol'
         self.assertRun((cmd_tshark, '-q', '-z', 'expert,' + invalid_filter,
@@ -11,7 +11,11 @@
 
 import os.path
 import shutil
+import socket
+import struct
 import subprocesstest
+import threading
+import time
 import fixtures
 
 tf_str = { True: 'TRUE', False: 'FALSE' }
@@ -54,6 +58,176 @@ def check_name_resolution(cmd_tshark, capture_file, nameres_env):
     return check_name_resolution_real
 
 
+class StandInDnsServer(threading.Thread):
+    '''A minimal DNS server on the loopback interface which answers reverse
+    (PTR) queries for IPv4 addresses from a dict, and NXDOMAIN otherwise.'''
+    def __init__(self, names):
+        super().__init__(daemon=True)
+        self.names = names
+        self.queries = []
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('127.0.0.1', 0))
+        self.sock.settimeout(0.1)
+        self.port = self.sock.getsockname()[1]
+        self.stopping = False
+
+    def run(self):
+        while not self.stopping:
+            try:
+                query, peer = self.sock.recvfrom(512)
+            except socket.timeout:
+                continue
+            response = self.respond(query)
+            if response:
+                self.sock.sendto(response, peer)
+        self.sock.close()
+
+    def stop(self):
+        self.stopping = True
+        self.join()
+
+    def respond(self, query):
+        if len(query) < 12:
+            return None
+        qid, qflags = struct.unpack('!HH', query[:4])
+        labels = []
+        pos = 12
+        while pos < len(query) and query[pos] != 0:
+            labels.append(query[pos + 1:pos + 1 + query[pos]].decode('ascii', 'replace'))
+            pos += 1 + query[pos]
+        question = query[12:pos + 5]
+        address = None
+        if labels[-2:] == ['in-addr', 'arpa'] and len(labels) == 6:
+            address = '.'.join(reversed(labels[:4]))
+            self.queries.append(address)
+        name = self.names.get(address)
+        flags = 0x8480 | (qflags & 0x0100) | (0 if name else 3)
+        response = struct.pack('!HHHHHH', qid, flags, 1, 1 if name else 0, 0, 0) + question
+        if name:
+            rdata = b''.join(bytes([len(l)]) + l.encode('ascii') for l in name.split('.')) + b'\0'
+            response += b'\xc0\x0c' + struct.pack('!HHIH', 12, 1, 3600, len(rdata)) + rdata
+        return response
+
+
+@fixtures.fixture
+def dns_standin(request):
+    server = StandInDnsServer({'192.168.43.9': 'standin-192-168-43-9.example'})
+    server.start()
+    request.addfinalizer(server.stop)
+    return server
+
+
+@fixtures.fixture
+def check_standin_resolution(cmd_tshark, capture_file, dns_standin):
+    def check_standin_resolution_real(self, *extra_args):
+        dns_standin.queries = []
+        self.assertRun((cmd_tshark, '-2',
+            '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-o', 'nameres.network_name:TRUE',
+            '-o', 'nameres.use_external_name_resolver:TRUE',
+            '-o', 'nameres.dns_pkt_addr_resolution:FALSE',
+            '-o', 'nameres.use_custom_dns_servers:TRUE',
+            '-o', 'uat:addr_resolve_dns_servers:"127.0.0.1:{}"'.format(dns_standin.port),
+            ) + extra_args)
+        self.assertTrue(self.grepOutput('standin-192-168-43-9.example'))
+        return dns_standin.queries
+    return check_standin_resolution_real
+
+
+def mmdb_encode(value):
+    '''Encode a value in the MaxMind DB data section format.'''
+    def control(type_num, size):
+        if size < 29:
+            size_bytes = b''
+        elif size < 285:
+            size_bytes = bytes([size - 29])
+            size = 29
+        else:
+            size_bytes = struct.pack('!H', size - 285)
+            size = 30
+        if type_num > 7:
+            return bytes([size]) + bytes([type_num - 7]) + size_bytes
+        return bytes([(type_num << 5) | size]) + size_bytes
+
+    def uint(type_num, value):
+        payload = value.to_bytes((value.bit_length() + 7) // 8, 'big')
+        return control(type_num, len(payload)) + payload
+
+    if isinstance(value, str):
+        payload = value.encode('utf-8')
+        return control(2, len(payload)) + payload
+    if isinstance(value, float):
+        return control(3, 8) + struct.pack('!d', value)
+    if isinstance(value, tuple):
+        # (type, int): 5 = uint16, 6 = uint32, 9 = uint64
+        return uint(*value)
+    if isinstance(value, int):
+        return uint(6, value)
+    if isinstance(value, list):
+        return control(11, len(value)) + b''.join(mmdb_encode(v) for v in value)
+    if isinstance(value, dict):
+        return control(7, len(value)) + b''.join(mmdb_encode(k) + mmdb_encode(v) for k, v in value.items())
+    raise TypeError(value)
+
+
+def write_mmdb(path, networks):
+    '''Write a minimal IPv6 MaxMind database with 32-bit records.
+    networks is a list of (IPv4 address, prefix length, data) tuples. IPv4
+    networks live under ::/96, where libmaxminddb looks for them.'''
+    nodes = [[None, None]]
+    data = b''
+    for address, prefix, value in networks:
+        address = int.from_bytes(socket.inet_aton(address), 'big')
+        bits = 96 + prefix
+        node = 0
+        for bit in range(bits):
+            branch = (address >> (127 - bit)) & 1 if bit >= 96 else 0
+            if bit == bits - 1:
+                nodes[node][branch] = ('data', len(data))
+            else:
+                if nodes[node][branch] is None:
+                    nodes.append([None, None])
+                    nodes[node][branch] = ('node', len(nodes) - 1)
+                node = nodes[node][branch][1]
+        data += mmdb_encode(value)
+
+    node_count = len(nodes)
+    def record(rec):
+        if rec is None:
+            return node_count
+        if rec[0] == 'node':
+            return rec[1]
+        return node_count + 16 + rec[1]
+
+    tree = b''.join(struct.pack('!II', record(l), record(r)) for l, r in nodes)
+    metadata = {
+        'node_count': node_count,
+        'record_size': (5, 32),
+        'ip_version': (5, 6),
+        'database_type': 'Wireshark-Test',
+        'languages': ['en'],
+        'binary_format_major_version': (5, 2),
+        'binary_format_minor_version': (5, 0),
+        'build_epoch': (9, 1500000000),
+        'description': {'en': 'Wireshark test database'},
+    }
+    with open(path, 'wb') as mmdb_file:
+        mmdb_file.write(tree + b'\0' * 16 + data)
+        mmdb_file.write(b'\xab\xcd\xefMaxMind.com' + mmdb_encode(metadata))
+
+
+def write_ipv4_pcap(path, addresses):
+    '''Write one raw IPv4/UDP packet per source address.'''
+    with open(path, 'wb') as pcap_file:
+        # LINKTYPE_RAW
+        pcap_file.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 101))
+        for num, address in enumerate(addresses):
+            udp = struct.pack('!HHHH', 1024, 9, 8, 0)
+            ip = struct.pack('!BBHHHBBH4s4s', 0x45, 0, 20 + len(udp), num & 0xffff, 0, 64, 17, 0,
+                socket.inet_aton(address), socket.inet_aton('192.0.2.1')) + udp
+            pcap_file.write(struct.pack('<IIII', num, 0, len(ip), len(ip)) + ip)
+
+
 @fixtures.mark_usefixtures('test_env')
 @fixtures.uses_fixtures
 class case_name_resolution(subprocesstest.SubprocessTestCase):
@@ -129,3 +303,74 @@ class case_name_resolution(subprocesstest.SubprocessTestCase):
                 ))
         self.assertTrue(self.grepOutput('fe80::6233:4bff:fe13:c558\tCrunch.local'))
         self.assertFalse(self.grepOutput('174.137.42.65\twww.wireshark.org'))
+
+    def test_name_resolution_services(self, cmd_tshark, capture_file, conf_path, test_env):
+        '''Port names come from the built-in services table unless the personal file overrides them.'''
+        tshark_cmd = (cmd_tshark,
+            '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-N', 't',
+            '-o', 'gui.column.format:"Source port","%rS"',
+            )
+        self.assertRun(tshark_cmd, env=test_env)
+        self.assertTrue(self.grepOutput(r'\bdomain\b'))
+        with open(os.path.join(conf_path, 'services'), 'w') as services_file:
+            services_file.write('personal-dns\t53/udp\n')
+        self.assertRun(tshark_cmd, env=test_env)
+        self.assertTrue(self.grepOutput('personal-dns'))
+        self.assertFalse(self.grepOutput(r'\bdomain\b'))
+
+    def test_name_resolution_two_pass_prefetch(self, check_standin_resolution):
+        '''Two-pass analysis looks each address up once, in the first pass.'''
+        queries = check_standin_resolution(self)
+        self.assertEqual(queries.count('192.168.43.9'), 1)
+        self.assertEqual(queries.count('192.168.43.1'), 1)
+
+    def test_name_resolution_dns_cache(self, check_standin_resolution, conf_path):
+        '''Names and missing names are remembered between runs.'''
+        queries = check_standin_resolution(self, '-o', 'nameres.use_dns_cache:TRUE')
+        self.assertIn('192.168.43.9', queries)
+        self.assertIn('192.168.43.1', queries)
+        self.assertTrue(os.path.isfile(os.path.join(conf_path, 'dns_cache')))
+        queries = check_standin_resolution(self, '-o', 'nameres.use_dns_cache:TRUE')
+        self.assertNotIn('192.168.43.9', queries)
+        self.assertNotIn('192.168.43.1', queries)
+
+    def test_name_resolution_maxmind_db(self, cmd_tshark, features, home_path, test_env):
+        '''MaxMind lookups in-process, timed against the mmdbresolve pipe.'''
+        if not features.have_maxminddb:
+            self.skipTest('Requires MaxMind DB support.')
+        mmdb_dir = os.path.join(home_path, 'mmdb')
+        os.makedirs(mmdb_dir)
+        # One network per /24 and many unique hosts in each.
+        write_mmdb(os.path.join(mmdb_dir, 'test.mmdb'), [
+            ('10.0.{}.0'.format(net), 24, {
+                'city': {'names': {'en': 'City {}'.format(net)}},
+                'country': {'iso_code': 'C{}'.format(net % 10), 'names': {'en': 'Country {}'.format(net % 10)}},
+                'autonomous_system_number': 64512 + net,
+                'autonomous_system_organization': 'Org {}'.format(net),
+                'location': {'latitude': float(net % 90), 'longitude': float(net), 'accuracy_radius': (5, 100)},
+            }) for net in range(256)])
+        addresses = ['10.0.{}.{}'.format(num % 256, num // 256 + 1) for num in range(256 * 32)]
+        pcap_path = os.path.join(home_path, 'mmdb.pcap')
+        write_ipv4_pcap(pcap_path, addresses)
+
+        timings = {}
+        for in_process in (True, False):
+            start = time.perf_counter()
+            proc = self.assertRun((cmd_tshark,
+                '-r', pcap_path,
+                '-o', 'uat:maxmind_db_paths:"{}"'.format(mmdb_dir),
+                '-o', 'nameres.maxmind_db_in_process:' + tf_str[in_process],
+                '-T', 'fields', '-e', 'ip.src', '-e', 'ip.geoip.src_city', '-e', 'ip.geoip.src_asnum',
+                ), env=test_env)
+            timings[in_process] = time.perf_counter() - start
+            if in_process:
+                # Results from the pipe arrive asynchronously; only in-process
+                # lookups are guaranteed to be in the first dissection.
+                lines = proc.stdout_str.splitlines()
+                self.assertEqual(len(lines), len(addresses))
+                for line, address in zip(lines, addresses):
+                    net = int(address.split('.')[2])
+                    self.assertEqual(line.split('\t'), [address, 'City {}'.format(net), str(64512 + net)])
+        self.log_fd.write('MaxMind lookups for {} addresses: {:.3f}s in-process, {:.3f}s mmdbresolve\n'.format(
+            len(addresses), timings[True], timings[False]))
@@ -10,9 +10,11 @@
 
 import json
 import os.path
+import subprocess
 import subprocesstest
 import fixtures
 from matchers import *
+from util_cbor import cbor_decode_items
 
 
 @fixtures.fixture
@@ -93,3 +95,97 @@ class case_outputformats(subprocesstest.SubprocessTestCase):
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True)
+
+    def test_outputformat_columnar(self, cmd_tshark, capture_file, base_env):
+        '''Checks typed columns and list columns with -Tcolumnar.'''
+        # The output is binary, so don't go through assertRun.
+        proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+                               '-T', 'columnar', '-e', 'frame.number',
+                               '-e', 'frame.time', '-e', 'ip.addr',
+                               '-e', 'dhcp.hw.mac_addr'],
+            stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=base_env)
+        self.assertEqual(proc.returncode, 0)
+        # The stream is a sequence of CBOR items, terminate it for the decoder.
+        items = cbor_decode_items(proc.stdout + b'\xf7')
+        self.assertEqual(items, [[
+            {"version": 1, "fields": [
+                {"name": "frame.number", "type": "uint32", "ftype": "FT_FRAMENUM"},
+                {"name": "frame.time", "type": "timestamp_ns", "ftype": "FT_ABSOLUTE_TIME"},
+                {"name": "ip.addr", "type": "uint32", "ftype": "FT_IPv4"},
+                {"name": "dhcp.hw.mac_addr", "type": "string", "ftype": "FT_ETHER"},
+            ]},
+            {"rows": 4, "columns": [
+                {"offsets": [0, 1, 2, 3, 4], "values": [1, 2, 3, 4]},
+                {"offsets": [0, 1, 2, 3, 4], "values": [
+                    1102274184317453000, 1102274184317748000,
+                    1102274184387484000, 1102274184387798000]},
+                {"offsets": [0, 2, 4, 6, 8], "values": [
+                    0, 4294967295, 3232235521, 3232235530,
+                    0, 4294967295, 3232235521, 3232235530]},
+                {"offsets": [0, 1, 2, 3, 4], "dictionary": ["00:0b:82:01:fc:42"],
+                 "values": [0, 0, 0, 0]},
+            ]},
+        ]])
+
+    def test_outputformat_bintree(self, cmd_tshark, capture_file, base_env):
+        '''Decodes the binary protocol trees written with -Tbintree.'''
+        proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'), '-T', 'bintree'],
+            stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=base_env)
+        self.assertEqual(proc.returncode, 0)
+        data = proc.stdout
+        self.assertEqual(data[:5], b'WSPT\x01')
+        pos = 5
+
+        def varint():
+            nonlocal pos
+            value = shift = 0
+            while True:
+                b = data[pos]
+                pos += 1
+                value |= (b & 0x7f) << shift
+                shift += 7
+                if not b & 0x80:
+                    return value
+
+        def blob():
+            nonlocal pos
+            length = varint()
+            pos += length
+            return data[pos - length:pos]
+
+        fields = []
+        packets = []
+        while pos < len(data):
+            record = varint()
+            if record == 1:
+                self.assertEqual(varint(), len(fields))
+                ftype, kind, abbrev = varint(), varint(), blob().decode()
+                fields.append((abbrev, kind))
+                continue
+            self.assertEqual(record, 2)
+            frame_num, node_count = varint(), varint()
+            values = {}
+            for _ in range(node_count):
+                abbrev, kind = fields[varint()]
+                varint(), varint(), varint()    # children, start, length
+                if kind in (1, 2):
+                    value = varint()
+                elif kind == 3:
+                    value = data[pos:pos + 8]
+                    pos += 8
+                elif kind == 4:
+                    value = (varint(), varint())
+                elif kind in (5, 6):
+                    value = blob()
+                else:
+                    value = None
+                values.setdefault(abbrev, value)
+            packets.append((frame_num, values))
+
+        self.assertEqual([p[0] for p in packets], [1, 2, 3, 4])
+        first = packets[0][1]
+        self.assertEqual(first['frame.number'], 1)
+        self.assertEqual(first['ip.dst'], 4294967295)
+        self.assertEqual(first['udp.dstport'], 67)
+        self.assertEqual(first['dhcp.hw.mac_addr'], bytes.fromhex('000b8201fc42'))
+        self.assertIn('dhcp', first)
@@ -15,6 +15,7 @@ import unittest
 import subprocesstest
 import fixtures
 from matchers import *
+from util_cbor import cbor_decode_items
 
 
 @fixtures.fixture(scope='session')
@@ -170,6 +171,65 @@ class case_sharkd(subprocesstest.SubprocessTestCase):
             }),
         ))
 
+    def test_sharkd_req_frames_paged(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames", "skip": 2, "limit": 1},
+            {"req": "frames", "filter": "frame.number != 2", "skip": 1, "limit": 1},
+            {"req": "frames", "filter": "frame.number != 2", "skip": 2},
+            {"req": "frames", "filter": "frame.number != 2", "skip": 3},
+        ), (
+            {"err": 0},
+            [MatchObject({"num": 3})],
+            [MatchObject({"num": 3})],
+            [MatchObject({"num": 4})],
+            [],
+        ))
+
+    def test_sharkd_req_stats(self, check_sharkd_session, capture_file):
+        '''Second frames request should be served from the row cache.'''
+        check_sharkd_session((
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames"},
+            {"req": "frames"},
+            {"req": "stats"},
+        ), (
+            {"err": 0},
+            MatchList(MatchObject({"c": MatchList(MatchAny(str))}), n=4),
+            MatchList(MatchObject({"c": MatchList(MatchAny(str))}), n=4),
+            {
+                "reqs": MatchList(MatchObject({
+                    "req": "frames",
+                    "count": 2,
+                    "hist": MatchList(MatchAny(int)),
+                }), match_element=any),
+                "cache": {"entries": 4, "max": MatchAny(int), "hits": 4, "misses": 4},
+            },
+        ))
+
+    def test_sharkd_req_setformat_cbor(self, cmd_sharkd, capture_file, base_env):
+        '''CBOR replies should carry the same data as JSON replies.'''
+        commands = (
+            {"req": "load", "file": capture_file('dhcp.pcap')},
+            {"req": "frames"},
+            {"req": "setformat", "format": "cbor"},
+            {"req": "frames"},
+            {"req": "status"},
+        )
+        proc = subprocess.run((cmd_sharkd, '-'),
+            input='\n'.join(json.dumps(x) for x in commands).encode('utf8'),
+            stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=base_env)
+        self.assertEqual(proc.returncode, 0)
+
+        # load, frames and setformat replies are JSON, separated by empty lines.
+        _, json_frames, json_setformat, cbor_part = proc.stdout.split(b'\n\n', 3)
+        json_frames = json.loads(json_frames)
+        self.assertEqual(json.loads(json_setformat), {"err": 0})
+        self.assertEqual(cbor_decode_items(cbor_part), [
+            [json_frames],
+            [{"frames": 4, "duration": 0.070345000, "filename": "dhcp.pcap", "filesize": 1400}],
+        ])
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
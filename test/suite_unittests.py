@@ -20,18 +20,46 @@ import fixtures
 
 @fixtures.uses_fixtures
 class case_unittests(subprocesstest.SubprocessTestCase):
+    def test_unit_charsets_test(self, program, base_env):
+        '''charsets_test'''
+        self.assertRun(program('charsets_test'), env=base_env)
+
+    def test_unit_checksum_test(self, program, base_env):
+        '''checksum_test'''
+        self.assertRun(program('checksum_test'), env=base_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         self.assertRun(program('exntest'), env=base_env)
 
+    def test_unit_field_index_test(self, program, base_env):
+        '''field_index_test'''
+        self.assertRun(program('field_index_test'), env=base_env)
+
+    def test_unit_follow_test(self, program, capture_file, base_env):
+        '''follow_test'''
+        self.assertRun((program('follow_test'), capture_file('tls12-chacha20poly1305.pcap')), env=base_env)
+
+    def test_unit_io_graph_item_test(self, program, base_env):
+        '''io_graph_item_test'''
+        self.assertRun(program('io_graph_item_test'), env=base_env)
+
     def test_unit_oids_test(self, program, base_env):
         '''oids_test'''
         self.assertRun(program('oids_test'), env=base_env)
 
+    def test_unit_proto_tree_bin_test(self, program, base_env):
+        '''proto_tree_bin_test'''
+        self.assertRun(program('proto_tree_bin_test'), env=base_env)
+
     def test_unit_reassemble_test(self, program, base_env):
         '''reassemble_test'''
         self.assertRun(program('reassemble_test'), env=base_env)
 
+    def test_unit_stats_tree_test(self, program, base_env):
+        '''stats_tree_test'''
+        self.assertRun(program('stats_tree_test'), env=base_env)
+
     def test_unit_tvbtest(self, program, base_env):
         '''tvbtest'''
         self.assertRun(program('tvbtest'), env=base_env)
@@ -0,0 +1,85 @@
+#
+# -*- coding: utf-8 -*-
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Decoding of the CBOR replies of sharkd, shared by the tests and tools/sharkd_format_bench.py.'''
+
+import struct
+
+
+def cbor_decode_items(data):
+    '''Decodes a sequence of CBOR data items, as used by "setformat" "cbor".'''
+    pos = 0
+    BREAK = object()
+    UNDEFINED = object()
+
+    def read_head():
+        nonlocal pos
+        initial = data[pos]
+        pos += 1
+        major, info = initial >> 5, initial & 0x1f
+        if info < 24:
+            return major, info
+        if info == 31:
+            return major, None
+        size = 1 << (info - 24)
+        value = int.from_bytes(data[pos:pos + size], 'big')
+        pos += size
+        return major, value
+
+    def read_item():
+        nonlocal pos
+        if data[pos] == 0xff:
+            pos += 1
+            return BREAK
+        if data[pos] == 0xfb:
+            value = struct.unpack('>d', data[pos + 1:pos + 9])[0]
+            pos += 9
+            return value
+        major, value = read_head()
+        if major == 0:
+            return value
+        if major == 1:
+            return -1 - value
+        if major in (2, 3):
+            if value is None:
+                chunks = []
+                while True:
+                    chunk = read_item()
+                    if chunk is BREAK:
+                        break
+                    chunks.append(chunk)
+                return (b'' if major == 2 else '').join(chunks)
+            raw = data[pos:pos + value]
+            pos += value
+            return raw if major == 2 else raw.decode('utf8')
+        if major == 4:
+            items = []
+            while value is None or len(items) < value:
+                item = read_item()
+                if item is BREAK:
+                    break
+                items.append(item)
+            return items
+        if major == 5:
+            obj = {}
+            while value is None or len(obj) < value:
+                key = read_item()
+                if key is BREAK:
+                    break
+                obj[key] = read_item()
+            return obj
+        return {20: False, 21: True, 22: None, 23: UNDEFINED}[value]
+
+    replies = []
+    reply = []
+    while pos < len(data):
+        item = read_item()
+        if item is UNDEFINED:
+            replies.append(reply)
+            reply = []
+        else:
+            reply.append(item)
+    return replies
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+# Compare how long TShark takes to dissect captures of common protocols
+# when only the columns are printed, when one field is and when the whole
+# tree is.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''\
+Run TShark over each capture three ways, and report the best time of
+several runs:
+
+    columns  only the columns are printed; no protocol tree is built, so
+             proto_tree_add_*() return at once
+    fields   one field is printed with -T fields; a tree is built but every
+             other item is faked, and there are no columns to fill in
+    tree     the whole tree is printed with -V
+
+The time TShark takes to start up, measured on an empty capture, is taken
+off, so that small captures can be compared too.
+
+Give more than one --tshark to compare builds, e.g. before and after a
+change to proto.c or column-utils.c.
+
+Example:
+    dissect_columns_bench.py --tshark old/run/tshark --tshark run/tshark
+    dissect_columns_bench.py --repeat 10 big-http.pcapng big-dns.pcapng
+'''
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+CAPTURE_DIR = os.path.join(os.path.dirname(__file__), '..', 'test', 'captures')
+
+# One capture per protocol, from test/captures
+DEFAULT_CAPTURES = (
+    'arp.pcap',
+    'dhcp.pcap',
+    'dns+icmp.pcapng.gz',
+    'http.pcap',
+    'http2-data-reassembly.pcap',
+    'nfs.pcap',
+    'sip.pcapng',
+    'tls12-chacha20poly1305.pcap',
+    'wpa-Induction.pcap.gz',
+)
+
+MODES = (
+    ('columns', ()),
+    ('fields', ('-T', 'fields', '-e', 'frame.len')),
+    ('tree', ('-V',)),
+)
+
+
+def best_time(tshark, capture, args, repeat):
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.run((tshark, '-r', capture) + args,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--tshark', action='append', help='tshark binary (default: tshark)')
+    parser.add_argument('--repeat', type=int, default=5, help='number of runs per capture and mode')
+    parser.add_argument('captures', nargs='*', help='capture files (default: some from test/captures)')
+    args = parser.parse_args()
+
+    tsharks = args.tshark or ['tshark']
+    captures = args.captures or [os.path.join(CAPTURE_DIR, c) for c in DEFAULT_CAPTURES]
+    empty = os.path.join(CAPTURE_DIR, 'empty.pcap')
+
+    print('%-32s %-8s %s' % ('capture', 'mode',
+                             ' '.join('%14s' % ('build %d (ms)' % (i + 1)) for i in range(len(tsharks)))))
+    startup = [best_time(tshark, empty, (), args.repeat) for tshark in tsharks]
+    for capture in captures:
+        if not os.path.exists(capture):
+            sys.stderr.write('%s: not found\n' % capture)
+            continue
+        for mode, mode_args in MODES:
+            times = [best_time(tshark, capture, mode_args, args.repeat) - startup[i]
+                     for i, tshark in enumerate(tsharks)]
+            print('%-32s %-8s %s' % (os.path.basename(capture)[:32], mode,
+                                     ' '.join('%14.1f' % (t * 1000) for t in times)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+'''Compile the "manuf", "wka" and "services" files into C tables.
+
+Usage: make-addr-resolv-tables.py manuf wka services output.c
+
+The files are parsed the same way epan/addr_resolv.c parses them, with later
+entries overriding earlier ones, and written out as arrays sorted by address
+or port so that they can be searched with bsearch() instead of being loaded
+into hash tables at startup.
+'''
+
+import re
+import sys
+
+MAXNAMELEN = 64
+
+def exit_msg(msg=None, status=1):
+    if msg is not None:
+        sys.stderr.write(msg + '\n\n')
+    sys.stderr.write(__doc__ + '\n')
+    sys.exit(status)
+
+def strtok(s, pos, delims):
+    '''Return the next token of s at or after pos and the position after its
+    delimiter, like strtok(3).'''
+    while pos < len(s) and s[pos] in delims:
+        pos += 1
+    if pos >= len(s):
+        return None, pos
+    end = pos
+    while end < len(s) and s[end] not in delims:
+        end += 1
+    return s[pos:end], end + 1
+
+def truncate(name):
+    '''Truncate a name as g_strlcpy(..., MAXNAMELEN) would.'''
+    return name[:MAXNAMELEN - 1]
+
+def parse_ether_address(cp):
+    '''Port of parse_ether_address() with accept_mask set. Returns a list
+    of six octets and the mask (0 for an OUI, 48 for a full address).'''
+    addr = [0] * 6
+    sep = None
+    pos = 0
+    for i in range(6):
+        m = re.match(rb'[0-9A-Fa-f]+', cp[pos:])
+        if not m:
+            return None
+        num = int(m.group(0), 16)
+        if num > 0xFF:
+            return None
+        addr[i] = num
+        pos += len(m.group(0))
+
+        if cp[pos:pos + 1] == b'/':
+            m = re.match(rb'[0-9]+$', cp[pos + 1:])
+            if not m:
+                return None
+            mask = num = int(m.group(0))
+            if num == 0 or num >= 48:
+                return None
+            i = 0
+            while num >= 8:
+                i += 1
+                num -= 8
+            addr[i] &= (0xFF << (8 - num)) & 0xFF
+            for j in range(i + 1, 6):
+                addr[j] = 0
+            return addr, mask
+        if pos == len(cp):
+            if i == 2:
+                return addr, 0
+            if i == 5:
+                return addr, 48
+            return None
+        if sep is None:
+            if cp[pos:pos + 1] not in (b':', b'-', b'.'):
+                return None
+            sep = cp[pos:pos + 1]
+        elif cp[pos:pos + 1] != sep:
+            return None
+        pos += 1
+    # Trailing separator after six octets
+    return None
+
+def parse_ether_file(path, manuf, wka, ethers):
+    with open(path, 'rb') as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith(b'#'):
+                continue
+            line = line.split(b'#', 1)[0].rstrip()
+
+            token, pos = strtok(line, 0, b' \t')
+            if token is None:
+                continue
+            parsed = parse_ether_address(token)
+            if parsed is None:
+                continue
+            addr, mask = parsed
+
+            name, pos = strtok(line, pos, b' \t')
+            if name is None:
+                continue
+            longname, pos = strtok(line, pos, b'\t')
+            if longname is None:
+                longname = name
+            name = truncate(name)
+            longname = truncate(longname)
+
+            if mask == 0:
+                manuf[(addr[0] << 16) | (addr[1] << 8) | addr[2]] = (name, longname)
+            else:
+                key = 0
+                for octet in addr:
+                    key = (key << 8) | octet
+                if mask == 48:
+                    ethers[key] = name
+                else:
+                    wka[key] = name
+
+def parse_services_file(path, services):
+    protos = ('tcp', 'udp', 'sctp', 'dccp')
+    with open(path, 'rb') as f:
+        for line in f:
+            line = line.rstrip(b'\r\n').split(b'#', 1)[0]
+
+            service, pos = strtok(line, 0, b' \t')
+            if service is None:
+                continue
+            port, pos = strtok(line, pos, b' \t')
+            if port is None:
+                continue
+            fields = port.split(b'/')
+            ports = []
+            try:
+                for port_range in fields[0].split(b','):
+                    low, _, high = port_range.strip().partition(b'-')
+                    low = int(low)
+                    high = int(high) if high else low
+                    if low > high or high > 0xFFFF:
+                        raise ValueError
+                    ports.extend(range(low, high + 1))
+            except ValueError:
+                continue
+
+            for proto in [p for p in fields[1:] if p]:
+                proto = proto.decode('ascii', 'replace')
+                if proto not in protos:
+                    break
+                for p in ports:
+                    if p:
+                        services.setdefault(p, {})[proto] = service
+
+def c_string(s):
+    if s is None:
+        return 'NULL'
+    out = '"'
+    for b in s:
+        c = chr(b)
+        if c in '"\\?':
+            out += '\\' + c
+        elif 0x20 <= b < 0x7F:
+            out += c
+        else:
+            out += '\\%03o' % b
+    return out + '"'
+
+def main():
+    if len(sys.argv) != 5:
+        exit_msg()
+
+    manuf = {}
+    wka = {}
+    ethers = {}
+    services = {}
+
+    # Same order as initialize_ethers() used to read them.
+    parse_ether_file(sys.argv[1], manuf, wka, ethers)
+    parse_ether_file(sys.argv[2], manuf, wka, ethers)
+    parse_services_file(sys.argv[3], services)
+
+    out = []
+    out.append('''\
+/* DO NOT EDIT
+ *
+ * Created by make-addr-resolv-tables.py from the manuf, wka and services
+ * files.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include "addr_resolv-int.h"
+''')
+
+    out.append('const builtin_manuf_t builtin_manuf[] = {')
+    for oui in sorted(manuf):
+        name, longname = manuf[oui]
+        out.append('    { 0x%06X, %s, %s },' % (oui, c_string(name), c_string(longname)))
+    out.append('};\n')
+    out.append('const guint builtin_manuf_count = G_N_ELEMENTS(builtin_manuf);\n')
+
+    for table, entries in (('builtin_wka', wka), ('builtin_ethers', ethers)):
+        out.append('const builtin_eth_t %s[] = {' % table)
+        for key in sorted(entries):
+            out.append('    { G_GUINT64_CONSTANT(0x%012X), %s },' % (key, c_string(entries[key])))
+        out.append('};\n')
+        out.append('const guint %s_count = G_N_ELEMENTS(%s);\n' % (table, table))
+
+    out.append('const builtin_serv_t builtin_services[] = {')
+    for port in sorted(services):
+        names = services[port]
+        out.append('    { %5u, %s, %s, %s, %s },' % (port,
+            c_string(names.get('tcp')), c_string(names.get('udp')),
+            c_string(names.get('sctp')), c_string(names.get('dccp'))))
+    out.append('};\n')
+    out.append('const guint builtin_services_count = G_N_ELEMENTS(builtin_services);')
+
+    with open(sys.argv[4], 'w') as f:
+        f.write('\n'.join(out) + '\n')
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# Compare sharkd reply sizes and end-to-end latency for JSON and CBOR
+# encodings (see the "setformat" request in sharkd_session.c).
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''\
+Run the same requests against sharkd once with JSON replies and once with
+CBOR replies, and report reply size, time until the reply was received and
+time needed to decode it in Python.
+
+Example:
+    sharkd_format_bench.py --sharkd run/sharkd big.pcapng
+    sharkd_format_bench.py big.pcapng '{"req":"tap","tap0":"conv:TCP"}'
+'''
+
+import argparse
+import json
+import os
+import struct
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'test'))
+from util_cbor import cbor_decode_items
+
+
+def read_json_reply(stream):
+    data = b''
+    while True:
+        line = stream.readline()
+        if not line:
+            raise EOFError('sharkd terminated')
+        if line == b'\n':
+            return data
+        data += line
+
+
+def read_cbor_reply(stream):
+    # Replies are terminated by the undefined simple value (0xf7). Read
+    # greedily and let the decoder find the boundary, as 0xf7 can appear in
+    # payload bytes.
+    data = b''
+    while True:
+        chunk = stream.read1(1 << 16)
+        if not chunk:
+            raise EOFError('sharkd terminated')
+        data += chunk
+        if data.endswith(b'\xf7'):
+            try:
+                cbor_decode_items(data)
+                return data
+            except (IndexError, KeyError, struct.error):
+                continue
+
+
+def run(sharkd, capture, requests, fmt):
+    proc = subprocess.Popen((sharkd, '-'), stdin=subprocess.PIPE,
+                            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+
+    def send(req):
+        proc.stdin.write(json.dumps(req).encode('utf8') + b'\n')
+        proc.stdin.flush()
+
+    send({'req': 'load', 'file': capture})
+    read_json_reply(proc.stdout)
+    send({'req': 'setformat', 'format': fmt})
+    read_json_reply(proc.stdout)
+
+    results = []
+    for req in requests:
+        start = time.perf_counter()
+        send(req)
+        if fmt == 'cbor':
+            data = read_cbor_reply(proc.stdout)
+        else:
+            data = read_json_reply(proc.stdout)
+        received = time.perf_counter()
+        if fmt == 'cbor':
+            cbor_decode_items(data)
+        else:
+            for line in data.splitlines():
+                json.loads(line)
+        decoded = time.perf_counter()
+        results.append((req['req'], len(data), received - start, decoded - received))
+
+    proc.stdin.close()
+    proc.wait()
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--sharkd', default='sharkd', help='sharkd binary')
+    parser.add_argument('--repeat', type=int, default=3, help='number of runs per encoding')
+    parser.add_argument('capture', help='capture file to load')
+    parser.add_argument('requests', nargs='*', help='JSON requests (default: all frames)')
+    args = parser.parse_args()
+
+    requests = [json.loads(r) for r in args.requests] or [{'req': 'frames'}]
+    capture = os.path.abspath(args.capture)
+
+    print('%-6s %-10s %12s %12s %12s' % ('format', 'req', 'bytes', 'reply (s)', 'decode (s)'))
+    for fmt in ('json', 'cbor'):
+        best = None
+        for _ in range(args.repeat):
+            results = run(args.sharkd, capture, requests, fmt)
+            if best is None:
+                best = results
+            else:
+                best = [min(a, b, key=lambda r: r[2] + r[3]) for a, b in zip(best, results)]
+        for name, size, reply_time, decode_time in best:
+            print('%-6s %-10s %12d %12.3f %12.3f' % (fmt, name, size, reply_time, decode_time))
+
+
+if __name__ == '__main__':
+    main()
@@ -37,6 +37,8 @@ setcomment
 setconf
 dumpconf
 download
+stats
+setformat
 bye
 """.split()
 all_commands += """
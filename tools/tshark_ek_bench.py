@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# Time TShark's -T ek and -T json output (see wsutil/json_dumper.c).
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''\
+Run TShark over each capture with -T ek and -T json, and with -T ek -l,
+which flushes after every packet instead of writing out a large buffer,
+and report the best time of several runs and the size of the output.
+The time TShark takes to start up, measured on an empty capture, is taken
+off.
+
+The output goes to a temporary file rather than a pipe, so that the
+reader doesn't slow TShark down. Give more than one --tshark to compare
+builds, e.g. before and after a change to json_dumper.c.
+
+Example:
+    tshark_ek_bench.py --tshark old/run/tshark --tshark run/tshark big.pcapng
+'''
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+CAPTURE_DIR = os.path.join(os.path.dirname(__file__), '..', 'test', 'captures')
+
+DEFAULT_CAPTURES = (
+    'dns+icmp.pcapng.gz',
+    'http.pcap',
+    'sip.pcapng',
+    'tls12-chacha20poly1305.pcap',
+)
+
+MODES = (
+    ('ek', ('-T', 'ek')),
+    ('ek -l', ('-T', 'ek', '-l')),
+    ('json', ('-T', 'json')),
+)
+
+
+def best_time(tshark, capture, args, repeat):
+    best = None
+    size = 0
+    for _ in range(repeat):
+        with tempfile.TemporaryFile() as out_f:
+            start = time.perf_counter()
+            subprocess.run((tshark, '-r', capture) + args,
+                           stdout=out_f, stderr=subprocess.DEVNULL)
+            elapsed = time.perf_counter() - start
+            size = out_f.tell()
+        if best is None or elapsed < best:
+            best = elapsed
+    return best, size
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--tshark', action='append', help='tshark binary (default: tshark)')
+    parser.add_argument('--repeat', type=int, default=5, help='number of runs per capture and mode')
+    parser.add_argument('captures', nargs='*', help='capture files (default: some from test/captures)')
+    args = parser.parse_args()
+
+    tsharks = args.tshark or ['tshark']
+    captures = args.captures or [os.path.join(CAPTURE_DIR, c) for c in DEFAULT_CAPTURES]
+    empty = os.path.join(CAPTURE_DIR, 'empty.pcap')
+
+    print('%-32s %-6s %12s %s' % ('capture', 'mode', 'bytes',
+                                  ' '.join('%14s' % ('build %d (ms)' % (i + 1)) for i in range(len(tsharks)))))
+    startup = [best_time(tshark, empty, (), args.repeat)[0] for tshark in tsharks]
+    for capture in captures:
+        if not os.path.exists(capture):
+            sys.stderr.write('%s: not found\n' % capture)
+            continue
+        for mode, mode_args in MODES:
+            results = [best_time(tshark, capture, mode_args, args.repeat) for tshark in tsharks]
+            print('%-32s %-6s %12d %s' % (os.path.basename(capture)[:32], mode, results[-1][1],
+                                          ' '.join('%14.1f' % ((t - startup[i]) * 1000)
+                                                   for i, (t, _) in enumerate(results))))
+
+
+if __name__ == '__main__':
+    main()
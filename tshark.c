@@ -30,6 +30,8 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #endif
 
 #ifndef HAVE_GETOPT_LONG
@@ -66,6 +68,7 @@
 #include <epan/column.h>
 #include <epan/decode_as.h>
 #include <epan/print.h>
+#include <epan/proto_tree_bin.h>
 #include <epan/addr_resolv.h>
 #ifdef HAVE_LIBPCAP
 #include "ui/capture_ui_utils.h"
@@ -116,6 +119,10 @@
 
 #include "extcap.h"
 
+#ifndef _WIN32
+#include "tshark_zygote.h"
+#endif
+
 #ifdef HAVE_PLUGINS
 #include <wsutil/plugins.h>
 #endif
@@ -137,6 +144,15 @@
 #define LONGOPT_COLOR                   LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_NO_DUPLICATE_KEYS       LONGOPT_BASE_APPLICATION+3
 #define LONGOPT_ELASTIC_MAPPING_FILTER  LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_STARTUP_PROFILE         LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_ZYGOTE                  LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_TAP_WORKERS             LONGOPT_BASE_APPLICATION+7
+
+/* Size of the standard output buffer used for JSON and EK output */
+#define JSON_STDOUT_BUFSIZE (256 * 1024)
+
+/* How many packets of the first pass to go between host_name_lookup_process() calls */
+#define PREFETCH_PROCESS_INTERVAL 64
 
 #if 0
 #define tshark_debug(...) g_warning(__VA_ARGS__)
@@ -164,7 +180,9 @@ typedef enum {
   WRITE_FIELDS, /* User defined list of fields */
   WRITE_JSON,   /* JSON */
   WRITE_JSON_RAW,   /* JSON only raw hex */
-  WRITE_EK      /* JSON bulk insert to Elasticsearch */
+  WRITE_EK,     /* JSON bulk insert to Elasticsearch */
+  WRITE_COLUMNAR, /* User defined list of fields, as typed CBOR columns */
+  WRITE_BINTREE  /* Binary protocol trees */
   /* Add CSV and the like here */
 } output_action_e;
 
@@ -189,10 +207,35 @@ static gchar **protocolfilter = NULL;
 static pf_flags protocolfilter_flags = PF_NONE;
 
 static gboolean no_duplicate_keys = FALSE;
+
+/* --startup-profile: time spent in each phase of startup */
+#define STARTUP_PROFILE_MAX_PHASES 8
+#define STARTUP_PROFILE_MAX_ROUTINES 25
+static gboolean startup_profile = FALSE;
+static gint64 startup_profile_last;
+static guint startup_profile_n_phases;
+static struct {
+  const char *name;
+  gint64 usecs;
+} startup_profile_phases[STARTUP_PROFILE_MAX_PHASES];
+
+#ifndef _WIN32
+/* --zygote: socket to listen on for jobs */
+static const char *zygote_socket = NULL;
+#endif
+static gboolean in_zygote_job = FALSE;
+
+#ifndef _WIN32
+/* --tap-workers: number of processes running the taps in the second pass */
+static guint tap_workers = 1;
+#endif
+
 static proto_node_children_grouper_func node_children_grouper = proto_node_group_children_by_unique;
 
 static json_dumper jdumper;
 
+static proto_tree_bin_writer_t *bintree_writer = NULL;
+
 /* The line separator used between packets, changeable via the -S option */
 static const char *separator = "";
 
@@ -427,7 +470,7 @@ print_usage(FILE *output)
   fprintf(output, "  -P, --print              print packet summary even when writing to a file\n");
   fprintf(output, "  -S <separator>           the line separator to print between packets\n");
   fprintf(output, "  -x                       add output of hex and ASCII dump (Packet Bytes)\n");
-  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|?\n");
+  fprintf(output, "  -T pdml|ps|psml|json|jsonraw|ek|tabs|text|fields|columnar|bintree|?\n");
   fprintf(output, "                           format of text output (def: text)\n");
   fprintf(output, "  -j <protocolfilter>      protocols layers filter if -T ek|pdml|json selected\n");
   fprintf(output, "                           (e.g. \"ip ip.flags text\", filter does not expand child\n");
@@ -469,6 +512,14 @@ print_usage(FILE *output)
   fprintf(output, "                           values\n");
   fprintf(output, "  --elastic-mapping-filter <protocols> If -G elastic-mapping is specified, put only the\n");
   fprintf(output, "                           specified protocols within the mapping file\n");
+  fprintf(output, "  --startup-profile        print the time spent in each phase of startup and\n");
+  fprintf(output, "                           in the slowest dissector registration routines\n");
+#ifndef _WIN32
+  fprintf(output, "  --zygote unix:<path>     initialize once, then run each job sent to the socket\n");
+  fprintf(output, "                           in a process forked from this one\n");
+  fprintf(output, "  --tap-workers <n>        with -2, split the second pass over <n> processes when\n");
+  fprintf(output, "                           only running statistics (-z) that can be merged\n");
+#endif
 
   fprintf(output, "\n");
   fprintf(output, "Miscellaneous:\n");
@@ -672,6 +723,212 @@ about_folders(void)
 
 }
 
+/*
+ * Record the time spent since the previous phase of startup ended.
+ */
+static void
+startup_profile_mark(const char *name)
+{
+  gint64 now = g_get_monotonic_time();
+
+  if (startup_profile && startup_profile_n_phases < STARTUP_PROFILE_MAX_PHASES) {
+    startup_profile_phases[startup_profile_n_phases].name = name;
+    startup_profile_phases[startup_profile_n_phases].usecs = now - startup_profile_last;
+    startup_profile_n_phases++;
+  }
+  startup_profile_last = now;
+}
+
+static void
+write_startup_profile(FILE *fp)
+{
+  gint64 total = 0;
+
+  fprintf(fp, "Startup profile:\n");
+  for (guint i = 0; i < startup_profile_n_phases; i++) {
+    fprintf(fp, "%10.3f ms  %s\n", startup_profile_phases[i].usecs / 1000.0, startup_profile_phases[i].name);
+    total += startup_profile_phases[i].usecs;
+  }
+  fprintf(fp, "%10.3f ms  total\n", total / 1000.0);
+  /* In a zygote job, registration happened once, in the zygote. */
+  if (!in_zygote_job) {
+    fprintf(fp, "\nDissector registration:\n");
+    register_write_profile(fp, STARTUP_PROFILE_MAX_ROUTINES);
+  }
+}
+
+/*
+ * Process the options we need before libwireshark is initialized.
+ * In a zygote job libwireshark has already been initialized, so
+ * options that only take effect during initialization are refused.
+ */
+static int
+process_early_options(int argc, char *argv[], const char *optstring,
+                      const struct option *long_options, gboolean in_job,
+                      gchar **output_only, const gchar **elastic_mapping_filter)
+{
+  int opt;
+
+  opterr = 0;
+
+  while ((opt = getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
+    switch (opt) {
+    case 'C':        /* Configuration Profile */
+      if (in_job) {
+        cmdarg_err("-C can't be used in a zygote job; give it to the zygote");
+        return INVALID_OPTION;
+      }
+      if (profile_exists (optarg, FALSE)) {
+        set_profile_name (optarg);
+      } else {
+        cmdarg_err("Configuration Profile \"%s\" does not exist", optarg);
+        return INVALID_OPTION;
+      }
+      break;
+    case 'P':        /* Print packet summary info even when writing to a file */
+      print_packet_info = TRUE;
+      print_summary = TRUE;
+      break;
+    case 'O':        /* Only output these protocols */
+      g_free(*output_only);
+      *output_only = g_strdup(optarg);
+      /* FALLTHROUGH */
+    case 'V':        /* Verbose */
+      print_details = TRUE;
+      print_packet_info = TRUE;
+      break;
+    case 'x':        /* Print packet data in hex (and ASCII) */
+      print_hex = TRUE;
+      /*  The user asked for hex output, so let's ensure they get it,
+       *  even if they're writing to a file.
+       */
+      print_packet_info = TRUE;
+      break;
+    case 'X':
+      ex_opt_add(optarg);
+      break;
+    case LONGOPT_ELASTIC_MAPPING_FILTER:
+      *elastic_mapping_filter = optarg;
+      break;
+    case LONGOPT_STARTUP_PROFILE:
+      startup_profile = TRUE;
+      register_set_profiling(TRUE);
+      break;
+    case LONGOPT_ZYGOTE:
+#ifdef _WIN32
+      cmdarg_err("--zygote isn't supported on Windows");
+      return INVALID_OPTION;
+#else
+      if (in_job) {
+        cmdarg_err("--zygote can't be used in a zygote job");
+        return INVALID_OPTION;
+      }
+      zygote_socket = optarg;
+#endif
+      break;
+    default:
+      break;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+#ifndef _WIN32
+/*
+ * The zygote only initializes; everything else is up to each job, and
+ * the options that would otherwise have no effect are refused.
+ */
+static int
+check_zygote_options(int argc, char *argv[], const char *optstring,
+                     const struct option *long_options)
+{
+  int opt;
+
+  opterr = 0;
+
+  while ((opt = getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
+    switch (opt) {
+    case 'C':
+    case 'X':
+    case LONGOPT_STARTUP_PROFILE:
+    case LONGOPT_ZYGOTE:
+      break;
+    default:
+      cmdarg_err("Only -C, -X and --startup-profile can be given with --zygote; give the other options to each job");
+      return INVALID_OPTION;
+    }
+  }
+  if (optind < argc) {
+    cmdarg_err("A capture filter can't be given with --zygote; give it to each job");
+    return INVALID_OPTION;
+  }
+
+  return EXIT_SUCCESS;
+}
+#endif
+
+/*
+ * To reset the options parser, set optreset to 1 on platforms that
+ * have optreset (documented in *BSD and macOS, apparently present but
+ * not documented in Solaris - the Illumos repository seems to
+ * suggest that the first Solaris getopt_long(), at least as of 2004,
+ * was based on the NetBSD one, it had optreset) and set optind to 1,
+ * and set optind to 0 otherwise (documented as working in the GNU
+ * getopt_long().  Setting optind to 0 didn't originally work in the
+ * NetBSD one, but that was added later - we don't want to depend on
+ * it if we have optreset).
+ */
+static void
+reset_option_parser(void)
+{
+#ifdef HAVE_OPTRESET
+  optreset = 1;
+  optind = 1;
+#else
+  optind = 0;
+#endif
+}
+
+/*
+ * Put the globals options set back to their defaults, so that a zygote
+ * job gets the options it was given, not those of the zygote.
+ */
+static void
+reset_option_globals(gchar **output_only, const gchar **elastic_mapping_filter)
+{
+  perform_two_pass_analysis = FALSE;
+  epan_auto_reset_count = 0;
+  epan_auto_reset = FALSE;
+  output_action = WRITE_TEXT;
+  print_packet_info = FALSE;
+  print_summary = FALSE;
+  print_details = FALSE;
+  print_hex = FALSE;
+  line_buffered = FALSE;
+  really_quiet = FALSE;
+  delimiter_char = " ";
+  dissect_color = FALSE;
+  print_format = PR_FMT_TEXT;
+  g_free(output_file_name);
+  output_file_name = NULL;
+  protocolfilter = NULL;
+  protocolfilter_flags = PF_NONE;
+  no_duplicate_keys = FALSE;
+  node_children_grouper = proto_node_group_children_by_unique;
+  separator = "";
+  startup_profile = FALSE;
+#ifndef _WIN32
+  tap_workers = 1;
+#endif
+#ifdef HAVE_LIBPCAP
+  print_packet_counts = FALSE;
+#endif
+  g_free(*output_only);
+  *output_only = NULL;
+  *elastic_mapping_filter = NULL;
+}
+
 static gboolean
 must_do_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
                    gchar *volatile pdu_export_arg)
@@ -706,6 +963,9 @@ main(int argc, char *argv[])
     {"color", no_argument, NULL, LONGOPT_COLOR},
     {"no-duplicate-keys", no_argument, NULL, LONGOPT_NO_DUPLICATE_KEYS},
     {"elastic-mapping-filter", required_argument, NULL, LONGOPT_ELASTIC_MAPPING_FILTER},
+    {"startup-profile", no_argument, NULL, LONGOPT_STARTUP_PROFILE},
+    {"zygote", required_argument, NULL, LONGOPT_ZYGOTE},
+    {"tap-workers", required_argument, NULL, LONGOPT_TAP_WORKERS},
     {0, 0, 0, 0 }
   };
   gboolean             arg_error = FALSE;
@@ -764,6 +1024,8 @@ main(int argc, char *argv[])
 
   static const char    optstring[] = OPTSTRING;
 
+  startup_profile_last = g_get_monotonic_time();
+
   tshark_debug("tshark started with %d args", argc);
 
   /* Set the C-language locale to the native environment. */
@@ -828,47 +1090,19 @@ main(int argc, char *argv[])
    * arguments we can't handle until after initializing libwireshark,
    * and then process them after initializing libwireshark?
    */
-  opterr = 0;
+  exit_status = process_early_options(argc, argv, optstring, long_options, FALSE,
+                                      &output_only, &elastic_mapping_filter);
+  if (exit_status != EXIT_SUCCESS)
+    goto clean_exit;
 
-  while ((opt = getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
-    switch (opt) {
-    case 'C':        /* Configuration Profile */
-      if (profile_exists (optarg, FALSE)) {
-        set_profile_name (optarg);
-      } else {
-        cmdarg_err("Configuration Profile \"%s\" does not exist", optarg);
-        exit_status = INVALID_OPTION;
-        goto clean_exit;
-      }
-      break;
-    case 'P':        /* Print packet summary info even when writing to a file */
-      print_packet_info = TRUE;
-      print_summary = TRUE;
-      break;
-    case 'O':        /* Only output these protocols */
-      output_only = g_strdup(optarg);
-      /* FALLTHROUGH */
-    case 'V':        /* Verbose */
-      print_details = TRUE;
-      print_packet_info = TRUE;
-      break;
-    case 'x':        /* Print packet data in hex (and ASCII) */
-      print_hex = TRUE;
-      /*  The user asked for hex output, so let's ensure they get it,
-       *  even if they're writing to a file.
-       */
-      print_packet_info = TRUE;
-      break;
-    case 'X':
-      ex_opt_add(optarg);
-      break;
-    case LONGOPT_ELASTIC_MAPPING_FILTER:
-      elastic_mapping_filter = optarg;
-      break;
-    default:
-      break;
-    }
+#ifndef _WIN32
+  if (zygote_socket) {
+    reset_option_parser();
+    exit_status = check_zygote_options(argc, argv, optstring, long_options);
+    if (exit_status != EXIT_SUCCESS)
+      goto clean_exit;
   }
+#endif
 
 /** Send All g_log messages to our own handler **/
 
@@ -914,6 +1148,7 @@ main(int argc, char *argv[])
   timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
 
   wtap_init(TRUE);
+  startup_profile_mark("wtap_init");
 
   /* Register all dissectors; we must do this before checking for the
      "-G" flag, as the "-G" flag dumps information registered by the
@@ -923,6 +1158,7 @@ main(int argc, char *argv[])
     exit_status = INIT_FAILED;
     goto clean_exit;
   }
+  startup_profile_mark("epan_init");
 
   /* Register all tap listeners; we do this before we parse the arguments,
      as the "-z" argument can specify a registered tap. */
@@ -943,6 +1179,7 @@ main(int argc, char *argv[])
   srt_table_iterate_tables(register_srt_tables, NULL);
   rtd_table_iterate_tables(register_rtd_tables, NULL);
   stat_tap_iterate_tables(register_simple_stat_tables, NULL);
+  startup_profile_mark("tap listener registration");
 
   /* If invoked with the "-G" flag, we dump out information based on
      the argument to the "-G" flag; if no argument is specified,
@@ -1023,6 +1260,7 @@ main(int argc, char *argv[])
   /* Load libwireshark settings from the current profile. */
   prefs_p = epan_load_settings();
   prefs_loaded = TRUE;
+  startup_profile_mark("preferences");
 
   read_filter_list(CFILTER_LIST);
 
@@ -1034,26 +1272,35 @@ main(int argc, char *argv[])
 
   output_fields = output_fields_new();
 
+#ifndef _WIN32
+  if (zygote_socket) {
+    /*
+     * Everything up to here is shared by all of the zygote's jobs.
+     * We only come back from this in a job's process, with the job's
+     * arguments and its standard input, output and error.
+     */
+    if (!tshark_zygote_run(zygote_socket, &argc, &argv)) {
+      exit_status = INIT_FAILED;
+      goto clean_exit;
+    }
+    in_zygote_job = TRUE;
+    startup_profile_n_phases = 0;
+    startup_profile_last = g_get_monotonic_time();
+
+    reset_option_globals(&output_only, &elastic_mapping_filter);
+    reset_option_parser();
+    exit_status = process_early_options(argc, argv, optstring, long_options, TRUE,
+                                        &output_only, &elastic_mapping_filter);
+    if (exit_status != EXIT_SUCCESS)
+      goto clean_exit;
+  }
+#endif
+
   /*
-   * To reset the options parser, set optreset to 1 on platforms that
-   * have optreset (documented in *BSD and macOS, apparently present but
-   * not documented in Solaris - the Illumos repository seems to
-   * suggest that the first Solaris getopt_long(), at least as of 2004,
-   * was based on the NetBSD one, it had optreset) and set optind to 1,
-   * and set optind to 0 otherwise (documented as working in the GNU
-   * getopt_long().  Setting optind to 0 didn't originally work in the
-   * NetBSD one, but that was added later - we don't want to depend on
-   * it if we have optreset).
-   *
-   * Also reset opterr to 1, so that error messages are printed by
-   * getopt_long().
+   * Reset the options parser, and reset opterr to 1, so that error
+   * messages are printed by getopt_long().
    */
-#ifdef HAVE_OPTRESET
-  optreset = 1;
-  optind = 1;
-#else
-  optind = 0;
-#endif
+  reset_option_parser();
   opterr = 1;
 
   /* Now get our args */
@@ -1321,6 +1568,14 @@ main(int argc, char *argv[])
         output_action = WRITE_FIELDS;
         print_details = TRUE;   /* Need full tree info */
         print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "columnar") == 0) {
+        output_action = WRITE_COLUMNAR;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
+      } else if (strcmp(optarg, "bintree") == 0) {
+        output_action = WRITE_BINTREE;
+        print_details = TRUE;   /* Need full tree info */
+        print_summary = FALSE;  /* Don't allow summary */
       } else if (strcmp(optarg, "json") == 0) {
         output_action = WRITE_JSON;
         print_details = TRUE;   /* Need details */
@@ -1338,6 +1593,10 @@ main(int argc, char *argv[])
         cmdarg_err("Invalid -T parameter \"%s\"; it must be one of:", optarg);                   /* x */
         cmdarg_err_cont("\t\"fields\"  The values of fields specified with the -e option, in a form\n"
                         "\t          specified by the -E option.\n"
+                        "\t\"columnar\" The values of fields specified with the -e option, as typed\n"
+                        "\t          columns in CBOR record batches for bulk loading.\n"
+                        "\t\"bintree\"  The full protocol tree of each packet in a compact binary\n"
+                        "\t          form that can be read back with epan/proto_tree_bin.h.\n"
                         "\t\"pdml\"    Packet Details Markup Language, an XML-based format for the\n"
                         "\t          details of a decoded packet. This information is equivalent to\n"
                         "\t          the packet details printed with the -V flag.\n"
@@ -1462,6 +1721,19 @@ main(int argc, char *argv[])
       no_duplicate_keys = TRUE;
       node_children_grouper = proto_node_group_children_by_json_key;
       break;
+    case LONGOPT_STARTUP_PROFILE:
+    case LONGOPT_ZYGOTE:
+      /* already processed */
+      break;
+    case LONGOPT_TAP_WORKERS:
+#ifdef _WIN32
+      cmdarg_err("--tap-workers isn't supported on Windows");
+      exit_status = INVALID_OPTION;
+      goto clean_exit;
+#else
+      tap_workers = get_positive_int(optarg, "tap worker count");
+#endif
+      break;
     default:
     case '?':        /* Bad flag - print usage message */
       switch(optopt) {
@@ -1492,15 +1764,28 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+  /*
+   * The JSON writers produce output in many small pieces; unless we're
+   * flushing after every packet anyway, give the standard output a large
+   * buffer so that it goes out in a few big writes.
+   */
+  if (!line_buffered && (output_action == WRITE_JSON ||
+                         output_action == WRITE_JSON_RAW ||
+                         output_action == WRITE_EK ||
+                         output_action == WRITE_COLUMNAR ||
+                         output_action == WRITE_BINTREE))
+    setvbuf(stdout, NULL, _IOFBF, JSON_STDOUT_BUFSIZE);
+
   /* If we specified output fields, but not the output field type... */
-  if ((WRITE_FIELDS != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
+  if ((WRITE_FIELDS != output_action && WRITE_COLUMNAR != output_action && WRITE_XML != output_action && WRITE_JSON != output_action && WRITE_EK != output_action) && 0 != output_fields_num_fields(output_fields)) {
         cmdarg_err("Output fields were specified with \"-e\", "
-            "but \"-Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
+            "but \"-Tcolumnar, -Tek, -Tfields, -Tjson or -Tpdml\" was not specified.");
         exit_status = INVALID_OPTION;
         goto clean_exit;
-  } else if (WRITE_FIELDS == output_action && 0 == output_fields_num_fields(output_fields)) {
-        cmdarg_err("\"-Tfields\" was specified, but no fields were "
-                    "specified with \"-e\".");
+  } else if ((WRITE_FIELDS == output_action || WRITE_COLUMNAR == output_action) && 0 == output_fields_num_fields(output_fields)) {
+        cmdarg_err("\"-T%s\" was specified, but no fields were "
+                    "specified with \"-e\".",
+                    WRITE_FIELDS == output_action ? "fields" : "columnar");
 
         exit_status = INVALID_OPTION;
         goto clean_exit;
@@ -1619,6 +1904,14 @@ main(int argc, char *argv[])
     goto clean_exit;
   }
 
+#ifndef _WIN32
+  if (tap_workers > 1 && !perform_two_pass_analysis) {
+    cmdarg_err("--tap-workers requires -2.");
+    exit_status = INVALID_OPTION;
+    goto clean_exit;
+  }
+#endif
+
 #ifdef HAVE_LIBPCAP
   if (caps_queries) {
     /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -2013,6 +2306,11 @@ main(int argc, char *argv[])
 
   tshark_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
 
+  if (startup_profile) {
+    startup_profile_mark("options and filters");
+    write_startup_profile(stderr);
+  }
+
   if (cf_name) {
     tshark_debug("tshark: Opening capture file: %s", cf_name);
     /*
@@ -2989,6 +3287,16 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
       }
     }
 
+    /* Start looking up the names the second pass will show. Sending the
+       queued lookups and collecting the answers costs a select() call, so
+       only do that every so often, and only while there are some. */
+    if (edt && gbl_resolv_flags.network_name) {
+      host_name_lookup_prefetch(&edt->pi.net_src);
+      host_name_lookup_prefetch(&edt->pi.net_dst);
+      if (cf->count % PREFETCH_PROCESS_INTERVAL == 0 && host_name_lookups_pending())
+        host_name_lookup_process();
+    }
+
     cf->count++;
   } else {
     /* if we don't add it to the frame_data_sequence, clean it up right now
@@ -3121,6 +3429,10 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
   if (edt)
     epan_dissect_free(edt);
 
+  /* Collect the names looked up during this pass, for the second one. */
+  if (do_dissection && gbl_resolv_flags.network_name && status != PASS_INTERRUPTED)
+    host_name_lookup_wait();
+
   /* Close the sequential I/O side, to free up memory it requires. */
   wtap_sequential_close(cf->provider.wth);
 
@@ -3224,6 +3536,255 @@ process_packet_second_pass(capture_file *cf, epan_dissect_t *edt,
   return passed || fdata->dependent_of_displayed;
 }
 
+static pass_status_t
+process_frame_range(capture_file *cf, wtap_dumper *pdh, epan_dissect_t *edt,
+                    guint tap_flags, guint32 first, guint32 last,
+                    wtap_rec *rec, Buffer *buf, int *err, gchar **err_info,
+                    volatile guint32 *err_framenum)
+{
+  guint32         framenum;
+  frame_data     *fdata;
+
+  for (framenum = first; framenum <= last; framenum++) {
+    if (read_interrupted)
+      return PASS_INTERRUPTED;
+    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, err,
+                        err_info)) {
+      /* Error reading from the input file. */
+      return PASS_READ_ERROR;
+    }
+    tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
+    if (process_packet_second_pass(cf, edt, fdata, rec, buf, tap_flags)) {
+      /* Either there's no read filtering or this packet passed the
+         filter, so, if we're writing to a capture file, write
+         this packet out. */
+      if (pdh != NULL) {
+        tshark_debug("tshark: writing packet #%d to outfile", framenum);
+        if (!wtap_dump(pdh, rec, ws_buffer_start_ptr(buf), err, err_info)) {
+          /* Error writing to the output file. */
+          tshark_debug("tshark: error writing to a capture file (%d)", *err);
+          *err_framenum = framenum;
+          return PASS_WRITE_ERROR;
+        }
+      }
+    }
+  }
+  return PASS_SUCCEEDED;
+}
+
+#ifndef _WIN32
+/*
+ * Can the second pass be split over several processes?
+ *
+ * Each one runs the taps over a range of frames, starting from the
+ * state the first pass left behind, and the taps' results are then
+ * merged in frame order.  That only works if all of them can be merged,
+ * and if every frame passes (no display filter) and nothing but the
+ * taps' results gets written out.
+ */
+static gboolean
+use_tap_workers(capture_file *cf, wtap_dumper *pdh)
+{
+  return tap_workers > 1 && cf->count > 1 && pdh == NULL && !print_packet_info &&
+         cf->dfcode == NULL && strcmp(cf->filename, "-") != 0 &&
+         tap_listeners_mergeable();
+}
+
+/*
+ * Set up to start the second pass at a frame other than the first one,
+ * as if we had just done the frames before it.
+ */
+static void
+resume_second_pass(capture_file *cf, guint32 first, guint32 pass_cum_bytes)
+{
+  frame_data *prev = frame_data_sequence_find(cf->provider.frames, first - 1);
+
+  cf->provider.prev_dis = prev;
+  cf->provider.prev_cap = prev;
+  /* That's still the count of the first pass, which starts from 0 */
+  cum_bytes = pass_cum_bytes + prev->cum_bytes;
+}
+
+/*
+ * Run the taps over a range of frames in a child process, and write
+ * the result of the pass, followed by the taps' state, to fd.
+ */
+static void
+run_tap_worker(capture_file *cf, epan_dissect_t *edt, guint tap_flags,
+               guint32 first, guint32 last, wtap_rec *rec, Buffer *buf,
+               int fd)
+{
+  GByteArray     *state = g_byte_array_new();
+  pass_status_t   status;
+  int             err = 0;
+  gchar          *err_info = NULL;
+  guint32         err_framenum;
+  guint8         *p;
+  gssize          n;
+
+  /* Our descriptor shares its file position with our parent's. */
+  wtap_fdclose(cf->provider.wth);
+  if (!wtap_fdreopen(cf->provider.wth, cf->filename, &err)) {
+    status = PASS_READ_ERROR;
+  } else {
+    resume_second_pass(cf, first, cum_bytes);
+    status = process_frame_range(cf, NULL, edt, tap_flags, first, last,
+                                 rec, buf, &err, &err_info, &err_framenum);
+    g_free(err_info);
+  }
+
+  tap_merge_put_uint(state, status);
+  tap_merge_put_uint(state, err);
+  if (status == PASS_SUCCEEDED)
+    tap_listeners_serialize(state);
+
+  for (p = state->data; p < state->data + state->len; p += n) {
+    n = write(fd, p, state->data + state->len - p);
+    if (n < 0) {
+      if (errno != EINTR)
+        _exit(2);
+      n = 0;
+    }
+  }
+  _exit(0);
+}
+
+/*
+ * Read what a tap worker wrote and merge its taps' state into ours.
+ */
+static pass_status_t
+merge_tap_worker(pid_t pid, int fd, guint32 first, guint32 last, int *err)
+{
+  GByteArray       *state = g_byte_array_new();
+  tap_merge_state_t result;
+  guint32           worker_status, worker_err;
+  guint8            chunk[65536];
+  gssize            n;
+  int               wstatus;
+  pass_status_t     status = PASS_SUCCEEDED;
+
+  while ((n = read(fd, chunk, sizeof chunk)) != 0) {
+    if (n < 0) {
+      if (errno != EINTR)
+        break;
+      continue;
+    }
+    g_byte_array_append(state, chunk, (guint)n);
+  }
+  close(fd);
+  while (waitpid(pid, &wstatus, 0) < 0 && errno == EINTR)
+    ;
+
+  result.data = state->data;
+  result.len = state->len;
+  result.offset = 0;
+  if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0 ||
+      !tap_merge_get_uint(&result, &worker_status) ||
+      !tap_merge_get_uint(&result, &worker_err)) {
+    cmdarg_err("The tap worker for frames %u to %u failed.", first, last);
+    *err = WTAP_ERR_INTERNAL;
+    status = PASS_READ_ERROR;
+  } else if (worker_status != PASS_SUCCEEDED) {
+    *err = (int)worker_err;
+    status = (pass_status_t)worker_status;
+  } else if (!tap_listeners_merge(result.data + result.offset,
+                                  result.len - result.offset)) {
+    cmdarg_err("The statistics for frames %u to %u couldn't be merged.", first, last);
+    *err = WTAP_ERR_INTERNAL;
+    status = PASS_READ_ERROR;
+  }
+  g_byte_array_free(state, TRUE);
+  return status;
+}
+
+/*
+ * Do the second pass with tap_workers processes: we do the first range
+ * of frames ourselves and children do the others, whose results are
+ * merged into ours in frame order, so that everything comes out as if
+ * we had done all of them.
+ */
+static pass_status_t
+process_frames_with_tap_workers(capture_file *cf, epan_dissect_t *edt,
+                                guint tap_flags, wtap_rec *rec, Buffer *buf,
+                                int *err, gchar **err_info)
+{
+  guint           n_ranges = MIN(tap_workers, cf->count);
+  guint32        *firsts = g_new(guint32, n_ranges + 1);
+  pid_t          *pids = g_new(pid_t, n_ranges);
+  int            *fds = g_new(int, n_ranges);
+  guint32         pass_cum_bytes = cum_bytes;
+  guint32         err_framenum;
+  pass_status_t   status;
+  guint           n_started, i;
+
+  for (i = 0; i <= n_ranges; i++)
+    firsts[i] = (guint32)((guint64)cf->count * i / n_ranges) + 1;
+
+  /* Don't have our buffered output written out by every child as well. */
+  fflush(stdout);
+  fflush(stderr);
+
+  for (n_started = 1; n_started < n_ranges; n_started++) {
+    int pipe_fds[2];
+
+    if (pipe(pipe_fds) < 0) {
+      cmdarg_err("Couldn't create a pipe for a tap worker: %s", g_strerror(errno));
+      break;
+    }
+    pids[n_started] = fork();
+    if (pids[n_started] < 0) {
+      cmdarg_err("Couldn't fork a tap worker: %s", g_strerror(errno));
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      break;
+    }
+    if (pids[n_started] == 0) {
+      close(pipe_fds[0]);
+      for (i = 1; i < n_started; i++)
+        close(fds[i]);
+      run_tap_worker(cf, edt, tap_flags, firsts[n_started],
+                     firsts[n_started + 1] - 1, rec, buf, pipe_fds[1]);
+    }
+    close(pipe_fds[1]);
+    fds[n_started] = pipe_fds[0];
+  }
+
+  /* If none could be started, we do everything. */
+  status = process_frame_range(cf, NULL, edt, tap_flags, 1,
+                               n_started > 1 ? firsts[1] - 1 : cf->count,
+                               rec, buf, err, err_info, &err_framenum);
+
+  /* Merge their results in frame order. */
+  for (i = 1; i < n_started; i++) {
+    if (status == PASS_SUCCEEDED) {
+      status = merge_tap_worker(pids[i], fds[i], firsts[i], firsts[i + 1] - 1, err);
+    } else {
+      /* Its result is of no use anymore. */
+      kill(pids[i], SIGTERM);
+      close(fds[i]);
+      while (waitpid(pids[i], NULL, 0) < 0 && errno == EINTR)
+        ;
+    }
+  }
+
+  /* Do the frames of the workers we couldn't start. */
+  if (status == PASS_SUCCEEDED && n_started > 1 && n_started < n_ranges) {
+    resume_second_pass(cf, firsts[n_started], pass_cum_bytes);
+    status = process_frame_range(cf, NULL, edt, tap_flags, firsts[n_started],
+                                 cf->count, rec, buf, err, err_info, &err_framenum);
+  } else {
+    cf->provider.prev_dis = frame_data_sequence_find(cf->provider.frames, cf->count);
+    cf->provider.prev_cap = cf->provider.prev_dis;
+  }
+
+  g_free(firsts);
+  g_free(pids);
+  g_free(fds);
+  return status;
+}
+#endif /* _WIN32 */
+
 static pass_status_t
 process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
                              int *err, gchar **err_info,
@@ -3231,8 +3792,6 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
 {
   wtap_rec        rec;
   Buffer          buf;
-  guint32         framenum;
-  frame_data     *fdata;
   gboolean        filtering_tap_listeners;
   guint           tap_flags;
   epan_dissect_t *edt = NULL;
@@ -3282,35 +3841,14 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
    */
   set_resolution_synchrony(TRUE);
 
-  for (framenum = 1; framenum <= cf->count; framenum++) {
-    if (read_interrupted) {
-      status = PASS_INTERRUPTED;
-      break;
-    }
-    fdata = frame_data_sequence_find(cf->provider.frames, framenum);
-    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
-                        err_info)) {
-      /* Error reading from the input file. */
-      status = PASS_READ_ERROR;
-      break;
-    }
-    tshark_debug("tshark: invoking process_packet_second_pass() for frame #%d", framenum);
-    if (process_packet_second_pass(cf, edt, fdata, &rec, &buf, tap_flags)) {
-      /* Either there's no read filtering or this packet passed the
-         filter, so, if we're writing to a capture file, write
-         this packet out. */
-      if (pdh != NULL) {
-        tshark_debug("tshark: writing packet #%d to outfile", framenum);
-        if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
-          /* Error writing to the output file. */
-          tshark_debug("tshark: error writing to a capture file (%d)", *err);
-          *err_framenum = framenum;
-          status = PASS_WRITE_ERROR;
-          break;
-        }
-      }
-    }
-  }
+#ifndef _WIN32
+  if (use_tap_workers(cf, pdh))
+    status = process_frames_with_tap_workers(cf, edt, tap_flags, &rec, &buf,
+                                             err, err_info);
+  else
+#endif
+    status = process_frame_range(cf, pdh, edt, tap_flags, 1, cf->count,
+                                 &rec, &buf, err, err_info, err_framenum);
 
   if (edt)
     epan_dissect_free(edt);
@@ -3811,6 +4349,14 @@ write_preamble(capture_file *cf)
     write_fields_preamble(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNAR:
+    write_columnar_preamble(output_fields, stdout);
+    return !ferror(stdout);
+
+  case WRITE_BINTREE:
+    bintree_writer = proto_tree_bin_writer_new(stdout);
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     jdumper = write_json_preamble(stdout);
@@ -4164,6 +4710,13 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
     }
     break;
 
+  case WRITE_COLUMNAR:
+    write_columnar_proto_tree(output_fields, edt, &cf->cinfo, stdout);
+    return !ferror(stdout);
+
+  case WRITE_BINTREE:
+    return proto_tree_bin_write_packet(bintree_writer, edt);
+
   case WRITE_JSON:
     if (print_summary)
       g_assert_not_reached();
@@ -4224,6 +4777,15 @@ write_finale(void)
     write_fields_finale(output_fields, stdout);
     return !ferror(stdout);
 
+  case WRITE_COLUMNAR:
+    write_columnar_finale(output_fields, stdout);
+    return !ferror(stdout);
+
+  case WRITE_BINTREE:
+    proto_tree_bin_writer_free(bintree_writer);
+    bintree_writer = NULL;
+    return !ferror(stdout);
+
   case WRITE_JSON:
   case WRITE_JSON_RAW:
     write_json_finale(&jdumper);
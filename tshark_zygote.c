@@ -0,0 +1,377 @@
+/* tshark_zygote.c
+ * Run TShark jobs in processes forked from an initialized TShark
+ *
+ * The socket handling follows sharkd_daemon.c, which forks a session
+ * per connection in the same way.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <glib.h>
+
+#include <ui/cmdarg_err.h>
+
+#include "tshark_zygote.h"
+
+/* Exit status of a job whose request we couldn't read */
+#define ZYGOTE_BAD_JOB          2
+
+/* Largest request we accept */
+#define ZYGOTE_MAX_REQUEST      (1024 * 1024)
+
+/* Number of file descriptors a job passes: stdin, stdout and stderr */
+#define ZYGOTE_JOB_FDS          3
+
+static int zygote_sigchld_pipe[2] = { -1, -1 };
+
+static void
+zygote_sigchld(int signo _U_)
+{
+  int save_errno = errno;
+  ssize_t ret = write(zygote_sigchld_pipe[1], "", 1);
+
+  (void)ret;
+  errno = save_errno;
+}
+
+static void
+set_cloexec(int fd)
+{
+  int flags = fcntl(fd, F_GETFD);
+
+  if (flags != -1)
+    fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+}
+
+static int
+zygote_listen(const char *socket_path)
+{
+  struct sockaddr_un s_un;
+  socklen_t s_un_len;
+  const char *path;
+  mode_t old_umask;
+  int fd, ret;
+
+  if (strncmp(socket_path, "unix:", 5) != 0) {
+    cmdarg_err("The zygote socket must be given as \"unix:<path>\".");
+    return -1;
+  }
+  path = socket_path + 5;
+
+  if (strlen(path) + 1 > sizeof(s_un.sun_path)) {
+    cmdarg_err("The zygote socket path \"%s\" is too long.", path);
+    return -1;
+  }
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    cmdarg_err("Can't create the zygote socket: %s.", g_strerror(errno));
+    return -1;
+  }
+
+  memset(&s_un, 0, sizeof(s_un));
+  s_un.sun_family = AF_UNIX;
+  g_strlcpy(s_un.sun_path, path, sizeof(s_un.sun_path));
+
+  s_un_len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + strlen(s_un.sun_path));
+
+  if (s_un.sun_path[0] == '@')
+    s_un.sun_path[0] = '\0';
+
+  /*
+   * Jobs run as us, with whatever descriptors they pass, so only we may
+   * connect.
+   */
+  old_umask = umask(077);
+  ret = bind(fd, (struct sockaddr *) &s_un, s_un_len);
+  umask(old_umask);
+
+  if (ret || listen(fd, SOMAXCONN)) {
+    cmdarg_err("Can't listen on \"%s\": %s.", path, g_strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  set_cloexec(fd);
+  return fd;
+}
+
+/*
+ * Read a job's request and descriptors from its connection.
+ * Returns the request, or NULL on error.
+ */
+static GByteArray *
+zygote_read_request(int conn_fd, int job_fds[ZYGOTE_JOB_FDS])
+{
+  GByteArray *request = g_byte_array_new();
+  guint8 buf[4096];
+  gboolean have_fds = FALSE;
+
+  for (;;) {
+    union {
+      struct cmsghdr hdr;
+      char buf[CMSG_SPACE(sizeof(int) * ZYGOTE_JOB_FDS)];
+    } control;
+    struct iovec iov = { buf, sizeof(buf) };
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    ssize_t len;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    len = recvmsg(conn_fd, &msg, 0);
+    if (len < 0) {
+      if (errno == EINTR)
+        continue;
+      cmdarg_err("Can't read a zygote job: %s.", g_strerror(errno));
+      break;
+    }
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        int n_fds = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        int *fds = (int *) CMSG_DATA(cmsg);
+
+        if (!have_fds && n_fds == ZYGOTE_JOB_FDS) {
+          memcpy(job_fds, fds, sizeof(int) * ZYGOTE_JOB_FDS);
+          have_fds = TRUE;
+        } else {
+          for (int i = 0; i < n_fds; i++)
+            close(fds[i]);
+        }
+      }
+    }
+
+    if (len == 0) {
+      if (!have_fds) {
+        cmdarg_err("A zygote job didn't pass its standard input, output and error.");
+        break;
+      }
+      return request;
+    }
+
+    if (request->len + len > ZYGOTE_MAX_REQUEST) {
+      cmdarg_err("A zygote job's arguments are too long.");
+      break;
+    }
+    g_byte_array_append(request, buf, (guint) len);
+  }
+
+  if (have_fds) {
+    for (int i = 0; i < ZYGOTE_JOB_FDS; i++)
+      close(job_fds[i]);
+  }
+  g_byte_array_free(request, TRUE);
+  return NULL;
+}
+
+/*
+ * Set up a job's process: read its request, put its descriptors in
+ * place and build its argument vector.
+ */
+static void
+zygote_start_job(int conn_fd, const char *progname, int *argcp, char ***argvp)
+{
+  int job_fds[ZYGOTE_JOB_FDS];
+  GByteArray *request;
+  GPtrArray *args;
+  guint start = 0;
+
+  request = zygote_read_request(conn_fd, job_fds);
+  close(conn_fd);
+  if (!request)
+    exit(ZYGOTE_BAD_JOB);
+
+  for (int i = 0; i < ZYGOTE_JOB_FDS; i++) {
+    if (job_fds[i] != i) {
+      dup2(job_fds[i], i);
+      close(job_fds[i]);
+    }
+  }
+
+  args = g_ptr_array_new();
+  g_ptr_array_add(args, g_strdup(progname));
+  for (guint i = 0; i < request->len; i++) {
+    if (request->data[i] == '\0') {
+      g_ptr_array_add(args, g_strndup((const char *) request->data + start, i - start));
+      start = i + 1;
+    }
+  }
+  if (start < request->len) {
+    /* Last argument without a terminator */
+    g_ptr_array_add(args, g_strndup((const char *) request->data + start, request->len - start));
+  }
+  g_byte_array_free(request, TRUE);
+
+  *argcp = (int) args->len;
+  g_ptr_array_add(args, NULL);
+  *argvp = (char **) g_ptr_array_free(args, FALSE);
+}
+
+static void
+zygote_report_status(int conn_fd, int status)
+{
+  char *reply;
+  int exit_status;
+  ssize_t ret;
+
+  if (WIFEXITED(status))
+    exit_status = WEXITSTATUS(status);
+  else if (WIFSIGNALED(status))
+    exit_status = 128 + WTERMSIG(status);
+  else
+    return;
+
+  reply = g_strdup_printf("%d\n", exit_status);
+  ret = write(conn_fd, reply, strlen(reply));
+  (void)ret;
+  g_free(reply);
+}
+
+gboolean
+tshark_zygote_run(const char *socket_path, int *argcp, char ***argvp)
+{
+  /* Connections of running jobs, by process ID */
+  GHashTable *jobs;
+  int server_fd;
+
+  server_fd = zygote_listen(socket_path);
+  if (server_fd == -1)
+    return FALSE;
+
+  if (pipe(zygote_sigchld_pipe) != 0) {
+    cmdarg_err("Can't create a pipe: %s.", g_strerror(errno));
+    close(server_fd);
+    return FALSE;
+  }
+  for (int i = 0; i < 2; i++) {
+    set_cloexec(zygote_sigchld_pipe[i]);
+    fcntl(zygote_sigchld_pipe[i], F_SETFL, fcntl(zygote_sigchld_pipe[i], F_GETFL) | O_NONBLOCK);
+  }
+
+  signal(SIGCHLD, zygote_sigchld);
+  /* Clients that go away shouldn't take us with them. */
+  signal(SIGPIPE, SIG_IGN);
+
+  jobs = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  for (;;) {
+    struct pollfd fds[2];
+    pid_t pid;
+    int status;
+    int conn_fd;
+
+    fds[0].fd = server_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = zygote_sigchld_pipe[0];
+    fds[1].events = POLLIN;
+
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      cmdarg_err("Zygote poll() failed: %s.", g_strerror(errno));
+      break;
+    }
+
+    if (fds[1].revents) {
+      char drain[64];
+
+      while (read(zygote_sigchld_pipe[0], drain, sizeof(drain)) > 0)
+        ;
+      while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        gpointer job = g_hash_table_lookup(jobs, GINT_TO_POINTER(pid));
+
+        if (job) {
+          conn_fd = GPOINTER_TO_INT(job);
+          zygote_report_status(conn_fd, status);
+          close(conn_fd);
+          g_hash_table_remove(jobs, GINT_TO_POINTER(pid));
+        }
+      }
+    }
+
+    if (!(fds[0].revents & POLLIN))
+      continue;
+
+    conn_fd = accept(server_fd, NULL, NULL);
+    if (conn_fd == -1) {
+      if (errno != EINTR && errno != ECONNABORTED)
+        cmdarg_err("Zygote accept() failed: %s.", g_strerror(errno));
+      continue;
+    }
+    set_cloexec(conn_fd);
+
+    pid = fork();
+    if (pid == 0) {
+      GHashTableIter iter;
+      gpointer job;
+
+      /* We're the job. Let go of everything that belongs to the zygote. */
+      signal(SIGCHLD, SIG_DFL);
+      signal(SIGPIPE, SIG_DFL);
+      close(server_fd);
+      close(zygote_sigchld_pipe[0]);
+      close(zygote_sigchld_pipe[1]);
+      g_hash_table_iter_init(&iter, jobs);
+      while (g_hash_table_iter_next(&iter, NULL, &job))
+        close(GPOINTER_TO_INT(job));
+      g_hash_table_destroy(jobs);
+
+      zygote_start_job(conn_fd, (*argvp)[0], argcp, argvp);
+      return TRUE;
+    }
+
+    if (pid == -1) {
+      cmdarg_err("Can't fork a zygote job: %s.", g_strerror(errno));
+      close(conn_fd);
+      continue;
+    }
+
+    g_hash_table_insert(jobs, GINT_TO_POINTER(pid), GINT_TO_POINTER(conn_fd));
+  }
+
+  g_hash_table_destroy(jobs);
+  close(server_fd);
+  return FALSE;
+}
+
+#endif /* _WIN32 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */
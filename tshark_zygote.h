@@ -0,0 +1,64 @@
+/* tshark_zygote.h
+ * Run TShark jobs in processes forked from an initialized TShark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __TSHARK_ZYGOTE_H__
+#define __TSHARK_ZYGOTE_H__
+
+#include <glib.h>
+
+#ifndef _WIN32
+
+/*
+ * A zygote listens on a local socket, "unix:/path/to/socket" (a path
+ * beginning with '@' is in the abstract namespace on Linux). Each
+ * connection is a job:
+ *
+ *  - The client sends its standard input, output and error as three
+ *    file descriptors (SCM_RIGHTS) along with the first bytes of the
+ *    request.
+ *  - The request is the job's command line arguments, not including
+ *    the program name, each terminated by a NUL byte. The client shuts
+ *    down its side of the connection after the last one.
+ *  - When the job finishes, the zygote writes its exit status in
+ *    decimal, followed by a newline, and closes the connection. A job
+ *    killed by a signal reports 128 plus the signal number.
+ *
+ * Each job runs in a process forked from the zygote after libwireshark
+ * has been initialized and the preferences have been read.
+ */
+
+/**
+ * Become a zygote.
+ *
+ * @param socket_path Socket to listen on.
+ * @param argcp Set to the job's argument count in a job's process.
+ * @param argvp Set to the job's arguments in a job's process.
+ * @return Only returns in the zygote if the socket can't be set up
+ * (FALSE), or in a job's process, with its standard input, output and
+ * error in place (TRUE).
+ */
+gboolean tshark_zygote_run(const char *socket_path, int *argcp, char ***argvp);
+
+#endif /* _WIN32 */
+
+#endif /* __TSHARK_ZYGOTE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 2
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=2 tabstop=8 expandtab:
+ * :indentSize=2:tabSize=8:noTabs=true:
+ */
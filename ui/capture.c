@@ -572,6 +572,16 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
 }
 
 
+void
+capture_read_backlog(capture_session *cap_session)
+{
+    if (cap_session->state != CAPTURE_RUNNING || !cap_session->capture_opts->real_time_mode)
+        return;
+
+    /* No new packets, just those left over by cf_continue_tail(). */
+    capture_input_new_packets(cap_session, 0);
+}
+
 /* Capture child told us how many dropped packets it counted.
  */
 static void
@@ -76,6 +76,14 @@ capture_stop(capture_session *cap_session);
 extern void
 capture_kill_child(capture_session *cap_session);
 
+/**
+ * Read packets which the capture child already wrote, but which were left
+ * unread because cf_continue_tail() ran out of its time slice.
+ * See capture_file::tail_backlog.
+ */
+extern void
+capture_read_backlog(capture_session *cap_session);
+
 struct if_stat_cache_s;
 typedef struct if_stat_cache_s if_stat_cache_t;
 
@@ -40,6 +40,13 @@ endpoints_draw(void *arg)
 	printf("================================================================================\n");
 	printf("%s Endpoints\n", iu->type);
 	printf("Filter:%s\n", iu->filter ? iu->filter : "<No Filter>");
+	if (iu->hash.max_items) {
+		printf("Top %u endpoints (approximate", iu->hash.max_items);
+		if (iu->hash.evicted_frames) {
+			printf(", frames of dropped endpoints: %" G_GINT64_MODIFIER "u", iu->hash.evicted_frames);
+		}
+		printf(")\n");
+	}
 
 	printf("                       |  %sPackets  | |  Bytes  | | Tx Packets | | Tx Bytes | | Rx Packets | | Rx Bytes |\n",
 		display_port ? "Port  ||  " : "");
@@ -106,6 +113,7 @@ void init_hostlists(struct register_ct *ct, const char *filter)
 
 	iu = g_new0(endpoints_t, 1);
 	iu->type = proto_get_protocol_short_name(find_protocol_by_id(get_conversation_proto_id(ct)));
+	filter = conversation_table_parse_max_items(filter, &iu->hash.max_items);
 	iu->filter = g_strdup(filter);
 	iu->hash.user_data = iu;
 
@@ -117,6 +125,7 @@ void init_hostlists(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_merge(&iu->hash, hostlist_table_serialize, hostlist_table_merge);
 
 }
 
@@ -49,6 +49,7 @@ typedef struct expert_entry
 typedef struct expert_tapdata_t {
     GArray       *ei_array[max_level]; /* expert info items */
     GStringChunk *text;         /* for efficient storage of summary strings */
+    gboolean      brief;        /* one item per expert info field, with its registered summary */
 } expert_tapdata_t;
 
 
@@ -79,6 +80,7 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
     severity_level_t     severity_level;
     expert_entry         tmp_entry;
     expert_entry        *entry;
+    const gchar         *summary;
     guint                n;
 
     switch (ei->severity) {
@@ -107,12 +109,19 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
         return TAP_PACKET_REDRAW; /* XXX - TAP_PACKET_DONT_REDRAW? */
     }
 
+    /* In brief mode the messages aren't formatted (see TL_DEFERS_TEXT);
+       the name of the expert info's field is its registered summary */
+    summary = ei->summary;
+    if (data->brief && ei->hf_index != -1) {
+        summary = proto_registrar_get_nth(ei->hf_index)->name;
+    }
+
     /* If a duplicate just bump up frequency.
        TODO: could make more efficient by avoiding linear search...*/
     for (n=0; n < data->ei_array[severity_level]->len; n++) {
         entry = &g_array_index(data->ei_array[severity_level], expert_entry, n);
         if ((strcmp(ei->protocol, entry->protocol) == 0) &&
-            (strcmp(ei->summary, entry->summary) == 0)) {
+            (strcmp(summary, entry->summary) == 0)) {
             entry->frequency++;
             return TAP_PACKET_REDRAW;
         }
@@ -122,7 +131,7 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
     entry = &tmp_entry;
     /* Copy/Store protocol and summary strings efficiently using GStringChunk */
     entry->protocol = g_string_chunk_insert_const(data->text, ei->protocol);
-    entry->summary = g_string_chunk_insert_const(data->text, ei->summary);
+    entry->summary = g_string_chunk_insert_const(data->text, summary);
     entry->group = ei->group;
     entry->frequency = 1;
     /* Store a copy of the expert entry */
@@ -131,6 +140,75 @@ expert_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U
     return TAP_PACKET_REDRAW;
 }
 
+/* Serialize expert stats, for merging into another process's */
+static void
+expert_stat_serialize(void *tapdata, GByteArray *state)
+{
+    expert_tapdata_t *data = (expert_tapdata_t *)tapdata;
+    expert_entry     *entry;
+    gint              n;
+    guint             i;
+
+    for (n=0; n < max_level; n++) {
+        tap_merge_put_uint(state, data->ei_array[n]->len);
+        for (i=0; i < data->ei_array[n]->len; i++) {
+            entry = &g_array_index(data->ei_array[n], expert_entry, i);
+            tap_merge_put_uint(state, entry->group);
+            tap_merge_put_uint(state, (guint32)entry->frequency);
+            tap_merge_put_string(state, entry->protocol);
+            tap_merge_put_string(state, entry->summary);
+        }
+    }
+}
+
+/* Merge serialized expert stats of later frames into ours */
+static gboolean
+expert_stat_merge(void *tapdata, tap_merge_state_t *state)
+{
+    expert_tapdata_t *data = (expert_tapdata_t *)tapdata;
+    expert_entry      tmp_entry;
+    expert_entry     *entry;
+    const gchar      *protocol, *summary;
+    guint32           len, group, frequency;
+    gint              n;
+    guint             i, j;
+
+    for (n=0; n < max_level; n++) {
+        if (!tap_merge_get_uint(state, &len)) {
+            return FALSE;
+        }
+        for (i=0; i < len; i++) {
+            if (!tap_merge_get_uint(state, &group) ||
+                !tap_merge_get_uint(state, &frequency) ||
+                !tap_merge_get_string(state, &protocol) || !protocol ||
+                !tap_merge_get_string(state, &summary) || !summary) {
+                return FALSE;
+            }
+
+            /* As in expert_stat_packet(), keeping the first one's group */
+            for (j=0; j < data->ei_array[n]->len; j++) {
+                entry = &g_array_index(data->ei_array[n], expert_entry, j);
+                if ((strcmp(protocol, entry->protocol) == 0) &&
+                    (strcmp(summary, entry->summary) == 0)) {
+                    entry->frequency += (int)frequency;
+                    break;
+                }
+            }
+            if (j < data->ei_array[n]->len) {
+                continue;
+            }
+
+            tmp_entry.protocol = g_string_chunk_insert_const(data->text, protocol);
+            tmp_entry.summary = g_string_chunk_insert_const(data->text, summary);
+            tmp_entry.group = group;
+            tmp_entry.frequency = (int)frequency;
+            g_array_append_val(data->ei_array[n], tmp_entry);
+        }
+    }
+
+    return TRUE;
+}
+
 /* Output for all of the items of one severity */
 static void draw_items_for_severity(GArray *items, const gchar *label)
 {
@@ -200,6 +278,7 @@ static void expert_stat_init(const char *opt_arg, void *userdata _U_)
     const char       *filter = NULL;
     GString          *error_string;
     expert_tapdata_t *hs;
+    gboolean          brief  = FALSE;
     int               n;
 
     /* Check for args. */
@@ -233,7 +312,15 @@ static void expert_stat_init(const char *opt_arg, void *userdata _U_)
         }
     }
 
-    /* Second (optional) arg is a filter string */
+    /* Then (optional) brief */
+    if (args != NULL) {
+        if (g_ascii_strncasecmp(args, ",brief", 6) == 0 && (args[6] == '\0' || args[6] == ',')) {
+            brief = TRUE;
+            args += 6;
+        }
+    }
+
+    /* Last (optional) arg is a filter string */
     if (args != NULL) {
         if (args[0] == ',') {
             filter = args+1;
@@ -245,6 +332,7 @@ static void expert_stat_init(const char *opt_arg, void *userdata _U_)
 
     /* Allocate chunk of strings */
     hs->text = g_string_chunk_new(100);
+    hs->brief = brief;
 
     /* Allocate GArray for each severity level */
     for (n=0; n < max_level; n++) {
@@ -256,7 +344,7 @@ static void expert_stat_init(const char *opt_arg, void *userdata _U_)
     /**********************************************/
 
     error_string = register_tap_listener("expert", hs,
-                                         filter, 0,
+                                         filter, brief ? TL_DEFERS_TEXT : 0,
                                          expert_stat_reset,
                                          expert_stat_packet,
                                          expert_stat_draw,
@@ -267,6 +355,7 @@ static void expert_stat_init(const char *opt_arg, void *userdata _U_)
         expert_tapdata_free(hs);
         exit(1);
     }
+    set_tap_listener_merge(hs, expert_stat_serialize, expert_stat_merge);
 }
 
 static stat_tap_ui expert_stat_ui = {
@@ -144,10 +144,13 @@ eo_draw(void *tapdata)
         save_as_fullpath = NULL;
         slist = slist->next;
     }
+
+    eo_spill_free(tap_object->spill);
+    tap_object->spill = NULL;
 }
 
 static void
-exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
+exportobject_handler(gpointer key, gpointer value, gpointer user_data _U_)
 {
     GString *error_msg;
     export_object_list_t *tap_data;
@@ -170,6 +173,10 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
 
     object_list->eo = eo;
 
+    /* Write the objects out as they're found, next to where they'll be
+       saved, rather than keeping them all in memory until the end */
+    tap_data->spill = eo_spill_new((const gchar*)value);
+
     /* Data will be gathered via a tap callback */
     error_msg = register_tap_listener(get_eo_tap_listener_name(eo), tap_data, NULL, 0,
                       NULL, get_eo_packet_func(eo), eo_draw, NULL);
@@ -177,6 +184,7 @@ exportobject_handler(gpointer key, gpointer value _U_, gpointer user_data _U_)
     if (error_msg) {
         cmdarg_err("Can't register %s tap: %s", (const char*)key, error_msg->str);
         g_string_free(error_msg, TRUE);
+        eo_spill_free(tap_data->spill);
         g_free(tap_data);
         g_free(object_list);
         return;
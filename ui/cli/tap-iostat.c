@@ -78,6 +78,106 @@ typedef struct _io_stat_item_t {
 
 static guint64 last_relative_time;
 
+/* Add an empty interval (row) after the last one of a stat column */
+static io_stat_item_t *
+append_interval(io_stat_item_t *mit)
+{
+    io_stat_item_t *it = mit->prev;
+
+    it->next = (io_stat_item_t *)g_malloc(sizeof(io_stat_item_t));
+    it->next->prev = it;
+    it->next->next = NULL;
+    it = it->next;
+    mit->prev = it;
+
+    it->start_time = it->prev->start_time + mit->parent->interval;
+    it->frames = 0;
+    it->counter = 0;
+    it->float_counter = 0;
+    it->double_counter = 0;
+    it->num = 0;
+    it->calc_type = it->prev->calc_type;
+    it->hf_index = it->prev->hf_index;
+    it->colnum = it->prev->colnum;
+
+    return it;
+}
+
+/* Store the highest value for this item in order to determine the width of each stat column.
+*  For real numbers we only need to know its magnitude (the value to the left of the decimal point
+*  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
+*  calc the average, round it to the next second and store the seconds. For all other calc types
+*  of RELATIVE_TIME fields, store the counters without modification.
+*  fields. */
+static void
+update_max_vals(io_stat_t *parent, io_stat_item_t *it)
+{
+    int ftype;
+
+    switch (it->calc_type) {
+        case CALC_TYPE_FRAMES:
+        case CALC_TYPE_FRAMES_AND_BYTES:
+            parent->max_frame[it->colnum] =
+                MAX(parent->max_frame[it->colnum], it->frames);
+            if (it->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
+                parent->max_vals[it->colnum] =
+                    MAX(parent->max_vals[it->colnum], it->counter);
+            break;
+        case CALC_TYPE_BYTES:
+        case CALC_TYPE_COUNT:
+        case CALC_TYPE_LOAD:
+            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
+            break;
+        case CALC_TYPE_SUM:
+        case CALC_TYPE_MIN:
+        case CALC_TYPE_MAX:
+            ftype = proto_registrar_get_ftype(it->hf_index);
+            switch (ftype) {
+                case FT_FLOAT:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
+                    break;
+                case FT_DOUBLE:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)(it->double_counter+0.5));
+                    break;
+                case FT_RELATIVE_TIME:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter);
+                    break;
+                default:
+                    /* UINT16-64 and INT8-64 */
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter);
+                    break;
+            }
+            break;
+        case CALC_TYPE_AVG:
+            if (it->num == 0) /* avoid division by zero */
+               break;
+            ftype = proto_registrar_get_ftype(it->hf_index);
+            switch (ftype) {
+                case FT_FLOAT:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
+                    break;
+                case FT_DOUBLE:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (guint64)it->double_counter/it->num);
+                    break;
+                case FT_RELATIVE_TIME:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
+                    break;
+                default:
+                    /* UINT16-64 and INT8-64 */
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
+                    break;
+            }
+    }
+}
+
 static tap_packet_status
 iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_)
 {
@@ -115,21 +215,7 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
     *  struct will be created for it. */
     rt = relative_time;
     while (rt >= it->start_time + parent->interval) {
-        it->next = (io_stat_item_t *)g_malloc(sizeof(io_stat_item_t));
-        it->next->prev = it;
-        it->next->next = NULL;
-        it = it->next;
-        mit->prev = it;
-
-        it->start_time = it->prev->start_time + parent->interval;
-        it->frames = 0;
-        it->counter = 0;
-        it->float_counter = 0;
-        it->double_counter = 0;
-        it->num = 0;
-        it->calc_type = it->prev->calc_type;
-        it->hf_index = it->prev->hf_index;
-        it->colnum = it->prev->colnum;
+        it = append_interval(mit);
     }
 
     /* Store info in the current structure */
@@ -438,75 +524,164 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     }
-    /* Store the highest value for this item in order to determine the width of each stat column.
-    *  For real numbers we only need to know its magnitude (the value to the left of the decimal point
-    *  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
-    *  calc the average, round it to the next second and store the seconds. For all other calc types
-    *  of RELATIVE_TIME fields, store the counters without modification.
-    *  fields. */
-    switch (it->calc_type) {
-        case CALC_TYPE_FRAMES:
-        case CALC_TYPE_FRAMES_AND_BYTES:
-            parent->max_frame[it->colnum] =
-                MAX(parent->max_frame[it->colnum], it->frames);
-            if (it->calc_type == CALC_TYPE_FRAMES_AND_BYTES)
-                parent->max_vals[it->colnum] =
-                    MAX(parent->max_vals[it->colnum], it->counter);
-            break;
-        case CALC_TYPE_BYTES:
-        case CALC_TYPE_COUNT:
-        case CALC_TYPE_LOAD:
-            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
-            break;
-        case CALC_TYPE_SUM:
+    update_max_vals(parent, it);
+
+    return TAP_PACKET_REDRAW;
+}
+
+/* Append a stat column's intervals, for merging into another process's */
+static void
+iostat_serialize(void *arg, GByteArray *state)
+{
+    io_stat_item_t *mit = (io_stat_item_t *)arg;
+    io_stat_t *parent = mit->parent;
+    io_stat_item_t *it;
+    guint32 num_items = 0;
+
+    tap_merge_put_bytes(state, &parent->start_time, sizeof(parent->start_time));
+    tap_merge_put_bytes(state, &parent->max_vals[mit->colnum], sizeof(guint64));
+    tap_merge_put_uint(state, parent->max_frame[mit->colnum]);
+
+    for (it = mit; it; it = it->next)
+        num_items++;
+    tap_merge_put_uint(state, num_items);
+
+    for (it = mit; it; it = it->next) {
+        tap_merge_put_uint(state, it->frames);
+        tap_merge_put_uint(state, it->num);
+        tap_merge_put_bytes(state, &it->counter, sizeof(it->counter));
+        tap_merge_put_bytes(state, &it->float_counter, sizeof(it->float_counter));
+        tap_merge_put_bytes(state, &it->double_counter, sizeof(it->double_counter));
+    }
+}
+
+/* Is other's value for a MIN or MAX item lower (or higher) than it's? */
+static gboolean
+iostat_value_beyond(const io_stat_item_t *it, const io_stat_item_t *other, gboolean lower)
+{
+    switch (proto_registrar_get_ftype(it->hf_index)) {
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return lower ? (gint32)other->counter < (gint32)it->counter : (gint32)other->counter > (gint32)it->counter;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return lower ? (gint64)other->counter < (gint64)it->counter : (gint64)other->counter > (gint64)it->counter;
+    case FT_FLOAT:
+        return lower ? other->float_counter < it->float_counter : other->float_counter > it->float_counter;
+    case FT_DOUBLE:
+        return lower ? other->double_counter < it->double_counter : other->double_counter > it->double_counter;
+    default:
+        /* UINT8-64 and RELATIVE_TIME */
+        return lower ? other->counter < it->counter : other->counter > it->counter;
+    }
+}
+
+/*
+*  Can a stat column's intervals be merged with no difference from having seen all frames? The
+*  column width is the highest value an interval had after any frame. For counters that only grow
+*  that is the final value, which the merge recalculates. AVG, MIN, SUM of signed values and LOAD
+*  (which adds to earlier intervals) would need the values partway through the interval split
+*  between two processes.
+*/
+static gboolean
+iostat_merge_exact(const io_stat_item_t *mit)
+{
+    switch (mit->calc_type) {
+    case CALC_TYPE_FRAMES:
+    case CALC_TYPE_BYTES:
+    case CALC_TYPE_FRAMES_AND_BYTES:
+    case CALC_TYPE_COUNT:
+        return TRUE;
+    case CALC_TYPE_SUM:
+    case CALC_TYPE_MAX:
+        switch (proto_registrar_get_ftype(mit->hf_index)) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+            return TRUE;
+        default:
+            return FALSE;
+        }
+    default:
+        return FALSE;
+    }
+}
+
+/*
+*  Merge a stat column's intervals from frames following ours. An interval our last frames and the
+*  other's first frames fell into ends up as if we had seen them all. Only columns
+*  iostat_merge_exact() accepts are merged.
+*/
+static gboolean
+iostat_merge(void *arg, tap_merge_state_t *state)
+{
+    io_stat_item_t *mit = (io_stat_item_t *)arg;
+    io_stat_t *parent = mit->parent;
+    io_stat_item_t *it = mit;
+    io_stat_item_t other;
+    time_t start_time;
+    guint64 max_val;
+    guint32 max_frame, num_items, i;
+
+    if (!tap_merge_get_bytes(state, &start_time, sizeof(start_time)) ||
+        !tap_merge_get_bytes(state, &max_val, sizeof(max_val)) ||
+        !tap_merge_get_uint(state, &max_frame) ||
+        !tap_merge_get_uint(state, &num_items))
+        return FALSE;
+
+    if (parent->start_time == 0)
+        parent->start_time = start_time;
+    parent->max_vals[mit->colnum] = MAX(parent->max_vals[mit->colnum], max_val);
+    parent->max_frame[mit->colnum] = MAX(parent->max_frame[mit->colnum], max_frame);
+
+    for (i = 0; i < num_items; i++) {
+        if (!tap_merge_get_uint(state, &other.frames) ||
+            !tap_merge_get_uint(state, &other.num) ||
+            !tap_merge_get_bytes(state, &other.counter, sizeof(other.counter)) ||
+            !tap_merge_get_bytes(state, &other.float_counter, sizeof(other.float_counter)) ||
+            !tap_merge_get_bytes(state, &other.double_counter, sizeof(other.double_counter)))
+            return FALSE;
+
+        if (i > 0) {
+            it = it->next ? it->next : append_interval(mit);
+        }
+
+        if (other.frames == 0)
+            continue;
+
+        switch (it->calc_type) {
         case CALC_TYPE_MIN:
         case CALC_TYPE_MAX:
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->float_counter+0.5));
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)(it->double_counter+0.5));
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
+            /* A MAX starts out at 0, but a MIN at its first value */
+            if ((it->calc_type == CALC_TYPE_MIN && it->frames == 0) ||
+                iostat_value_beyond(it, &other, it->calc_type == CALC_TYPE_MIN)) {
+                it->counter = other.counter;
+                it->float_counter = other.float_counter;
+                it->double_counter = other.double_counter;
             }
             break;
-        case CALC_TYPE_AVG:
-            if (it->num == 0) /* avoid division by zero */
-               break;
-            ftype = proto_registrar_get_ftype(it->hf_index);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->float_counter/it->num);
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (guint64)it->double_counter/it->num);
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], ((it->counter/(guint64)it->num) + G_GUINT64_CONSTANT(500000000)) / NANOSECS_PER_SEC);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
-                    break;
-            }
+        default:
+            it->counter += other.counter;
+            it->float_counter += other.float_counter;
+            it->double_counter += other.double_counter;
+            break;
+        }
+        it->frames += other.frames;
+        it->num += other.num;
+
+        update_max_vals(parent, it);
     }
-    return TAP_PACKET_REDRAW;
+
+    return TRUE;
 }
 
 static int
@@ -1381,6 +1556,8 @@ register_io_tap(io_stat_t *io, int i, const char *filter)
         g_string_free(error_string, TRUE);
         exit(1);
     }
+    if (iostat_merge_exact(&io->items[i]))
+        set_tap_listener_merge(&io->items[i], iostat_serialize, iostat_merge);
 }
 
 static void
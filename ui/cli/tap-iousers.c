@@ -40,6 +40,13 @@ iousers_draw(void *arg)
 	printf("================================================================================\n");
 	printf("%s Conversations\n", iu->type);
 	printf("Filter:%s\n", iu->filter ? iu->filter : "<No Filter>");
+	if (iu->hash.max_items) {
+		printf("Top %u conversations (approximate", iu->hash.max_items);
+		if (iu->hash.evicted_frames) {
+			printf(", frames of dropped conversations: %" G_GINT64_MODIFIER "u", iu->hash.evicted_frames);
+		}
+		printf(")\n");
+	}
 
 	switch (timestamp_get_type()) {
 	case TS_ABSOLUTE:
@@ -230,6 +237,7 @@ void init_iousers(struct register_ct *ct, const char *filter)
 
 	iu = g_new0(io_users_t, 1);
 	iu->type = proto_get_protocol_short_name(find_protocol_by_id(get_conversation_proto_id(ct)));
+	filter = conversation_table_parse_max_items(filter, &iu->hash.max_items);
 	iu->filter = g_strdup(filter);
 	iu->hash.user_data = iu;
 
@@ -241,6 +249,7 @@ void init_iousers(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_merge(&iu->hash, conversation_table_serialize, conversation_table_merge);
 
 }
 
@@ -109,6 +109,7 @@ init_rtd_tables(register_rtd_t* rtd, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
+	set_tap_listener_merge(&ui->rtd, rtd_table_serialize, rtd_table_merge);
 }
 
 static void
@@ -18,6 +18,7 @@
 #include <wsutil/report_message.h>
 
 #include <epan/stats_tree_priv.h>
+#include <epan/prefs.h>
 #include <epan/stat_tap_ui.h>
 
 void register_tap_listener_stats_tree_stat(void);
@@ -91,6 +92,9 @@ init_stats_tree(const char *opt_arg, void *userdata _U_)
 		report_failure("stats_tree for: %s failed to attach to the tap: %s", cfg->name, error_string->str);
 		return;
 	}
+	/* A burst can span the frames of two processes, so burst rates can't be merged */
+	if (!prefs.st_enable_burstinfo)
+		set_tap_listener_merge(st, stats_tree_serialize, stats_tree_merge);
 
 	if (cfg->init) cfg->init(st);
 
@@ -27,6 +27,52 @@
 
 #include "export_object_ui.h"
 
+#define EO_COPY_BUFSIZE 65536
+
+/* Copy a payload that was written to a spill directory, a buffer at a time */
+static void
+eo_save_spilled_entry(const gchar *save_as_filename, int to_fd, export_object_entry_t *entry)
+{
+    int from_fd;
+    guint8 *buf;
+    ssize_t bytes_read;
+    ssize_t bytes_written;
+    ssize_t offset;
+    int err;
+
+    from_fd = ws_open(entry->payload_path, O_RDONLY | O_BINARY, 0000);
+    if (from_fd == -1) {
+        report_open_failure(entry->payload_path, errno, FALSE);
+        ws_close(to_fd);
+        return;
+    }
+
+    buf = (guint8 *)g_malloc(EO_COPY_BUFSIZE);
+    while ((bytes_read = ws_read(from_fd, buf, EO_COPY_BUFSIZE)) > 0) {
+        for (offset = 0; offset < bytes_read; offset += bytes_written) {
+            bytes_written = ws_write(to_fd, buf + offset, (int)(bytes_read - offset));
+            if (bytes_written <= 0) {
+                if (bytes_written < 0)
+                    err = errno;
+                else
+                    err = WTAP_ERR_SHORT_WRITE;
+                report_write_failure(save_as_filename, err);
+                g_free(buf);
+                ws_close(from_fd);
+                ws_close(to_fd);
+                return;
+            }
+        }
+    }
+    if (bytes_read < 0)
+        report_read_failure(entry->payload_path, errno);
+    g_free(buf);
+    ws_close(from_fd);
+
+    if (ws_close(to_fd) < 0)
+        report_write_failure(save_as_filename, errno);
+}
+
 void
 eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
 {
@@ -44,6 +90,11 @@ eo_save_entry(const gchar *save_as_filename, export_object_entry_t *entry)
         return;
     }
 
+    if (entry->payload_path) {
+        eo_save_spilled_entry(save_as_filename, to_fd, entry);
+        return;
+    }
+
     /*
      * The third argument to _write() on Windows is an unsigned int,
      * so, on Windows, that's the size of the third argument to
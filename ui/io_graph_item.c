@@ -17,12 +17,10 @@
 
 #include "ui/io_graph_item.h"
 
-int get_io_graph_index(packet_info *pinfo, int interval) {
+/* Milliseconds since the first packet, or -1 if the packet is before it. */
+static gint64 get_io_graph_msec(packet_info *pinfo) {
     nstime_t time_delta;
 
-    /*
-     * Find in which interval this is supposed to go and store the interval index as idx
-     */
     time_delta = pinfo->rel_ts;
     if (time_delta.nsecs<0) {
         time_delta.secs--;
@@ -31,7 +29,21 @@ int get_io_graph_index(packet_info *pinfo, int interval) {
     if (time_delta.secs<0) {
         return -1;
     }
-    return (int) ((time_delta.secs*1000 + time_delta.nsecs/1000000) / interval);
+    return (gint64)time_delta.secs*1000 + time_delta.nsecs/1000000;
+}
+
+int get_io_graph_index(packet_info *pinfo, int interval) {
+    gint64 idx;
+
+    /*
+     * Find in which interval this is supposed to go and store the interval index as idx
+     */
+    idx = get_io_graph_msec(pinfo);
+    if (idx < 0) {
+        return -1;
+    }
+    idx /= interval;
+    return idx > G_MAXINT ? G_MAXINT : (int) idx;
 }
 
 GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_unit_t item_unit)
@@ -263,6 +275,338 @@ double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val
     return value;
 }
 
+typedef struct {
+    gint64 idx;                 /* index of the bucket within its level */
+    io_graph_item_t item;
+} io_graph_bucket_t;
+
+/* Bucket width of a level (ms) */
+static gint64 pyramid_level_width(guint level)
+{
+    gint64 width = 1;
+
+    while (level--) {
+        width *= 10;
+    }
+    return width;
+}
+
+io_graph_pyramid_t *io_graph_pyramid_new(void)
+{
+    io_graph_pyramid_t *pyramid = g_new0(io_graph_pyramid_t, 1);
+    int level;
+
+    for (level = 0; level < IO_GRAPH_PYRAMID_LEVELS; level++) {
+        pyramid->levels[level] = g_array_new(FALSE, FALSE, sizeof(io_graph_bucket_t));
+    }
+    pyramid->hf_index = -1;
+    pyramid->num_valid_levels = 1;
+    return pyramid;
+}
+
+void io_graph_pyramid_free(io_graph_pyramid_t *pyramid)
+{
+    int level;
+
+    if (!pyramid) {
+        return;
+    }
+    for (level = 0; level < IO_GRAPH_PYRAMID_LEVELS; level++) {
+        g_array_free(pyramid->levels[level], TRUE);
+    }
+    g_free(pyramid);
+}
+
+void io_graph_pyramid_reset(io_graph_pyramid_t *pyramid, int hf_index, io_graph_item_unit_t item_unit, int interval)
+{
+    int level;
+
+    /* Give the memory back, the next graph may have far fewer buckets. */
+    for (level = 0; level < IO_GRAPH_PYRAMID_LEVELS; level++) {
+        g_array_free(pyramid->levels[level], TRUE);
+        pyramid->levels[level] = g_array_new(FALSE, FALSE, sizeof(io_graph_bucket_t));
+    }
+    pyramid->hf_index = hf_index;
+    pyramid->load = hf_index >= 0 && item_unit == IOG_ITEM_UNIT_CALC_LOAD;
+    pyramid->base_level = 0;
+    pyramid->max_base_level = 0;
+    while (interval > 0 && pyramid->max_base_level + 1 < IO_GRAPH_PYRAMID_LEVELS &&
+           interval % pyramid_level_width(pyramid->max_base_level + 1) == 0) {
+        pyramid->max_base_level++;
+    }
+    pyramid->num_valid_levels = 1;
+}
+
+gboolean io_graph_pyramid_has_data(const io_graph_pyramid_t *pyramid, int hf_index, io_graph_item_unit_t item_unit, int interval)
+{
+    if (hf_index != pyramid->hf_index) {
+        return FALSE;
+    }
+    if (hf_index >= 0 && (item_unit == IOG_ITEM_UNIT_CALC_LOAD) != pyramid->load) {
+        return FALSE;
+    }
+    return interval > 0 && interval % pyramid_level_width(pyramid->base_level) == 0;
+}
+
+/* Find the bucket with the given index, adding it if there's none. Packets
+ * mostly come in time order, so try the last one first. */
+static io_graph_item_t *get_bucket_item(GArray *level, gint64 idx)
+{
+    io_graph_bucket_t new_bucket;
+    guint lo = 0, hi = level->len;
+
+    if (hi > 0) {
+        io_graph_bucket_t *last = &g_array_index(level, io_graph_bucket_t, hi - 1);
+
+        if (last->idx == idx) {
+            return &last->item;
+        }
+        if (last->idx > idx) {
+            while (lo < hi) {
+                guint mid = lo + (hi - lo) / 2;
+                io_graph_bucket_t *bucket = &g_array_index(level, io_graph_bucket_t, mid);
+
+                if (bucket->idx == idx) {
+                    return &bucket->item;
+                }
+                if (bucket->idx < idx) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+        } else {
+            lo = hi;
+        }
+    }
+
+    new_bucket.idx = idx;
+    reset_io_graph_items(&new_bucket.item, 1);
+    g_array_insert_val(level, lo, new_bucket);
+    return &g_array_index(level, io_graph_bucket_t, lo).item;
+}
+
+/* Spread the time a relative-time value spanned, up to the packet it is in,
+ * over the buckets. */
+static void add_pyramid_load(io_graph_pyramid_t *pyramid, packet_info *pinfo, const nstime_t *new_time)
+{
+    GArray *level = pyramid->levels[pyramid->base_level];
+    guint64 width_us = (guint64)pyramid_level_width(pyramid->base_level) * 1000;
+    guint64 t, start, end, pos, next;
+
+    t = new_time->secs;
+    t = t * 1000000 + new_time->nsecs / 1000;
+    end = pinfo->rel_ts.secs * 1000000 + pinfo->rel_ts.nsecs / 1000;
+    start = end > t ? end - t : 0;
+
+    for (pos = start; pos < end; pos = next) {
+        guint64 idx = pos / width_us;
+        io_graph_item_t *item = get_bucket_item(level, (gint64)idx);
+        nstime_t spanned;
+
+        next = MIN((idx + 1) * width_us, end);
+        spanned.secs = (time_t)((next - pos) / 1000000);
+        spanned.nsecs = (int)((next - pos) % 1000000) * 1000;
+        nstime_add(&item->time_tot, &spanned);
+    }
+}
+
+static void build_pyramid_level(io_graph_pyramid_t *pyramid, guint level, int ftype);
+
+gboolean io_graph_pyramid_add(io_graph_pyramid_t *pyramid, packet_info *pinfo, epan_dissect_t *edt)
+{
+    GArray *base = pyramid->levels[pyramid->base_level];
+    gint64 idx = get_io_graph_msec(pinfo);
+    gboolean ok;
+
+    if (idx < 0) {
+        return FALSE;
+    }
+    idx /= pyramid_level_width(pyramid->base_level);
+
+    if (edt && pyramid->load) {
+        /* LOAD depends on the interval; spread the time spanned by each
+         * value over the buckets, which intervals are made of. */
+        GPtrArray *gp = proto_get_finfo_ptr_array(edt->tree, pyramid->hf_index);
+        guint i;
+
+        if (!gp) {
+            return FALSE;
+        }
+        for (i = 0; i < gp->len; i++) {
+            add_pyramid_load(pyramid, pinfo, (nstime_t *)fvalue_get(&((field_info *)gp->pdata[i])->value));
+        }
+        ok = update_io_graph_item(get_bucket_item(base, idx), 0, pinfo, NULL, -1, IOG_ITEM_UNIT_PACKETS, 1);
+    } else {
+        /* Any unit but LOAD collects everything the others need. */
+        ok = update_io_graph_item(get_bucket_item(base, idx), 0, pinfo, edt,
+                                  pyramid->hf_index, IOG_ITEM_UNIT_CALC_SUM, 1);
+    }
+
+    /* Too many buckets: move on to the next level, as long as its buckets
+     * fit into the interval. */
+    if (base->len > IO_GRAPH_PYRAMID_MAX_BUCKETS && pyramid->base_level < pyramid->max_base_level) {
+        int ftype = pyramid->hf_index >= 0 ? proto_registrar_get_ftype(pyramid->hf_index) : FT_NONE;
+
+        build_pyramid_level(pyramid, pyramid->base_level + 1, ftype);
+        g_array_free(base, TRUE);
+        pyramid->levels[pyramid->base_level] = g_array_new(FALSE, FALSE, sizeof(io_graph_bucket_t));
+        pyramid->base_level++;
+    }
+
+    pyramid->num_valid_levels = pyramid->base_level + 1;
+    return ok;
+}
+
+/* Add the values of a later item to those of an earlier one. */
+static void merge_io_graph_item(io_graph_item_t *item, const io_graph_item_t *later, int ftype)
+{
+    gboolean new_max = FALSE, new_min = FALSE;
+
+    item->frames += later->frames;
+    item->bytes += later->bytes;
+    /* Time can go backwards, but frames are added in order. */
+    if (item->first_frame_in_invl == 0 ||
+        (later->first_frame_in_invl != 0 && later->first_frame_in_invl < item->first_frame_in_invl)) {
+        item->first_frame_in_invl = later->first_frame_in_invl;
+    }
+    item->last_frame_in_invl = MAX(item->last_frame_in_invl, later->last_frame_in_invl);
+    /* The total, or the LOAD time of buckets without values. */
+    nstime_add(&item->time_tot, &later->time_tot);
+
+    if (later->fields == 0) {
+        return;
+    }
+
+    if (item->fields == 0) {
+        new_max = new_min = TRUE;
+    } else {
+        switch (ftype) {
+        case FT_UINT8:
+        case FT_UINT16:
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_UINT40:
+        case FT_UINT48:
+        case FT_UINT56:
+        case FT_UINT64:
+            new_max = (guint64)later->int_max > (guint64)item->int_max;
+            new_min = (guint64)later->int_min < (guint64)item->int_min;
+            break;
+        case FT_INT8:
+        case FT_INT16:
+        case FT_INT24:
+        case FT_INT32:
+        case FT_INT40:
+        case FT_INT48:
+        case FT_INT56:
+        case FT_INT64:
+            new_max = later->int_max > item->int_max;
+            new_min = later->int_min < item->int_min;
+            break;
+        case FT_FLOAT:
+            new_max = later->float_max > item->float_max;
+            new_min = later->float_min < item->float_min;
+            break;
+        case FT_DOUBLE:
+            new_max = later->double_max > item->double_max;
+            new_min = later->double_min < item->double_min;
+            break;
+        case FT_RELATIVE_TIME:
+            new_max = nstime_cmp(&later->time_max, &item->time_max) > 0;
+            new_min = nstime_cmp(&later->time_min, &item->time_min) < 0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (new_max) {
+        item->int_max = later->int_max;
+        item->float_max = later->float_max;
+        item->double_max = later->double_max;
+        item->time_max = later->time_max;
+        item->max_frame_in_invl = later->max_frame_in_invl;
+    }
+    if (new_min) {
+        item->int_min = later->int_min;
+        item->float_min = later->float_min;
+        item->double_min = later->double_min;
+        item->time_min = later->time_min;
+        item->min_frame_in_invl = later->min_frame_in_invl;
+    }
+    item->int_tot += later->int_tot;
+    item->float_tot += later->float_tot;
+    item->double_tot += later->double_tot;
+    item->fields += later->fields;
+}
+
+/* Sum up the buckets of a level into those of the next, ten times as wide. */
+static void build_pyramid_level(io_graph_pyramid_t *pyramid, guint level, int ftype)
+{
+    GArray *finer = pyramid->levels[level - 1];
+    GArray *coarser = pyramid->levels[level];
+    io_graph_bucket_t *bucket = NULL;
+    guint i;
+
+    g_array_set_size(coarser, 0);
+    for (i = 0; i < finer->len; i++) {
+        io_graph_bucket_t *fine = &g_array_index(finer, io_graph_bucket_t, i);
+
+        if (!bucket || bucket->idx != fine->idx / 10) {
+            g_array_set_size(coarser, coarser->len + 1);
+            bucket = &g_array_index(coarser, io_graph_bucket_t, coarser->len - 1);
+            bucket->idx = fine->idx / 10;
+            reset_io_graph_items(&bucket->item, 1);
+        }
+        merge_io_graph_item(&bucket->item, &fine->item, ftype);
+    }
+}
+
+int io_graph_pyramid_get_items(io_graph_pyramid_t *pyramid, int interval, io_graph_item_unit_t item_unit _U_, io_graph_item_t *items, int max_items)
+{
+    int ftype = pyramid->hf_index >= 0 ? proto_registrar_get_ftype(pyramid->hf_index) : FT_NONE;
+    guint level = pyramid->base_level;
+    gint64 width = pyramid_level_width(level); /* bucket width of the level (ms) */
+    GArray *buckets;
+    int cur_idx = -1;
+    guint i;
+
+    if (interval <= 0 || max_items <= 0 || interval % width != 0) {
+        return -1;
+    }
+
+    /* Use the coarsest level whose buckets each fall into a single interval. */
+    while (level + 1 < IO_GRAPH_PYRAMID_LEVELS && interval % (width * 10) == 0) {
+        level++;
+        width *= 10;
+    }
+    while (pyramid->num_valid_levels <= level) {
+        build_pyramid_level(pyramid, pyramid->num_valid_levels, ftype);
+        pyramid->num_valid_levels++;
+    }
+
+    buckets = pyramid->levels[level];
+    for (i = 0; i < buckets->len; i++) {
+        io_graph_bucket_t *bucket = &g_array_index(buckets, io_graph_bucket_t, i);
+        gint64 idx = bucket->idx * width / interval;
+
+        if (idx >= max_items) {
+            /* As far as we can go. */
+            reset_io_graph_items(&items[cur_idx + 1], max_items - 1 - cur_idx);
+            cur_idx = max_items - 1;
+            break;
+        }
+        if (idx > cur_idx) {
+            reset_io_graph_items(&items[cur_idx + 1], (gsize)(idx - cur_idx));
+            cur_idx = (int)idx;
+        }
+        merge_io_graph_item(&items[idx], &bucket->item, ftype);
+    }
+
+    return cur_idx;
+}
+
 /*
  * Editor modelines
  *
@@ -55,7 +55,8 @@ typedef struct _io_graph_item_t {
     nstime_t time_min;
     nstime_t time_tot;
     guint32  first_frame_in_invl;
-    guint32  extreme_frame_in_invl; /* frame with min/max value */
+    guint32  min_frame_in_invl; /* frame with min value */
+    guint32  max_frame_in_invl; /* frame with max value */
     guint32  last_frame_in_invl;
 } io_graph_item_t;
 
@@ -88,7 +89,8 @@ reset_io_graph_items(io_graph_item_t *items, gsize count) {
         nstime_set_zero(&item->time_min);
         nstime_set_zero(&item->time_tot);
         item->first_frame_in_invl = 0;
-        item->extreme_frame_in_invl = 0;
+        item->min_frame_in_invl = 0;
+        item->max_frame_in_invl = 0;
         item->last_frame_in_invl  = 0;
     }
 }
@@ -99,7 +101,8 @@ reset_io_graph_items(io_graph_item_t *items, gsize count) {
  *
  * @param [in] pinfo Packet of interest.
  * @param [in] interval Time interval in milliseconds.
- * @return Array index on success, -1 on failure.
+ * @return Array index on success, -1 on failure. Indexes too large for an
+ * int are returned as G_MAXINT.
  */
 int get_io_graph_index(packet_info *pinfo, int interval);
 
@@ -178,16 +181,12 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                 if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
                     item->int_max = new_uint64;
                     item->double_max = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->max_frame_in_invl = pinfo->num;
                 }
                 if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
                     item->int_min = new_uint64;
                     item->double_min = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->min_frame_in_invl = pinfo->num;
                 }
                 item->int_tot += new_uint64;
                 item->double_tot += (gdouble)new_uint64;
@@ -201,16 +200,12 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                 if ((new_int64 > item->int_max) || (item->fields == 0)) {
                     item->int_max = new_int64;
                     item->double_max = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->max_frame_in_invl = pinfo->num;
                 }
                 if ((new_int64 < item->int_min) || (item->fields == 0)) {
                     item->int_min = new_int64;
                     item->double_min = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->min_frame_in_invl = pinfo->num;
                 }
                 item->int_tot += new_int64;
                 item->double_tot += (gdouble)new_int64;
@@ -224,16 +219,12 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                 if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
                     item->int_max = new_uint64;
                     item->double_max = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->max_frame_in_invl = pinfo->num;
                 }
                 if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
                     item->int_min = new_uint64;
                     item->double_min = (gdouble)new_uint64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->min_frame_in_invl = pinfo->num;
                 }
                 item->int_tot += new_uint64;
                 item->double_tot += (gdouble)new_uint64;
@@ -247,16 +238,12 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                 if ((new_int64 > item->int_max) || (item->fields == 0)) {
                     item->int_max = new_int64;
                     item->double_max = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->max_frame_in_invl = pinfo->num;
                 }
                 if ((new_int64 < item->int_min) || (item->fields == 0)) {
                     item->int_min = new_int64;
                     item->double_min = (gdouble)new_int64;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->min_frame_in_invl = pinfo->num;
                 }
                 item->int_tot += new_int64;
                 item->double_tot += (gdouble)new_int64;
@@ -266,15 +253,11 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                 new_float = (gfloat)fvalue_get_floating(&((field_info *)gp->pdata[i])->value);
                 if ((new_float > item->float_max) || (item->fields == 0)) {
                     item->float_max = new_float;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->max_frame_in_invl = pinfo->num;
                 }
                 if ((new_float < item->float_min) || (item->fields == 0)) {
                     item->float_min = new_float;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->min_frame_in_invl = pinfo->num;
                 }
                 item->float_tot += new_float;
                 item->fields++;
@@ -283,15 +266,11 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                 new_double = fvalue_get_floating(&((field_info *)gp->pdata[i])->value);
                 if ((new_double > item->double_max) || (item->fields == 0)) {
                     item->double_max = new_double;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->max_frame_in_invl = pinfo->num;
                 }
                 if ((new_double < item->double_min) || (item->fields == 0)) {
                     item->double_min = new_double;
-                    if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                        item->extreme_frame_in_invl = pinfo->num;
-                    }
+                    item->min_frame_in_invl = pinfo->num;
                 }
                 item->double_tot += new_double;
                 item->fields++;
@@ -348,18 +327,14 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                               && (new_time->nsecs > item->time_max.nsecs))
                          || (item->fields == 0)) {
                         item->time_max = *new_time;
-                        if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
-                            item->extreme_frame_in_invl = pinfo->num;
-                        }
+                        item->max_frame_in_invl = pinfo->num;
                     }
                     if ( (new_time->secs<item->time_min.secs)
                          || ( (new_time->secs == item->time_min.secs)
                               && (new_time->nsecs < item->time_min.nsecs))
                          || (item->fields == 0)) {
                         item->time_min = *new_time;
-                        if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
-                            item->extreme_frame_in_invl = pinfo->num;
-                        }
+                        item->min_frame_in_invl = pinfo->num;
                     }
                     nstime_add(&item->time_tot, new_time);
                     item->fields++;
@@ -394,6 +369,99 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
     return TRUE;
 }
 
+/** Number of levels in an io_graph_pyramid_t. Level n has buckets of
+ * 10^n milliseconds, from 1 ms up to 100 s. */
+#define IO_GRAPH_PYRAMID_LEVELS 6
+
+/** Number of buckets the level packets are added to can have before it is
+ * replaced by the next, coarser one. */
+#define IO_GRAPH_PYRAMID_MAX_BUCKETS 100000
+
+/** Time-bucketed I/O graph data for any interval.
+ *
+ * Packets are added once into sparse buckets, which are summed up into
+ * coarser levels as needed. The items for an interval, and for any value
+ * unit that can be calculated from the collected data, are then made from
+ * the coarsest level whose buckets fit into the interval, without going
+ * over the packets again.
+ *
+ * Packets start out in 1 ms buckets. When there are too many of those the
+ * data is moved to 10 ms buckets, and so on, but never to buckets wider
+ * than the interval the pyramid was reset for. Intervals finer than the
+ * buckets then need the packets to be added again, see
+ * io_graph_pyramid_has_data().
+ */
+typedef struct _io_graph_pyramid_t {
+    int      hf_index;          /* field advanced statistics are collected for, or -1 */
+    gboolean load;              /* time_tot holds the LOAD of the field, not its total */
+    GArray  *levels[IO_GRAPH_PYRAMID_LEVELS]; /* io_graph_bucket_t, sorted by index */
+    guint    base_level;        /* level packets are added to, the finer ones are empty */
+    guint    max_base_level;    /* coarsest level whose buckets fit into the interval */
+    guint    num_valid_levels;  /* levels that are up to date with the base level */
+} io_graph_pyramid_t;
+
+/** Create an empty io_graph_pyramid_t.
+ *
+ * @return A new pyramid, to be freed with io_graph_pyramid_free().
+ */
+io_graph_pyramid_t *io_graph_pyramid_new(void);
+
+/** Free an io_graph_pyramid_t.
+ *
+ * @param pyramid [in] The pyramid to free.
+ */
+void io_graph_pyramid_free(io_graph_pyramid_t *pyramid);
+
+/** Remove all data from an io_graph_pyramid_t, before adding packets for
+ * a graph.
+ *
+ * @param pyramid [in,out] The pyramid to reset.
+ * @param hf_index [in] Header field index for advanced statistics, or -1.
+ * @param item_unit [in] The value unit of the graph. LOAD can't be
+ * calculated from the data collected for the other units, and the other
+ * way around.
+ * @param interval [in] Timing interval of the graph in ms.
+ */
+void io_graph_pyramid_reset(io_graph_pyramid_t *pyramid, int hf_index, io_graph_item_unit_t item_unit, int interval);
+
+/** Check whether the items for a graph can be made from the data in an
+ * io_graph_pyramid_t, or the packets have to be added again.
+ *
+ * @param pyramid [in] The pyramid.
+ * @param hf_index [in] Header field index for advanced statistics, or -1.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param interval [in] Timing interval in ms.
+ * @return TRUE if io_graph_pyramid_get_items() can make the items.
+ */
+gboolean io_graph_pyramid_has_data(const io_graph_pyramid_t *pyramid, int hf_index, io_graph_item_unit_t item_unit, int interval);
+
+/** Add a packet to an io_graph_pyramid_t.
+ *
+ * Frame and byte counts are always calculated. If edt is non-NULL advanced
+ * statistics are calculated for every value unit but LOAD, or for LOAD
+ * alone, using the pyramid's field.
+ *
+ * @param pyramid [in,out] The pyramid to update.
+ * @param pinfo [in] Packet containing update information.
+ * @param edt [in] Dissection information for advanced statistics. May be NULL.
+ * @return TRUE if the update was successful, otherwise FALSE.
+ */
+gboolean io_graph_pyramid_add(io_graph_pyramid_t *pyramid, packet_info *pinfo, epan_dissect_t *edt);
+
+/** Fill in the items for an interval from an io_graph_pyramid_t.
+ *
+ * Items past the last one with data are left as they are. The pyramid must
+ * have the data, see io_graph_pyramid_has_data().
+ *
+ * @param pyramid [in] The pyramid to get the items from.
+ * @param interval [in] Timing interval in ms.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param items [out] Array receiving the items.
+ * @param max_items [in] The number of items in the array.
+ * @return The index of the last item with data, or -1 if there is none.
+ */
+int io_graph_pyramid_get_items(io_graph_pyramid_t *pyramid, int interval, io_graph_item_unit_t item_unit, io_graph_item_t *items, int max_items);
+
 
 #ifdef __cplusplus
 }
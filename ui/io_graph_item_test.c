@@ -0,0 +1,396 @@
+/* io_graph_item_test.c
+ * I/O graph pyramid tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
+#include <epan/test_report_message.h>
+#include <wiretap/wtap.h>
+
+#include "ui/io_graph_item.h"
+
+/*
+ * The items an io_graph_pyramid_t makes for an interval must be the same as
+ * those update_io_graph_item() makes when tapping at that interval, which
+ * is what the I/O graphs did before.
+ *
+ * The packets come at uneven times, with frame.len as an integer field and
+ * frame.time_delta as a relative-time one. Their values repeat, so ties for
+ * the minimum and the maximum are checked too.
+ */
+
+#define NUM_PACKETS 2000
+
+typedef struct {
+    nstime_t rel_ts;
+    guint32  pkt_len;
+    guint32  uint_value;
+    nstime_t time_value;
+} test_packet_t;
+
+static epan_t *test_session;
+static test_packet_t test_packets[NUM_PACKETS];
+static const guint8 test_data[4];
+
+static void
+make_packets(void)
+{
+    guint64 us = 0;
+    guint i;
+
+    for (i = 0; i < NUM_PACKETS; i++) {
+        test_packet_t *packet = &test_packets[i];
+
+        /* Mostly bursts, now and then a gap of a few intervals. */
+        us += (i % 50 == 0) ? 700000 + i : (i * 7919) % 3000;
+        packet->rel_ts.secs = (time_t)(us / 1000000);
+        packet->rel_ts.nsecs = (int)(us % 1000000) * 1000;
+        packet->pkt_len = 60 + (i * 31) % 1400;
+        packet->uint_value = (i * 37) % 100;
+        packet->time_value.secs = (i % 7 == 0) ? 2 : 0;
+        packet->time_value.nsecs = (int)((i * 131) % 1000) * 1000000;
+    }
+}
+
+static void
+tap_packet(guint i, int hf_index, GArray *refs, const int *intervals, io_graph_item_unit_t item_unit, io_graph_pyramid_t *pyramid)
+{
+    test_packet_t *packet = &test_packets[i];
+    epan_dissect_t *edt = NULL;
+    frame_data fd;
+    packet_info pinfo;
+    guint j;
+
+    memset(&fd, 0, sizeof fd);
+    memset(&pinfo, 0, sizeof pinfo);
+    fd.pkt_len = packet->pkt_len;
+    pinfo.fd = &fd;
+    pinfo.num = i + 1;
+    pinfo.rel_ts = packet->rel_ts;
+
+    if (hf_index >= 0) {
+        edt = epan_dissect_new(test_session, TRUE, FALSE);
+        edt->tvb = tvb_new_real_data(test_data, sizeof test_data, sizeof test_data);
+        proto_tree_prime_with_hfid(edt->tree, hf_index);
+        if (proto_registrar_get_ftype(hf_index) == FT_RELATIVE_TIME)
+            proto_tree_add_time(edt->tree, hf_index, edt->tvb, 0, 0, &packet->time_value);
+        else
+            proto_tree_add_uint(edt->tree, hf_index, edt->tvb, 0, 0, packet->uint_value);
+    }
+
+    for (j = 0; j < refs->len; j++) {
+        GArray *items = g_array_index(refs, GArray *, j);
+        int idx = get_io_graph_index(&pinfo, intervals[j]);
+
+        if ((guint)idx >= items->len) {
+            guint len = items->len;
+
+            g_array_set_size(items, idx + 1);
+            reset_io_graph_items(&g_array_index(items, io_graph_item_t, len), idx + 1 - len);
+        }
+        g_assert(update_io_graph_item((io_graph_item_t *)(void *)items->data, idx, &pinfo, edt,
+                                      hf_index, item_unit, intervals[j]));
+    }
+    g_assert(io_graph_pyramid_add(pyramid, &pinfo, edt));
+
+    if (edt)
+        epan_dissect_free(edt);
+}
+
+/* LOAD is in milliseconds, from a time normalized differently. */
+static gboolean
+values_equal(double value, double expected)
+{
+    return fabs(value - expected) <= 1e-9 * MAX(1.0, fabs(expected));
+}
+
+static void
+check_items(const io_graph_item_t *ref, const io_graph_item_t *got, int idx, int interval, io_graph_item_unit_t item_unit)
+{
+    if (ref->frames != got->frames || ref->bytes != got->bytes || ref->fields != got->fields ||
+        ref->first_frame_in_invl != got->first_frame_in_invl ||
+        ref->last_frame_in_invl != got->last_frame_in_invl ||
+        ref->min_frame_in_invl != got->min_frame_in_invl ||
+        ref->max_frame_in_invl != got->max_frame_in_invl)
+        g_error("interval %d item %d: counts or frames differ", interval, idx);
+
+    if (item_unit == IOG_ITEM_UNIT_CALC_LOAD) {
+        if (!values_equal(nstime_to_msec(&got->time_tot), nstime_to_msec(&ref->time_tot)))
+            g_error("interval %d item %d: load %f, expected %f", interval, idx,
+                    nstime_to_msec(&got->time_tot), nstime_to_msec(&ref->time_tot));
+        return;
+    }
+
+    if (ref->int_max != got->int_max || ref->int_min != got->int_min || ref->int_tot != got->int_tot ||
+        ref->double_max != got->double_max || ref->double_min != got->double_min ||
+        ref->double_tot != got->double_tot ||
+        nstime_cmp(&ref->time_max, &got->time_max) != 0 ||
+        nstime_cmp(&ref->time_min, &got->time_min) != 0 ||
+        nstime_cmp(&ref->time_tot, &got->time_tot) != 0)
+        g_error("interval %d item %d: values differ", interval, idx);
+}
+
+/*
+ * Tap every packet at each interval and into a pyramid reset for the first
+ * one, then check the pyramid's items at each interval, and the graph values
+ * of the units.
+ */
+static void
+check_pyramid(const char *field, io_graph_item_unit_t tap_unit, const int *intervals, guint num_intervals,
+              const io_graph_item_unit_t *units, guint num_units)
+{
+    int hf_index = field ? proto_registrar_get_id_byname(field) : -1;
+    io_graph_pyramid_t *pyramid = io_graph_pyramid_new();
+    GArray *refs = g_array_new(FALSE, FALSE, sizeof(GArray *));
+    guint i, j, k;
+
+    for (j = 0; j < num_intervals; j++) {
+        GArray *items = g_array_new(FALSE, FALSE, sizeof(io_graph_item_t));
+
+        g_array_append_val(refs, items);
+    }
+    io_graph_pyramid_reset(pyramid, hf_index, tap_unit, intervals[0]);
+    for (i = 0; i < NUM_PACKETS; i++)
+        tap_packet(i, hf_index, refs, intervals, tap_unit, pyramid);
+
+    for (j = 0; j < num_intervals; j++) {
+        GArray *ref = g_array_index(refs, GArray *, j);
+        io_graph_item_t *items = g_new(io_graph_item_t, ref->len);
+        int cur_idx;
+
+        g_assert(io_graph_pyramid_has_data(pyramid, hf_index, tap_unit, intervals[j]));
+        cur_idx = io_graph_pyramid_get_items(pyramid, intervals[j], tap_unit, items, ref->len);
+        g_assert_cmpint(cur_idx, ==, (int)ref->len - 1);
+
+        for (i = 0; i < ref->len; i++) {
+            const io_graph_item_t *ref_item = &g_array_index(ref, io_graph_item_t, i);
+
+            check_items(ref_item, &items[i], i, intervals[j], tap_unit);
+            for (k = 0; k < num_units; k++) {
+                double expected = get_io_graph_item((io_graph_item_t *)(void *)ref->data, units[k], i, hf_index, NULL, intervals[j], cur_idx);
+                double value = get_io_graph_item(items, units[k], i, hf_index, NULL, intervals[j], cur_idx);
+
+                if (!values_equal(value, expected))
+                    g_error("interval %d item %d unit %d: %f, expected %f", intervals[j], i, units[k], value, expected);
+            }
+        }
+        g_free(items);
+        g_array_free(ref, TRUE);
+    }
+
+    g_array_free(refs, TRUE);
+    io_graph_pyramid_free(pyramid);
+}
+
+static void
+io_graph_test_basic(void)
+{
+    static const int intervals[] = { 1, 3, 10, 30, 250, 1000, 10000, 600000 };
+    static const io_graph_item_unit_t units[] = {
+        IOG_ITEM_UNIT_PACKETS, IOG_ITEM_UNIT_BYTES, IOG_ITEM_UNIT_BITS
+    };
+
+    check_pyramid(NULL, IOG_ITEM_UNIT_PACKETS, intervals, G_N_ELEMENTS(intervals), units, G_N_ELEMENTS(units));
+}
+
+static void
+io_graph_test_uint(void)
+{
+    static const int intervals[] = { 1, 7, 10, 100, 1000, 60000 };
+    static const io_graph_item_unit_t units[] = {
+        IOG_ITEM_UNIT_CALC_SUM, IOG_ITEM_UNIT_CALC_FRAMES, IOG_ITEM_UNIT_CALC_FIELDS,
+        IOG_ITEM_UNIT_CALC_MAX, IOG_ITEM_UNIT_CALC_MIN, IOG_ITEM_UNIT_CALC_AVERAGE
+    };
+
+    check_pyramid("frame.len", IOG_ITEM_UNIT_CALC_SUM, intervals, G_N_ELEMENTS(intervals), units, G_N_ELEMENTS(units));
+}
+
+static void
+io_graph_test_time(void)
+{
+    static const int intervals[] = { 1, 20, 100, 500, 10000 };
+    static const io_graph_item_unit_t units[] = {
+        IOG_ITEM_UNIT_CALC_SUM, IOG_ITEM_UNIT_CALC_FIELDS,
+        IOG_ITEM_UNIT_CALC_MAX, IOG_ITEM_UNIT_CALC_MIN, IOG_ITEM_UNIT_CALC_AVERAGE
+    };
+
+    check_pyramid("frame.time_delta", IOG_ITEM_UNIT_CALC_AVERAGE, intervals, G_N_ELEMENTS(intervals), units, G_N_ELEMENTS(units));
+}
+
+static void
+io_graph_test_load(void)
+{
+    /* update_io_graph_item() overflows its nanoseconds past 1 s intervals. */
+    static const int intervals[] = { 1, 3, 10, 40, 100, 1000 };
+    static const io_graph_item_unit_t units[] = { IOG_ITEM_UNIT_CALC_LOAD };
+
+    check_pyramid("frame.time_delta", IOG_ITEM_UNIT_CALC_LOAD, intervals, G_N_ELEMENTS(intervals), units, G_N_ELEMENTS(units));
+}
+
+static void
+io_graph_test_has_data(void)
+{
+    io_graph_pyramid_t *pyramid = io_graph_pyramid_new();
+    int hf_index = proto_registrar_get_id_byname("frame.time_delta");
+
+    io_graph_pyramid_reset(pyramid, hf_index, IOG_ITEM_UNIT_CALC_MAX, 100);
+    g_assert(io_graph_pyramid_has_data(pyramid, hf_index, IOG_ITEM_UNIT_CALC_MIN, 7));
+    g_assert(!io_graph_pyramid_has_data(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 7));
+    g_assert(!io_graph_pyramid_has_data(pyramid, hf_index, IOG_ITEM_UNIT_CALC_LOAD, 7));
+    g_assert(!io_graph_pyramid_has_data(pyramid, hf_index, IOG_ITEM_UNIT_CALC_MIN, 0));
+
+    io_graph_pyramid_reset(pyramid, hf_index, IOG_ITEM_UNIT_CALC_LOAD, 100);
+    g_assert(io_graph_pyramid_has_data(pyramid, hf_index, IOG_ITEM_UNIT_CALC_LOAD, 7));
+    g_assert(!io_graph_pyramid_has_data(pyramid, hf_index, IOG_ITEM_UNIT_CALC_MAX, 7));
+
+    io_graph_pyramid_free(pyramid);
+}
+
+/*
+ * Too many buckets: the data moves to coarser ones, but no coarser than the
+ * interval the pyramid was reset for.
+ */
+static void
+io_graph_test_bound(void)
+{
+    const guint num_packets = 3 * IO_GRAPH_PYRAMID_MAX_BUCKETS;
+    io_graph_pyramid_t *pyramid = io_graph_pyramid_new();
+    io_graph_item_t *items = g_new(io_graph_item_t, num_packets / 20);
+    frame_data fd;
+    packet_info pinfo;
+    guint i;
+    int cur_idx;
+
+    memset(&fd, 0, sizeof fd);
+    memset(&pinfo, 0, sizeof pinfo);
+    fd.pkt_len = 100;
+    pinfo.fd = &fd;
+
+    io_graph_pyramid_reset(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 20);
+    for (i = 0; i < num_packets; i++) {
+        /* One packet per millisecond */
+        pinfo.num = i + 1;
+        pinfo.rel_ts.secs = i / 1000;
+        pinfo.rel_ts.nsecs = (i % 1000) * 1000000;
+        g_assert(io_graph_pyramid_add(pyramid, &pinfo, NULL));
+    }
+
+    g_assert_cmpuint(pyramid->base_level, ==, 1);
+    g_assert_cmpuint(pyramid->levels[0]->len, ==, 0);
+    g_assert_cmpuint(pyramid->levels[1]->len, ==, num_packets / 10);
+    g_assert(!io_graph_pyramid_has_data(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 1));
+    g_assert(!io_graph_pyramid_has_data(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 25));
+    g_assert(io_graph_pyramid_has_data(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 20));
+
+    cur_idx = io_graph_pyramid_get_items(pyramid, 20, IOG_ITEM_UNIT_PACKETS, items, num_packets / 20);
+    g_assert_cmpint(cur_idx, ==, num_packets / 20 - 1);
+    for (i = 0; i <= (guint)cur_idx; i++) {
+        g_assert_cmpuint(items[i].frames, ==, 20);
+        g_assert_cmpuint(items[i].first_frame_in_invl, ==, 20 * i + 1);
+        g_assert_cmpuint(items[i].last_frame_in_invl, ==, 20 * i + 20);
+    }
+
+    /* Tapped at 1 ms, the 1 ms buckets are kept however many there are. */
+    io_graph_pyramid_reset(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 1);
+    for (i = 0; i < num_packets; i++) {
+        pinfo.num = i + 1;
+        pinfo.rel_ts.secs = i / 1000;
+        pinfo.rel_ts.nsecs = (i % 1000) * 1000000;
+        g_assert(io_graph_pyramid_add(pyramid, &pinfo, NULL));
+    }
+    g_assert_cmpuint(pyramid->base_level, ==, 0);
+    g_assert(io_graph_pyramid_has_data(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 1));
+
+    g_free(items);
+    io_graph_pyramid_free(pyramid);
+}
+
+/* More than G_MAXINT milliseconds after the first packet */
+static void
+io_graph_test_late(void)
+{
+    io_graph_pyramid_t *pyramid = io_graph_pyramid_new();
+    io_graph_item_t items[31];
+    frame_data fd;
+    packet_info pinfo;
+
+    memset(&fd, 0, sizeof fd);
+    memset(&pinfo, 0, sizeof pinfo);
+    fd.pkt_len = 100;
+    pinfo.fd = &fd;
+
+    io_graph_pyramid_reset(pyramid, -1, IOG_ITEM_UNIT_PACKETS, 86400000);
+    pinfo.num = 1;
+    g_assert(io_graph_pyramid_add(pyramid, &pinfo, NULL));
+    pinfo.num = 2;
+    pinfo.rel_ts.secs = 30 * 86400 + 1;
+    g_assert(io_graph_pyramid_add(pyramid, &pinfo, NULL));
+    g_assert_cmpint(get_io_graph_index(&pinfo, 1), ==, G_MAXINT);
+    g_assert_cmpint(get_io_graph_index(&pinfo, 86400000), ==, 30);
+
+    g_assert_cmpint(io_graph_pyramid_get_items(pyramid, 86400000, IOG_ITEM_UNIT_PACKETS, items, 31), ==, 30);
+    g_assert_cmpuint(items[0].frames, ==, 1);
+    g_assert_cmpuint(items[29].frames, ==, 0);
+    g_assert_cmpuint(items[30].frames, ==, 1);
+    g_assert_cmpuint(items[30].first_frame_in_invl, ==, 2);
+
+    io_graph_pyramid_free(pyramid);
+}
+
+int
+main(int argc, char **argv)
+{
+    static const struct packet_provider_funcs funcs = { NULL, NULL, NULL, NULL };
+    int result;
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/io_graph/pyramid/basic", io_graph_test_basic);
+    g_test_add_func("/io_graph/pyramid/uint", io_graph_test_uint);
+    g_test_add_func("/io_graph/pyramid/time", io_graph_test_time);
+    g_test_add_func("/io_graph/pyramid/load", io_graph_test_load);
+    g_test_add_func("/io_graph/pyramid/has_data", io_graph_test_has_data);
+    g_test_add_func("/io_graph/pyramid/bound", io_graph_test_bound);
+    g_test_add_func("/io_graph/pyramid/late", io_graph_test_late);
+
+    test_init_report_message();
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    test_session = epan_new(NULL, &funcs);
+    make_packets();
+
+    result = g_test_run();
+
+    epan_free(test_session);
+    epan_cleanup();
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
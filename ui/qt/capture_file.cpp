@@ -83,7 +83,8 @@ QString CaptureFile::no_capture_file_ = QObject::tr("[no capture file]");
 CaptureFile::CaptureFile(QObject *parent, capture_file *cap_file) :
     QObject(parent),
     cap_file_(cap_file),
-    file_state_(QString())
+    file_state_(QString()),
+    backlog_session_(NULL)
 {
 #ifdef HAVE_LIBPCAP
     capture_callback_add(captureCallback, (gpointer) this);
@@ -223,6 +224,18 @@ void CaptureFile::delayedRetapPackets()
     QTimer::singleShot(0, this, SLOT(retapPackets()));
 }
 
+void CaptureFile::readCaptureBacklog()
+{
+#ifdef HAVE_LIBPCAP
+    capture_session *cap_session = backlog_session_;
+
+    backlog_session_ = NULL;
+    if (cap_session) {
+        capture_read_backlog(cap_session);
+    }
+#endif
+}
+
 void CaptureFile::reload()
 {
     if (cap_file_ && cap_file_->state == FILE_READ_DONE) {
@@ -359,8 +372,15 @@ void CaptureFile::captureSessionEvent(int event, capture_session *cap_session)
         break;
     case(capture_cb_capture_update_continue):
         emit captureEvent(CaptureEvent(CaptureEvent::Update, CaptureEvent::Continued, cap_session));
+        // cf_continue_tail leaves records for later if it runs out of time.
+        // Read them after pending events (repaints, input) are processed.
+        if (cap_session->cf && cap_session->cf->tail_backlog > 0 && !backlog_session_) {
+            backlog_session_ = cap_session;
+            QTimer::singleShot(0, this, SLOT(readCaptureBacklog()));
+        }
         break;
     case(capture_cb_capture_update_finished):
+        backlog_session_ = NULL;
         emit captureEvent(CaptureEvent(CaptureEvent::Update, CaptureEvent::Finished, cap_session));
         break;
     case(capture_cb_capture_fixed_started):
@@ -378,6 +398,7 @@ void CaptureFile::captureSessionEvent(int event, capture_session *cap_session)
         emit captureEvent(CaptureEvent(CaptureEvent::Capture, CaptureEvent::Stopping, cap_session));
         break;
     case(capture_cb_capture_failed):
+        backlog_session_ = NULL;
         emit captureEvent(CaptureEvent(CaptureEvent::Capture, CaptureEvent::Failed, cap_session));
         break;
     default:
@@ -148,6 +148,11 @@ public slots:
      */
     void setCaptureStopFlag(bool stop_flag = true);
 
+private slots:
+    /** Read packets left over by cf_continue_tail during a live capture.
+     */
+    void readCaptureBacklog();
+
 private:
     static void captureFileCallback(gint event, gpointer data, gpointer user_data);
 #ifdef HAVE_LIBPCAP
@@ -162,6 +167,7 @@ private:
 
     capture_file *cap_file_;
     QString file_state_;
+    capture_session *backlog_session_;
 };
 
 #endif // CAPTURE_FILE_H
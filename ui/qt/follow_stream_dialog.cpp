@@ -991,11 +991,40 @@ bool FollowStreamDialog::follow(QString previous_filter, bool use_stream_index,
     beginRetapPackets();
     updateWidgets(true);
 
-    /* Run the display filter so it goes in effect - even if it's the
-       same as the previous display filter. */
-    emit updateFilter(follow_filter, TRUE);
+    /* If the first pass recorded the frames of the stream, only those need
+       to be tapped, and the display filter needn't look at the others. */
+    stream_type frames_type = MAX_STREAM;
+    switch (follow_type_)
+    {
+    case FOLLOW_TCP:
+    case FOLLOW_TLS:
+    case FOLLOW_HTTP:
+    case FOLLOW_HTTP2:
+        frames_type = TCP_STREAM;
+        break;
+    case FOLLOW_UDP:
+        frames_type = UDP_STREAM;
+        break;
+    case FOLLOW_QUIC:
+        frames_type = QUIC_STREAM;
+        break;
+    }
+    guint num_stream_frames = 0;
+    guint32 *stream_frames = frames_type != MAX_STREAM ? follow_get_stream_frames(frames_type, stream_num, &num_stream_frames) : NULL;
 
-    removeTapListeners();
+    if (stream_frames) {
+        cf_retap_frames(cap_file_.capFile(), stream_frames, num_stream_frames);
+        removeTapListeners();
+        cf_set_dfilter_frames(cap_file_.capFile(), follow_filter.toUtf8().constData(), stream_frames, num_stream_frames);
+
+        /* Run the display filter so it goes in effect - even if it's the
+           same as the previous display filter. */
+        emit updateFilter(follow_filter, TRUE);
+    } else {
+        emit updateFilter(follow_filter, TRUE);
+
+        removeTapListeners();
+    }
 
     hostname0 = address_to_name(&follow_info_.client_ip);
     hostname1 = address_to_name(&follow_info_.server_ip);
@@ -1208,7 +1208,7 @@ void IOGraphDialog::loadProfileGraphs()
 void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
-    bool need_retap = false;
+    bool need_recalc = false;
 
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
@@ -1216,14 +1216,16 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
             if (iog) {
                 iog->setInterval(interval);
                 if (iog->visible()) {
-                    need_retap = true;
+                    need_recalc = true;
                 }
             }
         }
     }
 
-    if (need_retap) {
-        scheduleRetap(true);
+    // The graphs can usually make the new interval from their data; those
+    // that can't have asked for a retap.
+    if (need_recalc) {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1573,6 +1575,9 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
+    interval_(0),
+    pyramid_(io_graph_pyramid_new()),
+    items_stale_(false),
     cur_idx_(-1)
 {
     Q_ASSERT(parent_ != NULL);
@@ -1598,6 +1603,7 @@ IOGraph::IOGraph(QCustomPlot *parent) :
 
 IOGraph::~IOGraph() {
     remove_tap_listener(this);
+    io_graph_pyramid_free(pyramid_);
     if (graph_) {
         parent_->removeGraph(graph_);
     }
@@ -1800,9 +1806,7 @@ void IOGraph::setValueUnits(int val_units)
 
         if (old_val_units != val_units) {
             setFilter(filter_); // Check config & prime vu field
-            if (val_units < IOG_ITEM_UNIT_CALC_SUM) {
-                emit requestRecalc();
-            }
+            requestDataUpdate();
         }
     }
 }
@@ -1821,6 +1825,21 @@ void IOGraph::setValueUnitField(const QString &vu_field)
 
     if (old_hf_index != hf_index_) {
         setFilter(filter_); // Check config & prime vu field
+        requestDataUpdate();
+    }
+}
+
+// The values of most units and intervals are calculated from the tapped
+// data, as long as we tapped the same field (if any).
+void IOGraph::requestDataUpdate()
+{
+    int hf_index = val_units_ >= IOG_ITEM_UNIT_CALC_SUM ? hf_index_ : -1;
+
+    if (io_graph_pyramid_has_data(pyramid_, hf_index, val_units_, interval_)) {
+        items_stale_ = true;
+        emit requestRecalc();
+    } else if (visible_) {
+        emit requestRetap();
     }
 }
 
@@ -1863,8 +1882,9 @@ int IOGraph::packetFromTime(double ts)
     if (idx >= 0 && idx < (int) cur_idx_) {
         switch (val_units_) {
         case IOG_ITEM_UNIT_CALC_MAX:
+            return items_[idx].max_frame_in_invl;
         case IOG_ITEM_UNIT_CALC_MIN:
-            return items_[idx].extreme_frame_in_invl;
+            return items_[idx].min_frame_in_invl;
         default:
             return items_[idx].last_frame_in_invl;
         }
@@ -1875,7 +1895,8 @@ int IOGraph::packetFromTime(double ts)
 void IOGraph::clearAllData()
 {
     cur_idx_ = -1;
-    reset_io_graph_items(items_, max_io_items_);
+    io_graph_pyramid_reset(pyramid_, val_units_ >= IOG_ITEM_UNIT_CALC_SUM ? hf_index_ : -1, val_units_, interval_);
+    items_stale_ = false;
     if (graph_) {
         graph_->data()->clear();
     }
@@ -1902,6 +1923,11 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
         x_axis = bars_->keyAxis();
     }
 
+    if (items_stale_) {
+        cur_idx_ = io_graph_pyramid_get_items(pyramid_, interval_, val_units_, items_, max_io_items_);
+        items_stale_ = false;
+    }
+
     if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
@@ -2119,7 +2145,10 @@ bool IOGraph::hasItemToShow(int idx, double value) const
 
 void IOGraph::setInterval(int interval)
 {
-    interval_ = interval;
+    if (interval_ != interval) {
+        interval_ = interval;
+        requestDataUpdate();
+    }
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -2152,13 +2181,15 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
     bool recalc = false;
 
     /* some sanity checks */
-    if ((idx < 0) || (idx >= max_io_items_)) {
-        iog->cur_idx_ = max_io_items_ - 1;
+    if (idx < 0) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    /* update num_items */
-    if (idx > iog->cur_idx_) {
+    /* update num_items. Packets past the last item are still kept, for
+     * longer intervals. */
+    if (idx >= max_io_items_) {
+        iog->cur_idx_ = max_io_items_ - 1;
+    } else if (idx > iog->cur_idx_) {
         iog->cur_idx_ = (guint32) idx;
         recalc = true;
     }
@@ -2177,9 +2208,10 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(iog->items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    if (!io_graph_pyramid_add(iog->pyramid_, pinfo, adv_edt)) {
         return TAP_PACKET_DONT_REDRAW;
     }
+    iog->items_stale_ = true;
 
 //    qDebug() << "=tapPacket" << iog->name_ << idx << iog->hf_index_ << iog->val_units_ << iog->num_items_;
 
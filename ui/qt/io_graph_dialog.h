@@ -98,6 +98,7 @@ private:
     static void tapDraw(void *iog_ptr);
 
     void calculateScaledValueUnit();
+    void requestDataUpdate();
     template<class DataMap> double maxValueFromGraphData(const DataMap &map);
     template<class DataMap> void scaleGraphData(DataMap &map, int scalar);
 
@@ -118,6 +119,8 @@ private:
 
     // Cached data. We should be able to change the Y axis without retapping as
     // much as is feasible.
+    io_graph_pyramid_t *pyramid_;
+    bool items_stale_;
     io_graph_item_t items_[max_io_items_];
     int cur_idx_;
 };
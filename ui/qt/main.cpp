@@ -46,6 +46,7 @@
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
 #include <epan/column.h>
+#include <epan/follow.h>
 #include <epan/disabled_protos.h>
 #include <epan/prefs.h>
 
@@ -652,6 +653,9 @@ int main(int argc, char *qt_argv[])
     g_log(LOG_DOMAIN_MAIN, G_LOG_LEVEL_INFO, "epan done, elapsed time %" G_GUINT64_FORMAT " us \n", g_get_monotonic_time() - start_time);
 #endif
 
+    /* Frames are kept, so record those of each stream for following them. */
+    follow_set_stream_frames_enabled(TRUE);
+
     /* Register all audio codecs. */
     codecs_init();
 
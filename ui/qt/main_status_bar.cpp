@@ -226,6 +226,14 @@ void MainStatusBar::expertUpdate() {
         break;
     }
 
+    if (expert_get_highest_severity() >= PI_CHAT) {
+        tt_text.append(tr("\n%1 errors, %2 warnings, %3 notes, %4 chats")
+                       .arg(expert_get_count(PI_ERROR, 0))
+                       .arg(expert_get_count(PI_WARN, 0))
+                       .arg(expert_get_count(PI_NOTE, 0))
+                       .arg(expert_get_count(PI_CHAT, 0)));
+    }
+
     StockIcon expert_icon(stock_name);
     expert_button_->setIcon(expert_icon);
     expert_button_->setToolTip(tt_text);
@@ -406,6 +414,12 @@ void MainStatusBar::showCaptureStatistics()
                                    .arg(cap_file_->marked_count)
                                    .arg((100.0*cap_file_->marked_count)/cap_file_->count, 0, 'f', 1));
             }
+            if (cap_file_->tail_backlog > 0) {
+                // Live capture: packets written by dumpcap which we haven't read yet.
+                packets_str.append(QString(tr(" %1 Behind: %2"))
+                                   .arg(UTF8_MIDDLE_DOT)
+                                   .arg(cap_file_->tail_backlog));
+            }
             if (cap_file_->drops_known) {
                 packets_str.append(QString(tr(" %1 Dropped: %2 (%3%)"))
                                    .arg(UTF8_MIDDLE_DOT)
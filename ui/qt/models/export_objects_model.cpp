@@ -51,6 +51,15 @@ ExportObjectModel::ExportObjectModel(register_eo_t* eo, QObject *parent) :
     export_object_list_.add_entry = object_list_add_entry;
     export_object_list_.get_entry = object_list_get_entry;
     export_object_list_.gui_data = (void*)&eo_gui_data_;
+    export_object_list_.spill = NULL;
+
+    if (prefs.gui_export_objects_spill_dir && prefs.gui_export_objects_spill_dir[0] != '\0')
+        export_object_list_.spill = eo_spill_new(prefs.gui_export_objects_spill_dir);
+}
+
+ExportObjectModel::~ExportObjectModel()
+{
+    eo_spill_free(export_object_list_.spill);
 }
 
 QVariant ExportObjectModel::data(const QModelIndex &index, int role) const
@@ -204,6 +213,9 @@ void ExportObjectModel::resetObjects()
     objects_.clear();
     emit endResetModel();
 
+    if (export_object_list_.spill)
+        eo_spill_reset(export_object_list_.spill);
+
     if (reset_cb)
         reset_cb();
 }
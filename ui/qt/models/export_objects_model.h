@@ -30,6 +30,7 @@ class ExportObjectModel : public QAbstractTableModel
 
 public:
     ExportObjectModel(register_eo_t* eo, QObject *parent);
+    ~ExportObjectModel();
 
     enum ExportObjectColumn {
         colPacket = 0,
@@ -690,6 +690,13 @@ void PacketListModel::dissectIdle(bool reset)
 
     idle_dissection_timer_->restart();
 
+    if (cap_file_ && cap_file_->tail_backlog > 0) {
+        // We're falling behind a live capture. Leave the CPU to reading new
+        // packets; visible rows are still colorized when they are drawn.
+        QTimer::singleShot(idle_dissection_interval_ * 20, this, SLOT(dissectIdle()));
+        return;
+    }
+
     int first = idle_dissection_row_;
     while (idle_dissection_timer_->elapsed() < idle_dissection_interval_
            && idle_dissection_row_ < physical_rows_.count()) {
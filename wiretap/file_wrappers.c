@@ -1635,6 +1635,16 @@ file_fdreopen(FILE_T file, const char *path)
 
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
+
+    /*
+     * Seeks within an uncompressed file are done relative to the
+     * current position of the descriptor, so the new one has to
+     * start out where the old one was.
+     */
+    if (ws_lseek64(fd, file->raw_pos, SEEK_SET) == -1) {
+        ws_close(fd);
+        return FALSE;
+    }
     file->fd = fd;
     return TRUE;
 }
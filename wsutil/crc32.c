@@ -17,6 +17,12 @@
 
 #include <glib.h>
 #include <wsutil/crc32.h>
+#include <wsutil/pint.h>
+
+#ifdef HAVE_SSE4_2
+#include "ws_cpuid.h"
+#include "crc32_int.h"
+#endif
 
 #define CRC32_ACCUMULATE(c,d,table) (c=(c>>8)^(table)[(c^(d))&0xFF])
 
@@ -353,6 +359,87 @@ static const guint32 crc32_5D6DCB[] =
 		0x0098206c, 0x00c54da7, 0x0022fbfa, 0x007f9631
 };
 
+/*
+ * "Slice-by-8" tables for the reflected CRCs: table[k][n] is the CRC of
+ * byte n followed by k zero bytes, so that eight input bytes can be
+ * processed with eight independent lookups instead of a chain of eight.
+ * Built from the byte-wise tables above on first use.
+ */
+static guint32 crc32_ccitt_slice8[8][256];
+static guint32 crc32c_slice8[8][256];
+
+#ifdef HAVE_SSE4_2
+static gboolean crc32c_use_sse42;
+#endif
+
+static void
+crc32_slice8_init_table(guint32 slice8[8][256], const guint32 table[256])
+{
+	guint n, k;
+
+	for (n = 0; n < 256; n++)
+		slice8[0][n] = table[n];
+	for (k = 1; k < 8; k++) {
+		for (n = 0; n < 256; n++)
+			slice8[k][n] = (slice8[k-1][n] >> 8) ^ table[slice8[k-1][n] & 0xFF];
+	}
+}
+
+static void
+crc32_slice8_init(void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter(&initialized)) {
+		crc32_slice8_init_table(crc32_ccitt_slice8, crc32_ccitt_table);
+		crc32_slice8_init_table(crc32c_slice8, crc32c_table);
+#ifdef HAVE_SSE4_2
+		crc32c_use_sse42 = ws_cpuid_sse42() != 0;
+#endif
+		g_once_init_leave(&initialized, 1);
+	}
+}
+
+/* Reflected CRC without pre- or post-inversion. */
+static guint32
+crc32_slice8(const guint8 *buf, gsize len, guint32 crc, guint32 slice8[8][256])
+{
+	guint32 lo, hi;
+
+	/* Byte-wise up to an 8-byte boundary, just so the loads below are aligned */
+	while (len > 0 && ((gsize)buf & 7) != 0) {
+		CRC32_ACCUMULATE(crc, *buf++, slice8[0]);
+		len--;
+	}
+
+	while (len >= 8) {
+		lo = pletoh32(buf) ^ crc;
+		hi = pletoh32(buf + 4);
+		crc = slice8[7][lo & 0xFF] ^ slice8[6][(lo >> 8) & 0xFF] ^
+		      slice8[5][(lo >> 16) & 0xFF] ^ slice8[4][lo >> 24] ^
+		      slice8[3][hi & 0xFF] ^ slice8[2][(hi >> 8) & 0xFF] ^
+		      slice8[1][(hi >> 16) & 0xFF] ^ slice8[0][hi >> 24];
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len-- > 0)
+		CRC32_ACCUMULATE(crc, *buf++, slice8[0]);
+
+	return crc;
+}
+
+static guint32
+crc32c_no_swap(const guint8 *buf, gsize len, guint32 crc)
+{
+	crc32_slice8_init();
+#ifdef HAVE_SSE4_2
+	if (crc32c_use_sse42)
+		return crc32c_sse42(buf, len, crc);
+#endif
+	return crc32_slice8(buf, len, crc, crc32c_slice8);
+}
+
 guint32
 crc32c_table_lookup (guchar pos)
 {
@@ -368,22 +455,17 @@ crc32_ccitt_table_lookup (guchar pos)
 guint32
 crc32c_calculate(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
 	crc = CRC32C_SWAP(crc);
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
+	if (len > 0)
+		crc = crc32c_no_swap((const guint8 *)buf, len, crc);
 	return CRC32C_SWAP(crc);
 }
 
 guint32
 crc32c_calculate_no_swap(const void *buf, int len, guint32 crc)
 {
-	const guint8 *p = (const guint8 *)buf;
-	while (len-- > 0) {
-		CRC32C(crc, *p++);
-	}
-
+	if (len > 0)
+		crc = crc32c_no_swap((const guint8 *)buf, len, crc);
 	return crc;
 }
 
@@ -396,13 +478,8 @@ crc32_ccitt(const guint8 *buf, guint len)
 guint32
 crc32_ccitt_seed(const guint8 *buf, guint len, guint32 seed)
 {
-	guint i;
-	guint32 crc32 = seed;
-
-	for (i = 0; i < len; i++)
-		CRC32_ACCUMULATE(crc32, buf[i], crc32_ccitt_table);
-
-	return ( ~crc32 );
+	crc32_slice8_init();
+	return ( ~crc32_slice8(buf, len, seed, crc32_ccitt_slice8) );
 }
 
 guint32
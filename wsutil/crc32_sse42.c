@@ -0,0 +1,79 @@
+/* crc32_sse42.c
+ * CRC-32C using the SSE4.2 crc32 instruction
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_SSE4_2
+
+#include <glib.h>
+
+#include <nmmintrin.h>
+#include <string.h>
+
+#include "crc32_int.h"
+
+/*
+ * The instruction implements exactly the reflected Castagnoli CRC, with
+ * the same register convention as the table-driven code in crc32.c, so
+ * the two can be used interchangeably. Callers must have checked
+ * ws_cpuid_sse42().
+ */
+guint32
+crc32c_sse42(const guint8 *buf, gsize len, guint32 crc)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	guint64 crc64 = crc;
+	guint64 word;
+
+	while (len > 0 && ((gsize)buf & 7) != 0) {
+		crc64 = _mm_crc32_u8((guint32)crc64, *buf++);
+		len--;
+	}
+	while (len >= 8) {
+		memcpy(&word, buf, sizeof word);
+		crc64 = _mm_crc32_u64(crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+	crc = (guint32)crc64;
+#else
+	guint32 word;
+
+	while (len > 0 && ((gsize)buf & 3) != 0) {
+		crc = _mm_crc32_u8(crc, *buf++);
+		len--;
+	}
+	while (len >= 4) {
+		memcpy(&word, buf, sizeof word);
+		crc = _mm_crc32_u32(crc, word);
+		buf += 4;
+		len -= 4;
+	}
+#endif
+	while (len-- > 0)
+		crc = _mm_crc32_u8(crc, *buf++);
+
+	return crc;
+}
+
+#endif /* HAVE_SSE4_2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -12,8 +12,11 @@
  */
 
 #include "json_dumper.h"
+#include "wsjson.h"
 
+#include <errno.h>
 #include <math.h>
+#include <string.h>
 
 /*
  * json_dumper.state[current_depth] describes a nested element:
@@ -42,6 +45,33 @@ enum json_dumper_change {
     JSON_DUMPER_FINISH,
 };
 
+/*
+ * Word-at-a-time checks for bytes that cannot be copied verbatim into a JSON
+ * string: control characters, '"', '\\' and '/' (which needs a look at the
+ * previous byte). See "Determine if a word has a byte less than n" in Sean
+ * Anderson's "Bit Twiddling Hacks". These only tell whether such a byte is
+ * present somewhere in the word, which is all that is needed to skip over
+ * long runs of plain text.
+ */
+#define JSON_WORD_ONES              G_GUINT64_CONSTANT(0x0101010101010101)
+#define JSON_WORD_HIGHS             G_GUINT64_CONSTANT(0x8080808080808080)
+#define JSON_WORD_HAS_LESS(w, n)    (((w) - JSON_WORD_ONES * (n)) & ~(w) & JSON_WORD_HIGHS)
+#define JSON_WORD_HAS_BYTE(w, b)    JSON_WORD_HAS_LESS((w) ^ (JSON_WORD_ONES * (b)), 1)
+
+static inline gboolean
+json_word_is_plain(guint64 w, gboolean dot_to_underscore)
+{
+    guint64 special = JSON_WORD_HAS_LESS(w, 0x20) |
+                      JSON_WORD_HAS_BYTE(w, '"') |
+                      JSON_WORD_HAS_BYTE(w, '\\') |
+                      JSON_WORD_HAS_BYTE(w, '/');
+
+    if (dot_to_underscore) {
+        special |= JSON_WORD_HAS_BYTE(w, '.');
+    }
+    return special == 0;
+}
+
 static void
 json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
 {
@@ -55,27 +85,231 @@ json_puts_string(FILE *fp, const char *str, gboolean dot_to_underscore)
         "u0010", "u0011", "u0012", "u0013", "u0014", "u0015", "u0016", "u0017", "u0018", "u0019", "u001a", "u001b", "u001c", "u001d", "u001e", "u001f"
     };
 
+    size_t len = strlen(str);
+    size_t plain_start = 0;
+    size_t i = 0;
+
+    /*
+     * Copy runs of bytes that need no escaping with a single fwrite instead
+     * of going through stdio one character at a time.
+     */
     fputc('"', fp);
-    for (int i = 0; str[i]; i++) {
-        if ((guint)str[i] < 0x20) {
+    while (i < len) {
+        while (i + sizeof(guint64) <= len) {
+            guint64 w;
+
+            memcpy(&w, str + i, sizeof(w));
+            if (!json_word_is_plain(w, dot_to_underscore))
+                break;
+            i += sizeof(w);
+        }
+        if (i >= len)
+            break;
+
+        guchar c = (guchar)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\' && c != '/' && !(dot_to_underscore && c == '.')) {
+            i++;
+            continue;
+        }
+        if (c == '/' && !(i > 0 && str[i - 1] == '<')) {
+            i++;
+            continue;
+        }
+
+        fwrite(str + plain_start, 1, i - plain_start, fp);
+        if (c < 0x20) {
             fputc('\\', fp);
-            fputs(json_cntrl[(guint)str[i]], fp);
-        } else if (i > 0 && str[i - 1] == '<' && str[i] == '/') {
+            fputs(json_cntrl[c], fp);
+        } else if (c == '/') {
             // Convert </script> to <\/script> to avoid breaking web pages.
             fputs("\\/", fp);
+        } else if (c == '.') {
+            fputc('_', fp);
         } else {
-            if (str[i] == '\\' || str[i] == '"') {
-                fputc('\\', fp);
-            }
-            if (dot_to_underscore && str[i] == '.')
-                fputc('_', fp);
-            else
-                fputc(str[i], fp);
+            fputc('\\', fp);
+            fputc(c, fp);
         }
+        plain_start = ++i;
     }
+    fwrite(str + plain_start, 1, len - plain_start, fp);
     fputc('"', fp);
 }
 
+/*
+ * CBOR (RFC 7049) encoding, used with JSON_DUMPER_FLAGS_CBOR.
+ *
+ * Objects and arrays are written as indefinite-length maps and arrays, so
+ * they can be streamed without knowing the number of members in advance.
+ * Base64 data is written as an indefinite-length byte string of raw bytes.
+ */
+#define CBOR_MAJOR_UINT         0
+#define CBOR_MAJOR_NEGINT       1
+#define CBOR_MAJOR_BYTES        2
+#define CBOR_MAJOR_TEXT         3
+#define CBOR_MAJOR_ARRAY        4
+#define CBOR_MAJOR_MAP          5
+
+#define CBOR_INDEFINITE_BYTES   0x5f
+#define CBOR_INDEFINITE_ARRAY   0x9f
+#define CBOR_INDEFINITE_MAP     0xbf
+#define CBOR_FALSE              0xf4
+#define CBOR_TRUE               0xf5
+#define CBOR_NULL               0xf6
+#define CBOR_DOUBLE             0xfb
+#define CBOR_BREAK              0xff
+
+static void
+cbor_put_head(FILE *fp, guint8 major_type, guint64 value)
+{
+    guint8 buf[9];
+    size_t len;
+
+    major_type <<= 5;
+    if (value < 24) {
+        buf[0] = major_type | (guint8)value;
+        len = 1;
+    } else if (value <= G_MAXUINT8) {
+        buf[0] = major_type | 24;
+        buf[1] = (guint8)value;
+        len = 2;
+    } else if (value <= G_MAXUINT16) {
+        buf[0] = major_type | 25;
+        buf[1] = (guint8)(value >> 8);
+        buf[2] = (guint8)value;
+        len = 3;
+    } else if (value <= G_MAXUINT32) {
+        buf[0] = major_type | 26;
+        for (int i = 0; i < 4; i++) {
+            buf[1 + i] = (guint8)(value >> (24 - 8 * i));
+        }
+        len = 5;
+    } else {
+        buf[0] = major_type | 27;
+        for (int i = 0; i < 8; i++) {
+            buf[1 + i] = (guint8)(value >> (56 - 8 * i));
+        }
+        len = 9;
+    }
+    fwrite(buf, 1, len, fp);
+}
+
+static void
+cbor_put_string(FILE *fp, const char *str, gboolean dot_to_underscore)
+{
+    if (!str) {
+        fputc(CBOR_NULL, fp);
+        return;
+    }
+
+    size_t len = strlen(str);
+    cbor_put_head(fp, CBOR_MAJOR_TEXT, len);
+    if (dot_to_underscore) {
+        const char *dot;
+
+        while ((dot = (const char *)memchr(str, '.', len)) != NULL) {
+            fwrite(str, 1, dot - str, fp);
+            fputc('_', fp);
+            len -= dot - str + 1;
+            str = dot + 1;
+        }
+    }
+    fwrite(str, 1, len, fp);
+}
+
+static void
+cbor_put_double(FILE *fp, double value)
+{
+    union {
+        double  d;
+        guint64 u;
+    } v;
+
+    if (!isfinite(value)) {
+        fputc(CBOR_NULL, fp);
+        return;
+    }
+
+    v.d = value;
+    fputc(CBOR_DOUBLE, fp);
+    for (int i = 0; i < 8; i++) {
+        fputc((guint8)(v.u >> (56 - 8 * i)), fp);
+    }
+}
+
+/**
+ * Converts a JSON literal as produced by json_dumper_value_anyf() (number,
+ * "true", "false", "null", a quoted string or a flat array of those) to the
+ * matching CBOR type.
+ */
+static void
+cbor_put_literal(FILE *fp, char *literal)
+{
+    size_t len = strlen(literal);
+    char *end;
+
+    if (!strcmp(literal, "true")) {
+        fputc(CBOR_TRUE, fp);
+        return;
+    }
+    if (!strcmp(literal, "false")) {
+        fputc(CBOR_FALSE, fp);
+        return;
+    }
+    if (!strcmp(literal, "null")) {
+        fputc(CBOR_NULL, fp);
+        return;
+    }
+
+    if (len >= 2 && literal[0] == '[' && literal[len - 1] == ']' && !strchr(literal, '"') && !strchr(literal + 1, '[')) {
+        /* Flat array of scalars like "[1,2]", used for compact tuples. */
+        literal[len - 1] = '\0';
+        gchar **items = g_strsplit(literal + 1, ",", -1);
+        guint n_items = literal[1] ? g_strv_length(items) : 0;
+
+        cbor_put_head(fp, CBOR_MAJOR_ARRAY, n_items);
+        for (guint i = 0; i < n_items; i++) {
+            cbor_put_literal(fp, g_strstrip(items[i]));
+        }
+        g_strfreev(items);
+        return;
+    }
+
+    if (len >= 2 && literal[0] == '"' && literal[len - 1] == '"') {
+        literal[len - 1] = '\0';
+        if (json_decode_string_inplace(literal + 1)) {
+            cbor_put_string(fp, literal + 1, FALSE);
+            return;
+        }
+        literal[len - 1] = '"';
+    } else if (len > 0) {
+        errno = 0;
+        if (literal[0] == '-') {
+            gint64 value = g_ascii_strtoll(literal, &end, 10);
+            if (*end == '\0' && errno == 0 && value < 0) {
+                /* -1 - n is encoded as n */
+                cbor_put_head(fp, CBOR_MAJOR_NEGINT, (guint64)(-(value + 1)));
+                return;
+            }
+        } else {
+            guint64 value = g_ascii_strtoull(literal, &end, 10);
+            if (*end == '\0' && errno == 0) {
+                cbor_put_head(fp, CBOR_MAJOR_UINT, value);
+                return;
+            }
+        }
+
+        errno = 0;
+        double value = g_ascii_strtod(literal, &end);
+        if (*end == '\0' && errno == 0) {
+            cbor_put_double(fp, value);
+            return;
+        }
+    }
+
+    /* Not a recognized literal, keep its text. */
+    cbor_put_string(fp, literal, FALSE);
+}
+
 /**
  * Called when a programming error is encountered where the JSON manipulation
  * state got corrupted. This could happen when pairing the wrong begin/end
@@ -193,6 +427,11 @@ prepare_token(json_dumper *dumper)
     // While processing the object value, reset the key state as it is consumed.
     dumper->state[dumper->current_depth - 1] &= ~JSON_DUMPER_HAS_NAME;
 
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        // CBOR does not need separators.
+        return;
+    }
+
     switch (JSON_DUMPER_TYPE(prev_state)) {
         case JSON_DUMPER_TYPE_OBJECT:
             if ((prev_state & JSON_DUMPER_HAS_NAME)) {
@@ -220,6 +459,11 @@ prepare_token(json_dumper *dumper)
 static void
 finish_token(const json_dumper *dumper, char close_char)
 {
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        fputc(CBOR_BREAK, dumper->output_file);
+        return;
+    }
+
     // if the object/array was non-empty, add a newline and indentation.
     if (dumper->state[dumper->current_depth]) {
         print_newline_indent(dumper, dumper->current_depth - 1);
@@ -235,7 +479,11 @@ json_dumper_begin_object(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    fputc('{', dumper->output_file);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        fputc(CBOR_INDEFINITE_MAP, dumper->output_file);
+    } else {
+        fputc('{', dumper->output_file);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_OBJECT;
     ++dumper->current_depth;
@@ -250,10 +498,14 @@ json_dumper_set_member_name(json_dumper *dumper, const char *name)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper->output_file, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
-    fputc(':', dumper->output_file);
-    if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
-        fputc(' ', dumper->output_file);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        cbor_put_string(dumper->output_file, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
+    } else {
+        json_puts_string(dumper->output_file, name, dumper->flags & JSON_DUMPER_DOT_TO_UNDERSCORE);
+        fputc(':', dumper->output_file);
+        if ((dumper->flags & JSON_DUMPER_FLAGS_PRETTY_PRINT)) {
+            fputc(' ', dumper->output_file);
+        }
     }
 
     dumper->state[dumper->current_depth - 1] |= JSON_DUMPER_HAS_NAME;
@@ -279,7 +531,11 @@ json_dumper_begin_array(json_dumper *dumper)
     }
 
     prepare_token(dumper);
-    fputc('[', dumper->output_file);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        fputc(CBOR_INDEFINITE_ARRAY, dumper->output_file);
+    } else {
+        fputc('[', dumper->output_file);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_ARRAY;
     ++dumper->current_depth;
@@ -306,7 +562,11 @@ json_dumper_value_string(json_dumper *dumper, const char *value)
     }
 
     prepare_token(dumper);
-    json_puts_string(dumper->output_file, value, FALSE);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        cbor_put_string(dumper->output_file, value, FALSE);
+    } else {
+        json_puts_string(dumper->output_file, value, FALSE);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
@@ -319,6 +579,12 @@ json_dumper_value_double(json_dumper *dumper, double value)
     }
 
     prepare_token(dumper);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        cbor_put_double(dumper->output_file, value);
+        dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
+        return;
+    }
+
     gchar buffer[G_ASCII_DTOSTR_BUF_SIZE] = { 0 };
     if (isfinite(value) && g_ascii_dtostr(buffer, G_ASCII_DTOSTR_BUF_SIZE, value) && buffer[0]) {
         fputs(buffer, dumper->output_file);
@@ -337,7 +603,13 @@ json_dumper_value_va_list(json_dumper *dumper, const char *format, va_list ap)
     }
 
     prepare_token(dumper);
-    vfprintf(dumper->output_file, format, ap);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        char *literal = g_strdup_vprintf(format, ap);
+        cbor_put_literal(dumper->output_file, literal);
+        g_free(literal);
+    } else {
+        vfprintf(dumper->output_file, format, ap);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_VALUE;
 }
@@ -359,7 +631,10 @@ json_dumper_finish(json_dumper *dumper)
         return FALSE;
     }
 
-    fputc('\n', dumper->output_file);
+    if (!(dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        /* CBOR data items are self-delimiting. */
+        fputc('\n', dumper->output_file);
+    }
     dumper->state[0] = 0;
     return TRUE;
 }
@@ -376,7 +651,11 @@ json_dumper_begin_base64(json_dumper *dumper)
 
     prepare_token(dumper);
 
-    fputc('"', dumper->output_file);
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        fputc(CBOR_INDEFINITE_BYTES, dumper->output_file);
+    } else {
+        fputc('"', dumper->output_file);
+    }
 
     dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_BASE64;
     ++dumper->current_depth;
@@ -393,6 +672,16 @@ json_dumper_write_base64(json_dumper* dumper, const guchar *data, size_t len)
     #define CHUNK_SIZE 1024
     gchar buf[(CHUNK_SIZE / 3 + 1) * 4 + 4];
 
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        /* Raw bytes, written as a chunk of indefinite-length byte string. */
+        if (len > 0) {
+            cbor_put_head(dumper->output_file, CBOR_MAJOR_BYTES, len);
+            fwrite(data, 1, len, dumper->output_file);
+        }
+        dumper->state[dumper->current_depth] = JSON_DUMPER_TYPE_BASE64;
+        return;
+    }
+
     while (len > 0) {
         gsize chunk_size = len < CHUNK_SIZE ? len : CHUNK_SIZE;
         gsize output_size = g_base64_encode_step(data, chunk_size, FALSE, buf, &dumper->base64_state, &dumper->base64_save);
@@ -414,6 +703,12 @@ json_dumper_end_base64(json_dumper *dumper)
     gchar buf[4];
     gsize wrote;
 
+    if ((dumper->flags & JSON_DUMPER_FLAGS_CBOR)) {
+        fputc(CBOR_BREAK, dumper->output_file);
+        --dumper->current_depth;
+        return;
+    }
+
     wrote = g_base64_encode_close(FALSE, buf, &dumper->base64_state, &dumper->base64_save);
     fwrite(buf, 1, wrote, dumper->output_file);
 
@@ -54,6 +54,7 @@ typedef struct json_dumper {
     FILE   *output_file;    /**< Output file, must be set. */
 #define JSON_DUMPER_FLAGS_PRETTY_PRINT  (1 << 0)    /* Enable pretty printing. */
 #define JSON_DUMPER_DOT_TO_UNDERSCORE   (1 << 1)    /* Convert dots to underscores in keys */
+#define JSON_DUMPER_FLAGS_CBOR          (1 << 2)    /* Encode as CBOR (RFC 7049) instead of JSON text. */
     int     flags;
     /* for internal use, initialize with zeroes. */
     int     current_depth;
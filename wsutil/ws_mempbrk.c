@@ -22,21 +22,47 @@
 #endif
 #endif
 
+/*
+ * SSE2 is part of x86-64, so unlike SSE4.2 it can be used without checking
+ * the CPU at run time.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WS_MEMPBRK_SSE2
+#endif
+
+#include <string.h>
+
 #include <glib.h>
 #include "ws_symbol_export.h"
 #include "ws_mempbrk.h"
 #include "ws_mempbrk_int.h"
 
+#ifdef WS_MEMPBRK_SSE2
+#include <emmintrin.h>
+#include "bits_ctz.h"
+#endif
+
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const gchar *needles)
 {
     const gchar *n = needles;
+#ifdef HAVE_SSE4_2
+    size_t length = strlen(needles);
+#endif
+
     while (*n) {
-        pattern->patt[(int)*n] = 1;
+        pattern->patt[(guchar)*n] = 1;
         n++;
     }
 
 #ifdef HAVE_SSE4_2
+    if (length > 0 && length <= WS_MEMPBRK_MAX_FEW_NEEDLES) {
+        pattern->n_needles = (guint8)length;
+        memcpy(pattern->needles, needles, length);
+    } else {
+        pattern->n_needles = 0;
+    }
+
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
 }
@@ -60,10 +86,59 @@ ws_mempbrk_portable_exec(const guint8* haystack, size_t haystacklen, const ws_me
 }
 
 
+#if defined(WS_MEMPBRK_SSE2) && defined(HAVE_SSE4_2)
+/*
+ * Compare 16 bytes at a time against each needle. This beats pcmpistri
+ * for the handful of needles used to find line ends and delimiters.
+ */
+static const guint8 *
+ws_mempbrk_sse2_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
+{
+    const guint8 *haystack_end = haystack + haystacklen;
+    const guint last = pattern->n_needles - 1;
+    /* Unused needles repeat the last one. */
+    const __m128i n0 = _mm_set1_epi8((char)pattern->needles[0]);
+    const __m128i n1 = _mm_set1_epi8((char)pattern->needles[MIN(1, last)]);
+    const __m128i n2 = _mm_set1_epi8((char)pattern->needles[MIN(2, last)]);
+    const __m128i n3 = _mm_set1_epi8((char)pattern->needles[MIN(3, last)]);
+
+    while (haystack_end - haystack >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)haystack);
+        const __m128i eq = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, n0), _mm_cmpeq_epi8(v, n1)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, n2), _mm_cmpeq_epi8(v, n3)));
+        const int mask = _mm_movemask_epi8(eq);
+
+        if (mask) {
+            haystack += ws_ctz((guint32)mask);
+            if (found_needle)
+                *found_needle = *haystack;
+            return haystack;
+        }
+        haystack += 16;
+    }
+
+    return ws_mempbrk_portable_exec(haystack, haystack_end - haystack, pattern, found_needle);
+}
+#endif
+
 WS_DLL_PUBLIC const guint8 *
 ws_mempbrk_exec(const guint8* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, guchar *found_needle)
 {
 #ifdef HAVE_SSE4_2
+    if (pattern->n_needles == 1) {
+        const guint8 *result = (const guint8 *)memchr(haystack, pattern->needles[0], haystacklen);
+
+        if (result && found_needle)
+            *found_needle = *result;
+        return result;
+    }
+
+#ifdef WS_MEMPBRK_SSE2
+    if (haystacklen >= 16 && pattern->n_needles > 1)
+        return ws_mempbrk_sse2_exec(haystack, haystacklen, pattern, found_needle);
+#endif
+
     if (haystacklen >= 16 && pattern->use_sse42)
         return ws_mempbrk_sse42_exec(haystack, haystacklen, pattern, found_needle);
 #endif
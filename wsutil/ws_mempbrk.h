@@ -16,12 +16,21 @@
 #include <emmintrin.h>
 #endif
 
+#ifdef HAVE_SSE4_2
+/** The largest number of needles that are also kept as a list, to be
+ * compared directly instead of looked up byte by byte.
+ */
+#define WS_MEMPBRK_MAX_FEW_NEEDLES 4
+#endif
+
 /** The pattern object used for ws_mempbrk_exec().
  */
 typedef struct {
     gchar patt[256];
 #ifdef HAVE_SSE4_2
     gboolean use_sse42;
+    guint8 n_needles;   /* 0 if more than WS_MEMPBRK_MAX_FEW_NEEDLES */
+    guint8 needles[WS_MEMPBRK_MAX_FEW_NEEDLES];
     __m128i mask;
 #endif
 } ws_mempbrk_pattern;